@@ -27,6 +27,8 @@
 // #include "freertos/task.h"
 #include "driver/gpio.h"
 
+#include "discovery.h"
+
 #define CONFIG_ESP_WIFI_SSID      "lab-iot"
 #define CONFIG_ESP_WIFI_PASS      "IoT-IoT-IoT"
 #define CONFIG_ESP_MAXIMUM_RETRY  5
@@ -44,7 +46,11 @@
 #define ESP_INTR_FLAG_DEFAULT 0
 
 #define UDP_PORT 10001
+/* Peers find each other as _esp-ctl._udp over mDNS; SERVER_IP is only
+ * used when no other board answers */
 #define SERVER_IP "192.168.89.49"
+#define CTL_SERVICE       "_esp-ctl"
+#define CTL_SERVICE_PROTO "_udp"
 
 /* FreeRTOS event group to signal when we are connected*/
 static EventGroupHandle_t s_wifi_event_group;
@@ -253,6 +259,35 @@ static void gpio_task_example(void* arg)
 }
 
 
+/* Peer found by discovery_task. send_task only reads it, so a query that
+ * waits out the mDNS timeout never holds up a send */
+#define DISCOVERY_PERIOD_MS 5000
+
+static portMUX_TYPE s_peer_lock = portMUX_INITIALIZER_UNLOCKED;
+static esp_ip4_addr_t s_peer_addr;
+static uint16_t s_peer_port;
+static bool s_have_peer = false;
+
+// Task for looking the peer up again once the cached answer expires
+static void discovery_task(void *pvParameters) {
+    while (1) {
+        esp_ip4_addr_t peer;
+        uint16_t peer_port;
+        if (discovery_find_service(CTL_SERVICE, CTL_SERVICE_PROTO, &peer, &peer_port) == ESP_OK) {
+            taskENTER_CRITICAL(&s_peer_lock);
+            bool changed = !s_have_peer || s_peer_addr.addr != peer.addr || s_peer_port != peer_port;
+            s_peer_addr = peer;
+            s_peer_port = peer_port;
+            s_have_peer = true;
+            taskEXIT_CRITICAL(&s_peer_lock);
+            if (changed) {
+                ESP_LOGI("UDP", "Peer is " IPSTR ":%u", IP2STR(&peer), peer_port);
+            }
+        }
+        vTaskDelay(DISCOVERY_PERIOD_MS / portTICK_PERIOD_MS);
+    }
+}
+
 // Task for sending GPIO status over UDP
 static void send_task(void *pvParameters) {
     struct sockaddr_in dest_addr;
@@ -272,6 +307,14 @@ static void send_task(void *pvParameters) {
     gpio_set_direction(GPIO_INPUT_IO_2, GPIO_MODE_INPUT);
     
     while (1) {
+        // Latest peer from discovery_task, SERVER_IP until there is one
+        taskENTER_CRITICAL(&s_peer_lock);
+        if (s_have_peer) {
+            dest_addr.sin_addr.s_addr = s_peer_addr.addr;
+            dest_addr.sin_port = htons(s_peer_port);
+        }
+        taskEXIT_CRITICAL(&s_peer_lock);
+
         // Read the GPIO state
         int gpio_state = gpio_get_level(GPIO_INPUT_IO_2);
         
@@ -347,7 +390,18 @@ void app_main(void)
     bool connected = wifi_init_sta();
 
     if (connected) {
+        // esp32-ctl-xxxxxx.local, reachable on CONFIG_LOCAL_PORT with "GPIO4=<0|1>"
+        mdns_txt_item_t txt[] = {
+            { "caps", "gpio4" },
+            { "cmd", "GPIO4=<0|1>" },
+        };
+        if (discovery_init("esp32-ctl", "Lab2 UDP control") == ESP_OK) {
+            discovery_advertise(CTL_SERVICE, CTL_SERVICE_PROTO, CONFIG_LOCAL_PORT,
+                                txt, sizeof(txt) / sizeof(txt[0]));
+            xTaskCreate(discovery_task, "discovery_task", 4096, NULL, 4, NULL);
+        }
+
         xTaskCreate(udp_task, "udp_task", 4096, NULL, 5, NULL);
         xTaskCreate(send_task, "send_task", 4096, NULL, 5, NULL);
     }
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <string.h>
+#include <inttypes.h>
 #include <sys/param.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -16,52 +17,67 @@
 #include "esp_http_server.h"
 
 #include <stdio.h>
-#include <unistd.h>  // For getcwd()
-
-/* Our URI handler function to be called during GET /uri request */
-static int get_handler(httpd_req_t *req) {
-    // Inside your code before opening the file
-    // char cwd[1024];
-    // if (getcwd(cwd, sizeof(cwd)) != NULL) {
-    //     printf("Current working directory: %s\n", cwd);
-    // } else {
-    //     perror("getcwd() error");
-    // }
-    // Open the index.html file
-    FILE *file = fopen("D:/CI1A/Laborator/Lab5/src/index.html", "r");
-    if (!file) {
-        // Handle error if file cannot be opened
-        const char *error_response = "HTTP/1.1 404 Not Found\r\n\r\nFile Not Found";
-        httpd_resp_send(req, error_response, strlen(error_response));
-        return ESP_FAIL;
-    }
 
-    // Read the file into memory
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    char *file_contents = (char *)malloc(file_size + 1);
-    if (!file_contents) {
-        // Handle memory allocation error
-        fclose(file);
-        const char *error_response = "HTTP/1.1 500 Internal Server Error\r\n\r\nUnable to read file";
-        httpd_resp_send(req, error_response, strlen(error_response));
-        return ESP_FAIL;
-    }
+/* Static pages, gzip-compressed at build time (see gzip_asset.cmake) and
+ * linked into flash by target_add_binary_data() */
+extern const uint8_t index_html_gz_start[] asm("_binary_index_html_gz_start");
+extern const uint8_t index_html_gz_end[]   asm("_binary_index_html_gz_end");
+extern const uint8_t results_html_gz_start[] asm("_binary_results_html_gz_start");
+extern const uint8_t results_html_gz_end[]   asm("_binary_results_html_gz_end");
+
+typedef struct {
+    const uint8_t *start;
+    const uint8_t *end;
+    const char *type;
+    char etag[12];      /* "xxxxxxxx" incl. quotes */
+} web_asset_t;
+
+static web_asset_t index_asset = {
+    .start = index_html_gz_start,
+    .end   = index_html_gz_end,
+    .type  = "text/html",
+};
 
-    fread(file_contents, 1, file_size, file);
-    file_contents[file_size] = '\0';  // Null terminate the string
+static web_asset_t results_asset = {
+    .start = results_html_gz_start,
+    .end   = results_html_gz_end,
+    .type  = "text/html",
+};
 
-    fclose(file);
+static const char *TAG = "http-server";
 
-    // Send HTTP headers and content
-    const char *headers = "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\n\r\n";
-    httpd_resp_send(req, headers, strlen(headers)); // Send headers
-    httpd_resp_send(req, file_contents, file_size); // Send file content
+/* FNV-1a over the compressed bytes; changes whenever a new page is flashed */
+static void web_asset_init(web_asset_t *asset)
+{
+    uint32_t hash = 2166136261u;
+    for (const uint8_t *p = asset->start; p < asset->end; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    snprintf(asset->etag, sizeof(asset->etag), "\"%08" PRIx32 "\"", hash);
+}
 
-    free(file_contents);  // Free memory
-    return ESP_OK;
+/* Our URI handler function to be called during GET /uri request.
+ * Pages are sent straight from flash: no file I/O and no heap. */
+static esp_err_t get_handler(httpd_req_t *req)
+{
+    const web_asset_t *asset = req->user_ctx;
+    char if_none_match[64];
+
+    httpd_resp_set_hdr(req, "ETag", asset->etag);
+    /* Let the browser keep its copy but revalidate it on every load */
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match,
+                                    sizeof(if_none_match)) == ESP_OK
+            && strstr(if_none_match, asset->etag) != NULL) {
+        ESP_LOGD(TAG, "%s not modified", req->uri);
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    httpd_resp_set_type(req, asset->type);
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    return httpd_resp_send(req, (const char *)asset->start, asset->end - asset->start);
 }
 
 /* Our URI handler function to be called during POST /uri request */
@@ -97,12 +113,26 @@ esp_err_t post_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
-/* URI handler structure for GET /uri */
+/* URI handler structures for GET /uri */
+httpd_uri_t uri_get_root = {
+    .uri      = "/",
+    .method   = HTTP_GET,
+    .handler  = get_handler,
+    .user_ctx = &index_asset
+};
+
 httpd_uri_t uri_get = {
     .uri      = "/index.html",
     .method   = HTTP_GET,
     .handler  = get_handler,
-    .user_ctx = NULL
+    .user_ctx = &index_asset
+};
+
+httpd_uri_t uri_get_results = {
+    .uri      = "/results.html",
+    .method   = HTTP_GET,
+    .handler  = get_handler,
+    .user_ctx = &results_asset
 };
 
 /* URI handler structure for POST /uri */
@@ -122,10 +152,15 @@ httpd_handle_t start_webserver(void)
     /* Empty handle to esp_http_server */
     httpd_handle_t server = NULL;
 
+    web_asset_init(&index_asset);
+    web_asset_init(&results_asset);
+
     /* Start the httpd server */
     if (httpd_start(&server, &config) == ESP_OK) {
         /* Register URI handlers */
+        httpd_register_uri_handler(server, &uri_get_root);
         httpd_register_uri_handler(server, &uri_get);
+        httpd_register_uri_handler(server, &uri_get_results);
         httpd_register_uri_handler(server, &uri_post);
     }
     /* If server failed to start, handle will be NULL */
@@ -139,4 +174,4 @@ void stop_webserver(httpd_handle_t server)
         /* Stop the httpd server */
         httpd_stop(server);
     }
-}
\ No newline at end of file
+}
\ No newline at end of file
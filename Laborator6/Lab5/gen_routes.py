@@ -0,0 +1,138 @@
+"""Generates the web server's route table from src/routes.txt.
+
+Exact routes go into a perfect hash (hash and displace): the method and
+path pick a bucket, the bucket's displacement seed then picks a slot no
+other route uses, so a lookup is two hashes and one string compare.
+Routes ending in '*' are prefix routes, tried longest first after a miss.
+
+Usage: python gen_routes.py routes.txt routes_gen.h routes_count.h
+routes_count.h only holds ROUTER_ROUTE_COUNT, for code that sizes per-route
+state (async-pool.c) but must not pull in the table and its handlers.
+The hash must stay in step with router_hash() in src/router.c.
+"""
+import sys
+
+METHODS = {'DELETE': 0, 'GET': 1, 'HEAD': 2, 'POST': 3, 'PUT': 4}
+MASK = 0xffffffff
+
+
+def router_hash(seed, method, path):
+    h = (2166136261 ^ seed) & MASK
+    for c in bytes([method]) + path.encode():
+        h = ((h ^ c) * 16777619) & MASK
+    # murmur3 finaliser, FNV alone keeps too much of the seed in the low bits
+    h ^= h >> 16
+    h = (h * 0x85ebca6b) & MASK
+    h ^= h >> 13
+    h = (h * 0xc2b2ae35) & MASK
+    h ^= h >> 16
+    return h
+
+
+def parse(path):
+    routes = []
+    with open(path) as f:
+        for n, line in enumerate(f, 1):
+            fields = line.split('#', 1)[0].split()
+            if not fields:
+                continue
+            if len(fields) < 3 or fields[0] not in METHODS:
+                sys.exit('{}:{}: expected "METHOD /uri handler [user_ctx] [slow]"'.format(path, n))
+            method, uri, handler = fields[:3]
+            ctx = fields[3] if len(fields) > 3 and fields[3] != '-' else 'NULL'
+            flags = fields[4:]
+            if any(flag != 'slow' for flag in flags):
+                sys.exit('{}:{}: unknown flag in {}'.format(path, n, flags))
+            if not uri.startswith('/') or '*' in uri[:-1]:
+                sys.exit('{}:{}: bad uri {}'.format(path, n, uri))
+            key = (METHODS[method], uri)
+            if any((METHODS[r['method']], r['uri']) == key for r in routes):
+                sys.exit('{}:{}: duplicate route {} {}'.format(path, n, method, uri))
+            routes.append({'method': method, 'uri': uri, 'handler': handler,
+                           'ctx': ctx, 'slow': 'slow' in flags})
+    return routes
+
+
+def build(keys):
+    """Returns (displacements, slots) for the (method, path) keys"""
+    n = len(keys)
+    bucket_count = max(1, (n + 1) // 2)
+    slot_count = 1
+    while slot_count * 4 < n * 5:
+        slot_count *= 2
+    while True:
+        buckets = [[] for _ in range(bucket_count)]
+        for i, (method, path) in enumerate(keys):
+            buckets[router_hash(0, method, path) % bucket_count].append(i)
+        slots = [-1] * slot_count
+        disp = [0] * bucket_count
+        ok = True
+        for b in sorted(range(bucket_count), key=lambda b: -len(buckets[b])):
+            if not buckets[b]:
+                continue
+            for d in range(1, 256):
+                pos = [router_hash(d, *keys[i]) % slot_count for i in buckets[b]]
+                if len(set(pos)) == len(pos) and all(slots[p] < 0 for p in pos):
+                    for i, p in zip(buckets[b], pos):
+                        slots[p] = i
+                    disp[b] = d
+                    break
+            else:
+                ok = False
+                break
+        if ok:
+            return disp, slots
+        slot_count *= 2
+
+
+def c_list(values, per_line=16):
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append('    ' + ', '.join(str(v) for v in values[i:i + per_line]) + ',')
+    return '\n'.join(lines)
+
+
+def main():
+    if len(sys.argv) != 4:
+        sys.exit(__doc__)
+    routes = parse(sys.argv[1])
+    exact = [i for i, r in enumerate(routes) if not r['uri'].endswith('*')]
+    prefix = sorted((i for i, r in enumerate(routes) if r['uri'].endswith('*')),
+                    key=lambda i: -len(routes[i]['uri']))
+    if len(routes) > 255:
+        sys.exit('too many routes for the 8-bit prefix index')
+
+    keys = [(METHODS[routes[i]['method']], routes[i]['uri']) for i in exact]
+    disp, slots = build(keys) if keys else ([0], [-1])
+    slots = [exact[s] if s >= 0 else -1 for s in slots]
+
+    out = ['/* Generated by gen_routes.py from routes.txt, do not edit */', '',
+           'static const router_route_t s_routes[] = {']
+    for r in routes:
+        out.append('    {{ "{}", HTTP_{}, {}, {}, {} }},'.format(
+            r['uri'], r['method'], r['handler'], r['ctx'], 'true' if r['slow'] else 'false'))
+    out += ['};', '',
+            'static const uint8_t s_route_disp[] = {', c_list(disp), '};', '',
+            'static const int16_t s_route_slots[] = {', c_list(slots), '};', '',
+            'static const uint8_t s_route_prefixes[] = {', c_list(prefix or [0]), '};', '',
+            'static const router_table_t s_route_table = {',
+            '    .routes = s_routes,',
+            '    .route_count = {},'.format(len(routes)),
+            '    .disp = s_route_disp,',
+            '    .bucket_count = {},'.format(len(disp)),
+            '    .slots = s_route_slots,',
+            '    .slot_count = {},'.format(len(slots)),
+            '    .prefixes = s_route_prefixes,',
+            '    .prefix_count = {},'.format(len(prefix)),
+            '};', '']
+    with open(sys.argv[2], 'w') as f:
+        f.write('\n'.join(out))
+
+    count = ['/* Generated by gen_routes.py from routes.txt, do not edit */', '',
+             '#define ROUTER_ROUTE_COUNT {}'.format(len(routes)), '']
+    with open(sys.argv[3], 'w') as f:
+        f.write('\n'.join(count))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,3 @@
+# Compresses one web asset for embedding in flash.
+# Usage: cmake -DIN=<page.html> -DOUT=<page.html.gz> -P gzip_asset.cmake
+file(ARCHIVE_CREATE OUTPUT ${OUT} PATHS ${IN} FORMAT raw COMPRESSION GZip COMPRESSION_LEVEL 9)
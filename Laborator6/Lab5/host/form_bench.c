@@ -0,0 +1,135 @@
+/* Throughput of src/form-parser.c on the host.
+ *
+ * Feeds a large urlencoded body and a multipart body through the parser
+ * in recv-sized chunks, the way post_handler does, and prints MB/s.
+ *
+ *   ./build/form_bench [--size-kb N] [--chunk N] [--runs N]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "form-parser.h"
+
+static unsigned long field_count;
+static size_t field_bytes;
+
+static int on_field(void *user, const char *key, const char *value, size_t value_len)
+{
+    (void)user;
+    (void)key;
+    (void)value;
+    field_count++;
+    field_bytes += value_len;
+    return 0;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* ssid=...&ipass=...&... with a mix of plain and escaped characters */
+static size_t make_urlencoded(char *buf, size_t size)
+{
+    size_t off = 0;
+    unsigned i = 0;
+    while (off + 64 < size) {
+        off += sprintf(buf + off, "%sfield%u=Retea+%u%%20p%%40ss%%2Bword-%08x",
+                       i ? "&" : "", i, i, i * 2654435761u);
+        i++;
+    }
+    return off;
+}
+
+/* One large part whose data contains near-miss delimiters */
+static size_t make_multipart(char *buf, size_t size)
+{
+    size_t off = sprintf(buf, "--BenchBoundary\r\n"
+                              "Content-Disposition: form-data; name=\"blob\"; filename=\"b.bin\"\r\n"
+                              "Content-Type: application/octet-stream\r\n\r\n");
+    const char *tail = "\r\n--BenchBoundary--\r\n";
+    size_t end = size - strlen(tail);
+    while (off < end) {
+        size_t left = end - off;
+        const char *piece = (off % 512) < 16 ? "\r\n--BenchBound" : "0123456789abcdef";
+        size_t n = strlen(piece) < left ? strlen(piece) : left;
+        memcpy(buf + off, piece, n);
+        off += n;
+    }
+    memcpy(buf + off, tail, strlen(tail));
+    return off + strlen(tail);
+}
+
+static double bench(const char *name, const char *ctype, const char *body, size_t len,
+                    char *value, size_t value_size, size_t chunk, int runs)
+{
+    double best = 0;
+    form_status_t st = FORM_OK;
+
+    for (int r = 0; r < runs; r++) {
+        form_parser_t p;
+        field_count = 0;
+        field_bytes = 0;
+        double t0 = now_s();
+        form_parser_init(&p, ctype, value, value_size, on_field, NULL);
+        for (size_t off = 0; off < len && st == FORM_OK; off += chunk) {
+            st = form_parser_feed(&p, body + off, len - off < chunk ? len - off : chunk);
+        }
+        if (st == FORM_OK) {
+            st = form_parser_finish(&p);
+        }
+        double mbps = len / (now_s() - t0) / 1e6;
+        if (mbps > best) {
+            best = mbps;
+        }
+    }
+    printf("%-11s %8zu bytes  chunk %4zu  %7.1f MB/s  %lu fields, %zu value bytes  %s\n",
+           name, len, chunk, best, field_count, field_bytes, form_status_str(st));
+    return st == FORM_OK ? best : -1;
+}
+
+int main(int argc, char **argv)
+{
+    size_t size_kb = 1024, chunk = 64;
+    int runs = 5;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--size-kb") == 0) {
+            size_kb = strtoul(argv[i + 1], NULL, 0);
+        } else if (strcmp(argv[i], "--chunk") == 0) {
+            chunk = strtoul(argv[i + 1], NULL, 0);
+        } else if (strcmp(argv[i], "--runs") == 0) {
+            runs = atoi(argv[i + 1]);
+        } else {
+            fprintf(stderr, "usage: %s [--size-kb N] [--chunk N] [--runs N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (chunk == 0 || size_kb == 0 || runs <= 0) {
+        return 2;
+    }
+
+    size_t size = size_kb * 1024;
+    char *body = malloc(size);
+    char *value = malloc(size);
+    if (body == NULL || value == NULL) {
+        return 1;
+    }
+
+    printf("sizeof(form_parser_t) = %zu bytes\n", sizeof(form_parser_t));
+    int failed = 0;
+    size_t len = make_urlencoded(body, size);
+    failed |= bench("urlencoded", "application/x-www-form-urlencoded",
+                    body, len, value, 128, chunk, runs) < 0;
+    len = make_multipart(body, size);
+    failed |= bench("multipart", "multipart/form-data; boundary=BenchBoundary",
+                    body, len, value, size, chunk, runs) < 0;
+
+    free(body);
+    free(value);
+    return failed;
+}
@@ -0,0 +1,247 @@
+/* Fuzz target for src/form-parser.c.
+ *
+ * Every input is parsed twice: in one piece and split into random
+ * chunks. Both runs must report the same fields and the same status,
+ * and every value must respect its limit. Built with libFuzzer
+ * (FORM_FUZZ_LIBFUZZER) the input comes from the fuzzer; otherwise a
+ * small driver generates near-valid bodies, or replays files given on
+ * the command line.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "form-parser.h"
+
+#define VALUE_BUF_SIZE 48
+
+static const form_limit_t limits[] = {
+    { "ssid", 32 },
+    { "ipass", 20 },
+    { "k", 0 },
+};
+
+typedef struct {
+    uint64_t hash;
+    unsigned fields;
+} record_t;
+
+static uint64_t fnv1a(uint64_t h, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ p[i]) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static size_t limit_for(const char *key)
+{
+    for (size_t i = 0; i < sizeof(limits) / sizeof(limits[0]); i++) {
+        if (strcmp(limits[i].key, key) == 0) {
+            return limits[i].max_len;
+        }
+    }
+    return VALUE_BUF_SIZE - 1;
+}
+
+static int on_field(void *user, const char *key, const char *value, size_t value_len)
+{
+    record_t *rec = user;
+
+    if (strlen(key) > FORM_MAX_KEY_LEN || value_len > limit_for(key) || value[value_len] != '\0') {
+        fprintf(stderr, "limit violated: key '%s' value_len %zu\n", key, value_len);
+        abort();
+    }
+    rec->hash = fnv1a(rec->hash, key, strlen(key) + 1);
+    rec->hash = fnv1a(rec->hash, &value_len, sizeof(value_len));
+    rec->hash = fnv1a(rec->hash, value, value_len);
+    rec->fields++;
+    /* Exercise the abort path too */
+    return rec->fields > 64;
+}
+
+static form_status_t run(const char *ctype, const uint8_t *data, size_t len,
+                         uint32_t split_seed, record_t *rec)
+{
+    char value[VALUE_BUF_SIZE];
+    form_parser_t p;
+    form_status_t st;
+
+    memset(rec, 0, sizeof(*rec));
+    rec->hash = 0xcbf29ce484222325ULL;
+    st = form_parser_init(&p, ctype, value, sizeof(value), on_field, rec);
+    if (st != FORM_OK) {
+        return st;
+    }
+    form_parser_set_limits(&p, limits, sizeof(limits) / sizeof(limits[0]));
+
+    size_t off = 0;
+    while (off < len) {
+        size_t n = len - off;
+        if (split_seed) {
+            split_seed = split_seed * 1103515245u + 12345u;
+            n = 1 + (split_seed >> 16) % (n < 17 ? n : 17);
+        }
+        st = form_parser_feed(&p, (const char *)data + off, n);
+        if (st != FORM_OK) {
+            return st;
+        }
+        off += n;
+    }
+    return form_parser_finish(&p);
+}
+
+/* The first input byte picks the content type and the split pattern */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static const char *ctypes[] = {
+        "application/x-www-form-urlencoded",
+        "multipart/form-data; boundary=XyZ",
+        "multipart/form-data; boundary=\"--ab--\"",
+        "multipart/form-data; boundary=a",
+    };
+    record_t whole, split;
+
+    if (size < 1) {
+        return 0;
+    }
+    const char *ctype = ctypes[data[0] % 4];
+    uint32_t seed = data[0] | 1u;
+    data++;
+    size--;
+
+    form_status_t a = run(ctype, data, size, 0, &whole);
+    form_status_t b = run(ctype, data, size, seed, &split);
+    if (a != b || whole.hash != split.hash || whole.fields != split.fields) {
+        fprintf(stderr, "split mismatch: %s/%u fields vs %s/%u fields\n",
+                form_status_str(a), whole.fields, form_status_str(b), split.fields);
+        abort();
+    }
+    return 0;
+}
+
+#ifndef FORM_FUZZ_LIBFUZZER
+
+static uint32_t rng_state = 1;
+
+static uint32_t rnd(uint32_t n)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state % n;
+}
+
+static size_t put(uint8_t *buf, size_t off, size_t cap, const char *s)
+{
+    size_t n = strlen(s);
+    if (off + n > cap) {
+        n = cap - off;
+    }
+    memcpy(buf + off, s, n);
+    return off + n;
+}
+
+static const char *keys[] = { "ssid", "ipass", "k", "other", "a%3Db", "" };
+static const char *values[] = { "", "net", "p%40ss+word", "%zz", "%4", "--XyZ",
+                                "\r\n--XyZ", "\r\n--Xy", "0123456789012345678901234567890123456789" };
+
+static size_t gen_urlencoded(uint8_t *buf, size_t cap)
+{
+    size_t off = 0;
+    int fields = rnd(6);
+    for (int i = 0; i < fields; i++) {
+        if (i) {
+            off = put(buf, off, cap, rnd(8) ? "&" : "&&");
+        }
+        off = put(buf, off, cap, keys[rnd(6)]);
+        if (rnd(6)) {
+            off = put(buf, off, cap, "=");
+            off = put(buf, off, cap, values[rnd(9)]);
+        }
+    }
+    return off;
+}
+
+static size_t gen_multipart(uint8_t *buf, size_t cap)
+{
+    size_t off = put(buf, 0, cap, rnd(4) ? "" : "preamble\r\n");
+    int parts = rnd(5);
+    for (int i = 0; i < parts; i++) {
+        off = put(buf, off, cap, i ? "\r\n--XyZ\r\n" : "--XyZ\r\n");
+        off = put(buf, off, cap, "Content-Disposition: form-data; ");
+        if (rnd(3) == 0) {
+            off = put(buf, off, cap, "filename=\"f.txt\"; ");
+        }
+        off = put(buf, off, cap, "name=\"");
+        off = put(buf, off, cap, keys[rnd(4)]);
+        off = put(buf, off, cap, "\"\r\n");
+        if (rnd(2)) {
+            off = put(buf, off, cap, "Content-Type: text/plain\r\n");
+        }
+        off = put(buf, off, cap, "\r\n");
+        off = put(buf, off, cap, values[rnd(9)]);
+    }
+    if (rnd(8)) {
+        off = put(buf, off, cap, parts ? "\r\n--XyZ--\r\n" : "--XyZ--");
+    }
+    return off;
+}
+
+static int replay_file(const char *path)
+{
+    static uint8_t buf[1 << 16];
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return 1;
+    }
+    size_t n = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+    LLVMFuzzerTestOneInput(buf, n);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static uint8_t buf[1024];
+    unsigned long iterations = 100000;
+    int argi = 1;
+
+    if (argi + 1 < argc && strcmp(argv[argi], "-n") == 0) {
+        iterations = strtoul(argv[argi + 1], NULL, 0);
+        argi += 2;
+    }
+    if (argi + 1 < argc && strcmp(argv[argi], "-s") == 0) {
+        rng_state = (uint32_t)strtoul(argv[argi + 1], NULL, 0) | 1u;
+        argi += 2;
+    }
+    if (argi < argc) {
+        int failed = 0;
+        for (; argi < argc; argi++) {
+            failed |= replay_file(argv[argi]);
+        }
+        return failed;
+    }
+
+    for (unsigned long i = 0; i < iterations; i++) {
+        int multipart = rnd(2);
+        /* Selector byte: 0 = urlencoded, 1 = boundary XyZ */
+        buf[0] = (uint8_t)((rnd(64) << 2) | multipart);
+        size_t len = 1 + (multipart ? gen_multipart(buf + 1, sizeof(buf) - 1)
+                                    : gen_urlencoded(buf + 1, sizeof(buf) - 1));
+        /* Occasionally flip a few bytes */
+        if (len > 1 && rnd(4) == 0) {
+            for (int k = rnd(3) + 1; k > 0; k--) {
+                buf[1 + rnd(len - 1)] = (uint8_t)rnd(256);
+            }
+        }
+        LLVMFuzzerTestOneInput(buf, len);
+    }
+    printf("form_fuzz: %lu inputs, no mismatches\n", iterations);
+    return 0;
+}
+
+#endif
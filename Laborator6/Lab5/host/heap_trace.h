@@ -0,0 +1,12 @@
+#ifndef _HEAP_TRACE_H_
+#define _HEAP_TRACE_H_
+
+#include <stddef.h>
+
+/* Live/peak heap of the code linked with -Wl,--wrap=malloc,... i.e. the
+ * firmware sources and the stubs, not libc or OpenSSL internals */
+size_t heap_trace_current(void);
+size_t heap_trace_peak(void);
+void heap_trace_reset_peak(void);
+
+#endif
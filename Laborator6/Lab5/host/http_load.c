@@ -0,0 +1,563 @@
+/* Host load test of the softAP web server.
+ *
+ * Runs src/http-server.c, async-pool.c, provision.c, form-parser.c and
+ * template.c in process against the socket-backed esp_http_server in
+ * stubs/ and a simulated radio, then drives it from several keep-alive
+ * clients at once. Prints requests/s and latency percentiles per request
+ * type, followed by the peak heap of one request of each type measured
+ * with a single client. --max-p99-ms / --max-heap / --max-leak turn it
+ * into a pass/fail check for CI.
+ *
+ *   cmake -S . -B build && cmake --build build && ./build/http_load --clients 4
+ */
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "esp_http_server.h"
+#include "http-server.h"
+#include "provision.h"
+#include "heap_trace.h"
+
+#define SIM_SSID    "lab-iot"
+#define SIM_PASS    "IoT-IoT-IoT"
+
+typedef enum {
+    REQ_INDEX,
+    REQ_RESULTS,
+    REQ_RESULTS_304,
+    REQ_STATUS,
+    REQ_METRICS,
+    REQ_POST,
+    REQ_TYPE_COUNT
+} req_type_t;
+
+static const char *const s_req_names[REQ_TYPE_COUNT] = {
+    [REQ_INDEX]       = "index",
+    [REQ_RESULTS]     = "results",
+    [REQ_RESULTS_304] = "results304",
+    [REQ_STATUS]      = "status",
+    [REQ_METRICS]     = "metrics",
+    [REQ_POST]        = "post",
+};
+
+typedef struct {
+    int fd;
+    size_t start;
+    size_t len;
+    char buf[8192];
+} conn_t;
+
+typedef struct {
+    int status;
+    bool close;
+    char etag[16];
+    size_t body_len;
+} resp_t;
+
+typedef struct {
+    uint32_t *us;
+    size_t count;
+    size_t cap;
+    uint32_t errors;
+} samples_t;
+
+typedef struct {
+    int id;
+    pthread_t thread;
+    samples_t samples[REQ_TYPE_COUNT];
+    uint32_t busy;          /* 503 from the worker pool */
+    uint32_t reconnects;
+} client_t;
+
+static uint16_t s_port;
+static bool s_close_each;
+static char s_etag[16];
+static req_type_t s_mix[REQ_TYPE_COUNT];
+static int s_mix_len;
+static volatile int s_stop;
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --clients N         concurrent connections (default 4, the softAP limit)\n"
+            "  --duration S        length of the load phase in seconds (default 5)\n"
+            "  --mix LIST          request types, comma separated (default all):\n"
+            "                      index,results,results304,status,metrics,post\n"
+            "  --close             new connection for every request\n"
+            "  --profile-runs N    requests per type in the heap profile (default 20)\n"
+            "  --connect-ms N      simulated Wi-Fi join time (default 30)\n"
+            "  --max-p99-ms F      fail if the p99 latency of any type exceeds F ms\n"
+            "  --max-heap N        fail if one request needs more than N bytes of heap\n"
+            "  --max-leak N        fail if the heap grows more than N bytes over the profile\n"
+            "  --verbose           firmware logs at INFO level (default: errors only)\n", prog);
+}
+
+static int conn_open(conn_t *c)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(s_port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    struct timeval tv = { .tv_sec = 10 };
+    int one = 1;
+
+    c->start = c->len = 0;
+    c->fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (c->fd < 0) {
+        return -1;
+    }
+    setsockopt(c->fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(c->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(c->fd);
+        c->fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+static void conn_close(conn_t *c)
+{
+    if (c->fd >= 0) {
+        close(c->fd);
+    }
+    c->fd = -1;
+}
+
+static int conn_fill(conn_t *c)
+{
+    if (c->start > 0) {
+        memmove(c->buf, c->buf + c->start, c->len);
+        c->start = 0;
+    }
+    if (c->len == sizeof(c->buf)) {
+        return -1;
+    }
+    ssize_t n = recv(c->fd, c->buf + c->len, sizeof(c->buf) - c->len, 0);
+    if (n <= 0) {
+        return -1;
+    }
+    c->len += n;
+    return 0;
+}
+
+/* Next CRLF-terminated line without the CRLF */
+static int conn_line(conn_t *c, char *line, size_t size)
+{
+    for (;;) {
+        char *eol = c->len >= 2 ? memmem(c->buf + c->start, c->len, "\r\n", 2) : NULL;
+        if (eol) {
+            size_t n = eol - (c->buf + c->start);
+            if (n >= size) {
+                return -1;
+            }
+            memcpy(line, c->buf + c->start, n);
+            line[n] = '\0';
+            c->start += n + 2;
+            c->len -= n + 2;
+            return 0;
+        }
+        if (conn_fill(c) != 0) {
+            return -1;
+        }
+    }
+}
+
+static int conn_skip(conn_t *c, size_t n)
+{
+    while (n > 0) {
+        if (c->len == 0 && conn_fill(c) != 0) {
+            return -1;
+        }
+        size_t take = n < c->len ? n : c->len;
+        c->start += take;
+        c->len -= take;
+        n -= take;
+    }
+    return 0;
+}
+
+static int read_response(conn_t *c, resp_t *r)
+{
+    char line[512];
+    bool chunked = false;
+    size_t content_len = 0;
+
+    memset(r, 0, sizeof(*r));
+    if (conn_line(c, line, sizeof(line)) != 0 || sscanf(line, "HTTP/1.%*d %d", &r->status) != 1) {
+        return -1;
+    }
+    for (;;) {
+        if (conn_line(c, line, sizeof(line)) != 0) {
+            return -1;
+        }
+        if (line[0] == '\0') {
+            break;
+        }
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            content_len = strtoul(line + 15, NULL, 10);
+        } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+            chunked = strstr(line + 18, "chunked") != NULL;
+        } else if (strncasecmp(line, "Connection:", 11) == 0) {
+            r->close = strstr(line + 11, "close") != NULL;
+        } else if (strncasecmp(line, "ETag:", 5) == 0) {
+            snprintf(r->etag, sizeof(r->etag), "%s", line + 5 + strspn(line + 5, " "));
+        }
+    }
+
+    if (!chunked) {
+        r->body_len = content_len;
+        return conn_skip(c, content_len);
+    }
+    for (;;) {
+        if (conn_line(c, line, sizeof(line)) != 0) {
+            return -1;
+        }
+        size_t n = strtoul(line, NULL, 16);
+        if (n == 0) {
+            return conn_line(c, line, sizeof(line));
+        }
+        if (conn_skip(c, n) != 0 || conn_line(c, line, sizeof(line)) != 0 || line[0] != '\0') {
+            return -1;
+        }
+        r->body_len += n;
+    }
+}
+
+static int format_request(req_type_t type, char *buf, size_t size)
+{
+    static const char body[] = "ssid=" SIM_SSID "&ipass=" SIM_PASS;
+    const char *conn = s_close_each ? "Connection: close\r\n" : "";
+
+    switch (type) {
+    case REQ_INDEX:
+        return snprintf(buf, size, "GET / HTTP/1.1\r\nHost: 192.168.4.1\r\n%s\r\n", conn);
+    case REQ_RESULTS:
+        return snprintf(buf, size, "GET /results.html HTTP/1.1\r\nHost: 192.168.4.1\r\n"
+                        "Accept-Encoding: gzip\r\n%s\r\n", conn);
+    case REQ_RESULTS_304:
+        return snprintf(buf, size, "GET /results.html HTTP/1.1\r\nHost: 192.168.4.1\r\n"
+                        "Accept-Encoding: gzip\r\nIf-None-Match: %s\r\n%s\r\n", s_etag, conn);
+    case REQ_STATUS:
+        return snprintf(buf, size, "GET /status HTTP/1.1\r\nHost: 192.168.4.1\r\n%s\r\n", conn);
+    case REQ_METRICS:
+        return snprintf(buf, size, "GET /metrics HTTP/1.1\r\nHost: 192.168.4.1\r\n%s\r\n", conn);
+    case REQ_POST:
+        return snprintf(buf, size, "POST /results.html HTTP/1.1\r\nHost: 192.168.4.1\r\n"
+                        "Content-Type: application/x-www-form-urlencoded\r\n"
+                        "Content-Length: %zu\r\n%s\r\n%s", sizeof(body) - 1, conn, body);
+    default:
+        return -1;
+    }
+}
+
+/* A POST may also find an attempt already running (409) or the worker
+ * queue full (503); both are normal answers under load */
+static bool status_ok(req_type_t type, int status)
+{
+    switch (type) {
+    case REQ_RESULTS_304: return status == 304;
+    case REQ_POST:        return status == 303 || status == 409 || status == 503;
+    default:              return status == 200;
+    }
+}
+
+/* One request on c, reconnecting first if needed. A kept-alive socket
+ * may have been purged by the server (LRU) since the last request; that
+ * is retried once on a new connection. */
+static int do_request(conn_t *c, req_type_t type, resp_t *r, uint32_t *reconnects)
+{
+    char req[512];
+    int len = format_request(type, req, sizeof(req));
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = c->fd >= 0;
+        if (!reused) {
+            if (conn_open(c) != 0) {
+                return -1;
+            }
+            if (attempt > 0 && reconnects) {
+                (*reconnects)++;
+            }
+        }
+        if (send(c->fd, req, len, MSG_NOSIGNAL) == len && read_response(c, r) == 0) {
+            if (r->close || s_close_each) {
+                conn_close(c);
+            }
+            return 0;
+        }
+        conn_close(c);
+        if (!reused) {
+            return -1;
+        }
+    }
+    return -1;
+}
+
+static void samples_add(samples_t *s, uint32_t us)
+{
+    if (s->count == s->cap) {
+        size_t cap = s->cap ? s->cap * 2 : 1024;
+        uint32_t *p = realloc(s->us, cap * sizeof(*p));
+        if (p == NULL) {
+            return;
+        }
+        s->us = p;
+        s->cap = cap;
+    }
+    s->us[s->count++] = us;
+}
+
+static void *client_main(void *arg)
+{
+    client_t *cl = arg;
+    conn_t *c = malloc(sizeof(*c));
+    resp_t r;
+
+    c->fd = -1;
+    for (int i = cl->id; !__atomic_load_n(&s_stop, __ATOMIC_RELAXED); i++) {
+        req_type_t type = s_mix[i % s_mix_len];
+        samples_t *s = &cl->samples[type];
+
+        int64_t t = esp_timer_get_time();
+        if (do_request(c, type, &r, &cl->reconnects) != 0 || !status_ok(type, r.status)) {
+            s->errors++;
+            continue;
+        }
+        if (r.status == 503) {
+            cl->busy++;
+        }
+        samples_add(s, esp_timer_get_time() - t);
+    }
+    conn_close(c);
+    free(c);
+    return NULL;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static double pct_ms(const uint32_t *sorted, size_t n, double pct)
+{
+    size_t i = (size_t)(pct / 100.0 * (n - 1) + 0.5);
+    return sorted[i] / 1000.0;
+}
+
+static int parse_mix(const char *list)
+{
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s", list);
+    s_mix_len = 0;
+    for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+        int t;
+        for (t = 0; t < REQ_TYPE_COUNT && strcmp(tok, s_req_names[t]) != 0; t++) {
+        }
+        if (t == REQ_TYPE_COUNT || s_mix_len == REQ_TYPE_COUNT) {
+            return -1;
+        }
+        s_mix[s_mix_len++] = t;
+    }
+    return s_mix_len > 0 ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+    int clients = 4, duration = 5, profile_runs = 20, connect_ms = 30;
+    double max_p99_ms = 0;
+    size_t max_heap = 0;
+    long max_leak = -1;
+
+    /* 503s under load are expected and logged as warnings */
+    esp_log_host_level = ESP_LOG_ERROR;
+    parse_mix("index,results,results304,status,metrics,post");
+
+    static const struct option opts[] = {
+        { "clients", required_argument, NULL, 'c' },
+        { "duration", required_argument, NULL, 'd' },
+        { "mix", required_argument, NULL, 'm' },
+        { "close", no_argument, NULL, 'C' },
+        { "profile-runs", required_argument, NULL, 'r' },
+        { "connect-ms", required_argument, NULL, 'j' },
+        { "max-p99-ms", required_argument, NULL, 'p' },
+        { "max-heap", required_argument, NULL, 'H' },
+        { "max-leak", required_argument, NULL, 'L' },
+        { "verbose", no_argument, NULL, 'v' },
+        { "help", no_argument, NULL, 'h' },
+        { 0 }
+    };
+    int c;
+    while ((c = getopt_long(argc, argv, "", opts, NULL)) != -1) {
+        switch (c) {
+        case 'c': clients = atoi(optarg); break;
+        case 'd': duration = atoi(optarg); break;
+        case 'm':
+            if (parse_mix(optarg) != 0) {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'C': s_close_each = true; break;
+        case 'r': profile_runs = atoi(optarg); break;
+        case 'j': connect_ms = atoi(optarg); break;
+        case 'p': max_p99_ms = atof(optarg); break;
+        case 'H': max_heap = strtoul(optarg, NULL, 0); break;
+        case 'L': max_leak = strtol(optarg, NULL, 0); break;
+        case 'v': esp_log_host_level = ESP_LOG_INFO; break;
+        default: usage(argv[0]); return c == 'h' ? 0 : 2;
+        }
+    }
+    if (clients <= 0 || duration <= 0 || profile_runs <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    /* Same order as app_main, minus the radio and SPIFFS */
+    esp_wifi_sim_set_network(SIM_SSID, SIM_PASS, connect_ms);
+    httpd_host_port_override = 0;
+    if (provision_init() != ESP_OK) {
+        fprintf(stderr, "provision_init failed\n");
+        return 1;
+    }
+    httpd_handle_t server = start_webserver();
+    if (server == NULL) {
+        fprintf(stderr, "Web server did not start\n");
+        return 1;
+    }
+    s_port = httpd_host_port(server);
+
+    /* ETag for the conditional requests */
+    conn_t *probe = malloc(sizeof(*probe));
+    resp_t r;
+    probe->fd = -1;
+    if (do_request(probe, REQ_RESULTS, &r, NULL) != 0 || r.status != 200 || r.etag[0] == '\0') {
+        fprintf(stderr, "GET /results.html failed\n");
+        return 1;
+    }
+    snprintf(s_etag, sizeof(s_etag), "%s", r.etag);
+    conn_close(probe);
+
+    /* Load phase */
+    client_t *cl = calloc(clients, sizeof(*cl));
+    int64_t t_start = esp_timer_get_time();
+    for (int i = 0; i < clients; i++) {
+        cl[i].id = i;
+        pthread_create(&cl[i].thread, NULL, client_main, &cl[i]);
+    }
+    sleep(duration);
+    __atomic_store_n(&s_stop, 1, __ATOMIC_RELAXED);
+    for (int i = 0; i < clients; i++) {
+        pthread_join(cl[i].thread, NULL);
+    }
+    double elapsed_s = (esp_timer_get_time() - t_start) / 1e6;
+
+    /* Heap profile: one client, one request at a time, so the peak above
+     * the starting point belongs to that request alone */
+    size_t peak[REQ_TYPE_COUNT] = {0};
+    int profile_errors = 0;
+    usleep(100 * 1000);
+    size_t heap_before = heap_trace_current();
+    probe->fd = -1;
+    for (int m = 0; m < s_mix_len; m++) {
+        req_type_t type = s_mix[m];
+        for (int i = 0; i < profile_runs; i++) {
+            heap_trace_reset_peak();
+            size_t base = heap_trace_current();
+            if (do_request(probe, type, &r, NULL) != 0 || !status_ok(type, r.status)) {
+                profile_errors++;
+                continue;
+            }
+            /* Async handlers free their request copy after the response */
+            usleep(1000);
+            size_t used = heap_trace_peak() - base;
+            if (used > peak[type]) {
+                peak[type] = used;
+            }
+        }
+    }
+    conn_close(probe);
+    usleep(200 * 1000);
+    long leak = (long)heap_trace_current() - (long)heap_before;
+
+    /* Report */
+    int rc = 0;
+    uint64_t total = 0, errors = profile_errors, busy = 0, reconnects = 0;
+    printf("%d clients, %.1f s%s\n", clients, elapsed_s, s_close_each ? ", connection per request" : "");
+    printf("%-11s %9s %7s %9s %8s %8s %8s %8s %10s\n",
+           "type", "requests", "errors", "req/s", "p50 ms", "p90 ms", "p99 ms", "max ms", "peak heap");
+    for (int m = 0; m < s_mix_len; m++) {
+        req_type_t type = s_mix[m];
+        samples_t all = {0};
+        for (int i = 0; i < clients; i++) {
+            samples_t *s = &cl[i].samples[type];
+            for (size_t k = 0; k < s->count; k++) {
+                samples_add(&all, s->us[k]);
+            }
+            all.errors += s->errors;
+        }
+        total += all.count;
+        errors += all.errors;
+        if (all.count == 0) {
+            printf("%-11s %9d %7u %9s\n", s_req_names[type], 0, all.errors, "-");
+            rc = 1;
+            continue;
+        }
+        qsort(all.us, all.count, sizeof(all.us[0]), cmp_u32);
+        double p99 = pct_ms(all.us, all.count, 99);
+        printf("%-11s %9zu %7u %9.1f %8.2f %8.2f %8.2f %8.2f %10zu\n", s_req_names[type],
+               all.count, all.errors, all.count / elapsed_s, pct_ms(all.us, all.count, 50),
+               pct_ms(all.us, all.count, 90), p99, all.us[all.count - 1] / 1000.0, peak[type]);
+        if (max_p99_ms > 0 && p99 > max_p99_ms) {
+            printf("FAIL: %s p99 %.2f ms exceeds %.2f ms\n", s_req_names[type], p99, max_p99_ms);
+            rc = 1;
+        }
+        if (max_heap > 0 && peak[type] > max_heap) {
+            printf("FAIL: %s needs %zu B of heap, limit %zu B\n", s_req_names[type], peak[type], max_heap);
+            rc = 1;
+        }
+        free(all.us);
+    }
+    for (int i = 0; i < clients; i++) {
+        busy += cl[i].busy;
+        reconnects += cl[i].reconnects;
+        for (int t = 0; t < REQ_TYPE_COUNT; t++) {
+            free(cl[i].samples[t].us);
+        }
+    }
+    printf("total: %.1f req/s, %llu errors, %llu answered 503, %llu reconnects after LRU purge\n",
+           total / elapsed_s, (unsigned long long)errors, (unsigned long long)busy,
+           (unsigned long long)reconnects);
+    printf("heap: %zu B live, %+ld B over %d profiled requests\n",
+           heap_trace_current(), leak, profile_runs * s_mix_len);
+    if (errors > 0) {
+        printf("FAIL: %llu requests failed or got an unexpected status\n", (unsigned long long)errors);
+        rc = 1;
+    }
+    if (max_leak >= 0 && leak > max_leak) {
+        printf("FAIL: heap grew by %ld B, limit %ld B\n", leak, max_leak);
+        rc = 1;
+    }
+
+    httpd_stop(server);
+    free(probe);
+    free(cl);
+    return rc;
+}
@@ -0,0 +1,813 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+
+#include "esp_log.h"
+#include "esp_http_server.h"
+
+static const char *TAG = "httpd-host";
+
+#define SESS_RBUF_SIZE      1024    /* request head plus pipelined bytes */
+#define MAX_RESP_HEADERS    16
+#define WORK_QUEUE_LEN      16
+
+int httpd_host_port_override = -1;
+
+typedef struct {
+    int fd;                 /* -1: slot free */
+    bool busy;              /* owned by an async request */
+    bool close_pending;
+    uint64_t lru;
+    size_t rstart;
+    size_t rlen;
+    char rbuf[SESS_RBUF_SIZE];
+} sess_t;
+
+typedef struct {
+    sess_t *sess;
+    char hdrs[HTTPD_MAX_REQ_HDR_LEN];   /* "Name: value\r\n" lines */
+    size_t remaining;                   /* body bytes not read yet */
+    bool keep_alive;
+    bool chunked;
+    bool detached;                      /* handed to httpd_req_async_handler_begin() */
+    const char *status;
+    const char *type;
+    int resp_hdr_count;
+    struct {
+        const char *field;
+        const char *value;
+    } resp_hdrs[MAX_RESP_HEADERS];
+} req_aux_t;
+
+typedef struct {
+    httpd_config_t config;
+    int listen_fd;
+    int ctrl[2];            /* wakes the server thread */
+    uint16_t port;
+    pthread_t thread;
+    volatile bool stop;
+
+    httpd_uri_t *handlers;
+    int handler_count;
+    sess_t *sessions;
+    uint64_t lru_counter;
+
+    pthread_mutex_t lock;   /* session busy/close flags, work queue */
+    struct {
+        httpd_work_fn_t fn;
+        void *arg;
+    } work[WORK_QUEUE_LEN];
+    int work_head;
+    int work_count;
+
+    /* The request being handled on the server thread */
+    httpd_req_t req;
+    req_aux_t aux;
+} httpd_data_t;
+
+static const struct {
+    const char *status;
+    const char *msg;
+} s_errors[HTTPD_ERR_CODE_MAX] = {
+    [HTTPD_500_INTERNAL_SERVER_ERROR]   = { "500 Internal Server Error", "Server has encountered an unexpected error" },
+    [HTTPD_501_METHOD_NOT_IMPLEMENTED]  = { "501 Method Not Implemented", "Request method is not supported by server" },
+    [HTTPD_505_VERSION_NOT_SUPPORTED]   = { "505 Version Not Supported", "HTTP version not supported by server" },
+    [HTTPD_400_BAD_REQUEST]             = { "400 Bad Request", "Bad request syntax" },
+    [HTTPD_401_UNAUTHORIZED]            = { "401 Unauthorized", "No permission -- see authorization schemes" },
+    [HTTPD_403_FORBIDDEN]               = { "403 Forbidden", "Request forbidden -- authorization will not help" },
+    [HTTPD_404_NOT_FOUND]               = { "404 Not Found", "Nothing matches the given URI" },
+    [HTTPD_405_METHOD_NOT_ALLOWED]      = { "405 Method Not Allowed", "Specified method is invalid for this resource" },
+    [HTTPD_408_REQ_TIMEOUT]             = { "408 Request Timeout", "Server closed this connection" },
+    [HTTPD_411_LENGTH_REQUIRED]         = { "411 Length Required", "Client must specify Content-Length" },
+    [HTTPD_414_URI_TOO_LONG]            = { "414 URI Too Long", "URI is too long" },
+    [HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE] = { "431 Request Header Fields Too Large", "Header fields are too long" },
+};
+
+const char *http_method_str(int method)
+{
+    switch (method) {
+    case HTTP_DELETE: return "DELETE";
+    case HTTP_GET:    return "GET";
+    case HTTP_HEAD:   return "HEAD";
+    case HTTP_POST:   return "POST";
+    case HTTP_PUT:    return "PUT";
+    default:          return "<unknown>";
+    }
+}
+
+static int method_from_str(const char *s, size_t len)
+{
+    for (int m = HTTP_DELETE; m <= HTTP_PUT; m++) {
+        if (strlen(http_method_str(m)) == len && strncmp(http_method_str(m), s, len) == 0) {
+            return m;
+        }
+    }
+    return -1;
+}
+
+/* Same rules as IDF: a trailing '*' matches any rest, a trailing '?'
+ * makes the character before it optional ("/path/?*" matches "/path",
+ * "/path/" and "/path/x") */
+bool httpd_uri_match_wildcard(const char *tpl, const char *uri, size_t len)
+{
+    size_t tpl_len = strlen(tpl);
+    bool asterisk = tpl_len > 0 && tpl[tpl_len - 1] == '*';
+    if (asterisk) {
+        tpl_len--;
+    }
+    bool quest = tpl_len > 0 && tpl[tpl_len - 1] == '?';
+    if (quest) {
+        tpl_len--;
+    }
+
+    if (!quest) {
+        if (asterisk) {
+            return len >= tpl_len && strncmp(tpl, uri, tpl_len) == 0;
+        }
+        return len == tpl_len && strncmp(tpl, uri, len) == 0;
+    }
+    /* Without the optional character: exact match only */
+    if (tpl_len > 0 && len == tpl_len - 1 && strncmp(tpl, uri, len) == 0) {
+        return true;
+    }
+    if (asterisk) {
+        return len >= tpl_len && strncmp(tpl, uri, tpl_len) == 0;
+    }
+    return len == tpl_len && strncmp(tpl, uri, len) == 0;
+}
+
+static void wake(httpd_data_t *hd)
+{
+    char c = 0;
+    if (write(hd->ctrl[1], &c, 1) < 0) {
+        ESP_LOGW(TAG, "Wake-up write failed: %s", strerror(errno));
+    }
+}
+
+static void sess_close(httpd_data_t *hd, sess_t *sess)
+{
+    (void)hd;
+    if (sess->fd >= 0) {
+        ESP_LOGD(TAG, "Closing socket %d", sess->fd);
+        close(sess->fd);
+    }
+    sess->fd = -1;
+    sess->busy = false;
+    sess->close_pending = false;
+    sess->rstart = 0;
+    sess->rlen = 0;
+}
+
+static esp_err_t send_all(int fd, const char *buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return ESP_ERR_HTTPD_RESP_SEND;
+        }
+        buf += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+/* Status line and headers; content_len < 0 starts a chunked response */
+static esp_err_t send_head(httpd_req_t *r, ssize_t content_len)
+{
+    req_aux_t *aux = r->aux;
+    char head[1024];
+    int n;
+
+    n = snprintf(head, sizeof(head), "HTTP/1.1 %s\r\nContent-Type: %s\r\n",
+                 aux->status, aux->type);
+    if (content_len < 0) {
+        n += snprintf(head + n, sizeof(head) - n, "Transfer-Encoding: chunked\r\n");
+    } else {
+        n += snprintf(head + n, sizeof(head) - n, "Content-Length: %zd\r\n", content_len);
+    }
+    for (int i = 0; i < aux->resp_hdr_count && n < (int)sizeof(head); i++) {
+        n += snprintf(head + n, sizeof(head) - n, "%s: %s\r\n",
+                      aux->resp_hdrs[i].field, aux->resp_hdrs[i].value);
+    }
+    if (n < (int)sizeof(head)) {
+        n += snprintf(head + n, sizeof(head) - n, "\r\n");
+    }
+    if (n >= (int)sizeof(head)) {
+        return ESP_ERR_HTTPD_RESP_HDR;
+    }
+    return send_all(aux->sess->fd, head, n);
+}
+
+esp_err_t httpd_resp_set_status(httpd_req_t *r, const char *status)
+{
+    ((req_aux_t *)r->aux)->status = status;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type)
+{
+    ((req_aux_t *)r->aux)->type = type;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *r, const char *field, const char *value)
+{
+    httpd_data_t *hd = r->handle;
+    req_aux_t *aux = r->aux;
+
+    if (aux->resp_hdr_count >= hd->config.max_resp_headers
+            || aux->resp_hdr_count >= MAX_RESP_HEADERS) {
+        return ESP_ERR_HTTPD_RESP_HDR;
+    }
+    aux->resp_hdrs[aux->resp_hdr_count].field = field;
+    aux->resp_hdrs[aux->resp_hdr_count].value = value;
+    aux->resp_hdr_count++;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
+{
+    req_aux_t *aux = r->aux;
+
+    if (buf == NULL) {
+        buf_len = 0;
+    } else if (buf_len == HTTPD_RESP_USE_STRLEN) {
+        buf_len = strlen(buf);
+    }
+    esp_err_t err = send_head(r, buf_len);
+    if (err == ESP_OK && buf_len > 0) {
+        err = send_all(aux->sess->fd, buf, buf_len);
+    }
+    return err;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len)
+{
+    req_aux_t *aux = r->aux;
+    char size[16];
+    esp_err_t err = ESP_OK;
+
+    if (buf == NULL) {
+        buf_len = 0;
+    } else if (buf_len == HTTPD_RESP_USE_STRLEN) {
+        buf_len = strlen(buf);
+    }
+    if (!aux->chunked) {
+        aux->chunked = true;
+        err = send_head(r, -1);
+    }
+    if (err == ESP_OK) {
+        int n = snprintf(size, sizeof(size), "%zx\r\n", buf_len);
+        err = send_all(aux->sess->fd, size, n);
+    }
+    if (err == ESP_OK && buf_len > 0) {
+        err = send_all(aux->sess->fd, buf, buf_len);
+    }
+    if (err == ESP_OK) {
+        err = send_all(aux->sess->fd, "\r\n", 2);
+    }
+    return err;
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *msg)
+{
+    if (error >= HTTPD_ERR_CODE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    httpd_resp_set_status(req, s_errors[error].status);
+    httpd_resp_set_type(req, "text/html");
+    return httpd_resp_sendstr(req, msg ? msg : s_errors[error].msg);
+}
+
+int httpd_req_recv(httpd_req_t *r, char *buf, size_t buf_len)
+{
+    req_aux_t *aux = r->aux;
+    sess_t *sess = aux->sess;
+    size_t want = buf_len < aux->remaining ? buf_len : aux->remaining;
+
+    if (want == 0) {
+        return 0;
+    }
+    if (sess->rlen > 0) {
+        size_t n = want < sess->rlen ? want : sess->rlen;
+        memcpy(buf, sess->rbuf + sess->rstart, n);
+        sess->rstart += n;
+        sess->rlen -= n;
+        aux->remaining -= n;
+        return n;
+    }
+    ssize_t n = recv(sess->fd, buf, want, 0);
+    if (n < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? HTTPD_SOCK_ERR_TIMEOUT
+                                                         : HTTPD_SOCK_ERR_FAIL;
+    }
+    aux->remaining -= n;
+    return n;
+}
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *r, const char *field, char *val, size_t val_size)
+{
+    req_aux_t *aux = r->aux;
+    size_t field_len = strlen(field);
+
+    for (const char *line = aux->hdrs; *line; ) {
+        const char *eol = strstr(line, "\r\n");
+        if (eol == NULL) {
+            break;
+        }
+        if ((size_t)(eol - line) > field_len && line[field_len] == ':'
+                && strncasecmp(line, field, field_len) == 0) {
+            const char *v = line + field_len + 1;
+            while (v < eol && (*v == ' ' || *v == '\t')) {
+                v++;
+            }
+            size_t len = eol - v;
+            if (val_size == 0) {
+                return ESP_ERR_HTTPD_RESULT_TRUNC;
+            }
+            size_t n = len < val_size - 1 ? len : val_size - 1;
+            memcpy(val, v, n);
+            val[n] = '\0';
+            return n < len ? ESP_ERR_HTTPD_RESULT_TRUNC : ESP_OK;
+        }
+        line = eol + 2;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+int httpd_req_to_sockfd(httpd_req_t *r)
+{
+    return ((req_aux_t *)r->aux)->sess->fd;
+}
+
+/* Drops what the handler left of the body so the next request starts at
+ * its own first byte */
+static bool purge_body(req_aux_t *aux)
+{
+    char buf[128];
+
+    while (aux->remaining > 0) {
+        int n = httpd_req_recv(&(httpd_req_t){ .aux = aux }, buf, sizeof(buf));
+        if (n <= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+esp_err_t httpd_req_async_handler_begin(httpd_req_t *r, httpd_req_t **out)
+{
+    httpd_data_t *hd = r->handle;
+    httpd_req_t *copy = malloc(sizeof(*copy));
+    req_aux_t *aux = malloc(sizeof(*aux));
+
+    if (copy == NULL || aux == NULL) {
+        free(copy);
+        free(aux);
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(copy, r, sizeof(*copy));
+    memcpy(aux, r->aux, sizeof(*aux));
+    copy->aux = aux;
+    ((req_aux_t *)r->aux)->detached = true;
+
+    pthread_mutex_lock(&hd->lock);
+    aux->sess->busy = true;
+    pthread_mutex_unlock(&hd->lock);
+    *out = copy;
+    return ESP_OK;
+}
+
+esp_err_t httpd_req_async_handler_complete(httpd_req_t *r)
+{
+    httpd_data_t *hd = r->handle;
+    req_aux_t *aux = r->aux;
+    sess_t *sess = aux->sess;
+
+    bool reuse = aux->keep_alive && purge_body(aux);
+
+    pthread_mutex_lock(&hd->lock);
+    if (!reuse || sess->close_pending) {
+        sess_close(hd, sess);
+    } else {
+        sess->busy = false;
+        sess->lru = ++hd->lru_counter;
+    }
+    pthread_mutex_unlock(&hd->lock);
+    wake(hd);
+
+    free(aux);
+    free(r);
+    return ESP_OK;
+}
+
+esp_err_t httpd_queue_work(httpd_handle_t handle, httpd_work_fn_t work, void *arg)
+{
+    httpd_data_t *hd = handle;
+    esp_err_t err = ESP_OK;
+
+    pthread_mutex_lock(&hd->lock);
+    if (hd->work_count == WORK_QUEUE_LEN) {
+        err = ESP_FAIL;
+    } else {
+        int i = (hd->work_head + hd->work_count++) % WORK_QUEUE_LEN;
+        hd->work[i].fn = work;
+        hd->work[i].arg = arg;
+    }
+    pthread_mutex_unlock(&hd->lock);
+    if (err == ESP_OK) {
+        wake(hd);
+    }
+    return err;
+}
+
+esp_err_t httpd_sess_trigger_close(httpd_handle_t handle, int sockfd)
+{
+    httpd_data_t *hd = handle;
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+
+    pthread_mutex_lock(&hd->lock);
+    for (int i = 0; i < hd->config.max_open_sockets; i++) {
+        if (hd->sessions[i].fd == sockfd) {
+            hd->sessions[i].close_pending = true;
+            err = ESP_OK;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&hd->lock);
+    if (err == ESP_OK) {
+        wake(hd);
+    }
+    return err;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler)
+{
+    httpd_data_t *hd = handle;
+
+    for (int i = 0; i < hd->handler_count; i++) {
+        if (hd->handlers[i].method == uri_handler->method
+                && strcmp(hd->handlers[i].uri, uri_handler->uri) == 0) {
+            return ESP_ERR_HTTPD_HANDLER_EXISTS;
+        }
+    }
+    if (hd->handler_count == hd->config.max_uri_handlers) {
+        return ESP_ERR_HTTPD_HANDLERS_FULL;
+    }
+    hd->handlers[hd->handler_count++] = *uri_handler;
+    return ESP_OK;
+}
+
+static const httpd_uri_t *find_handler(httpd_data_t *hd, const char *uri, int method,
+                                       httpd_err_code_t *err)
+{
+    size_t len = strcspn(uri, "?");
+
+    *err = HTTPD_404_NOT_FOUND;
+    for (int i = 0; i < hd->handler_count; i++) {
+        const httpd_uri_t *h = &hd->handlers[i];
+        bool match = hd->config.uri_match_fn
+                     ? hd->config.uri_match_fn(h->uri, uri, len)
+                     : (strlen(h->uri) == len && strncmp(h->uri, uri, len) == 0);
+        if (match) {
+            if ((int)h->method == method) {
+                return h;
+            }
+            *err = HTTPD_405_METHOD_NOT_ALLOWED;
+        }
+    }
+    return NULL;
+}
+
+/* Errors detected before any handler ran; the session is always closed
+ * since the rest of the request cannot be framed */
+static void reject(httpd_data_t *hd, httpd_err_code_t code)
+{
+    httpd_resp_send_err(&hd->req, code, NULL);
+    hd->aux.keep_alive = false;
+}
+
+/* Reads one request head from sess, runs its handler. Returns false if
+ * the session should be closed. */
+static bool handle_request(httpd_data_t *hd, sess_t *sess)
+{
+    httpd_req_t *req = &hd->req;
+    req_aux_t *aux = &hd->aux;
+    char *head, *end;
+
+    /* Complete head in the buffer, reading more as needed */
+    for (;;) {
+        head = sess->rbuf + sess->rstart;
+        end = sess->rlen >= 4 ? memmem(head, sess->rlen, "\r\n\r\n", 4) : NULL;
+        if (end) {
+            break;
+        }
+        if (sess->rstart > 0) {
+            memmove(sess->rbuf, head, sess->rlen);
+            sess->rstart = 0;
+        }
+        if (sess->rlen == sizeof(sess->rbuf)) {
+            ESP_LOGW(TAG, "Request head over %d bytes", SESS_RBUF_SIZE);
+            return false;
+        }
+        ssize_t n = recv(sess->fd, sess->rbuf + sess->rlen, sizeof(sess->rbuf) - sess->rlen, 0);
+        if (n <= 0) {
+            return false;
+        }
+        sess->rlen += n;
+    }
+    size_t head_len = end + 4 - head;
+
+    memset(req, 0, sizeof(*req));
+    memset(aux, 0, sizeof(*aux));
+    req->handle = hd;
+    req->aux = aux;
+    aux->sess = sess;
+    aux->status = "200 OK";
+    aux->type = "text/html";
+    aux->keep_alive = true;
+
+    /* Request line */
+    char *line_end = memmem(head, head_len, "\r\n", 2);
+    char *sp1 = memchr(head, ' ', line_end - head);
+    char *sp2 = sp1 ? memchr(sp1 + 1, ' ', line_end - sp1 - 1) : NULL;
+    sess->rstart += head_len;
+    sess->rlen -= head_len;
+    if (sp2 == NULL) {
+        reject(hd, HTTPD_400_BAD_REQUEST);
+        return false;
+    }
+    req->method = method_from_str(head, sp1 - head);
+    size_t uri_len = sp2 - sp1 - 1;
+    if (uri_len > HTTPD_MAX_URI_LEN) {
+        reject(hd, HTTPD_414_URI_TOO_LONG);
+        return false;
+    }
+    memcpy((char *)req->uri, sp1 + 1, uri_len);
+    if (line_end - sp2 - 1 == 8 && strncmp(sp2 + 1, "HTTP/1.0", 8) == 0) {
+        aux->keep_alive = false;
+    }
+
+    /* Header lines, kept for httpd_req_get_hdr_value_str() */
+    size_t hdrs_len = end + 2 - (line_end + 2);
+    if (hdrs_len >= sizeof(aux->hdrs)) {
+        reject(hd, HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE);
+        return false;
+    }
+    memcpy(aux->hdrs, line_end + 2, hdrs_len);
+    aux->hdrs[hdrs_len] = '\0';
+
+    char value[32];
+    if (httpd_req_get_hdr_value_str(req, "Content-Length", value, sizeof(value)) == ESP_OK) {
+        req->content_len = strtoul(value, NULL, 10);
+    }
+    aux->remaining = req->content_len;
+    if (httpd_req_get_hdr_value_str(req, "Connection", value, sizeof(value)) == ESP_OK
+            && strcasecmp(value, "close") == 0) {
+        aux->keep_alive = false;
+    }
+
+    httpd_err_code_t err_code;
+    const httpd_uri_t *h = find_handler(hd, req->uri, req->method, &err_code);
+    if (h == NULL) {
+        ESP_LOGD(TAG, "No handler for %s %s", http_method_str(req->method), req->uri);
+        httpd_resp_send_err(req, err_code, NULL);
+        return aux->keep_alive && purge_body(aux);
+    }
+
+    req->user_ctx = h->user_ctx;
+    esp_err_t ret = h->handler(req);
+
+    if (aux->detached) {
+        /* The async copy owns the socket now and may even be done with it */
+        return true;
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGD(TAG, "Handler for %s failed, closing session", req->uri);
+        return false;
+    }
+    return aux->keep_alive && purge_body(aux);
+}
+
+static void accept_session(httpd_data_t *hd)
+{
+    int fd = accept(hd->listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return;
+    }
+
+    sess_t *slot = NULL, *lru = NULL;
+    pthread_mutex_lock(&hd->lock);
+    for (int i = 0; i < hd->config.max_open_sockets; i++) {
+        sess_t *s = &hd->sessions[i];
+        if (s->fd < 0) {
+            slot = s;
+            break;
+        }
+        if (!s->busy && (lru == NULL || s->lru < lru->lru)) {
+            lru = s;
+        }
+    }
+    if (slot == NULL && hd->config.lru_purge_enable && lru) {
+        ESP_LOGD(TAG, "Purging LRU socket %d", lru->fd);
+        sess_close(hd, lru);
+        slot = lru;
+    }
+    if (slot) {
+        slot->fd = fd;
+        slot->lru = ++hd->lru_counter;
+    }
+    pthread_mutex_unlock(&hd->lock);
+
+    if (slot == NULL) {
+        ESP_LOGW(TAG, "No free session, dropping new connection");
+        close(fd);
+        return;
+    }
+    struct timeval rcv = { .tv_sec = hd->config.recv_wait_timeout };
+    struct timeval snd = { .tv_sec = hd->config.send_wait_timeout };
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &rcv, sizeof(rcv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &snd, sizeof(snd));
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+static void run_work(httpd_data_t *hd)
+{
+    for (;;) {
+        httpd_work_fn_t fn = NULL;
+        void *arg = NULL;
+
+        pthread_mutex_lock(&hd->lock);
+        if (hd->work_count > 0) {
+            fn = hd->work[hd->work_head].fn;
+            arg = hd->work[hd->work_head].arg;
+            hd->work_head = (hd->work_head + 1) % WORK_QUEUE_LEN;
+            hd->work_count--;
+        }
+        pthread_mutex_unlock(&hd->lock);
+        if (fn == NULL) {
+            return;
+        }
+        fn(arg);
+    }
+}
+
+static void *server_thread(void *arg)
+{
+    httpd_data_t *hd = arg;
+
+    while (!hd->stop) {
+        fd_set rfds;
+        int max_fd = hd->ctrl[0] > hd->listen_fd ? hd->ctrl[0] : hd->listen_fd;
+
+        FD_ZERO(&rfds);
+        FD_SET(hd->listen_fd, &rfds);
+        FD_SET(hd->ctrl[0], &rfds);
+        pthread_mutex_lock(&hd->lock);
+        for (int i = 0; i < hd->config.max_open_sockets; i++) {
+            sess_t *s = &hd->sessions[i];
+            if (s->fd >= 0 && !s->busy && s->close_pending) {
+                sess_close(hd, s);
+            }
+            if (s->fd >= 0 && !s->busy) {
+                FD_SET(s->fd, &rfds);
+                if (s->fd > max_fd) {
+                    max_fd = s->fd;
+                }
+            }
+        }
+        pthread_mutex_unlock(&hd->lock);
+
+        if (select(max_fd + 1, &rfds, NULL, NULL, NULL) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ESP_LOGE(TAG, "select: %s", strerror(errno));
+            break;
+        }
+
+        if (FD_ISSET(hd->ctrl[0], &rfds)) {
+            char drain[32];
+            if (read(hd->ctrl[0], drain, sizeof(drain)) < 0) {
+                ESP_LOGW(TAG, "Wake-up read failed: %s", strerror(errno));
+            }
+            run_work(hd);
+        }
+        for (int i = 0; i < hd->config.max_open_sockets; i++) {
+            sess_t *s = &hd->sessions[i];
+            if (s->fd < 0 || s->busy || !FD_ISSET(s->fd, &rfds)) {
+                continue;
+            }
+            /* Pipelined requests already buffered are served in a row */
+            do {
+                bool keep = handle_request(hd, s);
+                pthread_mutex_lock(&hd->lock);
+                if (!s->busy) {
+                    if (keep && !s->close_pending) {
+                        s->lru = ++hd->lru_counter;
+                    } else {
+                        sess_close(hd, s);
+                    }
+                }
+                pthread_mutex_unlock(&hd->lock);
+            } while (s->fd >= 0 && !s->busy && s->rlen > 0
+                     && memmem(s->rbuf + s->rstart, s->rlen, "\r\n\r\n", 4) != NULL);
+        }
+        if (FD_ISSET(hd->listen_fd, &rfds)) {
+            accept_session(hd);
+        }
+    }
+    return NULL;
+}
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config)
+{
+    struct sockaddr_in addr = { .sin_family = AF_INET };
+    socklen_t addr_len = sizeof(addr);
+    int one = 1;
+
+    httpd_data_t *hd = calloc(1, sizeof(*hd));
+    if (hd == NULL) {
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+    hd->config = *config;
+    hd->handlers = calloc(config->max_uri_handlers, sizeof(httpd_uri_t));
+    hd->sessions = calloc(config->max_open_sockets, sizeof(sess_t));
+    if (hd->handlers == NULL || hd->sessions == NULL) {
+        goto fail;
+    }
+    for (int i = 0; i < config->max_open_sockets; i++) {
+        hd->sessions[i].fd = -1;
+    }
+    pthread_mutex_init(&hd->lock, NULL);
+
+    hd->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (hd->listen_fd < 0 || pipe(hd->ctrl) != 0) {
+        goto fail;
+    }
+    setsockopt(hd->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    /* Loopback only: the host build is for tests, not for serving */
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(httpd_host_port_override >= 0 ? httpd_host_port_override
+                                                       : config->server_port);
+    if (bind(hd->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0
+            || listen(hd->listen_fd, config->backlog_conn) != 0
+            || getsockname(hd->listen_fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+        ESP_LOGE(TAG, "Cannot listen on port %d: %s", ntohs(addr.sin_port), strerror(errno));
+        goto fail;
+    }
+    hd->port = ntohs(addr.sin_port);
+
+    if (pthread_create(&hd->thread, NULL, server_thread, hd) != 0) {
+        goto fail;
+    }
+    ESP_LOGI(TAG, "Listening on 127.0.0.1:%u", hd->port);
+    *handle = hd;
+    return ESP_OK;
+
+fail:
+    if (hd->listen_fd > 0) {
+        close(hd->listen_fd);
+    }
+    free(hd->handlers);
+    free(hd->sessions);
+    free(hd);
+    return ESP_ERR_HTTPD_TASK;
+}
+
+/* Async requests still running must have completed before this */
+esp_err_t httpd_stop(httpd_handle_t handle)
+{
+    httpd_data_t *hd = handle;
+
+    hd->stop = true;
+    wake(hd);
+    pthread_join(hd->thread, NULL);
+    for (int i = 0; i < hd->config.max_open_sockets; i++) {
+        sess_close(hd, &hd->sessions[i]);
+    }
+    close(hd->listen_fd);
+    close(hd->ctrl[0]);
+    close(hd->ctrl[1]);
+    free(hd->handlers);
+    free(hd->sessions);
+    free(hd);
+    return ESP_OK;
+}
+
+uint16_t httpd_host_port(httpd_handle_t handle)
+{
+    return ((httpd_data_t *)handle)->port;
+}
@@ -0,0 +1,27 @@
+#ifndef _HOST_ESP_NETIF_H_
+#define _HOST_ESP_NETIF_H_
+
+#include <stdbool.h>
+#include "esp_event.h"
+#include "esp_netif_ip_addr.h"
+
+extern esp_event_base_t const IP_EVENT;
+
+typedef enum {
+    IP_EVENT_STA_GOT_IP,
+    IP_EVENT_STA_LOST_IP,
+} ip_event_t;
+
+typedef struct {
+    esp_ip4_addr_t ip;
+    esp_ip4_addr_t netmask;
+    esp_ip4_addr_t gw;
+} esp_netif_ip_info_t;
+
+typedef struct {
+    void *esp_netif;
+    esp_netif_ip_info_t ip_info;
+    bool ip_changed;
+} ip_event_got_ip_t;
+
+#endif
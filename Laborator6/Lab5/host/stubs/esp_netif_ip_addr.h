@@ -0,0 +1,16 @@
+#ifndef _HOST_ESP_NETIF_IP_ADDR_H_
+#define _HOST_ESP_NETIF_IP_ADDR_H_
+
+#include <stdint.h>
+
+/* Network byte order, as in lwIP */
+typedef struct {
+    uint32_t addr;
+} esp_ip4_addr_t;
+
+#define esp_ip4_addr_get_byte(ipaddr, idx) (((const uint8_t *)(&(ipaddr)->addr))[idx])
+#define IP2STR(ipaddr) esp_ip4_addr_get_byte(ipaddr, 0), esp_ip4_addr_get_byte(ipaddr, 1), \
+                       esp_ip4_addr_get_byte(ipaddr, 2), esp_ip4_addr_get_byte(ipaddr, 3)
+#define IPSTR "%d.%d.%d.%d"
+
+#endif
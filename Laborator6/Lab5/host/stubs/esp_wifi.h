@@ -0,0 +1,28 @@
+#ifndef _HOST_ESP_WIFI_H_
+#define _HOST_ESP_WIFI_H_
+
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_wifi_types.h"
+
+extern esp_event_base_t const WIFI_EVENT;
+
+typedef enum {
+    WIFI_EVENT_SCAN_DONE = 1,
+    WIFI_EVENT_STA_START,
+    WIFI_EVENT_STA_STOP,
+    WIFI_EVENT_STA_CONNECTED,
+    WIFI_EVENT_STA_DISCONNECTED,
+} wifi_event_t;
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *conf);
+esp_err_t esp_wifi_connect(void);
+esp_err_t esp_wifi_disconnect(void);
+
+/* Host only: the one network the simulated radio can join. Connecting to
+ * it with pass succeeds after connect_ms, a wrong key fails with
+ * WIFI_REASON_AUTH_FAIL and any other SSID with WIFI_REASON_NO_AP_FOUND. */
+void esp_wifi_sim_set_network(const char *ssid, const char *pass, int connect_ms);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef _HOST_FREERTOS_H_
+#define _HOST_FREERTOS_H_
+
+/* Just enough of FreeRTOS on top of pthreads for the web server sources.
+ * One tick is one millisecond. */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              1
+#define pdFAIL              0
+#define portMAX_DELAY       ((TickType_t)0xffffffffu)
+#define configTICK_RATE_HZ  1000
+#define portTICK_PERIOD_MS  1
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+#define portNUM_PROCESSORS  2
+#define tskNO_AFFINITY      0x7fffffff
+#define tskIDLE_PRIORITY    0
+
+#define IRAM_ATTR
+#define portYIELD_FROM_ISR(x) ((void)(x))
+
+/* Spinlocks become one process-wide mutex per portMUX_TYPE */
+typedef struct {
+    pthread_mutex_t mutex;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { PTHREAD_MUTEX_INITIALIZER }
+#define portENTER_CRITICAL(mux)      pthread_mutex_lock(&(mux)->mutex)
+#define portEXIT_CRITICAL(mux)       pthread_mutex_unlock(&(mux)->mutex)
+
+#endif
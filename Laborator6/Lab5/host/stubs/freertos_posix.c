@@ -0,0 +1,264 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+struct host_task {
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *arg;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify;
+};
+
+struct host_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t *items;
+};
+
+struct host_mutex {
+    pthread_mutex_t lock;
+};
+
+static __thread struct host_task *s_current;
+
+/* Absolute CLOCK_REALTIME deadline for pthread timed waits, or NULL */
+static const struct timespec *deadline(TickType_t ticks, struct timespec *ts)
+{
+    if (ticks == portMAX_DELAY) {
+        return NULL;
+    }
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec += ticks / 1000;
+    ts->tv_nsec += (long)(ticks % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
+/* Waits on cond until pred() or the deadline; returns false on timeout */
+#define WAIT_UNTIL(cond, lock, abs, pred) ({                                    \
+        bool ok_ = true;                                                        \
+        while (!(pred)) {                                                       \
+            int rc_ = (abs) ? pthread_cond_timedwait(cond, lock, abs)           \
+                            : pthread_cond_wait(cond, lock);                    \
+            if (rc_ == ETIMEDOUT && !(pred)) {                                  \
+                ok_ = false;                                                    \
+                break;                                                          \
+            }                                                                   \
+        }                                                                       \
+        ok_;                                                                    \
+    })
+
+static void *task_main(void *arg)
+{
+    struct host_task *task = arg;
+    s_current = task;
+    task->fn(task->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_size,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core_id)
+{
+    (void)name;
+    (void)stack_size;
+    (void)priority;
+    (void)core_id;
+
+    struct host_task *task = calloc(1, sizeof(*task));
+    if (task == NULL) {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    pthread_mutex_init(&task->lock, NULL);
+    pthread_cond_init(&task->cond, NULL);
+    if (pthread_create(&task->thread, NULL, task_main, task) != 0) {
+        free(task);
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+    if (handle) {
+        *handle = task;
+    }
+    return pdPASS;
+}
+
+/* Only self-deletion is supported; the task struct is kept because
+ * others may still hold the handle */
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == NULL || task == s_current) {
+        pthread_exit(NULL);
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec ts = { .tv_sec = ticks / 1000, .tv_nsec = (long)(ticks % 1000) * 1000000 };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (TickType_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+void xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->lock);
+    task->notify++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+    xTaskNotifyGive(task);
+    if (woken) {
+        *woken = pdFALSE;
+    }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    struct host_task *task = s_current;
+    struct timespec ts;
+    const struct timespec *abs = deadline(ticks, &ts);
+    uint32_t value = 0;
+
+    if (task == NULL) {
+        vTaskDelay(ticks == portMAX_DELAY ? 1000 : ticks);
+        return 0;
+    }
+    pthread_mutex_lock(&task->lock);
+    if (WAIT_UNTIL(&task->cond, &task->lock, abs, task->notify > 0)) {
+        value = task->notify;
+        task->notify = clear_on_exit ? 0 : task->notify - 1;
+    }
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct host_queue *q = calloc(1, sizeof(*q));
+    if (q == NULL) {
+        return NULL;
+    }
+    q->items = malloc((size_t)length * item_size);
+    if (q->items == NULL) {
+        free(q);
+        return NULL;
+    }
+    q->length = length;
+    q->item_size = item_size;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    pthread_cond_init(&q->not_full, NULL);
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t q)
+{
+    free(q->items);
+    free(q);
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks)
+{
+    struct timespec ts;
+    const struct timespec *abs = deadline(ticks, &ts);
+    BaseType_t ret = pdFALSE;
+
+    pthread_mutex_lock(&q->lock);
+    if (ticks == 0 ? q->count < q->length
+                   : WAIT_UNTIL(&q->not_full, &q->lock, abs, q->count < q->length)) {
+        UBaseType_t tail = (q->head + q->count) % q->length;
+        memcpy(q->items + (size_t)tail * q->item_size, item, q->item_size);
+        q->count++;
+        pthread_cond_signal(&q->not_empty);
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ret;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks)
+{
+    struct timespec ts;
+    const struct timespec *abs = deadline(ticks, &ts);
+    BaseType_t ret = pdFALSE;
+
+    pthread_mutex_lock(&q->lock);
+    if (ticks == 0 ? q->count > 0
+                   : WAIT_UNTIL(&q->not_empty, &q->lock, abs, q->count > 0)) {
+        memcpy(item, q->items + (size_t)q->head * q->item_size, q->item_size);
+        q->head = (q->head + 1) % q->length;
+        q->count--;
+        pthread_cond_signal(&q->not_full);
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ret;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    pthread_mutex_lock(&q->lock);
+    UBaseType_t n = q->count;
+    pthread_mutex_unlock(&q->lock);
+    return n;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q)
+{
+    pthread_mutex_lock(&q->lock);
+    UBaseType_t n = q->length - q->count;
+    pthread_mutex_unlock(&q->lock);
+    return n;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    struct host_mutex *m = calloc(1, sizeof(*m));
+    if (m) {
+        pthread_mutex_init(&m->lock, NULL);
+    }
+    return m;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t m, TickType_t ticks)
+{
+    struct timespec ts;
+    const struct timespec *abs = deadline(ticks, &ts);
+
+    if (abs == NULL) {
+        return pthread_mutex_lock(&m->lock) == 0 ? pdTRUE : pdFALSE;
+    }
+    return pthread_mutex_timedlock(&m->lock, abs) == 0 ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t m)
+{
+    return pthread_mutex_unlock(&m->lock) == 0 ? pdTRUE : pdFALSE;
+}
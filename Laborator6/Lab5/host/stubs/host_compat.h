@@ -0,0 +1,11 @@
+#ifndef _HOST_COMPAT_H_
+#define _HOST_COMPAT_H_
+
+/* Force-included into every host source: newlib functions the firmware
+ * uses that glibc before 2.38 does not have */
+
+#include <stddef.h>
+
+size_t strlcpy(char *dst, const char *src, size_t size);
+
+#endif
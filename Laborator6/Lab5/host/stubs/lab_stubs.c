@@ -0,0 +1,19 @@
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#include "file-server.h"
+#include "ws-server.h"
+
+/* file-server.c needs SPIFFS and ws-server.c the WebSocket transport,
+ * neither of which the host build has */
+
+esp_err_t file_server_get_handler(httpd_req_t *req)
+{
+    return httpd_resp_send_404(req);
+}
+
+esp_err_t ws_server_register(httpd_handle_t server)
+{
+    (void)server;
+    return ESP_OK;
+}
@@ -0,0 +1,3 @@
+#ifndef _HOST_LWIP_ERR_H_
+#define _HOST_LWIP_ERR_H_
+#endif
@@ -0,0 +1,11 @@
+#ifndef _HOST_NVS_FLASH_H_
+#define _HOST_NVS_FLASH_H_
+
+#include "nvs.h"
+
+static inline esp_err_t nvs_flash_init(void)
+{
+    return ESP_OK;
+}
+
+#endif
@@ -0,0 +1,178 @@
+#include <string.h>
+#include <pthread.h>
+
+#include "nvs.h"
+
+#define NVS_RAM_MAX_ENTRIES 32
+#define NVS_RAM_MAX_HANDLES 8
+
+typedef struct {
+    char ns[16];
+    char key[16];
+    bool is_str;
+    int32_t i32;
+    char str[96];
+} entry_t;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static entry_t s_entries[NVS_RAM_MAX_ENTRIES];
+static int s_count;
+static struct {
+    bool open;
+    bool writable;
+    char ns[16];
+} s_handles[NVS_RAM_MAX_HANDLES];
+
+static bool ns_exists(const char *ns)
+{
+    for (int i = 0; i < s_count; i++) {
+        if (strcmp(s_entries[i].ns, ns) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Handles are 1-based indices into s_handles */
+static const char *handle_ns(nvs_handle_t handle, bool write)
+{
+    if (handle == 0 || handle > NVS_RAM_MAX_HANDLES || !s_handles[handle - 1].open
+            || (write && !s_handles[handle - 1].writable)) {
+        return NULL;
+    }
+    return s_handles[handle - 1].ns;
+}
+
+static entry_t *find(const char *ns, const char *key, bool create)
+{
+    for (int i = 0; i < s_count; i++) {
+        if (strcmp(s_entries[i].ns, ns) == 0 && strcmp(s_entries[i].key, key) == 0) {
+            return &s_entries[i];
+        }
+    }
+    if (!create || s_count == NVS_RAM_MAX_ENTRIES) {
+        return NULL;
+    }
+    entry_t *e = &s_entries[s_count++];
+    memset(e, 0, sizeof(*e));
+    strncpy(e->ns, ns, sizeof(e->ns) - 1);
+    strncpy(e->key, key, sizeof(e->key) - 1);
+    return e;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *out_handle)
+{
+    esp_err_t err = ESP_ERR_NO_MEM;
+
+    if (strlen(name) >= sizeof(s_handles[0].ns)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_lock);
+    if (mode == NVS_READONLY && !ns_exists(name)) {
+        err = ESP_ERR_NVS_NOT_FOUND;
+    } else {
+        for (int i = 0; i < NVS_RAM_MAX_HANDLES; i++) {
+            if (!s_handles[i].open) {
+                s_handles[i].open = true;
+                s_handles[i].writable = mode == NVS_READWRITE;
+                strcpy(s_handles[i].ns, name);
+                *out_handle = i + 1;
+                err = ESP_OK;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    return err;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    pthread_mutex_lock(&s_lock);
+    if (handle_ns(handle, false)) {
+        s_handles[handle - 1].open = false;
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    return handle_ns(handle, false) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value)
+{
+    esp_err_t err = ESP_OK;
+
+    if (strlen(value) >= sizeof(s_entries[0].str)) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    pthread_mutex_lock(&s_lock);
+    const char *ns = handle_ns(handle, true);
+    entry_t *e = ns ? find(ns, key, true) : NULL;
+    if (e) {
+        e->is_str = true;
+        strcpy(e->str, value);
+    } else {
+        err = ns ? ESP_ERR_NO_MEM : ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return err;
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out_value, size_t *length)
+{
+    esp_err_t err = ESP_OK;
+
+    pthread_mutex_lock(&s_lock);
+    const char *ns = handle_ns(handle, false);
+    entry_t *e = ns ? find(ns, key, false) : NULL;
+    if (e == NULL || !e->is_str) {
+        err = ns ? ESP_ERR_NVS_NOT_FOUND : ESP_ERR_INVALID_ARG;
+    } else {
+        size_t need = strlen(e->str) + 1;
+        if (out_value == NULL) {
+            *length = need;
+        } else if (*length < need) {
+            err = ESP_ERR_NVS_INVALID_LENGTH;
+        } else {
+            memcpy(out_value, e->str, need);
+            *length = need;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    return err;
+}
+
+esp_err_t nvs_set_i32(nvs_handle_t handle, const char *key, int32_t value)
+{
+    esp_err_t err = ESP_OK;
+
+    pthread_mutex_lock(&s_lock);
+    const char *ns = handle_ns(handle, true);
+    entry_t *e = ns ? find(ns, key, true) : NULL;
+    if (e) {
+        e->is_str = false;
+        e->i32 = value;
+    } else {
+        err = ns ? ESP_ERR_NO_MEM : ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return err;
+}
+
+esp_err_t nvs_get_i32(nvs_handle_t handle, const char *key, int32_t *out_value)
+{
+    esp_err_t err = ESP_OK;
+
+    pthread_mutex_lock(&s_lock);
+    const char *ns = handle_ns(handle, false);
+    entry_t *e = ns ? find(ns, key, false) : NULL;
+    if (e == NULL || e->is_str) {
+        err = ns ? ESP_ERR_NVS_NOT_FOUND : ESP_ERR_INVALID_ARG;
+    } else {
+        *out_value = e->i32;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return err;
+}
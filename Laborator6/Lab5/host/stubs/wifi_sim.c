@@ -0,0 +1,204 @@
+#include <string.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_event.h"
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+
+#include "soft-ap.h"
+
+/* Simulated radio for the host build: events are raised from a short-lived
+ * thread after the configured connect time, like the real driver does from
+ * its own task */
+
+static const char *TAG = "wifi-sim";
+
+esp_event_base_t const WIFI_EVENT = "WIFI_EVENT";
+esp_event_base_t const IP_EVENT = "IP_EVENT";
+
+#define MAX_HANDLERS 8
+
+typedef struct {
+    esp_event_base_t base;
+    int32_t id;
+    esp_event_handler_t handler;
+    void *arg;
+} handler_t;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static handler_t s_handlers[MAX_HANDLERS];
+static int s_handler_count;
+
+static char s_net_ssid[33] = "lab-iot";
+static char s_net_pass[65] = "IoT-IoT-IoT";
+static int s_connect_ms = 30;
+
+static wifi_config_t s_sta;
+static bool s_connected;
+static unsigned s_attempt;      /* bumped to cancel a pending connect */
+
+static const struct {
+    const char *ssid;
+    int8_t rssi;
+    uint8_t channel;
+    wifi_auth_mode_t authmode;
+} s_scan_list[] = {
+    { "lab-iot",            -48, 6,  WIFI_AUTH_WPA2_PSK },
+    { "eduroam",            -61, 1,  WIFI_AUTH_WPA2_ENTERPRISE },
+    { "Guest <open>",       -70, 11, WIFI_AUTH_OPEN },
+    { "Tom & Jerry's \"AP\"", -77, 3, WIFI_AUTH_WPA_WPA2_PSK },
+    { "DIRECT-42-Printer",  -83, 6,  WIFI_AUTH_WPA2_PSK },
+};
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t base, int32_t id,
+                                              esp_event_handler_t handler, void *arg,
+                                              esp_event_handler_instance_t *instance)
+{
+    pthread_mutex_lock(&s_lock);
+    if (s_handler_count == MAX_HANDLERS) {
+        pthread_mutex_unlock(&s_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    s_handlers[s_handler_count++] = (handler_t){ base, id, handler, arg };
+    pthread_mutex_unlock(&s_lock);
+    if (instance) {
+        *instance = &s_handlers[s_handler_count - 1];
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_event_post(esp_event_base_t base, int32_t id, const void *data,
+                         size_t size, uint32_t ticks)
+{
+    handler_t handlers[MAX_HANDLERS];
+    int n;
+
+    (void)size;
+    (void)ticks;
+    pthread_mutex_lock(&s_lock);
+    n = s_handler_count;
+    memcpy(handlers, s_handlers, sizeof(handlers));
+    pthread_mutex_unlock(&s_lock);
+
+    for (int i = 0; i < n; i++) {
+        if (handlers[i].base == base && (handlers[i].id == id || handlers[i].id == ESP_EVENT_ANY_ID)) {
+            handlers[i].handler(handlers[i].arg, base, id, (void *)data);
+        }
+    }
+    return ESP_OK;
+}
+
+void esp_wifi_sim_set_network(const char *ssid, const char *pass, int connect_ms)
+{
+    pthread_mutex_lock(&s_lock);
+    strncpy(s_net_ssid, ssid, sizeof(s_net_ssid) - 1);
+    strncpy(s_net_pass, pass, sizeof(s_net_pass) - 1);
+    s_connect_ms = connect_ms;
+    pthread_mutex_unlock(&s_lock);
+}
+
+static void *connect_thread(void *arg)
+{
+    unsigned attempt = (unsigned)(uintptr_t)arg;
+    bool ssid_ok, pass_ok;
+
+    vTaskDelay(pdMS_TO_TICKS(s_connect_ms));
+
+    pthread_mutex_lock(&s_lock);
+    if (attempt != s_attempt) {
+        pthread_mutex_unlock(&s_lock);
+        return NULL;
+    }
+    ssid_ok = strncmp((const char *)s_sta.sta.ssid, s_net_ssid, sizeof(s_sta.sta.ssid)) == 0;
+    pass_ok = strncmp((const char *)s_sta.sta.password, s_net_pass, sizeof(s_sta.sta.password)) == 0;
+    s_connected = ssid_ok && pass_ok;
+    pthread_mutex_unlock(&s_lock);
+
+    if (ssid_ok && pass_ok) {
+        ip_event_got_ip_t got_ip = {0};
+        inet_pton(AF_INET, "192.168.1.57", &got_ip.ip_info.ip.addr);
+        ESP_LOGI(TAG, "Connected to %s", s_net_ssid);
+        esp_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &got_ip, sizeof(got_ip), 0);
+    } else {
+        wifi_event_sta_disconnected_t ev = {
+            .reason = ssid_ok ? WIFI_REASON_AUTH_FAIL : WIFI_REASON_NO_AP_FOUND,
+        };
+        esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &ev, sizeof(ev), 0);
+    }
+    return NULL;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode)
+{
+    ESP_LOGD(TAG, "Mode %d", mode);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *conf)
+{
+    if (interface != WIFI_IF_STA) {
+        return ESP_OK;
+    }
+    pthread_mutex_lock(&s_lock);
+    s_sta = *conf;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_connect(void)
+{
+    pthread_t thread;
+
+    pthread_mutex_lock(&s_lock);
+    unsigned attempt = ++s_attempt;
+    pthread_mutex_unlock(&s_lock);
+    if (pthread_create(&thread, NULL, connect_thread, (void *)(uintptr_t)attempt) != 0) {
+        return ESP_ERR_NO_MEM;
+    }
+    pthread_detach(thread);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_disconnect(void)
+{
+    pthread_mutex_lock(&s_lock);
+    bool was_connected = s_connected;
+    s_connected = false;
+    s_attempt++;
+    pthread_mutex_unlock(&s_lock);
+
+    if (was_connected) {
+        wifi_event_sta_disconnected_t ev = { .reason = WIFI_REASON_ASSOC_LEAVE };
+        esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &ev, sizeof(ev), 0);
+    }
+    return ESP_OK;
+}
+
+void wifi_scan_start(void)
+{
+}
+
+void wifi_scan_stop(void)
+{
+}
+
+int wifi_scan_get_cached(scan_entry_t *entries, int max_entries)
+{
+    int n = 0;
+    int64_t now = esp_timer_get_time();
+
+    for (size_t i = 0; i < sizeof(s_scan_list) / sizeof(s_scan_list[0]) && n < max_entries; i++, n++) {
+        strncpy(entries[n].ssid, s_scan_list[i].ssid, sizeof(entries[n].ssid) - 1);
+        entries[n].ssid[sizeof(entries[n].ssid) - 1] = '\0';
+        entries[n].rssi = s_scan_list[i].rssi;
+        entries[n].channel = s_scan_list[i].channel;
+        entries[n].authmode = s_scan_list[i].authmode;
+        entries[n].last_seen_us = now;
+    }
+    return n;
+}
@@ -0,0 +1,249 @@
+#include <string.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "esp_http_server.h"
+
+#include "async-pool.h"
+
+static const char *TAG = "async-pool";
+
+typedef struct {
+    uint32_t requests;
+    uint32_t rejected;          /* queue full, answered 503 */
+    uint32_t errors;            /* handler returned an error */
+    uint64_t wait_us_total;     /* time spent in the queue */
+    uint32_t wait_us_max;
+    uint64_t run_us_total;      /* time spent in the handler */
+    uint32_t run_us_max;
+} route_stats_t;
+
+typedef struct {
+    const char *uri;
+    httpd_method_t method;
+    esp_err_t (*handler)(httpd_req_t *r);
+    void *user_ctx;
+    bool slow;
+    route_stats_t stats;
+} route_t;
+
+typedef struct {
+    httpd_req_t *req;           /* copy from httpd_req_async_handler_begin() */
+    route_t *route;
+    int64_t t_queued;
+} job_t;
+
+static route_t s_routes[ASYNC_POOL_MAX_ROUTES];
+static int s_route_count;
+static QueueHandle_t s_jobs;
+static portMUX_TYPE s_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+static int s_busy_workers;
+static int s_queue_high_water;
+
+static void record(route_t *route, int64_t wait_us, int64_t run_us, esp_err_t ret)
+{
+    route_stats_t *st = &route->stats;
+
+    portENTER_CRITICAL(&s_stats_mux);
+    st->requests++;
+    if (ret != ESP_OK) {
+        st->errors++;
+    }
+    st->wait_us_total += wait_us;
+    if (wait_us > st->wait_us_max) {
+        st->wait_us_max = wait_us;
+    }
+    st->run_us_total += run_us;
+    if (run_us > st->run_us_max) {
+        st->run_us_max = run_us;
+    }
+    portEXIT_CRITICAL(&s_stats_mux);
+}
+
+static void worker_task(void *arg)
+{
+    job_t job;
+
+    for (;;) {
+        if (xQueueReceive(s_jobs, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        portENTER_CRITICAL(&s_stats_mux);
+        s_busy_workers++;
+        portEXIT_CRITICAL(&s_stats_mux);
+
+        int64_t t_start = esp_timer_get_time();
+        job.req->user_ctx = job.route->user_ctx;
+        esp_err_t ret = job.route->handler(job.req);
+        record(job.route, t_start - job.t_queued, esp_timer_get_time() - t_start, ret);
+
+        if (ret != ESP_OK) {
+            /* Same as returning an error from a normal handler */
+            httpd_sess_trigger_close(job.req->handle, httpd_req_to_sockfd(job.req));
+        }
+        httpd_req_async_handler_complete(job.req);
+
+        portENTER_CRITICAL(&s_stats_mux);
+        s_busy_workers--;
+        portEXIT_CRITICAL(&s_stats_mux);
+    }
+}
+
+/* Runs on the httpd task for every route */
+static esp_err_t run_route(httpd_req_t *req, route_t *route)
+{
+    if (!route->slow) {
+        int64_t t_start = esp_timer_get_time();
+        req->user_ctx = route->user_ctx;
+        esp_err_t ret = route->handler(req);
+        record(route, 0, esp_timer_get_time() - t_start, ret);
+        return ret;
+    }
+
+    /* Only this task enqueues, so a free slot cannot disappear before
+     * the send below */
+    if (uxQueueSpacesAvailable(s_jobs) == 0) {
+        portENTER_CRITICAL(&s_stats_mux);
+        route->stats.rejected++;
+        portEXIT_CRITICAL(&s_stats_mux);
+        ESP_LOGW(TAG, "Queue full, rejecting %s", req->uri);
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "1");
+        httpd_resp_sendstr(req, "Busy, try again");
+        return ESP_OK;
+    }
+
+    job_t job = { .route = route, .t_queued = esp_timer_get_time() };
+    esp_err_t err = httpd_req_async_handler_begin(req, &job.req);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "async_handler_begin: %s", esp_err_to_name(err));
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+    xQueueSend(s_jobs, &job, 0);
+
+    int depth = uxQueueMessagesWaiting(s_jobs);
+    portENTER_CRITICAL(&s_stats_mux);
+    if (depth > s_queue_high_water) {
+        s_queue_high_water = depth;
+    }
+    portEXIT_CRITICAL(&s_stats_mux);
+    return ESP_OK;
+}
+
+/* Handler of the routes registered through async_pool_register() */
+static esp_err_t dispatch(httpd_req_t *req)
+{
+    return run_route(req, req->user_ctx);
+}
+
+esp_err_t async_pool_start(void)
+{
+    if (s_jobs != NULL) {
+        return ESP_OK;
+    }
+    s_jobs = xQueueCreate(ASYNC_POOL_QUEUE_LEN, sizeof(job_t));
+    if (s_jobs == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < ASYNC_POOL_WORKERS; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "httpd_async%d", i);
+        if (xTaskCreatePinnedToCore(worker_task, name, ASYNC_POOL_STACK_SIZE, NULL,
+                                    ASYNC_POOL_PRIORITY, NULL, i % portNUM_PROCESSORS) != pdPASS) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    ESP_LOGI(TAG, "%d workers, queue of %d", ASYNC_POOL_WORKERS, ASYNC_POOL_QUEUE_LEN);
+    return ESP_OK;
+}
+
+esp_err_t async_pool_add_route(const httpd_uri_t *uri, bool slow, int *route_id)
+{
+    if (s_route_count >= ASYNC_POOL_MAX_ROUTES) {
+        ESP_LOGE(TAG, "No room for route %s, raise ASYNC_POOL_EXTRA_ROUTES", uri->uri);
+        return ESP_ERR_NO_MEM;
+    }
+    if (slow && s_jobs == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    route_t *route = &s_routes[s_route_count];
+    route->uri = uri->uri;
+    route->method = uri->method;
+    route->handler = uri->handler;
+    route->user_ctx = uri->user_ctx;
+    route->slow = slow;
+    *route_id = s_route_count++;
+    return ESP_OK;
+}
+
+esp_err_t async_pool_dispatch(httpd_req_t *req, int route_id)
+{
+    return run_route(req, &s_routes[route_id]);
+}
+
+esp_err_t async_pool_register(httpd_handle_t server, const httpd_uri_t *uri, bool slow)
+{
+    int id;
+    esp_err_t err = async_pool_add_route(uri, slow, &id);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    httpd_uri_t wrapped = *uri;
+    wrapped.handler = dispatch;
+    wrapped.user_ctx = &s_routes[id];
+    err = httpd_register_uri_handler(server, &wrapped);
+    if (err != ESP_OK) {
+        /* Give the slot back */
+        s_route_count--;
+    }
+    return err;
+}
+
+esp_err_t async_pool_metrics_handler(httpd_req_t *req)
+{
+    char buf[256];
+    route_stats_t st;
+    int busy, high_water;
+
+    portENTER_CRITICAL(&s_stats_mux);
+    busy = s_busy_workers;
+    high_water = s_queue_high_water;
+    portEXIT_CRITICAL(&s_stats_mux);
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    snprintf(buf, sizeof(buf),
+             "{\"workers\":%d,\"busy\":%d,\"queue\":%d,\"queue_max\":%d,\"queue_len\":%d,\"routes\":[",
+             ASYNC_POOL_WORKERS, busy, s_jobs ? (int)uxQueueMessagesWaiting(s_jobs) : 0,
+             high_water, ASYNC_POOL_QUEUE_LEN);
+    httpd_resp_sendstr_chunk(req, buf);
+
+    for (int i = 0; i < s_route_count; i++) {
+        route_t *route = &s_routes[i];
+        portENTER_CRITICAL(&s_stats_mux);
+        st = route->stats;
+        portEXIT_CRITICAL(&s_stats_mux);
+
+        uint32_t n = st.requests ? st.requests : 1;
+        snprintf(buf, sizeof(buf),
+                 "%s{\"uri\":\"%s\",\"method\":\"%s\",\"async\":%s,\"requests\":%" PRIu32
+                 ",\"rejected\":%" PRIu32 ",\"errors\":%" PRIu32
+                 ",\"wait_avg_us\":%" PRIu32 ",\"wait_max_us\":%" PRIu32
+                 ",\"run_avg_us\":%" PRIu32 ",\"run_max_us\":%" PRIu32 "}",
+                 i ? "," : "", route->uri, http_method_str(route->method),
+                 route->slow ? "true" : "false", st.requests, st.rejected, st.errors,
+                 (uint32_t)(st.wait_us_total / n), st.wait_us_max,
+                 (uint32_t)(st.run_us_total / n), st.run_us_max);
+        httpd_resp_sendstr_chunk(req, buf);
+    }
+    httpd_resp_sendstr_chunk(req, "]}");
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
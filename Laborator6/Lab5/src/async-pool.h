@@ -0,0 +1,35 @@
+#ifndef _ASYNC_POOL_H_
+#define _ASYNC_POOL_H_
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "routes_count.h"   /* ROUTER_ROUTE_COUNT, generated from routes.txt */
+
+/* Handlers registered as slow run on these workers instead of the single
+ * httpd task, so one long request does not hold up the others */
+#define ASYNC_POOL_WORKERS      2       /* spread over both cores */
+#define ASYNC_POOL_QUEUE_LEN    4       /* beyond this: 503 + Retry-After */
+#define ASYNC_POOL_STACK_SIZE   4096
+#define ASYNC_POOL_PRIORITY     5
+/* Every route of routes.txt, plus the ones registered directly with
+ * async_pool_register() (ws-server.c) */
+#define ASYNC_POOL_EXTRA_ROUTES 1
+#define ASYNC_POOL_MAX_ROUTES   (ROUTER_ROUTE_COUNT + ASYNC_POOL_EXTRA_ROUTES)
+
+esp_err_t async_pool_start(void);
+
+/* Registers uri like httpd_register_uri_handler(). Every route gets
+ * request/latency counters; slow routes are handed to the workers. */
+esp_err_t async_pool_register(httpd_handle_t server, const httpd_uri_t *uri, bool slow);
+
+/* For requests resolved outside httpd (see router.h): add_route sets up
+ * the counters and returns an id, dispatch runs the route from the httpd
+ * task like a handler registered above would */
+esp_err_t async_pool_add_route(const httpd_uri_t *uri, bool slow, int *route_id);
+esp_err_t async_pool_dispatch(httpd_req_t *req, int route_id);
+
+/* GET handler that reports the counters as JSON */
+esp_err_t async_pool_metrics_handler(httpd_req_t *req);
+
+#endif
@@ -0,0 +1,203 @@
+#include <string.h>
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_mac.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "mdns.h"
+
+#include "discovery.h"
+
+static const char *TAG = "discovery";
+
+typedef struct {
+    char name[64];              /* "host" or "_service._proto" */
+    esp_ip4_addr_t addr;
+    uint16_t port;
+    bool found;
+    int64_t expires_us;         /* 0: free slot */
+} cache_entry_t;
+
+static char s_hostname[32];
+static cache_entry_t s_cache[DISCOVERY_CACHE_SIZE];
+static SemaphoreHandle_t s_cache_lock;
+
+/* Returns true and fills the outputs on a live hit */
+static bool cache_get(const char *name, esp_err_t *result, esp_ip4_addr_t *addr, uint16_t *port)
+{
+    bool hit = false;
+    int64_t now = esp_timer_get_time();
+
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    for (int i = 0; i < DISCOVERY_CACHE_SIZE; i++) {
+        cache_entry_t *e = &s_cache[i];
+        if (e->expires_us > now && strcmp(e->name, name) == 0) {
+            *result = e->found ? ESP_OK : ESP_ERR_NOT_FOUND;
+            if (e->found) {
+                *addr = e->addr;
+                if (port) {
+                    *port = e->port;
+                }
+            }
+            hit = true;
+            break;
+        }
+    }
+    xSemaphoreGive(s_cache_lock);
+    return hit;
+}
+
+/* Replaces the same name, else a free or expired slot, else the one
+ * closest to expiring */
+static void cache_put(const char *name, bool found, const esp_ip4_addr_t *addr,
+                      uint16_t port, uint32_t ttl_s)
+{
+    int64_t now = esp_timer_get_time();
+    cache_entry_t *slot = NULL;
+
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    for (int i = 0; i < DISCOVERY_CACHE_SIZE; i++) {
+        cache_entry_t *e = &s_cache[i];
+        if (strcmp(e->name, name) == 0) {
+            slot = e;
+            break;
+        }
+        if (slot == NULL || (slot->expires_us > now && e->expires_us < slot->expires_us)) {
+            slot = e;
+        }
+    }
+    strlcpy(slot->name, name, sizeof(slot->name));
+    slot->found = found;
+    if (found) {
+        slot->addr = *addr;
+        slot->port = port;
+    }
+    slot->expires_us = now + (int64_t)ttl_s * 1000000;
+    xSemaphoreGive(s_cache_lock);
+}
+
+esp_err_t discovery_init(const char *host_prefix, const char *instance_name)
+{
+    uint8_t mac[6];
+
+    s_cache_lock = xSemaphoreCreateMutex();
+    if (s_cache_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err = mdns_init();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "mdns_init failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    snprintf(s_hostname, sizeof(s_hostname), "%s-%02x%02x%02x", host_prefix, mac[3], mac[4], mac[5]);
+    ESP_ERROR_CHECK(mdns_hostname_set(s_hostname));
+    ESP_ERROR_CHECK(mdns_instance_name_set(instance_name));
+    ESP_LOGI(TAG, "mDNS host name %s.local", s_hostname);
+    return ESP_OK;
+}
+
+const char *discovery_hostname(void)
+{
+    return s_hostname;
+}
+
+esp_err_t discovery_advertise(const char *service, const char *proto, uint16_t port,
+                              mdns_txt_item_t *txt, size_t txt_count)
+{
+    esp_err_t err = mdns_service_add(NULL, service, proto, port, txt, txt_count);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Advertising %s.%s failed: %s", service, proto, esp_err_to_name(err));
+    } else {
+        ESP_LOGI(TAG, "Advertising %s.%s on port %u", service, proto, port);
+    }
+    return err;
+}
+
+esp_err_t discovery_resolve_host(const char *host, esp_ip4_addr_t *addr)
+{
+    char name[sizeof(((cache_entry_t *)0)->name)];
+    esp_err_t result;
+
+    /* mdns_query_a() wants the name without the .local suffix */
+    strlcpy(name, host, sizeof(name));
+    size_t len = strlen(name);
+    if (len > 6 && strcmp(name + len - 6, ".local") == 0) {
+        name[len - 6] = '\0';
+    }
+
+    if (cache_get(name, &result, addr, NULL)) {
+        return result;
+    }
+
+    int64_t t = esp_timer_get_time();
+    result = mdns_query_a(name, DISCOVERY_QUERY_TIMEOUT_MS, addr);
+    if (result == ESP_OK) {
+        ESP_LOGI(TAG, "%s.local is " IPSTR " (%lld ms)", name, IP2STR(addr),
+                 (long long)(esp_timer_get_time() - t) / 1000);
+        cache_put(name, true, addr, 0, DISCOVERY_DEFAULT_TTL_S);
+    } else {
+        ESP_LOGW(TAG, "%s.local not resolved: %s", name, esp_err_to_name(result));
+        cache_put(name, false, NULL, 0, DISCOVERY_NEGATIVE_TTL_S);
+        result = ESP_ERR_NOT_FOUND;
+    }
+    return result;
+}
+
+esp_err_t discovery_find_service(const char *service, const char *proto,
+                                 esp_ip4_addr_t *addr, uint16_t *port)
+{
+    char name[sizeof(((cache_entry_t *)0)->name)];
+    mdns_result_t *results = NULL;
+    esp_err_t result;
+
+    snprintf(name, sizeof(name), "%s.%s", service, proto);
+    if (cache_get(name, &result, addr, port)) {
+        return result;
+    }
+
+    result = ESP_ERR_NOT_FOUND;
+    if (mdns_query_ptr(service, proto, DISCOVERY_QUERY_TIMEOUT_MS, 8, &results) == ESP_OK) {
+        for (mdns_result_t *r = results; r; r = r->next) {
+            if (r->hostname && strcmp(r->hostname, s_hostname) == 0) {
+                continue;
+            }
+            for (mdns_ip_addr_t *a = r->addr; a; a = a->next) {
+                if (a->addr.type != ESP_IPADDR_TYPE_V4) {
+                    continue;
+                }
+                *addr = a->addr.u_addr.ip4;
+                *port = r->port;
+                ESP_LOGI(TAG, "%s: %s (%s.local) at " IPSTR ":%u", name,
+                         r->instance_name ? r->instance_name : "?",
+                         r->hostname ? r->hostname : "?", IP2STR(addr), *port);
+                cache_put(name, true, addr, *port, r->ttl ? r->ttl : DISCOVERY_DEFAULT_TTL_S);
+                result = ESP_OK;
+                break;
+            }
+            if (result == ESP_OK) {
+                break;
+            }
+        }
+        mdns_query_results_free(results);
+    }
+    if (result != ESP_OK) {
+        ESP_LOGW(TAG, "No %s instance found", name);
+        cache_put(name, false, NULL, 0, DISCOVERY_NEGATIVE_TTL_S);
+    }
+    return result;
+}
+
+void discovery_invalidate(const char *name)
+{
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    for (int i = 0; i < DISCOVERY_CACHE_SIZE; i++) {
+        if (strcmp(s_cache[i].name, name) == 0) {
+            s_cache[i].expires_us = 0;
+        }
+    }
+    xSemaphoreGive(s_cache_lock);
+}
@@ -0,0 +1,229 @@
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_spiffs.h"
+
+#include "esp_http_server.h"
+
+#include "file-server.h"
+
+static const char *TAG = "file-server";
+
+/* One transfer buffer per concurrent transfer, allocated statically so
+ * serving a file of any size never touches the heap */
+typedef struct {
+    bool busy;
+    char buf[FILE_SERVER_CHUNK_SIZE];
+} transfer_slot_t;
+
+static transfer_slot_t s_slots[FILE_SERVER_MAX_TRANSFERS];
+static SemaphoreHandle_t s_slots_lock;
+
+typedef struct {
+    const char *ext;
+    const char *type;
+} mime_map_t;
+
+static const mime_map_t s_mime_types[] = {
+    { ".html", "text/html" },
+    { ".htm",  "text/html" },
+    { ".css",  "text/css" },
+    { ".js",   "application/javascript" },
+    { ".json", "application/json" },
+    { ".svg",  "image/svg+xml" },
+    { ".png",  "image/png" },
+    { ".jpg",  "image/jpeg" },
+    { ".ico",  "image/x-icon" },
+    { ".woff", "font/woff" },
+    { ".woff2","font/woff2" },
+    { ".ttf",  "font/ttf" },
+    { ".txt",  "text/plain" },
+};
+
+static const char *mime_type(const char *path)
+{
+    const char *ext = strrchr(path, '.');
+    if (ext) {
+        for (size_t i = 0; i < sizeof(s_mime_types) / sizeof(s_mime_types[0]); i++) {
+            if (strcasecmp(ext, s_mime_types[i].ext) == 0) {
+                return s_mime_types[i].type;
+            }
+        }
+    }
+    return "application/octet-stream";
+}
+
+static transfer_slot_t *slot_acquire(void)
+{
+    transfer_slot_t *slot = NULL;
+    xSemaphoreTake(s_slots_lock, portMAX_DELAY);
+    for (int i = 0; i < FILE_SERVER_MAX_TRANSFERS; i++) {
+        if (!s_slots[i].busy) {
+            s_slots[i].busy = true;
+            slot = &s_slots[i];
+            break;
+        }
+    }
+    xSemaphoreGive(s_slots_lock);
+    return slot;
+}
+
+static void slot_release(transfer_slot_t *slot)
+{
+    xSemaphoreTake(s_slots_lock, portMAX_DELAY);
+    slot->busy = false;
+    xSemaphoreGive(s_slots_lock);
+}
+
+/* Parses a single "bytes=a-b", "bytes=a-" or "bytes=-n" range.
+ * Returns 0 on success, -1 if the range cannot be satisfied. */
+static int parse_range(const char *hdr, long size, long *first, long *last)
+{
+    char *end;
+
+    if (strncmp(hdr, "bytes=", 6) != 0 || strchr(hdr, ',') != NULL) {
+        return -1;
+    }
+    hdr += 6;
+    if (*hdr == '-') {
+        long n = strtol(hdr + 1, &end, 10);
+        if (end == hdr + 1 || n <= 0) {
+            return -1;
+        }
+        *first = n >= size ? 0 : size - n;
+        *last = size - 1;
+    } else {
+        *first = strtol(hdr, &end, 10);
+        if (end == hdr || *end != '-') {
+            return -1;
+        }
+        hdr = end + 1;
+        *last = *hdr ? strtol(hdr, &end, 10) : size - 1;
+        if (*last >= size) {
+            *last = size - 1;
+        }
+    }
+    return (*first < size && *first <= *last) ? 0 : -1;
+}
+
+/* GET /static/<path>: streams <base>/<path> in FILE_SERVER_CHUNK_SIZE pieces */
+esp_err_t file_server_get_handler(httpd_req_t *req)
+{
+    char path[sizeof(FILE_SERVER_BASE_PATH) + CONFIG_SPIFFS_OBJ_NAME_LEN];
+    char range[48];
+    char content_range[64];
+    struct stat st;
+    long first = 0, last;
+
+    const char *name = req->uri + strlen(FILE_SERVER_URI_PREFIX);
+    size_t name_len = strcspn(name, "?#");
+    if (name_len == 0 || strstr(name, "..") != NULL
+            || strlen(FILE_SERVER_BASE_PATH) + 1 + name_len + 1 > sizeof(path)) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Bad path");
+    }
+    snprintf(path, sizeof(path), FILE_SERVER_BASE_PATH "/%.*s", (int)name_len, name);
+
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "File not found");
+    }
+    last = st.st_size - 1;
+
+    httpd_resp_set_type(req, mime_type(path));
+    httpd_resp_set_hdr(req, "Accept-Ranges", "bytes");
+
+    bool partial = httpd_req_get_hdr_value_str(req, "Range", range, sizeof(range)) == ESP_OK;
+    if (partial && (st.st_size == 0 || parse_range(range, st.st_size, &first, &last) != 0)) {
+        snprintf(content_range, sizeof(content_range), "bytes */%ld", (long)st.st_size);
+        httpd_resp_set_status(req, "416 Range Not Satisfiable");
+        httpd_resp_set_hdr(req, "Content-Range", content_range);
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    transfer_slot_t *slot = slot_acquire();
+    if (slot == NULL) {
+        ESP_LOGW(TAG, "All %d transfer slots busy, rejecting %s", FILE_SERVER_MAX_TRANSFERS, path);
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "1");
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        slot_release(slot);
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Read failed");
+    }
+    /* The slot is the only buffer; keep stdio from allocating its own */
+    setvbuf(file, NULL, _IONBF, 0);
+    if (fseek(file, first, SEEK_SET) != 0) {
+        fclose(file);
+        slot_release(slot);
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Read failed");
+    }
+
+    /* Only once the transfer is certain, so a 503 or 500 carries no range */
+    if (partial) {
+        snprintf(content_range, sizeof(content_range), "bytes %ld-%ld/%ld",
+                 first, last, (long)st.st_size);
+        httpd_resp_set_status(req, "206 Partial Content");
+        httpd_resp_set_hdr(req, "Content-Range", content_range);
+    }
+
+    esp_err_t ret = ESP_OK;
+    long remaining = last - first + 1;
+    while (remaining > 0) {
+        size_t n = fread(slot->buf, 1, MIN(remaining, (long)sizeof(slot->buf)), file);
+        if (n == 0) {
+            ESP_LOGE(TAG, "Short read on %s", path);
+            ret = ESP_FAIL;
+            break;
+        }
+        if (httpd_resp_send_chunk(req, slot->buf, n) != ESP_OK) {
+            ESP_LOGW(TAG, "Client dropped %s", path);
+            ret = ESP_FAIL;
+            break;
+        }
+        remaining -= n;
+    }
+    fclose(file);
+    slot_release(slot);
+
+    if (ret != ESP_OK) {
+        /* Returning ESP_FAIL closes the socket, which is the only way to
+         * abort a chunked response half way */
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+esp_err_t file_server_mount(void)
+{
+    esp_vfs_spiffs_conf_t conf = {
+        .base_path = FILE_SERVER_BASE_PATH,
+        .partition_label = FILE_SERVER_PARTITION,
+        .max_files = FILE_SERVER_MAX_TRANSFERS,
+        .format_if_mount_failed = false
+    };
+
+    if (s_slots_lock == NULL) {
+        s_slots_lock = xSemaphoreCreateMutex();
+    }
+
+    esp_err_t ret = esp_vfs_spiffs_register(&conf);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to mount SPIFFS partition '%s' (%s)",
+                 FILE_SERVER_PARTITION, esp_err_to_name(ret));
+        return ret;
+    }
+
+    size_t total = 0, used = 0;
+    esp_spiffs_info(FILE_SERVER_PARTITION, &total, &used);
+    ESP_LOGI(TAG, "Mounted %s at %s: %u of %u bytes used",
+             FILE_SERVER_PARTITION, FILE_SERVER_BASE_PATH, used, total);
+    return ESP_OK;
+}
@@ -0,0 +1,18 @@
+#ifndef _FILE_SERVER_H_
+#define _FILE_SERVER_H_
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#define FILE_SERVER_BASE_PATH       "/www"
+#define FILE_SERVER_PARTITION       "storage"
+#define FILE_SERVER_URI_PREFIX      "/static/"
+#define FILE_SERVER_CHUNK_SIZE      4096
+#define FILE_SERVER_MAX_TRANSFERS   2
+
+esp_err_t file_server_mount(void);
+/* Route GET FILE_SERVER_URI_PREFIX* to this (see routes.txt); SPIFFS
+ * reads are slow, so as a slow route */
+esp_err_t file_server_get_handler(httpd_req_t *req);
+
+#endif
@@ -0,0 +1,408 @@
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+#include "form-parser.h"
+
+enum {
+    /* application/x-www-form-urlencoded */
+    ST_KEY,
+    ST_VALUE,
+    /* multipart/form-data */
+    ST_PREAMBLE,
+    ST_BOUNDARY_END,        /* after a delimiter: "\r\n" or "--" */
+    ST_BOUNDARY_FINAL,      /* saw the first '-' of "--" */
+    ST_BOUNDARY_LF,         /* saw '\r' after a delimiter */
+    ST_HEADERS,
+    ST_BODY,
+    ST_EPILOGUE,
+};
+
+static const form_limit_t *find_limit(const form_parser_t *p, const char *key)
+{
+    for (size_t i = 0; i < p->limit_count; i++) {
+        if (strcmp(p->limits[i].key, key) == 0) {
+            return &p->limits[i];
+        }
+    }
+    return NULL;
+}
+
+/* Key is complete: pick the limit for its value */
+static void begin_value(form_parser_t *p)
+{
+    const form_limit_t *limit;
+
+    p->key[p->key_len] = '\0';
+    p->value_len = 0;
+    p->value_limit = p->value_cap - 1;
+    limit = find_limit(p, p->key);
+    if (limit && limit->max_len < p->value_limit) {
+        p->value_limit = limit->max_len;
+    }
+}
+
+static form_status_t fail(form_parser_t *p, form_status_t status)
+{
+    p->status = status;
+    return status;
+}
+
+static form_status_t key_append(form_parser_t *p, char c)
+{
+    if (p->key_len >= FORM_MAX_KEY_LEN) {
+        return fail(p, FORM_ERR_KEY_TOO_LONG);
+    }
+    p->key[p->key_len++] = c;
+    return FORM_OK;
+}
+
+static form_status_t value_append(form_parser_t *p, char c)
+{
+    if (p->value_len >= p->value_limit) {
+        return fail(p, FORM_ERR_VALUE_TOO_LONG);
+    }
+    p->value[p->value_len++] = c;
+    return FORM_OK;
+}
+
+static form_status_t emit_field(form_parser_t *p)
+{
+    p->value[p->value_len] = '\0';
+    if (p->cb && p->cb(p->user, p->key, p->value, p->value_len) != 0) {
+        return fail(p, FORM_ERR_ABORTED);
+    }
+    p->key_len = 0;
+    p->value_len = 0;
+    return FORM_OK;
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c = (char)tolower((unsigned char)c);
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+/* ------------------------------------------------------------------------
+ * application/x-www-form-urlencoded
+ * ----------------------------------------------------------------------*/
+
+static form_status_t urlenc_byte(form_parser_t *p, char c)
+{
+    if (p->pct_digits) {
+        int v = hex_value(c);
+        if (v < 0) {
+            return fail(p, FORM_ERR_BAD_ENCODING);
+        }
+        p->pct_value = (uint8_t)(p->pct_value << 4 | v);
+        if (--p->pct_digits) {
+            return FORM_OK;
+        }
+        c = (char)p->pct_value;
+        /* A decoded byte is data, never a separator */
+        return p->state == ST_KEY ? key_append(p, c) : value_append(p, c);
+    }
+
+    switch (c) {
+    case '%':
+        p->pct_digits = 2;
+        p->pct_value = 0;
+        return FORM_OK;
+    case '+':
+        c = ' ';
+        break;
+    case '=':
+        if (p->state == ST_KEY) {
+            begin_value(p);
+            p->state = ST_VALUE;
+            return FORM_OK;
+        }
+        break;
+    case '&':
+        if (p->state == ST_KEY) {
+            if (p->key_len == 0) {
+                return FORM_OK;     /* "a=1&&b=2" */
+            }
+            begin_value(p);         /* "flag&..." has an empty value */
+        }
+        p->state = ST_KEY;
+        return emit_field(p);
+    default:
+        break;
+    }
+    return p->state == ST_KEY ? key_append(p, c) : value_append(p, c);
+}
+
+static form_status_t urlenc_finish(form_parser_t *p)
+{
+    if (p->pct_digits) {
+        return fail(p, FORM_ERR_BAD_ENCODING);
+    }
+    if (p->state == ST_KEY) {
+        if (p->key_len == 0) {
+            return FORM_OK;
+        }
+        begin_value(p);
+    }
+    p->state = ST_KEY;
+    return emit_field(p);
+}
+
+/* ------------------------------------------------------------------------
+ * multipart/form-data
+ * ----------------------------------------------------------------------*/
+
+/* Pulls name="..." out of a Content-Disposition header */
+static form_status_t parse_part_header(form_parser_t *p)
+{
+    static const char cd[] = "content-disposition:";
+
+    p->header[p->header_len] = '\0';
+    if (strncasecmp(p->header, cd, sizeof(cd) - 1) != 0) {
+        return FORM_OK;
+    }
+
+    const char *name = p->header + sizeof(cd) - 1;
+    while ((name = strstr(name, "name=\"")) != NULL) {
+        /* Skip the tail of filename="..." */
+        if (name == p->header || name[-1] == ' ' || name[-1] == ';') {
+            break;
+        }
+        name++;
+    }
+    if (name == NULL) {
+        return fail(p, FORM_ERR_BAD_MULTIPART);
+    }
+    name += 6;
+    const char *end = strchr(name, '"');
+    if (end == NULL) {
+        return fail(p, FORM_ERR_BAD_MULTIPART);
+    }
+    if ((size_t)(end - name) > FORM_MAX_KEY_LEN) {
+        return fail(p, FORM_ERR_KEY_TOO_LONG);
+    }
+    memcpy(p->key, name, end - name);
+    p->key_len = end - name;
+    return FORM_OK;
+}
+
+static form_status_t multipart_body_byte(form_parser_t *p, char c);
+
+static form_status_t delimiter_found(form_parser_t *p)
+{
+    form_status_t ret = FORM_OK;
+    if (p->state == ST_BODY) {
+        ret = emit_field(p);
+    }
+    p->state = ST_BOUNDARY_END;
+    return ret;
+}
+
+/* Matches the delimiter across chunk borders. Bytes of a partial match
+ * that turns out not to be the delimiter are body data. */
+static form_status_t multipart_body_byte(form_parser_t *p, char c)
+{
+    form_status_t ret;
+
+    for (;;) {
+        if (c == p->delim[p->delim_match]) {
+            if (++p->delim_match == p->delim_len) {
+                p->delim_match = 0;
+                return delimiter_found(p);
+            }
+            return FORM_OK;
+        }
+        if (p->delim_match == 0) {
+            return p->state == ST_BODY ? value_append(p, c) : FORM_OK;
+        }
+
+        size_t matched = p->delim_match;
+        p->delim_match = 0;
+        if (p->state == ST_BODY && (ret = value_append(p, p->delim[0])) != FORM_OK) {
+            return ret;
+        }
+        for (size_t i = 1; i < matched; i++) {
+            /* Shorter than the delimiter, so this cannot complete it */
+            if ((ret = multipart_body_byte(p, p->delim[i])) != FORM_OK) {
+                return ret;
+            }
+        }
+    }
+}
+
+static form_status_t multipart_byte(form_parser_t *p, char c)
+{
+    switch (p->state) {
+    case ST_PREAMBLE:
+    case ST_BODY:
+        return multipart_body_byte(p, c);
+
+    case ST_BOUNDARY_END:
+        if (c == '-') {
+            p->state = ST_BOUNDARY_FINAL;
+        } else if (c == '\r') {
+            p->state = ST_BOUNDARY_LF;
+        } else if (c != ' ' && c != '\t') {     /* transport padding */
+            return fail(p, FORM_ERR_BAD_MULTIPART);
+        }
+        return FORM_OK;
+
+    case ST_BOUNDARY_FINAL:
+        if (c != '-') {
+            return fail(p, FORM_ERR_BAD_MULTIPART);
+        }
+        p->state = ST_EPILOGUE;
+        return FORM_OK;
+
+    case ST_BOUNDARY_LF:
+        if (c != '\n') {
+            return fail(p, FORM_ERR_BAD_MULTIPART);
+        }
+        p->state = ST_HEADERS;
+        p->key_len = 0;
+        p->header_len = 0;
+        p->pending_cr = 0;
+        return FORM_OK;
+
+    case ST_HEADERS:
+        if (p->pending_cr) {
+            p->pending_cr = 0;
+            if (c != '\n') {
+                return fail(p, FORM_ERR_BAD_MULTIPART);
+            }
+            if (p->header_len == 0) {
+                /* Blank line: the part body follows */
+                if (p->key_len == 0) {
+                    return fail(p, FORM_ERR_BAD_MULTIPART);
+                }
+                begin_value(p);
+                p->state = ST_BODY;
+                return FORM_OK;
+            }
+            form_status_t ret = parse_part_header(p);
+            p->header_len = 0;
+            return ret;
+        }
+        if (c == '\r') {
+            p->pending_cr = 1;
+        } else if (p->header_len < FORM_MAX_HEADER_LEN) {
+            p->header[p->header_len++] = c;
+        }
+        /* Longer header lines are cut; only Content-Disposition matters */
+        return FORM_OK;
+
+    case ST_EPILOGUE:
+    default:
+        return FORM_OK;
+    }
+}
+
+/* ------------------------------------------------------------------------
+ * Public API
+ * ----------------------------------------------------------------------*/
+
+form_status_t form_parser_init(form_parser_t *p, const char *content_type,
+                               char *value_buf, size_t value_buf_size,
+                               form_field_cb cb, void *user)
+{
+    static const char urlenc[] = "application/x-www-form-urlencoded";
+    static const char multipart[] = "multipart/form-data";
+
+    memset(p, 0, sizeof(*p));
+    p->cb = cb;
+    p->user = user;
+    p->value = value_buf;
+    p->value_cap = value_buf_size;
+    if (value_buf == NULL || value_buf_size == 0) {
+        return fail(p, FORM_ERR_UNSUPPORTED);
+    }
+
+    /* Missing Content-Type: browsers always send one, curl -d too */
+    if (content_type == NULL || strncasecmp(content_type, urlenc, sizeof(urlenc) - 1) == 0) {
+        p->state = ST_KEY;
+        return FORM_OK;
+    }
+    if (strncasecmp(content_type, multipart, sizeof(multipart) - 1) != 0) {
+        return fail(p, FORM_ERR_UNSUPPORTED);
+    }
+
+    const char *b = strcasestr(content_type, "boundary=");
+    if (b == NULL) {
+        return fail(p, FORM_ERR_UNSUPPORTED);
+    }
+    b += 9;
+    size_t len;
+    if (*b == '"') {
+        b++;
+        len = strcspn(b, "\"");
+    } else {
+        len = strcspn(b, "; \t");
+    }
+    if (len == 0 || len > FORM_MAX_BOUNDARY_LEN) {
+        return fail(p, FORM_ERR_UNSUPPORTED);
+    }
+
+    memcpy(p->delim, "\r\n--", 4);
+    memcpy(p->delim + 4, b, len);
+    p->delim_len = len + 4;
+    p->multipart = 1;
+    p->state = ST_PREAMBLE;
+    /* The first delimiter has no CRLF in front of it */
+    p->delim_match = 2;
+    return FORM_OK;
+}
+
+void form_parser_set_limits(form_parser_t *p, const form_limit_t *limits, size_t count)
+{
+    p->limits = limits;
+    p->limit_count = count;
+}
+
+form_status_t form_parser_feed(form_parser_t *p, const char *data, size_t len)
+{
+    if (p->status != FORM_OK) {
+        return p->status;
+    }
+    for (size_t i = 0; i < len; i++) {
+        form_status_t ret = p->multipart ? multipart_byte(p, data[i]) : urlenc_byte(p, data[i]);
+        if (ret != FORM_OK) {
+            return ret;
+        }
+    }
+    return FORM_OK;
+}
+
+form_status_t form_parser_finish(form_parser_t *p)
+{
+    if (p->status != FORM_OK) {
+        return p->status;
+    }
+    if (!p->multipart) {
+        return urlenc_finish(p);
+    }
+    if (p->state != ST_EPILOGUE) {
+        return fail(p, FORM_ERR_TRUNCATED);
+    }
+    return FORM_OK;
+}
+
+const char *form_status_str(form_status_t status)
+{
+    switch (status) {
+    case FORM_OK:                 return "ok";
+    case FORM_ERR_UNSUPPORTED:    return "unsupported content type";
+    case FORM_ERR_KEY_TOO_LONG:   return "field name too long";
+    case FORM_ERR_VALUE_TOO_LONG: return "field value too long";
+    case FORM_ERR_BAD_ENCODING:   return "bad percent-encoding";
+    case FORM_ERR_BAD_MULTIPART:  return "malformed multipart body";
+    case FORM_ERR_TRUNCATED:      return "body ended early";
+    case FORM_ERR_ABORTED:        return "aborted";
+    default:                      return "unknown";
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef _FORM_PARSER_H_
+#define _FORM_PARSER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Incremental parser for application/x-www-form-urlencoded and
+ * multipart/form-data request bodies. The body can be fed in chunks of
+ * any size; every complete field is reported through the callback with a
+ * NUL-terminated, decoded value. Nothing is allocated. */
+
+#define FORM_MAX_KEY_LEN        32
+#define FORM_MAX_BOUNDARY_LEN   70
+#define FORM_MAX_HEADER_LEN     128
+
+typedef enum {
+    FORM_OK = 0,
+    FORM_ERR_UNSUPPORTED,       /* unknown Content-Type or missing boundary */
+    FORM_ERR_KEY_TOO_LONG,
+    FORM_ERR_VALUE_TOO_LONG,    /* field longer than its limit */
+    FORM_ERR_BAD_ENCODING,      /* broken %XX escape */
+    FORM_ERR_BAD_MULTIPART,
+    FORM_ERR_TRUNCATED,         /* body ended in the middle of a part */
+    FORM_ERR_ABORTED,           /* the field callback returned non-zero */
+} form_status_t;
+
+/* Return non-zero to stop parsing */
+typedef int (*form_field_cb)(void *user, const char *key, const char *value, size_t value_len);
+
+typedef struct {
+    const char *key;
+    uint16_t max_len;
+} form_limit_t;
+
+typedef struct {
+    form_field_cb cb;
+    void *user;
+    const form_limit_t *limits;
+    size_t limit_count;
+
+    int multipart;
+    int state;
+    form_status_t status;
+
+    char key[FORM_MAX_KEY_LEN + 1];
+    size_t key_len;
+    char *value;
+    size_t value_cap;           /* including the terminating NUL */
+    size_t value_len;
+    size_t value_limit;
+
+    /* urlencoded: pending %XX escape */
+    uint8_t pct_digits;
+    uint8_t pct_value;
+
+    /* multipart: "\r\n--" + boundary, and how much of it matched so far */
+    char delim[FORM_MAX_BOUNDARY_LEN + 5];
+    size_t delim_len;
+    size_t delim_match;
+    char header[FORM_MAX_HEADER_LEN + 1];
+    size_t header_len;
+    uint8_t pending_cr;
+} form_parser_t;
+
+form_status_t form_parser_init(form_parser_t *p, const char *content_type,
+                               char *value_buf, size_t value_buf_size,
+                               form_field_cb cb, void *user);
+void form_parser_set_limits(form_parser_t *p, const form_limit_t *limits, size_t count);
+form_status_t form_parser_feed(form_parser_t *p, const char *data, size_t len);
+form_status_t form_parser_finish(form_parser_t *p);
+const char *form_status_str(form_status_t status);
+
+#endif
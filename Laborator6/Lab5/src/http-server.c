@@ -1,4 +1,5 @@
 #include <string.h>
+#include <inttypes.h>
 #include <sys/param.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -7,7 +8,6 @@
 #include "esp_event.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
-#include "esp_spiffs.h"
 
 #include "lwip/err.h"
 #include "lwip/sys.h"
@@ -16,117 +16,299 @@
 #include "esp_http_server.h"
 
 #include <stdio.h>
-#include <unistd.h>  // For getcwd()
-
-/* Our URI handler function to be called during GET /uri request */
-static int get_handler(httpd_req_t *req) {
-    // Inside your code before opening the file
-    // char cwd[1024];
-    // if (getcwd(cwd, sizeof(cwd)) != NULL) {
-    //     printf("Current working directory: %s\n", cwd);
-    // } else {
-    //     perror("getcwd() error");
-    // }
-    // Open the index.html file
-    FILE *file = fopen("D:/CI1A/Laborator/Lab5/src/index.html", "r");
-    if (!file) {
-        // Handle error if file cannot be opened
-        const char *error_response = "HTTP/1.1 404 Not Found\r\n\r\nFile Not Found";
-        httpd_resp_send(req, error_response, strlen(error_response));
-        return ESP_FAIL;
+
+#include "async-pool.h"
+#include "file-server.h"
+#include "form-parser.h"
+#include "provision.h"
+#include "router.h"
+#include "soft-ap.h"
+#include "template.h"
+#include "ws-server.h"
+
+/* index.html is a template rendered per request; it is embedded as text */
+extern const char index_html_start[] asm("_binary_index_html_start");
+extern const char index_html_end[]   asm("_binary_index_html_end");
+
+/* Static pages, gzip-compressed at build time (see gzip_asset.cmake) and
+ * linked into flash by target_add_binary_data() */
+extern const uint8_t results_html_gz_start[] asm("_binary_results_html_gz_start");
+extern const uint8_t results_html_gz_end[]   asm("_binary_results_html_gz_end");
+
+typedef struct {
+    const uint8_t *start;
+    const uint8_t *end;
+    const char *type;
+    char etag[12];      /* "xxxxxxxx" incl. quotes */
+} web_asset_t;
+
+static web_asset_t results_asset = {
+    .start = results_html_gz_start,
+    .end   = results_html_gz_end,
+    .type  = "text/html",
+};
+
+static const char *TAG = "http-server";
+
+/* FNV-1a over the compressed bytes; changes whenever a new page is flashed */
+static void web_asset_init(web_asset_t *asset)
+{
+    uint32_t hash = 2166136261u;
+    for (const uint8_t *p = asset->start; p < asset->end; p++) {
+        hash = (hash ^ *p) * 16777619u;
     }
+    snprintf(asset->etag, sizeof(asset->etag), "\"%08" PRIx32 "\"", hash);
+}
 
-    // Read the file into memory
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
+/* Our URI handler function to be called during GET /uri request.
+ * Pages are sent straight from flash: no file I/O and no heap. */
+static esp_err_t get_handler(httpd_req_t *req)
+{
+    const web_asset_t *asset = req->user_ctx;
+    char if_none_match[64];
 
-    char *file_contents = (char *)malloc(file_size + 1);
-    if (!file_contents) {
-        // Handle memory allocation error
-        fclose(file);
-        const char *error_response = "HTTP/1.1 500 Internal Server Error\r\n\r\nUnable to read file";
-        httpd_resp_send(req, error_response, strlen(error_response));
+    httpd_resp_set_hdr(req, "ETag", asset->etag);
+    /* Let the browser keep its copy but revalidate it on every load */
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match,
+                                    sizeof(if_none_match)) == ESP_OK
+            && strstr(if_none_match, asset->etag) != NULL) {
+        ESP_LOGD(TAG, "%s not modified", req->uri);
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    httpd_resp_set_type(req, asset->type);
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    return httpd_resp_send(req, (const char *)asset->start, asset->end - asset->start);
+}
+
+static esp_err_t send_chunk(void *ctx, const char *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len);
+}
+
+static esp_err_t index_var(tmpl_out_t *out, const char *name, size_t name_len, void *user)
+{
+    char rssi[24];
+    scan_entry_t networks[SCAN_CACHE_SIZE];
+
+    if (name_len != 8 || strncmp(name, "networks", name_len) != 0) {
+        return ESP_OK;
+    }
+
+    int count = wifi_scan_get_cached(networks, SCAN_CACHE_SIZE);
+    if (count == 0) {
+        return tmpl_write_str(out, "<option value=\"\" disabled>Scanning...</option>\n");
+    }
+    esp_err_t err = ESP_OK;
+    for (int i = 0; i < count && err == ESP_OK; i++) {
+        snprintf(rssi, sizeof(rssi), " (%d dBm)</option>\n", networks[i].rssi);
+        err = tmpl_write_str(out, "<option value=\"");
+        if (err == ESP_OK) err = tmpl_write_escaped(out, networks[i].ssid);
+        if (err == ESP_OK) err = tmpl_write_str(out, "\">");
+        if (err == ESP_OK) err = tmpl_write_escaped(out, networks[i].ssid);
+        if (err == ESP_OK) err = tmpl_write_str(out, rssi);
+    }
+    return err;
+}
+
+/* GET / and /index.html: the page is streamed out while the template is
+ * walked, with the network list taken from the background scan cache */
+static esp_err_t index_get_handler(httpd_req_t *req)
+{
+    tmpl_out_t out;
+
+    httpd_resp_set_type(req, "text/html");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    tmpl_out_init(&out, send_chunk, req);
+    /* TEXT embedding appends a NUL that is not part of the page */
+    if (tmpl_render(&out, index_html_start, index_html_end - index_html_start - 1,
+                    index_var, NULL) != ESP_OK) {
         return ESP_FAIL;
     }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
 
-    fread(file_contents, 1, file_size, file);
-    file_contents[file_size] = '\0';  // Null terminate the string
+/* Fields of the provisioning form. The body is parsed while it is
+ * received, so its size is bounded by these limits, not by a buffer. */
+#define FORM_RECV_CHUNK 64
 
-    fclose(file);
+typedef struct {
+    char ssid[33];
+    char pass[65];
+} wifi_form_t;
 
-    // Send HTTP headers and content
-    const char *headers = "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\n\r\n";
-    httpd_resp_send(req, headers, strlen(headers)); // Send headers
-    httpd_resp_send(req, file_contents, file_size); // Send file content
+static const form_limit_t wifi_form_limits[] = {
+    { "ssid",  sizeof(((wifi_form_t *)0)->ssid) - 1 },
+    { "ipass", sizeof(((wifi_form_t *)0)->pass) - 1 },
+};
 
-    free(file_contents);  // Free memory
-    return ESP_OK;
+static int wifi_form_field(void *user, const char *key, const char *value, size_t value_len)
+{
+    wifi_form_t *form = user;
+
+    if (strcmp(key, "ssid") == 0) {
+        memcpy(form->ssid, value, value_len + 1);
+    } else if (strcmp(key, "ipass") == 0) {
+        memcpy(form->pass, value, value_len + 1);
+    } else {
+        ESP_LOGD(TAG, "Ignoring form field %s", key);
+    }
+    return 0;
 }
 
 /* Our URI handler function to be called during POST /uri request */
 esp_err_t post_handler(httpd_req_t *req)
 {
-    /* Destination buffer for content of HTTP POST request.
-     * httpd_req_recv() accepts char* only, but content could
-     * as well be any binary data (needs type casting).
-     * In case of string data, null termination will be absent, and
-     * content length would give length of string */
-    char content[100];
-
-    /* Truncate if content length larger than the buffer */
-    size_t recv_size = MIN(req->content_len, sizeof(content));
-
-    int ret = httpd_req_recv(req, content, recv_size);
-    if (ret <= 0) {  /* 0 return value indicates connection closed */
-        /* Check if timeout occurred */
-        if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
-            /* In case of timeout one can choose to retry calling
-             * httpd_req_recv(), but to keep it simple, here we
-             * respond with an HTTP 408 (Request Timeout) error */
-            httpd_resp_send_408(req);
-        }
-        /* In case of error, returning ESP_FAIL will
-         * ensure that the underlying socket is closed */
+    char chunk[FORM_RECV_CHUNK];
+    char value[sizeof(((wifi_form_t *)0)->pass)];
+    char content_type[96];
+    wifi_form_t form = {0};
+    form_parser_t parser;
+    form_status_t st;
+    int timeouts = 0;
+
+    if (httpd_req_get_hdr_value_str(req, "Content-Type", content_type, sizeof(content_type)) != ESP_OK) {
+        content_type[0] = '\0';
+    }
+    st = form_parser_init(&parser, content_type[0] ? content_type : NULL,
+                          value, sizeof(value), wifi_form_field, &form);
+    if (st != FORM_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, form_status_str(st));
         return ESP_FAIL;
     }
+    form_parser_set_limits(&parser, wifi_form_limits,
+                           sizeof(wifi_form_limits) / sizeof(wifi_form_limits[0]));
+
+    size_t remaining = req->content_len;
+    while (remaining > 0) {
+        int ret = httpd_req_recv(req, chunk, MIN(remaining, sizeof(chunk)));
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts < 3) {
+            continue;
+        }
+        if (ret <= 0) {  /* 0 return value indicates connection closed */
+            if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+                httpd_resp_send_408(req);
+            }
+            /* In case of error, returning ESP_FAIL will
+             * ensure that the underlying socket is closed */
+            return ESP_FAIL;
+        }
+        timeouts = 0;
+        remaining -= ret;
+
+        st = form_parser_feed(&parser, chunk, ret);
+        if (st != FORM_OK) {
+            break;
+        }
+    }
+    if (st == FORM_OK) {
+        st = form_parser_finish(&parser);
+    }
+    if (st != FORM_OK) {
+        ESP_LOGW(TAG, "Rejected form: %s", form_status_str(st));
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, form_status_str(st));
+        /* Unread body bytes would be taken for the next request */
+        return remaining ? ESP_FAIL : ESP_OK;
+    }
+    if (form.ssid[0] == '\0') {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "ssid missing");
+        return ESP_OK;
+    }
+
+    /* Connecting takes seconds; the browser is sent to the status page
+     * right away and polls /status from there */
+    esp_err_t err = provision_submit(form.ssid, form.pass);
+    if (err == ESP_ERR_INVALID_ARG) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "invalid SSID or key length");
+        return ESP_OK;
+    }
+    if (err == ESP_ERR_INVALID_STATE) {
+        httpd_resp_set_status(req, "409 Conflict");
+        httpd_resp_sendstr(req, "A connection attempt is already running");
+        return ESP_OK;
+    }
 
-    /* Send a simple response */
-    const char resp[] = "URI POST Response";
-    httpd_resp_send(req, resp, HTTPD_RESP_USE_STRLEN);  // TODO: Inlocuire cu un sir de caractere ce contine SSID selectat & parola introdusa
+    httpd_resp_set_status(req, "303 See Other");
+    httpd_resp_set_hdr(req, "Location", "/results.html");
+    httpd_resp_send(req, NULL, 0);
     return ESP_OK;
 }
 
-/* URI handler structure for GET /uri */
-httpd_uri_t uri_get = {
-    .uri      = "/index.html",
-    .method   = HTTP_GET,
-    .handler  = get_handler,
-    .user_ctx = NULL
-};
+/* Copies src into dst as the inside of a JSON string */
+static void json_escape(char *dst, size_t size, const char *src)
+{
+    size_t n = 0;
 
-/* URI handler structure for POST /uri */
-httpd_uri_t uri_post = {
-    .uri      = "/results.html",
-    .method   = HTTP_POST,
-    .handler  = post_handler,
-    .user_ctx = NULL
-};
+    for (; *src && n + 7 < size; src++) {
+        unsigned char c = *src;
+        if (c == '"' || c == '\\') {
+            dst[n++] = '\\';
+            dst[n++] = c;
+        } else if (c < 0x20) {
+            n += snprintf(dst + n, size - n, "\\u%04x", c);
+        } else {
+            dst[n++] = c;
+        }
+    }
+    dst[n] = '\0';
+}
+
+esp_err_t status_get_handler(httpd_req_t *req)
+{
+    prov_status_t st;
+    char ssid[sizeof(st.ssid) * 6];
+    char body[384];
+
+    provision_get_status(&st);
+    json_escape(ssid, sizeof(ssid), st.ssid);
+    snprintf(body, sizeof(body),
+             "{\"state\":\"%s\",\"ssid\":\"%s\",\"ip\":\"" IPSTR "\","
+             "\"attempts\":%d,\"reason\":%u,\"elapsed_ms\":%lld,\"ap\":%s}",
+             provision_state_str(st.state), ssid, IP2STR(&st.ip),
+             st.attempts, st.reason, (long long)st.elapsed_ms, st.ap_active ? "true" : "false");
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    return httpd_resp_sendstr(req, body);
+}
+
+/* s_route_table: the routes of routes.txt, generated at build time */
+#include "routes_gen.h"
 
 /* Function for starting the webserver */
 httpd_handle_t start_webserver(void)
 {
     /* Generate default configuration */
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    /* httpd only holds /ws and the router's catch-all per method */
+    config.uri_match_fn = httpd_uri_match_wildcard;
+    config.max_uri_handlers = 4;
+    /* Requests handed to the worker pool keep their socket until they
+     * finish; drop the least recently used idle one when we run out */
+    config.lru_purge_enable = true;
 
     /* Empty handle to esp_http_server */
     httpd_handle_t server = NULL;
 
+    web_asset_init(&results_asset);
+
+    if (async_pool_start() != ESP_OK) {
+        ESP_LOGE(TAG, "Worker pool not started");
+        return NULL;
+    }
+
     /* Start the httpd server */
     if (httpd_start(&server, &config) == ESP_OK) {
-        /* Register URI handlers */
-        httpd_register_uri_handler(server, &uri_get);
-        httpd_register_uri_handler(server, &uri_post);
+        /* /ws goes first: httpd tries handlers in registration order
+         * and the router's catch-all matches everything */
+        ws_server_register(server);
+        if (router_register(server, &s_route_table) != ESP_OK) {
+            ESP_LOGE(TAG, "Routes not registered");
+        }
     }
     /* If server failed to start, handle will be NULL */
     return server;
@@ -139,4 +321,4 @@ void stop_webserver(httpd_handle_t server)
         /* Stop the httpd server */
         httpd_stop(server);
     }
-}
\ No newline at end of file
+}
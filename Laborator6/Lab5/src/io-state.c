@@ -0,0 +1,145 @@
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "esp_adc/adc_oneshot.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+#include "io-state.h"
+
+static const char *TAG = "io-state";
+
+static io_state_t s_state;
+static portMUX_TYPE s_state_mux = portMUX_INITIALIZER_UNLOCKED;
+static adc_oneshot_unit_handle_t s_adc;
+static TaskHandle_t s_task;
+static io_state_cb s_cb;
+static void *s_cb_arg;
+
+/* The button wakes the task at once instead of waiting for the next poll */
+static void IRAM_ATTR button_isr_handler(void *arg)
+{
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(s_task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void update(uint32_t changed, const io_state_t *next)
+{
+    io_state_t copy;
+
+    if (changed == 0) {
+        return;
+    }
+    portENTER_CRITICAL(&s_state_mux);
+    s_state.button = next->button;
+    s_state.led = next->led;
+    s_state.adc_raw = next->adc_raw;
+    s_state.free_heap = next->free_heap;
+    s_state.seq++;
+    copy = s_state;
+    portEXIT_CRITICAL(&s_state_mux);
+
+    if (s_cb) {
+        s_cb(&copy, changed, s_cb_arg);
+    }
+}
+
+static void io_state_task(void *arg)
+{
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(IO_STATE_POLL_MS));
+
+        io_state_t prev, next;
+        uint32_t changed = 0;
+        int raw = 0;
+
+        io_state_get(&prev);
+        next = prev;
+        next.button = !gpio_get_level(IO_STATE_BUTTON_GPIO);
+        next.led = gpio_get_level(IO_STATE_LED_GPIO);
+        if (adc_oneshot_read(s_adc, IO_STATE_ADC_CHANNEL, &raw) == ESP_OK) {
+            next.adc_raw = raw;
+        }
+        next.free_heap = esp_get_free_heap_size();
+
+        if (next.button != prev.button) {
+            changed |= IO_FIELD_BUTTON;
+        }
+        if (next.led != prev.led) {
+            changed |= IO_FIELD_LED;
+        }
+        if (abs((int)next.adc_raw - (int)prev.adc_raw) >= IO_STATE_ADC_DEADBAND) {
+            changed |= IO_FIELD_ADC;
+        } else {
+            next.adc_raw = prev.adc_raw;
+        }
+        if (abs((int)next.free_heap - (int)prev.free_heap) >= IO_STATE_HEAP_DEADBAND) {
+            changed |= IO_FIELD_HEAP;
+        } else {
+            next.free_heap = prev.free_heap;
+        }
+        update(changed, &next);
+    }
+}
+
+esp_err_t io_state_start(io_state_cb cb, void *arg)
+{
+    s_cb = cb;
+    s_cb_arg = arg;
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << IO_STATE_LED_GPIO,
+        /* Input too, so gpio_get_level() reads back what was set */
+        .mode = GPIO_MODE_INPUT_OUTPUT,
+    };
+    ESP_ERROR_CHECK(gpio_config(&io_conf));
+
+    io_conf.pin_bit_mask = 1ULL << IO_STATE_BUTTON_GPIO;
+    io_conf.mode = GPIO_MODE_INPUT;
+    io_conf.pull_up_en = GPIO_PULLUP_ENABLE;
+    io_conf.intr_type = GPIO_INTR_ANYEDGE;
+    ESP_ERROR_CHECK(gpio_config(&io_conf));
+
+    adc_oneshot_unit_init_cfg_t adc_cfg = { .unit_id = ADC_UNIT_1 };
+    ESP_ERROR_CHECK(adc_oneshot_new_unit(&adc_cfg, &s_adc));
+    adc_oneshot_chan_cfg_t chan_cfg = {
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+        .atten = ADC_ATTEN_DB_12,
+    };
+    ESP_ERROR_CHECK(adc_oneshot_config_channel(s_adc, IO_STATE_ADC_CHANNEL, &chan_cfg));
+
+    s_state.led = gpio_get_level(IO_STATE_LED_GPIO);
+    s_state.button = !gpio_get_level(IO_STATE_BUTTON_GPIO);
+    s_state.free_heap = esp_get_free_heap_size();
+
+    if (xTaskCreate(io_state_task, "io_state", 3072, NULL, 6, &s_task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {  /* already installed */
+        return err;
+    }
+    ESP_LOGI(TAG, "LED GPIO%d, button GPIO%d, sampling every %d ms",
+             IO_STATE_LED_GPIO, IO_STATE_BUTTON_GPIO, IO_STATE_POLL_MS);
+    return gpio_isr_handler_add(IO_STATE_BUTTON_GPIO, button_isr_handler, NULL);
+}
+
+void io_state_get(io_state_t *state)
+{
+    portENTER_CRITICAL(&s_state_mux);
+    *state = s_state;
+    portEXIT_CRITICAL(&s_state_mux);
+}
+
+/* The change is picked up and pushed by the task like any other */
+esp_err_t io_state_set_led(int on)
+{
+    esp_err_t err = gpio_set_level(IO_STATE_LED_GPIO, on ? 1 : 0);
+    if (err == ESP_OK && s_task) {
+        xTaskNotifyGive(s_task);
+    }
+    return err;
+}
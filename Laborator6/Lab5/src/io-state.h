@@ -0,0 +1,37 @@
+#ifndef _IO_STATE_H_
+#define _IO_STATE_H_
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/* Same wiring as Laborator1: LED on GPIO4, button on GPIO2 (pull-up) */
+#define IO_STATE_LED_GPIO       4
+#define IO_STATE_BUTTON_GPIO    2
+#define IO_STATE_ADC_CHANNEL    ADC_CHANNEL_6   /* ADC1, GPIO34 */
+#define IO_STATE_POLL_MS        100             /* ADC/heap sampling */
+#define IO_STATE_ADC_DEADBAND   16              /* raw counts, filters noise */
+#define IO_STATE_HEAP_DEADBAND  1024            /* bytes */
+
+/* Bits of the changed mask; also the field order of binary deltas */
+#define IO_FIELD_BUTTON (1u << 0)
+#define IO_FIELD_LED    (1u << 1)
+#define IO_FIELD_ADC    (1u << 2)
+#define IO_FIELD_HEAP   (1u << 3)
+#define IO_FIELD_ALL    (IO_FIELD_BUTTON | IO_FIELD_LED | IO_FIELD_ADC | IO_FIELD_HEAP)
+
+typedef struct {
+    uint32_t seq;           /* bumped on every change */
+    uint8_t button;         /* 1 = pressed */
+    uint8_t led;
+    uint16_t adc_raw;
+    uint32_t free_heap;
+} io_state_t;
+
+/* Called from the io-state task whenever a field changes */
+typedef void (*io_state_cb)(const io_state_t *state, uint32_t changed, void *arg);
+
+esp_err_t io_state_start(io_state_cb cb, void *arg);
+void io_state_get(io_state_t *state);
+esp_err_t io_state_set_led(int on);
+
+#endif
@@ -7,6 +7,7 @@
    CONDITIONS OF ANY KIND, either express or implied.
 */
 #include <string.h>
+#include <inttypes.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_system.h"
@@ -23,11 +24,30 @@
 
 #include "soft-ap.h"
 #include "http-server.h"
+#include "file-server.h"
+#include "provision.h"
+#include "nvs-cache.h"
 
-#include "../mdns/include/mdns.h"
+#include "esp_app_desc.h"
+#include "discovery.h"
 
 static const char *SOFTAP_TAG = "wifi softAP";
 
+/* http://esp32-luchian-xxxxxx.local/ on both the softAP and the station side */
+static void start_discovery(void)
+{
+    const esp_app_desc_t *app = esp_app_get_description();
+    mdns_txt_item_t txt[] = {
+        { "version", app->version },
+        { "path", "/" },
+        { "caps", "provision,ws,static,metrics" },
+    };
+
+    if (discovery_init("esp32-luchian", "Lab6 provisioning") == ESP_OK) {
+        discovery_advertise("_http", "_tcp", 80, txt, sizeof(txt) / sizeof(txt[0]));
+    }
+}
+
 void app_main(void)
 {
     //Initialize NVS
@@ -38,89 +58,43 @@ void app_main(void)
     }
     ESP_ERROR_CHECK(ret);
 
-     // Initialize NVS
-     esp_err_t err = nvs_flash_init();
-     if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-         // NVS partition was truncated and needs to be erased
-         // Retry nvs_flash_init
-         ESP_ERROR_CHECK(nvs_flash_erase());
-         err = nvs_flash_init();
-     }
-     ESP_ERROR_CHECK( err );
-
-    static httpd_handle_t server = NULL;
-
-    // TODO: 3. Pornire mod STA + scanare SSID-uri disponibile
+    // Settings and counters live in RAM and reach flash in batches
+    // (nvs-cache.c), so none of this waits for a flash erase at boot
+    ESP_ERROR_CHECK(nvs_cache_init(NVS_CACHE_NAMESPACE));
 
+    int32_t restart_counter = 0; // value will default to 0, if not set yet in NVS
+    if (nvs_cache_get_i32("restart_counter", &restart_counter) == ESP_ERR_NVS_NOT_FOUND) {
+        ESP_LOGI(SOFTAP_TAG, "Restart counter not initialized yet");
+    }
+    restart_counter++;
+    // Committed right away: a crash or brownout soon after boot is exactly
+    // the restart this has to count
+    nvs_cache_set_critical("restart_counter", true);
+    nvs_cache_set_i32("restart_counter", restart_counter);
+    ESP_LOGI(SOFTAP_TAG, "Restart counter: %" PRId32, restart_counter);
 
-    // wifi_scan();
-
-    // TODO: 4. Initializare mDNS (daca mai ramana timp)   
-
+    static httpd_handle_t server = NULL;
 
     // TODO: 1. Pornire softAP
 
     ESP_LOGI(SOFTAP_TAG, "ESP_WIFI_MODE_AP");
     wifi_init_softap();
 
-    
-    esp_netif_init();
-    esp_event_loop_create_default();
-    esp_netif_t *wifi_netif = esp_netif_create_default_wifi_sta();
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    esp_wifi_init(&cfg);
-    esp_wifi_set_mode(WIFI_MODE_STA);
-    esp_wifi_start();
-    esp_wifi_stop();
-    esp_wifi_deinit();
-    esp_wifi_clear_default_wifi_driver_and_handlers(wifi_netif);
-    esp_netif_destroy(wifi_netif);
+    // TODO: 3. Pornire mod STA + scanare SSID-uri disponibile
+    // The AP runs in APSTA mode; networks are scanned in the background
+    // and cached so the provisioning page never waits for a scan
+    wifi_scan_start();
 
     // TODO: 2. Pornire server web (si config specifice in http-server.c) 
+    // Static assets (JS/CSS/fonts) live on the "storage" SPIFFS partition,
+    // uploaded from data/ with `pio run -t uploadfs`
+    file_server_mount();
     server = start_webserver();
 
-     // Open
-     printf("\n");
-     printf("Opening Non-Volatile Storage (NVS) handle... ");
-     nvs_handle_t my_handle;
-     err = nvs_open("storage", NVS_READWRITE, &my_handle);
-     if (err != ESP_OK) {
-         printf("Error (%s) opening NVS handle!\n", esp_err_to_name(err));
-     } else {
-         printf("Done\n");
- 
-         // Read
-         printf("Reading restart counter from NVS ... ");
-         int32_t restart_counter = 0; // value will default to 0, if not set yet in NVS
-         err = nvs_get_i32(my_handle, "restart_counter", &restart_counter);
-         switch (err) {
-             case ESP_OK:
-                 printf("Done\n");
-                 break;
-             case ESP_ERR_NVS_NOT_FOUND:
-                 printf("The value is not initialized yet!\n");
-                 break;
-             default :
-                 printf("Error (%s) reading!\n", esp_err_to_name(err));
-         }
- 
-         // Write
-         printf("Updating restart counter in NVS ... ");
-         restart_counter++;
-         err = nvs_set_i32(my_handle, "restart_counter", restart_counter);
-         printf((err != ESP_OK) ? "Failed!\n" : "Done\n");
- 
-         // Commit written value.
-         // After setting any values, nvs_commit() must be called to ensure changes are written
-         // to flash storage. Implementations may write to storage at other times,
-         // but this is not guaranteed.
-         printf("Committing updates in NVS ... ");
-         err = nvs_commit(my_handle);
-         printf((err != ESP_OK) ? "Failed!\n" : "Done\n");
- 
-         // Close
-         nvs_close(my_handle);
-     }
- 
-     printf("\n");
-}
\ No newline at end of file
+    // 4. mDNS (needs the event loop created by wifi_init_softap)
+    start_discovery();
+
+    // Saved credentials are tried first; the softAP stays up until the
+    // station has an IP, and comes back if the connection fails
+    ESP_ERROR_CHECK(provision_init());
+}
@@ -0,0 +1,375 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+#include "nvs-cache.h"
+
+static const char *TAG = "nvs-cache";
+
+#define NVS_ENTRY_SIZE 32
+
+typedef enum {
+    TYPE_NONE,          /* key not loaded yet */
+    TYPE_I32,
+    TYPE_U32,
+    TYPE_STR,
+} entry_type_t;
+
+typedef struct {
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    entry_type_t type;
+    bool exists;        /* present in NVS or set since boot */
+    bool dirty;
+    bool critical;
+    union {
+        int32_t i32;
+        uint32_t u32;
+        char str[NVS_CACHE_MAX_STR];
+    } v;
+} entry_t;
+
+static char s_namespace[NVS_KEY_NAME_MAX_SIZE];
+static entry_t s_entries[NVS_CACHE_MAX_KEYS];
+static int s_entry_count;
+static int s_dirty_count;
+static int64_t s_first_dirty_us;
+static nvs_cache_stats_t s_stats;
+static SemaphoreHandle_t s_lock;
+static TaskHandle_t s_flush_task;
+
+/* Must be called with s_lock held */
+static entry_t *entry_find(const char *key, bool create)
+{
+    for (int i = 0; i < s_entry_count; i++) {
+        if (strcmp(s_entries[i].key, key) == 0) {
+            return &s_entries[i];
+        }
+    }
+    if (!create || s_entry_count >= NVS_CACHE_MAX_KEYS || strlen(key) >= NVS_KEY_NAME_MAX_SIZE) {
+        return NULL;
+    }
+    entry_t *e = &s_entries[s_entry_count++];
+    memset(e, 0, sizeof(*e));
+    strcpy(e->key, key);
+    return e;
+}
+
+/* Must be called with s_lock held. First access of a key reads flash once. */
+static esp_err_t entry_load(entry_t *e, entry_type_t type)
+{
+    nvs_handle_t nvs;
+    esp_err_t err;
+
+    if (e->type == type) {
+        return ESP_OK;
+    }
+    if (e->type != TYPE_NONE) {
+        return ESP_ERR_NVS_TYPE_MISMATCH;
+    }
+
+    e->type = type;
+    s_stats.flash_reads++;
+    err = nvs_open(s_namespace, NVS_READONLY, &nvs);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        return ESP_OK;      /* namespace not created yet: key does not exist */
+    }
+    if (err != ESP_OK) {
+        e->type = TYPE_NONE;
+        return err;
+    }
+
+    size_t len = sizeof(e->v.str);
+    switch (type) {
+    case TYPE_I32:
+        err = nvs_get_i32(nvs, e->key, &e->v.i32);
+        break;
+    case TYPE_U32:
+        err = nvs_get_u32(nvs, e->key, &e->v.u32);
+        break;
+    case TYPE_STR:
+        err = nvs_get_str(nvs, e->key, e->v.str, &len);
+        break;
+    default:
+        err = ESP_ERR_INVALID_ARG;
+        break;
+    }
+    nvs_close(nvs);
+
+    if (err == ESP_OK) {
+        e->exists = true;
+    } else if (err != ESP_ERR_NVS_NOT_FOUND) {
+        e->type = TYPE_NONE;
+        return err;
+    }
+    return ESP_OK;
+}
+
+/* Must be called with s_lock held */
+static esp_err_t flush_locked(void)
+{
+    nvs_handle_t nvs;
+    int written = 0;
+    uint32_t bytes = 0;
+
+    if (s_dirty_count == 0) {
+        return ESP_OK;
+    }
+
+    int64_t t = esp_timer_get_time();
+    esp_err_t err = nvs_open(s_namespace, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) {
+        s_stats.errors++;
+        return err;
+    }
+    for (int i = 0; i < s_entry_count && err == ESP_OK; i++) {
+        entry_t *e = &s_entries[i];
+        if (!e->dirty) {
+            continue;
+        }
+        switch (e->type) {
+        case TYPE_I32:
+            err = nvs_set_i32(nvs, e->key, e->v.i32);
+            bytes += NVS_ENTRY_SIZE;
+            break;
+        case TYPE_U32:
+            err = nvs_set_u32(nvs, e->key, e->v.u32);
+            bytes += NVS_ENTRY_SIZE;
+            break;
+        case TYPE_STR:
+            err = nvs_set_str(nvs, e->key, e->v.str);
+            /* Header entry plus the data spans */
+            bytes += NVS_ENTRY_SIZE * (1 + (strlen(e->v.str) + NVS_ENTRY_SIZE) / NVS_ENTRY_SIZE);
+            break;
+        default:
+            break;
+        }
+        if (err == ESP_OK) {
+            e->dirty = false;
+            written++;
+        }
+    }
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+
+    s_dirty_count -= written;
+    if (err != ESP_OK) {
+        s_stats.errors++;
+        ESP_LOGE(TAG, "Commit failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    s_first_dirty_us = 0;
+    s_stats.commits++;
+    s_stats.keys_written += written;
+    s_stats.bytes_written += bytes;
+    ESP_LOGI(TAG, "Committed %d key(s), %u bytes in %lld ms (%u writes, %u commits so far)",
+             written, (unsigned)bytes, (long long)(esp_timer_get_time() - t) / 1000,
+             (unsigned)s_stats.writes, (unsigned)s_stats.commits);
+    return ESP_OK;
+}
+
+/* Must be called with s_lock held, after e changed */
+static esp_err_t mark_dirty(entry_t *e)
+{
+    e->exists = true;
+    if (!e->dirty) {
+        e->dirty = true;
+        s_dirty_count++;
+    }
+    if (e->critical) {
+        return flush_locked();
+    }
+    if (s_first_dirty_us == 0) {
+        s_first_dirty_us = esp_timer_get_time();
+    }
+    /* The flush task owns the timing; wake it to recompute */
+    xTaskNotifyGive(s_flush_task);
+    return ESP_OK;
+}
+
+static void flush_task(void *arg)
+{
+    for (;;) {
+        TickType_t wait = portMAX_DELAY;
+
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        int64_t now = esp_timer_get_time();
+        bool due = s_dirty_count >= NVS_CACHE_DIRTY_MAX ||
+                   (s_first_dirty_us && now - s_first_dirty_us >= NVS_CACHE_FLUSH_MS * 1000LL);
+        if (due && flush_locked() != ESP_OK) {
+            /* Retry after a full interval rather than spinning on flash */
+            s_first_dirty_us = now;
+        }
+        if (s_first_dirty_us) {
+            int64_t left_ms = NVS_CACHE_FLUSH_MS - (now - s_first_dirty_us) / 1000;
+            wait = pdMS_TO_TICKS(left_ms > 0 ? left_ms : 0) + 1;
+        }
+        xSemaphoreGive(s_lock);
+
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+static void shutdown_handler(void)
+{
+    nvs_cache_flush();
+}
+
+esp_err_t nvs_cache_init(const char *namespace_name)
+{
+    if (s_lock != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    strlcpy(s_namespace, namespace_name, sizeof(s_namespace));
+    s_lock = xSemaphoreCreateMutex();
+    if (s_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(flush_task, "nvs_cache", 3072, NULL, 2, &s_flush_task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return esp_register_shutdown_handler(shutdown_handler);
+}
+
+esp_err_t nvs_cache_get_i32(const char *key, int32_t *value)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_stats.reads++;
+    entry_t *e = entry_find(key, true);
+    esp_err_t err = e ? entry_load(e, TYPE_I32) : ESP_ERR_NO_MEM;
+    if (err == ESP_OK) {
+        if (e->exists) {
+            *value = e->v.i32;
+        } else {
+            err = ESP_ERR_NVS_NOT_FOUND;
+        }
+    }
+    xSemaphoreGive(s_lock);
+    return err;
+}
+
+esp_err_t nvs_cache_set_i32(const char *key, int32_t value)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_stats.writes++;
+    entry_t *e = entry_find(key, true);
+    esp_err_t err = e ? entry_load(e, TYPE_I32) : ESP_ERR_NO_MEM;
+    if (err == ESP_OK) {
+        if (e->exists && e->v.i32 == value) {
+            s_stats.writes_unchanged++;
+        } else {
+            e->v.i32 = value;
+            err = mark_dirty(e);
+        }
+    }
+    xSemaphoreGive(s_lock);
+    return err;
+}
+
+esp_err_t nvs_cache_get_u32(const char *key, uint32_t *value)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_stats.reads++;
+    entry_t *e = entry_find(key, true);
+    esp_err_t err = e ? entry_load(e, TYPE_U32) : ESP_ERR_NO_MEM;
+    if (err == ESP_OK) {
+        if (e->exists) {
+            *value = e->v.u32;
+        } else {
+            err = ESP_ERR_NVS_NOT_FOUND;
+        }
+    }
+    xSemaphoreGive(s_lock);
+    return err;
+}
+
+esp_err_t nvs_cache_set_u32(const char *key, uint32_t value)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_stats.writes++;
+    entry_t *e = entry_find(key, true);
+    esp_err_t err = e ? entry_load(e, TYPE_U32) : ESP_ERR_NO_MEM;
+    if (err == ESP_OK) {
+        if (e->exists && e->v.u32 == value) {
+            s_stats.writes_unchanged++;
+        } else {
+            e->v.u32 = value;
+            err = mark_dirty(e);
+        }
+    }
+    xSemaphoreGive(s_lock);
+    return err;
+}
+
+esp_err_t nvs_cache_get_str(const char *key, char *value, size_t size)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_stats.reads++;
+    entry_t *e = entry_find(key, true);
+    esp_err_t err = e ? entry_load(e, TYPE_STR) : ESP_ERR_NO_MEM;
+    if (err == ESP_OK) {
+        if (!e->exists) {
+            err = ESP_ERR_NVS_NOT_FOUND;
+        } else if (strlcpy(value, e->v.str, size) >= size) {
+            err = ESP_ERR_NVS_INVALID_LENGTH;
+        }
+    }
+    xSemaphoreGive(s_lock);
+    return err;
+}
+
+esp_err_t nvs_cache_set_str(const char *key, const char *value)
+{
+    if (strlen(value) >= NVS_CACHE_MAX_STR) {
+        return ESP_ERR_NVS_VALUE_TOO_LONG;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_stats.writes++;
+    entry_t *e = entry_find(key, true);
+    esp_err_t err = e ? entry_load(e, TYPE_STR) : ESP_ERR_NO_MEM;
+    if (err == ESP_OK) {
+        if (e->exists && strcmp(e->v.str, value) == 0) {
+            s_stats.writes_unchanged++;
+        } else {
+            strcpy(e->v.str, value);
+            err = mark_dirty(e);
+        }
+    }
+    xSemaphoreGive(s_lock);
+    return err;
+}
+
+esp_err_t nvs_cache_set_critical(const char *key, bool critical)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    entry_t *e = entry_find(key, true);
+    if (e) {
+        e->critical = critical;
+    }
+    xSemaphoreGive(s_lock);
+    return e ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t nvs_cache_flush(void)
+{
+    if (s_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    esp_err_t err = flush_locked();
+    xSemaphoreGive(s_lock);
+    return err;
+}
+
+void nvs_cache_get_stats(nvs_cache_stats_t *stats)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *stats = s_stats;
+    xSemaphoreGive(s_lock);
+}
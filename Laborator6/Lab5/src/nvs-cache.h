@@ -0,0 +1,48 @@
+#ifndef _NVS_CACHE_H_
+#define _NVS_CACHE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/* RAM copy of NVS keys. Reads never touch flash after the first one;
+ * writes are collected and committed together, NVS_CACHE_FLUSH_MS after
+ * the first change, when NVS_CACHE_DIRTY_MAX keys are pending, on
+ * nvs_cache_flush(), or from the esp_restart() shutdown hook. Keys marked
+ * critical are committed as soon as they change. */
+
+#define NVS_CACHE_NAMESPACE     "storage"
+#define NVS_CACHE_MAX_KEYS      16
+#define NVS_CACHE_MAX_STR       64      /* including the NUL */
+#define NVS_CACHE_FLUSH_MS      30000
+#define NVS_CACHE_DIRTY_MAX     8
+
+typedef struct {
+    uint32_t reads;             /* all served from RAM */
+    uint32_t flash_reads;       /* first read of a key */
+    uint32_t writes;            /* nvs_cache_set_*() calls */
+    uint32_t writes_unchanged;  /* same value, nothing to do */
+    uint32_t commits;
+    uint32_t keys_written;
+    uint32_t bytes_written;     /* NVS entry bytes, 32 per entry */
+    uint32_t errors;
+} nvs_cache_stats_t;
+
+esp_err_t nvs_cache_init(const char *namespace_name);
+
+esp_err_t nvs_cache_get_i32(const char *key, int32_t *value);
+esp_err_t nvs_cache_set_i32(const char *key, int32_t value);
+esp_err_t nvs_cache_get_u32(const char *key, uint32_t *value);
+esp_err_t nvs_cache_set_u32(const char *key, uint32_t value);
+esp_err_t nvs_cache_get_str(const char *key, char *value, size_t size);
+esp_err_t nvs_cache_set_str(const char *key, const char *value);
+
+/* Later writes to key are committed immediately */
+esp_err_t nvs_cache_set_critical(const char *key, bool critical);
+
+/* Commits everything pending; call before deep sleep */
+esp_err_t nvs_cache_flush(void);
+void nvs_cache_get_stats(nvs_cache_stats_t *stats);
+
+#endif
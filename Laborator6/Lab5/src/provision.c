@@ -0,0 +1,346 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_wifi.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
+
+#include "provision.h"
+#include "soft-ap.h"
+
+static const char *TAG = "provision";
+
+typedef enum {
+    MSG_SUBMIT,
+    MSG_GOT_IP,
+    MSG_DISCONNECTED,
+} prov_msg_type_t;
+
+typedef struct {
+    prov_msg_type_t type;
+    uint8_t reason;
+    esp_ip4_addr_t ip;
+} prov_msg_t;
+
+/* All Wi-Fi mode changes happen in the provisioning task; event handlers
+ * and the HTTP server only post messages to it */
+static QueueHandle_t s_queue;
+static SemaphoreHandle_t s_lock;        /* s_status, s_pending */
+static prov_status_t s_status;
+static wifi_config_t s_pending;
+static bool s_from_nvs;
+static int64_t s_t_submit;
+static int64_t s_deadline_us;           /* 0: no timeout pending */
+
+const char *provision_state_str(prov_state_t state)
+{
+    switch (state) {
+    case PROV_IDLE:       return "idle";
+    case PROV_CONNECTING: return "connecting";
+    case PROV_CONNECTED:  return "connected";
+    case PROV_FAILED:     return "failed";
+    default:              return "unknown";
+    }
+}
+
+static void set_state(prov_state_t state)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_status.state = state;
+    s_status.elapsed_ms = (esp_timer_get_time() - s_t_submit) / 1000;
+    xSemaphoreGive(s_lock);
+}
+
+static esp_err_t creds_save(const wifi_config_t *cfg)
+{
+    /* A 32 character SSID or 64 character passphrase fills the wifi_config_t
+     * field with no terminator left */
+    char ssid[sizeof(cfg->sta.ssid) + 1];
+    char pass[sizeof(cfg->sta.password) + 1];
+    nvs_handle_t nvs;
+
+    memcpy(ssid, cfg->sta.ssid, sizeof(cfg->sta.ssid));
+    ssid[sizeof(cfg->sta.ssid)] = '\0';
+    memcpy(pass, cfg->sta.password, sizeof(cfg->sta.password));
+    pass[sizeof(cfg->sta.password)] = '\0';
+
+    esp_err_t err = nvs_open(PROV_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = nvs_set_str(nvs, "ssid", ssid);
+    if (err == ESP_OK) {
+        err = nvs_set_str(nvs, "pass", pass);
+    }
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    return err;
+}
+
+static esp_err_t creds_load(char *ssid, size_t ssid_size, char *pass, size_t pass_size)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(PROV_NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = nvs_get_str(nvs, "ssid", ssid, &ssid_size);
+    if (err == ESP_OK) {
+        err = nvs_get_str(nvs, "pass", pass, &pass_size);
+    }
+    nvs_close(nvs);
+    return err;
+}
+
+static void start_attempt(void)
+{
+    wifi_config_t cfg;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    cfg = s_pending;
+    s_status.attempts++;
+    xSemaphoreGive(s_lock);
+
+    esp_wifi_disconnect();
+    esp_err_t err = esp_wifi_set_config(WIFI_IF_STA, &cfg);
+    if (err == ESP_OK) {
+        err = esp_wifi_connect();
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Connect to %.*s not started: %s",
+                 (int)strnlen((const char *)cfg.sta.ssid, sizeof(cfg.sta.ssid)),
+                 cfg.sta.ssid, esp_err_to_name(err));
+    }
+}
+
+/* Validation failed or the link is gone: the softAP takes over again */
+static void fall_back_to_ap(uint8_t reason)
+{
+    esp_wifi_disconnect();
+    if (!s_status.ap_active) {
+        esp_wifi_set_mode(WIFI_MODE_APSTA);
+    }
+    wifi_scan_start();
+    s_deadline_us = 0;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_status.ap_active = true;
+    s_status.reason = reason;
+    xSemaphoreGive(s_lock);
+    set_state(PROV_FAILED);
+    ESP_LOGW(TAG, "%s failed after %d attempt(s), %lld ms, reason %u; softAP is up",
+             s_status.ssid, s_status.attempts, (long long)s_status.elapsed_ms, reason);
+}
+
+static bool is_auth_failure(uint8_t reason)
+{
+    /* A wrong key does not get better with retries */
+    return reason == WIFI_REASON_AUTH_FAIL ||
+           reason == WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT ||
+           reason == WIFI_REASON_HANDSHAKE_TIMEOUT;
+}
+
+static void handle_msg(const prov_msg_t *msg)
+{
+    switch (msg->type) {
+    case MSG_SUBMIT:
+        /* Scans and connects share the radio; the page shows the cache */
+        wifi_scan_stop();
+        s_deadline_us = s_t_submit + PROV_CONNECT_TIMEOUT_MS * 1000LL;
+        start_attempt();
+        break;
+
+    case MSG_GOT_IP:
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        s_status.ip = msg->ip;
+        xSemaphoreGive(s_lock);
+        if (s_status.state != PROV_CONNECTING) {
+            break;      /* reconnected after a drop */
+        }
+        set_state(PROV_CONNECTED);
+        ESP_LOGI(TAG, "Connected to %s, IP " IPSTR " in %lld ms (%d attempt(s))",
+                 s_status.ssid, IP2STR(&msg->ip), (long long)s_status.elapsed_ms,
+                 s_status.attempts);
+        if (!s_from_nvs) {
+            esp_err_t err = creds_save(&s_pending);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Saving credentials failed: %s", esp_err_to_name(err));
+            }
+        }
+        s_deadline_us = s_status.ap_active ? esp_timer_get_time() + PROV_AP_LINGER_MS * 1000LL : 0;
+        break;
+
+    case MSG_DISCONNECTED:
+        /* Our own esp_wifi_disconnect() before a new attempt */
+        if (msg->reason == WIFI_REASON_ASSOC_LEAVE) {
+            break;
+        }
+        if (s_status.state == PROV_CONNECTING) {
+            if (is_auth_failure(msg->reason) || s_status.attempts >= PROV_MAX_ATTEMPTS) {
+                fall_back_to_ap(msg->reason);
+            } else {
+                start_attempt();
+            }
+        } else if (s_status.state == PROV_CONNECTED) {
+            ESP_LOGW(TAG, "Lost %s, reason %u; reconnecting", s_status.ssid, msg->reason);
+            xSemaphoreTake(s_lock, portMAX_DELAY);
+            s_status.attempts = 0;
+            xSemaphoreGive(s_lock);
+            s_from_nvs = true;      /* already saved */
+            s_t_submit = esp_timer_get_time();
+            s_deadline_us = s_t_submit + PROV_CONNECT_TIMEOUT_MS * 1000LL;
+            set_state(PROV_CONNECTING);
+            start_attempt();
+        }
+        break;
+    }
+}
+
+static void handle_timeout(void)
+{
+    s_deadline_us = 0;
+    if (s_status.state == PROV_CONNECTING) {
+        fall_back_to_ap(s_status.reason);
+    } else if (s_status.state == PROV_CONNECTED && s_status.ap_active) {
+        esp_wifi_set_mode(WIFI_MODE_STA);
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        s_status.ap_active = false;
+        xSemaphoreGive(s_lock);
+        ESP_LOGI(TAG, "softAP off, running as station only");
+    }
+}
+
+static void provision_task(void *arg)
+{
+    prov_msg_t msg;
+
+    for (;;) {
+        TickType_t wait = portMAX_DELAY;
+        if (s_deadline_us) {
+            int64_t left_us = s_deadline_us - esp_timer_get_time();
+            wait = left_us > 0 ? pdMS_TO_TICKS(left_us / 1000) + 1 : 0;
+        }
+        if (xQueueReceive(s_queue, &msg, wait) == pdTRUE) {
+            handle_msg(&msg);
+        } else {
+            handle_timeout();
+        }
+    }
+}
+
+static void event_handler(void *arg, esp_event_base_t event_base,
+                          int32_t event_id, void *event_data)
+{
+    prov_msg_t msg = {0};
+
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        msg.type = MSG_DISCONNECTED;
+        msg.reason = ((wifi_event_sta_disconnected_t *)event_data)->reason;
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        msg.type = MSG_GOT_IP;
+        msg.ip = ((ip_event_got_ip_t *)event_data)->ip_info.ip;
+    } else {
+        return;
+    }
+    xQueueSend(s_queue, &msg, 0);
+}
+
+/* Queues a connection attempt and returns right away; progress is
+ * available through provision_get_status() */
+static esp_err_t submit(const char *ssid, const char *pass, bool from_nvs)
+{
+    size_t ssid_len = strlen(ssid);
+    size_t pass_len = strlen(pass);
+    scan_entry_t seen[SCAN_CACHE_SIZE];
+
+    if (ssid_len == 0 || ssid_len > 32 || (pass_len > 0 && pass_len < 8) || pass_len > 64) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* Known channel: the STA skips the all-channel scan before joining */
+    uint8_t channel = 0;
+    int n = wifi_scan_get_cached(seen, SCAN_CACHE_SIZE);
+    for (int i = 0; i < n; i++) {
+        if (strcmp(seen[i].ssid, ssid) == 0) {
+            channel = seen[i].channel;
+            break;
+        }
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (s_status.state == PROV_CONNECTING) {
+        xSemaphoreGive(s_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    memset(&s_pending, 0, sizeof(s_pending));
+    memcpy(s_pending.sta.ssid, ssid, ssid_len);
+    memcpy(s_pending.sta.password, pass, pass_len);
+    s_pending.sta.channel = channel;
+    s_pending.sta.scan_method = WIFI_FAST_SCAN;
+    s_pending.sta.threshold.authmode = pass_len ? WIFI_AUTH_WPA_PSK : WIFI_AUTH_OPEN;
+    strlcpy(s_status.ssid, ssid, sizeof(s_status.ssid));
+    s_status.state = PROV_CONNECTING;
+    s_status.attempts = 0;
+    s_status.reason = 0;
+    s_status.ip.addr = 0;
+    s_from_nvs = from_nvs;
+    s_t_submit = esp_timer_get_time();
+    xSemaphoreGive(s_lock);
+
+    prov_msg_t msg = { .type = MSG_SUBMIT };
+    xQueueSend(s_queue, &msg, portMAX_DELAY);
+    ESP_LOGI(TAG, "Trying %s%s", ssid, from_nvs ? " (saved)" : "");
+    return ESP_OK;
+}
+
+esp_err_t provision_submit(const char *ssid, const char *pass)
+{
+    return submit(ssid, pass, false);
+}
+
+void provision_get_status(prov_status_t *status)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *status = s_status;
+    if (status->state == PROV_CONNECTING) {
+        status->elapsed_ms = (esp_timer_get_time() - s_t_submit) / 1000;
+    }
+    xSemaphoreGive(s_lock);
+}
+
+/* Call after wifi_init_softap(). Saved credentials are tried right away;
+ * the softAP stays up until they work. */
+esp_err_t provision_init(void)
+{
+    char ssid[33], pass[65];
+
+    s_lock = xSemaphoreCreateMutex();
+    s_queue = xQueueCreate(8, sizeof(prov_msg_t));
+    if (s_lock == NULL || s_queue == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_status.state = PROV_IDLE;
+    s_status.ap_active = true;
+
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED,
+                                                        &event_handler, NULL, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP,
+                                                        &event_handler, NULL, NULL));
+
+    if (xTaskCreate(provision_task, "provision", 3072, NULL, 5, NULL) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (creds_load(ssid, sizeof(ssid), pass, sizeof(pass)) == ESP_OK) {
+        return submit(ssid, pass, true);
+    }
+    ESP_LOGI(TAG, "No saved network, waiting for the form on the softAP");
+    return ESP_OK;
+}
@@ -0,0 +1,36 @@
+#ifndef _PROVISION_H_
+#define _PROVISION_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_netif_ip_addr.h"
+
+#define PROV_NVS_NAMESPACE      "wifi_prov"
+#define PROV_CONNECT_TIMEOUT_MS 15000   /* whole validation, all attempts */
+#define PROV_MAX_ATTEMPTS       3
+#define PROV_AP_LINGER_MS       5000    /* keep the AP up so the page can show the IP */
+
+typedef enum {
+    PROV_IDLE,          /* softAP, waiting for the form */
+    PROV_CONNECTING,    /* APSTA, trying the submitted credentials */
+    PROV_CONNECTED,     /* got an IP; the AP goes off after PROV_AP_LINGER_MS */
+    PROV_FAILED,        /* back on softAP, see reason */
+} prov_state_t;
+
+typedef struct {
+    prov_state_t state;
+    char ssid[33];
+    esp_ip4_addr_t ip;
+    uint8_t reason;         /* wifi_err_reason_t of the last disconnect */
+    int attempts;
+    int64_t elapsed_ms;     /* submit to IP, or to failure; running while connecting */
+    bool ap_active;
+} prov_status_t;
+
+esp_err_t provision_init(void);
+esp_err_t provision_submit(const char *ssid, const char *pass);
+void provision_get_status(prov_status_t *status);
+const char *provision_state_str(prov_state_t state);
+
+#endif
@@ -0,0 +1,118 @@
+#include <string.h>
+#include "esp_log.h"
+
+#include "esp_http_server.h"
+
+#include "async-pool.h"
+#include "router.h"
+
+static const char *TAG = "router";
+
+static const router_table_t *s_table;
+static int s_pool_base;     /* async-pool id of s_table->routes[0] */
+static uint32_t s_methods;  /* bit per method with at least one route */
+
+uint32_t router_hash(uint32_t seed, int method, const char *path, size_t len)
+{
+    uint32_t h = 2166136261u ^ seed;
+
+    h = (h ^ (uint8_t)method) * 16777619u;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (uint8_t)path[i]) * 16777619u;
+    }
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+const router_route_t *router_find(const router_table_t *table, int method,
+                                  const char *path, size_t len)
+{
+    uint32_t bucket = router_hash(0, method, path, len) % table->bucket_count;
+    uint32_t slot = router_hash(table->disp[bucket], method, path, len) % table->slot_count;
+    int16_t i = table->slots[slot];
+
+    /* Every path lands on some slot; only a compare tells if it is ours */
+    if (i >= 0) {
+        const router_route_t *r = &table->routes[i];
+        if ((int)r->method == method && strncmp(r->uri, path, len) == 0 && r->uri[len] == '\0') {
+            return r;
+        }
+    }
+    for (int p = 0; p < table->prefix_count; p++) {
+        const router_route_t *r = &table->routes[table->prefixes[p]];
+        size_t prefix_len = strlen(r->uri) - 1;
+        if ((int)r->method == method && len >= prefix_len && strncmp(r->uri, path, prefix_len) == 0) {
+            return r;
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t router_dispatch(httpd_req_t *req)
+{
+    size_t len = strcspn(req->uri, "?");
+    const router_route_t *r = router_find(s_table, req->method, req->uri, len);
+
+    if (r == NULL) {
+        /* Known path under another method is a 405, like httpd does */
+        for (int m = 0; m < 32; m++) {
+            if ((s_methods & (1u << m)) && m != req->method
+                    && router_find(s_table, m, req->uri, len)) {
+                return httpd_resp_send_err(req, HTTPD_405_METHOD_NOT_ALLOWED, NULL);
+            }
+        }
+        ESP_LOGD(TAG, "No route for %s", req->uri);
+        return httpd_resp_send_404(req);
+    }
+    return async_pool_dispatch(req, s_pool_base + (r - s_table->routes));
+}
+
+esp_err_t router_register(httpd_handle_t server, const router_table_t *table)
+{
+    int id;
+
+    if (s_table != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (int i = 0; i < table->route_count; i++) {
+        const router_route_t *r = &table->routes[i];
+        const httpd_uri_t uri = {
+            .uri = r->uri,
+            .method = r->method,
+            .handler = r->handler,
+            .user_ctx = r->user_ctx,
+        };
+        esp_err_t err = async_pool_add_route(&uri, r->slow, &id);
+        if (err != ESP_OK) {
+            return err;
+        }
+        /* Ids are consecutive, nothing else adds routes meanwhile */
+        if (i == 0) {
+            s_pool_base = id;
+        }
+        s_methods |= 1u << r->method;
+    }
+    s_table = table;
+
+    for (int m = 0; m < 32; m++) {
+        if (!(s_methods & (1u << m))) {
+            continue;
+        }
+        const httpd_uri_t catch_all = {
+            .uri = "/*",
+            .method = m,
+            .handler = router_dispatch,
+        };
+        esp_err_t err = httpd_register_uri_handler(server, &catch_all);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Catch-all for %s not registered: %s", http_method_str(m), esp_err_to_name(err));
+            return err;
+        }
+    }
+    ESP_LOGI(TAG, "%d routes in %d slots", table->route_count, table->slot_count);
+    return ESP_OK;
+}
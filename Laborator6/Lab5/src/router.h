@@ -0,0 +1,46 @@
+#ifndef _ROUTER_H_
+#define _ROUTER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+/* Routes are listed in routes.txt and turned into a router_table_t by
+ * gen_routes.py at build time. httpd only sees one catch-all handler
+ * per method; the request is resolved here with a perfect hash instead of
+ * httpd's linear scan over registered handlers. */
+
+typedef struct {
+    const char *uri;        /* exact path, or prefix ending in '*' */
+    httpd_method_t method;
+    esp_err_t (*handler)(httpd_req_t *r);
+    void *user_ctx;
+    bool slow;              /* runs on the async-pool workers */
+} router_route_t;
+
+typedef struct {
+    const router_route_t *routes;
+    uint16_t route_count;
+    const uint8_t *disp;    /* per bucket: seed of the second hash */
+    uint16_t bucket_count;
+    const int16_t *slots;   /* route index, -1 for a free slot */
+    uint16_t slot_count;
+    const uint8_t *prefixes; /* prefix routes, longest first */
+    uint16_t prefix_count;
+} router_table_t;
+
+/* Same function as router_hash() in gen_routes.py */
+uint32_t router_hash(uint32_t seed, int method, const char *path, size_t len);
+
+/* Route for method and the first len bytes of path, or NULL */
+const router_route_t *router_find(const router_table_t *table, int method,
+                                  const char *path, size_t len);
+
+/* Adds every route to the async pool and registers the catch-all
+ * handlers. Needs config.uri_match_fn = httpd_uri_match_wildcard, and
+ * handlers registered after this are never reached. */
+esp_err_t router_register(httpd_handle_t server, const router_table_t *table);
+
+#endif
@@ -10,12 +10,14 @@
 #include "lwip/err.h"
 #include "lwip/sys.h"
 #include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
 
 #include "soft-ap.h"
 
 #define WIFI_SOFT_AP_STARTED_BIT BIT0
 
-#define DEFAULT_SCAN_LIST_SIZE 10
+#define DEFAULT_SCAN_LIST_SIZE 20
 
 static const char *SCAN_TAG = "scan";
 
@@ -23,6 +25,15 @@ EventGroupHandle_t s_wifi_event_group;
 
 static const char *TAG = "wifi softAP";
 
+/* Raw records of the last scan and the deduplicated cache built from them */
+static wifi_ap_record_t s_scan_records[DEFAULT_SCAN_LIST_SIZE];
+static scan_entry_t s_scan_cache[SCAN_CACHE_SIZE];
+static int s_scan_cache_count;
+static SemaphoreHandle_t s_scan_lock;
+static esp_timer_handle_t s_scan_timer;
+
+static void wifi_scan_done(void);
+
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                                     int32_t event_id, void* event_data)
 {
@@ -37,6 +48,8 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
     } else if (event_id == WIFI_EVENT_AP_START) {
         ESP_LOGI(TAG, "Event: SoftAP started");
         xEventGroupSetBits(s_wifi_event_group, WIFI_SOFT_AP_STARTED_BIT);
+    } else if (event_id == WIFI_EVENT_SCAN_DONE) {
+        wifi_scan_done();
     }
 }
 
@@ -47,6 +60,9 @@ void wifi_init_softap(void)
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
     esp_netif_create_default_wifi_ap();
+    /* The STA interface scans in the background and joins the network
+     * chosen on the provisioning page (provision.c) */
+    esp_netif_create_default_wifi_sta();
 
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
@@ -71,7 +87,7 @@ void wifi_init_softap(void)
         wifi_config.ap.authmode = WIFI_AUTH_OPEN;
     }
 
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_AP));
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_APSTA));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_AP, &wifi_config));
     ESP_ERROR_CHECK(esp_wifi_start());
     esp_wifi_set_ps(WIFI_PS_NONE);
@@ -170,38 +186,159 @@ static void print_cipher_type(int pairwise_cipher, int group_cipher)
     }
 }
 
-/* Initialize Wi-Fi as sta and set scan method */
-void wifi_scan(void)
+static void scan_timer_cb(void *arg)
 {
-    ESP_ERROR_CHECK(esp_netif_init());
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
-    esp_netif_t *sta_netif = esp_netif_create_default_wifi_sta();
-    assert(sta_netif);
+    wifi_scan_config_t scan_config = {
+        .show_hidden = false,
+        .scan_type = WIFI_SCAN_TYPE_ACTIVE,
+    };
+    /* Non-blocking: results arrive with WIFI_EVENT_SCAN_DONE */
+    esp_err_t err = esp_wifi_scan_start(&scan_config, false);
+    if (err != ESP_OK) {
+        ESP_LOGD(SCAN_TAG, "Scan not started: %s", esp_err_to_name(err));
+    }
+}
 
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
+/* Must be called with s_scan_lock held */
+static void scan_cache_expire(int64_t now)
+{
+    int kept = 0;
+    for (int i = 0; i < s_scan_cache_count; i++) {
+        if (now - s_scan_cache[i].last_seen_us < SCAN_CACHE_TTL_MS * 1000LL) {
+            s_scan_cache[kept++] = s_scan_cache[i];
+        }
+    }
+    s_scan_cache_count = kept;
+}
 
+/* Must be called with s_scan_lock held. One entry per SSID: several APs
+ * of the same network keep the strongest signal of the latest scan. */
+static void scan_cache_insert(const wifi_ap_record_t *rec, int64_t now)
+{
+    scan_entry_t *entry = NULL;
+
+    if (rec->ssid[0] == '\0') {
+        return;
+    }
+    for (int i = 0; i < s_scan_cache_count; i++) {
+        if (strcmp(s_scan_cache[i].ssid, (const char *)rec->ssid) == 0) {
+            entry = &s_scan_cache[i];
+            if (entry->last_seen_us == now && entry->rssi >= rec->rssi) {
+                return;
+            }
+            break;
+        }
+    }
+
+    if (entry == NULL) {
+        if (s_scan_cache_count < SCAN_CACHE_SIZE) {
+            entry = &s_scan_cache[s_scan_cache_count++];
+        } else if (s_scan_cache[SCAN_CACHE_SIZE - 1].rssi < rec->rssi) {
+            /* Cache is sorted, the last entry is the weakest */
+            entry = &s_scan_cache[SCAN_CACHE_SIZE - 1];
+        } else {
+            return;
+        }
+        ESP_LOGI(SCAN_TAG, "SSID \t\t%s", rec->ssid);
+        ESP_LOGI(SCAN_TAG, "RSSI \t\t%d", rec->rssi);
+        print_auth_mode(rec->authmode);
+        if (rec->authmode != WIFI_AUTH_WEP) {
+            print_cipher_type(rec->pairwise_cipher, rec->group_cipher);
+        }
+        ESP_LOGI(SCAN_TAG, "Channel \t\t%d\n", rec->primary);
+    }
+
+    strlcpy(entry->ssid, (const char *)rec->ssid, sizeof(entry->ssid));
+    entry->rssi = rec->rssi;
+    entry->channel = rec->primary;
+    entry->authmode = rec->authmode;
+    entry->last_seen_us = now;
+}
+
+/* Must be called with s_scan_lock held */
+static void scan_cache_sort(void)
+{
+    for (int i = 1; i < s_scan_cache_count; i++) {
+        scan_entry_t tmp = s_scan_cache[i];
+        int j = i - 1;
+        while (j >= 0 && s_scan_cache[j].rssi < tmp.rssi) {
+            s_scan_cache[j + 1] = s_scan_cache[j];
+            j--;
+        }
+        s_scan_cache[j + 1] = tmp;
+    }
+}
+
+static void wifi_scan_done(void)
+{
     uint16_t number = DEFAULT_SCAN_LIST_SIZE;
-    wifi_ap_record_t ap_info[DEFAULT_SCAN_LIST_SIZE];
-    uint16_t ap_count = 0;
-    memset(ap_info, 0, sizeof(ap_info));
 
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_start());
-    esp_wifi_scan_start(NULL, true);
-    ESP_LOGI(SCAN_TAG, "Max AP number ap_info can hold = %u", number);
-    ESP_ERROR_CHECK(esp_wifi_scan_get_ap_records(&number, ap_info));
-    ESP_ERROR_CHECK(esp_wifi_scan_get_ap_num(&ap_count));
-    ESP_LOGI(SCAN_TAG, "Total APs scanned = %u, actual AP number ap_info holds = %u", ap_count, number);
+    if (esp_wifi_scan_get_ap_records(&number, s_scan_records) != ESP_OK) {
+        return;
+    }
+    /* A scan someone else started before wifi_scan_start(): the records
+     * above are still fetched so the driver frees its list */
+    if (s_scan_lock == NULL) {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    xSemaphoreTake(s_scan_lock, portMAX_DELAY);
+    scan_cache_expire(now);
     for (int i = 0; i < number; i++) {
-        ESP_LOGI(SCAN_TAG, "SSID \t\t%s", ap_info[i].ssid);
-        ESP_LOGI(SCAN_TAG, "RSSI \t\t%d", ap_info[i].rssi);
-        print_auth_mode(ap_info[i].authmode);
-        if (ap_info[i].authmode != WIFI_AUTH_WEP) {
-            print_cipher_type(ap_info[i].pairwise_cipher, ap_info[i].group_cipher);
-        }
-        ESP_LOGI(SCAN_TAG, "Channel \t\t%d\n", ap_info[i].primary);
+        scan_cache_insert(&s_scan_records[i], now);
+        scan_cache_sort();
     }
+    int cached = s_scan_cache_count;
+    xSemaphoreGive(s_scan_lock);
 
+    ESP_LOGD(SCAN_TAG, "Scan done: %u APs, %d networks cached", number, cached);
 }
 
+/* Starts periodic scans in the background; the first one runs right away.
+ * Calling it again after wifi_scan_stop() resumes the scans. */
+void wifi_scan_start(void)
+{
+    if (s_scan_lock == NULL) {
+        s_scan_lock = xSemaphoreCreateMutex();
+
+        const esp_timer_create_args_t timer_args = {
+            .callback = scan_timer_cb,
+            .name = "wifi_scan",
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_scan_timer));
+    }
+    if (esp_timer_is_active(s_scan_timer)) {
+        return;
+    }
+    ESP_ERROR_CHECK(esp_timer_start_periodic(s_scan_timer, SCAN_INTERVAL_MS * 1000ULL));
+    scan_timer_cb(NULL);
+}
+
+/* Stops the periodic scans, e.g. while the STA connects. The cache keeps
+ * what was found so far. */
+void wifi_scan_stop(void)
+{
+    if (s_scan_timer == NULL) {
+        return;
+    }
+    esp_timer_stop(s_scan_timer);
+    esp_wifi_scan_stop();
+}
+
+/* Copies the cached networks, strongest first. Never blocks on a scan. */
+int wifi_scan_get_cached(scan_entry_t *entries, int max_entries)
+{
+    int n = 0;
+
+    if (s_scan_lock == NULL) {
+        return 0;
+    }
+    xSemaphoreTake(s_scan_lock, portMAX_DELAY);
+    scan_cache_expire(esp_timer_get_time());
+    for (; n < s_scan_cache_count && n < max_entries; n++) {
+        entries[n] = s_scan_cache[n];
+    }
+    xSemaphoreGive(s_scan_lock);
+    return n;
+}
@@ -1,12 +1,29 @@
 #ifndef _SOFT_AP_H_
 #define _SOFT_AP_H_
 
+#include <stdint.h>
+#include "esp_wifi_types.h"
+
 #define EXAMPLE_ESP_WIFI_SSID      "esp32-luchian"
 #define EXAMPLE_ESP_WIFI_PASS      "12345678"
 #define EXAMPLE_ESP_WIFI_CHANNEL   6
 #define EXAMPLE_MAX_STA_CONN       4
 
+#define SCAN_CACHE_SIZE            16
+#define SCAN_INTERVAL_MS           15000
+#define SCAN_CACHE_TTL_MS          60000
+
+typedef struct {
+    char ssid[33];
+    int8_t rssi;
+    uint8_t channel;
+    wifi_auth_mode_t authmode;
+    int64_t last_seen_us;
+} scan_entry_t;
+
 void wifi_init_softap(void);
-void wifi_scan(void);
+void wifi_scan_start(void);
+void wifi_scan_stop(void);
+int wifi_scan_get_cached(scan_entry_t *entries, int max_entries);
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
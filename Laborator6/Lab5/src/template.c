@@ -0,0 +1,101 @@
+#include <string.h>
+
+#include "template.h"
+
+void tmpl_out_init(tmpl_out_t *out, tmpl_flush_fn flush, void *ctx)
+{
+    out->flush = flush;
+    out->ctx = ctx;
+    out->len = 0;
+}
+
+esp_err_t tmpl_flush(tmpl_out_t *out)
+{
+    esp_err_t err = ESP_OK;
+    if (out->len > 0) {
+        err = out->flush(out->ctx, out->buf, out->len);
+        out->len = 0;
+    }
+    return err;
+}
+
+esp_err_t tmpl_write(tmpl_out_t *out, const char *data, size_t len)
+{
+    if (out->len + len <= sizeof(out->buf)) {
+        memcpy(out->buf + out->len, data, len);
+        out->len += len;
+        return ESP_OK;
+    }
+
+    esp_err_t err = tmpl_flush(out);
+    if (err != ESP_OK) {
+        return err;
+    }
+    /* Too big to be worth copying: hand it over as it is */
+    if (len > sizeof(out->buf) / 2) {
+        return out->flush(out->ctx, data, len);
+    }
+    memcpy(out->buf, data, len);
+    out->len = len;
+    return ESP_OK;
+}
+
+esp_err_t tmpl_write_str(tmpl_out_t *out, const char *str)
+{
+    return tmpl_write(out, str, strlen(str));
+}
+
+/* Escapes text for use in element content and quoted attribute values */
+esp_err_t tmpl_write_escaped(tmpl_out_t *out, const char *str)
+{
+    esp_err_t err = ESP_OK;
+    const char *run = str;
+
+    for (const char *p = str; *p && err == ESP_OK; p++) {
+        const char *entity;
+        switch (*p) {
+        case '&':  entity = "&amp;";  break;
+        case '<':  entity = "&lt;";   break;
+        case '>':  entity = "&gt;";   break;
+        case '"':  entity = "&quot;"; break;
+        case '\'': entity = "&#39;";  break;
+        default:   continue;
+        }
+        err = tmpl_write(out, run, p - run);
+        if (err == ESP_OK) {
+            err = tmpl_write_str(out, entity);
+        }
+        run = p + 1;
+    }
+    if (err == ESP_OK) {
+        err = tmpl_write_str(out, run);
+    }
+    return err;
+}
+
+esp_err_t tmpl_render(tmpl_out_t *out, const char *tmpl, size_t len, tmpl_var_fn var, void *user)
+{
+    const char *p = tmpl;
+    const char *end = tmpl + len;
+    esp_err_t err = ESP_OK;
+
+    while (p < end && err == ESP_OK) {
+        const char *open = memmem(p, end - p, "{{", 2);
+        const char *close = open ? memmem(open + 2, end - open - 2, "}}", 2) : NULL;
+        if (close == NULL) {
+            err = tmpl_write(out, p, end - p);
+            break;
+        }
+
+        err = tmpl_write(out, p, open - p);
+        if (err == ESP_OK) {
+            err = var(out, open + 2, close - open - 2, user);
+        }
+        p = close + 2;
+    }
+
+    if (err == ESP_OK) {
+        err = tmpl_flush(out);
+    }
+    return err;
+}
@@ -0,0 +1,30 @@
+#ifndef _TEMPLATE_H_
+#define _TEMPLATE_H_
+
+#include <stddef.h>
+#include "esp_err.h"
+
+#define TMPL_OUT_BUF_SIZE 512
+
+/* Receives rendered output in pieces of at most TMPL_OUT_BUF_SIZE bytes
+ * (larger literal runs of the template are passed through directly) */
+typedef esp_err_t (*tmpl_flush_fn)(void *ctx, const char *data, size_t len);
+
+typedef struct {
+    tmpl_flush_fn flush;
+    void *ctx;
+    size_t len;
+    char buf[TMPL_OUT_BUF_SIZE];
+} tmpl_out_t;
+
+/* Called for every {{name}} in the template; writes the value to out */
+typedef esp_err_t (*tmpl_var_fn)(tmpl_out_t *out, const char *name, size_t name_len, void *user);
+
+void tmpl_out_init(tmpl_out_t *out, tmpl_flush_fn flush, void *ctx);
+esp_err_t tmpl_write(tmpl_out_t *out, const char *data, size_t len);
+esp_err_t tmpl_write_str(tmpl_out_t *out, const char *str);
+esp_err_t tmpl_write_escaped(tmpl_out_t *out, const char *str);
+esp_err_t tmpl_flush(tmpl_out_t *out);
+esp_err_t tmpl_render(tmpl_out_t *out, const char *tmpl, size_t len, tmpl_var_fn var, void *user);
+
+#endif
@@ -0,0 +1,305 @@
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+
+#include "esp_http_server.h"
+
+#include "async-pool.h"
+#include "form-parser.h"
+#include "io-state.h"
+#include "ws-server.h"
+
+static const char *TAG = "ws-server";
+
+typedef struct {
+    int fd;                 /* -1: free */
+    bool binary;
+    int pending;            /* frames queued with httpd_queue_work() */
+} ws_client_t;
+
+/* One queued frame for one client */
+typedef struct {
+    int fd;
+    bool binary;
+    size_t len;
+    uint8_t data[WS_MAX_FRAME_LEN];
+} ws_job_t;
+
+static httpd_handle_t s_server;
+static ws_client_t s_clients[WS_MAX_CLIENTS];
+static SemaphoreHandle_t s_clients_lock;
+
+static ws_client_t *client_find(int fd)
+{
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (s_clients[i].fd == fd) {
+            return &s_clients[i];
+        }
+    }
+    return NULL;
+}
+
+static size_t encode_json(char *buf, size_t size, const io_state_t *st, uint32_t changed)
+{
+    int n = snprintf(buf, size, "{\"seq\":%" PRIu32, st->seq);
+    if (changed & IO_FIELD_BUTTON) {
+        n += snprintf(buf + n, size - n, ",\"button\":%u", st->button);
+    }
+    if (changed & IO_FIELD_LED) {
+        n += snprintf(buf + n, size - n, ",\"led\":%u", st->led);
+    }
+    if (changed & IO_FIELD_ADC) {
+        n += snprintf(buf + n, size - n, ",\"adc\":%u", st->adc_raw);
+    }
+    if (changed & IO_FIELD_HEAP) {
+        n += snprintf(buf + n, size - n, ",\"heap\":%" PRIu32, st->free_heap);
+    }
+    n += snprintf(buf + n, size - n, "}");
+    return n;
+}
+
+static void put_le(uint8_t *p, uint32_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++) {
+        p[i] = v >> (8 * i);
+    }
+}
+
+static size_t encode_binary(uint8_t *buf, const io_state_t *st, uint32_t changed)
+{
+    size_t n = 0;
+
+    buf[n++] = 1;
+    put_le(buf + n, st->seq, 4);
+    n += 4;
+    buf[n++] = changed;
+    if (changed & IO_FIELD_BUTTON) {
+        buf[n++] = st->button;
+    }
+    if (changed & IO_FIELD_LED) {
+        buf[n++] = st->led;
+    }
+    if (changed & IO_FIELD_ADC) {
+        put_le(buf + n, st->adc_raw, 2);
+        n += 2;
+    }
+    if (changed & IO_FIELD_HEAP) {
+        put_le(buf + n, st->free_heap, 4);
+        n += 4;
+    }
+    return n;
+}
+
+/* Runs on the httpd task */
+static void send_job(void *arg)
+{
+    ws_job_t *job = arg;
+    httpd_ws_frame_t frame = {
+        .final = true,
+        .type = job->binary ? HTTPD_WS_TYPE_BINARY : HTTPD_WS_TYPE_TEXT,
+        .payload = job->data,
+        .len = job->len,
+    };
+
+    esp_err_t err = ESP_FAIL;
+    if (httpd_ws_get_fd_info(s_server, job->fd) == HTTPD_WS_CLIENT_WEBSOCKET) {
+        err = httpd_ws_send_frame_async(s_server, job->fd, &frame);
+    }
+
+    xSemaphoreTake(s_clients_lock, portMAX_DELAY);
+    ws_client_t *client = client_find(job->fd);
+    if (client) {
+        client->pending--;
+        if (err != ESP_OK) {
+            ESP_LOGI(TAG, "Client fd %d gone", job->fd);
+            client->fd = -1;
+        }
+    }
+    xSemaphoreGive(s_clients_lock);
+    free(job);
+}
+
+/* Must be called with s_clients_lock held */
+static void queue_state(ws_client_t *client, const io_state_t *st, uint32_t changed)
+{
+    if (client->pending >= WS_MAX_PENDING) {
+        /* Not draining its socket; a stale view is worse than none */
+        ESP_LOGW(TAG, "Dropping slow client fd %d", client->fd);
+        httpd_sess_trigger_close(s_server, client->fd);
+        client->fd = -1;
+        return;
+    }
+
+    ws_job_t *job = malloc(sizeof(*job));
+    if (job == NULL) {
+        return;
+    }
+    job->fd = client->fd;
+    job->binary = client->binary;
+    job->len = client->binary ? encode_binary(job->data, st, changed)
+                              : encode_json((char *)job->data, sizeof(job->data), st, changed);
+    if (httpd_queue_work(s_server, send_job, job) != ESP_OK) {
+        free(job);
+        return;
+    }
+    client->pending++;
+}
+
+/* io-state callback: one delta to every subscriber */
+static void on_state_change(const io_state_t *st, uint32_t changed, void *arg)
+{
+    xSemaphoreTake(s_clients_lock, portMAX_DELAY);
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (s_clients[i].fd >= 0) {
+            queue_state(&s_clients[i], st, changed);
+        }
+    }
+    xSemaphoreGive(s_clients_lock);
+}
+
+static void send_snapshot(int fd)
+{
+    io_state_t st;
+
+    io_state_get(&st);
+    xSemaphoreTake(s_clients_lock, portMAX_DELAY);
+    ws_client_t *client = client_find(fd);
+    if (client) {
+        queue_state(client, &st, IO_FIELD_ALL);
+    }
+    xSemaphoreGive(s_clients_lock);
+}
+
+typedef struct {
+    int fd;
+    bool snapshot;
+    const char *error;
+} ws_cmd_t;
+
+static int ws_command(void *user, const char *key, const char *value, size_t value_len)
+{
+    ws_cmd_t *cmd = user;
+
+    if (strcmp(key, "led") == 0) {
+        io_state_set_led(atoi(value));
+    } else if (strcmp(key, "format") == 0) {
+        bool binary = strcmp(value, "binary") == 0;
+        xSemaphoreTake(s_clients_lock, portMAX_DELAY);
+        ws_client_t *client = client_find(cmd->fd);
+        if (client) {
+            client->binary = binary;
+        }
+        xSemaphoreGive(s_clients_lock);
+        cmd->snapshot = true;
+    } else if (strcmp(key, "get") == 0) {
+        cmd->snapshot = true;
+    } else {
+        cmd->error = "unknown command";
+        return 1;
+    }
+    return 0;
+}
+
+static esp_err_t ws_handler(httpd_req_t *req)
+{
+    int fd = httpd_req_to_sockfd(req);
+
+    if (req->method == HTTP_GET) {
+        /* Handshake done: subscribe */
+        xSemaphoreTake(s_clients_lock, portMAX_DELAY);
+        for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+            /* Closed without us noticing: no send has failed yet */
+            if (s_clients[i].fd >= 0 &&
+                httpd_ws_get_fd_info(s_server, s_clients[i].fd) != HTTPD_WS_CLIENT_WEBSOCKET) {
+                s_clients[i].fd = -1;
+            }
+        }
+        ws_client_t *client = client_find(fd);
+        if (client == NULL) {
+            client = client_find(-1);
+        }
+        if (client) {
+            client->fd = fd;
+            client->binary = false;
+            client->pending = 0;
+        }
+        xSemaphoreGive(s_clients_lock);
+        if (client == NULL) {
+            ESP_LOGW(TAG, "No room for client fd %d", fd);
+            return ESP_FAIL;
+        }
+        ESP_LOGI(TAG, "Client fd %d subscribed", fd);
+        send_snapshot(fd);
+        return ESP_OK;
+    }
+
+    uint8_t buf[WS_MAX_RX_LEN];
+    httpd_ws_frame_t frame = { .payload = NULL };
+    esp_err_t err = httpd_ws_recv_frame(req, &frame, 0);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (frame.len > sizeof(buf)) {
+        ESP_LOGW(TAG, "Frame of %u bytes from fd %d, closing", (unsigned)frame.len, fd);
+        return ESP_FAIL;
+    }
+    frame.payload = buf;
+    err = httpd_ws_recv_frame(req, &frame, frame.len);
+    if (err != ESP_OK || frame.type != HTTPD_WS_TYPE_TEXT) {
+        return err;
+    }
+
+    char value[16];
+    form_parser_t parser;
+    ws_cmd_t cmd = { .fd = fd };
+    form_parser_init(&parser, NULL, value, sizeof(value), ws_command, &cmd);
+    form_status_t st = form_parser_feed(&parser, (const char *)buf, frame.len);
+    if (st == FORM_OK) {
+        st = form_parser_finish(&parser);
+    }
+    if (st != FORM_OK) {
+        char reply[64];
+        snprintf(reply, sizeof(reply), "{\"error\":\"%s\"}",
+                 cmd.error ? cmd.error : form_status_str(st));
+        httpd_ws_frame_t out = {
+            .final = true,
+            .type = HTTPD_WS_TYPE_TEXT,
+            .payload = (uint8_t *)reply,
+            .len = strlen(reply),
+        };
+        return httpd_ws_send_frame(req, &out);
+    }
+    if (cmd.snapshot) {
+        send_snapshot(fd);
+    }
+    return ESP_OK;
+}
+
+static const httpd_uri_t uri_ws = {
+    .uri          = "/ws",
+    .method       = HTTP_GET,
+    .handler      = ws_handler,
+    .user_ctx     = NULL,
+    .is_websocket = true,
+};
+
+esp_err_t ws_server_register(httpd_handle_t server)
+{
+    if (s_clients_lock == NULL) {
+        s_clients_lock = xSemaphoreCreateMutex();
+        for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+            s_clients[i].fd = -1;
+        }
+    }
+    s_server = server;
+
+    esp_err_t err = async_pool_register(server, &uri_ws, false);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return io_state_start(on_state_change, NULL);
+}
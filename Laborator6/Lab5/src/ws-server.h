@@ -0,0 +1,26 @@
+#ifndef _WS_SERVER_H_
+#define _WS_SERVER_H_
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+/* GET /ws: live GPIO/sensor state.
+ *
+ * Server to client, on connect and then on every change, only the fields
+ * that changed:
+ *   JSON (default):  {"seq":7,"button":1,"adc":1234}
+ *   binary:          u8 version (1), u32 seq, u8 changed mask (IO_FIELD_*),
+ *                    then per set bit in mask order: button u8, led u8,
+ *                    adc u16, heap u32; little endian
+ * Client to server, text frames in form encoding:
+ *   led=0|1   format=json|binary   get   (full snapshot)
+ */
+
+#define WS_MAX_CLIENTS      3
+#define WS_MAX_PENDING      4       /* queued frames per client before it is dropped */
+#define WS_MAX_RX_LEN       64
+#define WS_MAX_FRAME_LEN    96
+
+esp_err_t ws_server_register(httpd_handle_t server);
+
+#endif
@@ -0,0 +1,55 @@
+/***************************************************************************//**
+ * @file
+ * @brief Advertising interval policy: fast bursts stepping back to slow.
+ ******************************************************************************/
+
+#ifndef ADV_POLICY_H
+#define ADV_POLICY_H
+
+#include <stdint.h>
+#include "sl_bt_api.h"
+
+// External signal bit raised when the current stage runs out
+#define ADV_POLICY_SIGNAL       (1u << 0)
+
+#define ADV_POLICY_STAGES       3
+
+typedef enum {
+  ADV_POLICY_BOOT,
+  ADV_POLICY_DISCONNECT,
+  ADV_POLICY_BUTTON,
+  ADV_POLICY_CONNECTED,       // a link opened and slots remain
+  ADV_POLICY_REASONS
+} adv_policy_reason_t;
+
+typedef struct {
+  uint16_t interval_min;      ///< 0.625 ms units
+  uint16_t interval_max;
+  uint32_t duration_ms;       ///< 0: stay in this stage
+} adv_policy_stage_t;
+
+typedef struct {
+  uint32_t stage_ms[ADV_POLICY_STAGES];
+  uint32_t events[ADV_POLICY_STAGES];   ///< estimated from the interval
+  uint32_t connections[ADV_POLICY_STAGES];
+  uint32_t starts[ADV_POLICY_REASONS];
+  uint32_t connect_ms_last;   ///< from the last start to connection opened
+  uint32_t connect_ms_max;
+  uint32_t connect_ms_sum;
+} adv_policy_stats_t;
+
+/// Takes over an advertising set whose data is already set.
+void adv_policy_init(uint8_t handle, uint8_t connect_mode);
+
+/// (Re)starts advertising at the fastest stage.
+sl_status_t adv_policy_start(adv_policy_reason_t reason);
+
+/// Steps to the next stage; call on sl_bt_evt_system_external_signal_id.
+void adv_policy_on_signal(uint32_t signals);
+
+/// The stack stopped advertising because a central connected.
+void adv_policy_on_connected(void);
+
+const adv_policy_stats_t *adv_policy_stats(void);
+
+#endif // ADV_POLICY_H
@@ -3,6 +3,7 @@
  * @brief Core application logic.
  *******************************************************************************
  */
+#include <stdio.h>
 #include "em_common.h"
 #include "app_assert.h"
 #include "sl_bluetooth.h"
@@ -10,25 +11,21 @@
 
 #include "em_cmu.h"
 #include "em_gpio.h"
-#define gattdb_LED_IO 27
-#define gattdb_BUTTON_IO 29
+#include "gatt_db.h"
+#include "adv_policy.h"
+#include "button_io.h"
+#include "bond_db.h"
 
 static uint8_t advertising_set_handle = 0xff;
 
-void GPIO_ODD_IRQHandler(void)
-{
-  uint32_t interruptMask = GPIO_IntGet();
-  GPIO_IntClear(interruptMask);
-}
+// Single-link design: advertising only runs while this is 0
+static uint8_t open_links;
 
 SL_WEAK void app_init(void)
 {
   CMU_ClockEnable(cmuClock_GPIO, true);
   GPIO_PinModeSet(gpioPortA, 4, gpioModePushPull, 1);
-  GPIO_PinModeSet(gpioPortC, 7, gpioModeInputPullFilter, 1);
-  GPIO_ExtIntConfig(gpioPortC, 7, 1, true, true, true);
-  NVIC_ClearPendingIRQ(GPIO_ODD_IRQn);
-  NVIC_EnableIRQ(GPIO_ODD_IRQn);
+  button_io_init(gattdb_BUTTON_IO);
 }
 
 SL_WEAK void app_process_action(void)
@@ -37,13 +34,15 @@ SL_WEAK void app_process_action(void)
 
 void sl_bt_on_event(sl_bt_msg_t *evt)
 {
-  uint8_t recv_val;
-  size_t recv_len;
+  uint8_t value[BUTTON_IO_READ_LEN];
+  uint16_t sent_len;
   sl_status_t sc;
 
   switch (SL_BT_MSG_ID(evt->header)) {
     case sl_bt_evt_system_boot_id:
-      sc = sl_bt_sm_configure(0x03, sl_bt_sm_io_capability_displayonly );
+      // MITM, encryption only with bonding, and new bondings are confirmed
+      // by bond_db so it can evict one when the database is full
+      sc = sl_bt_sm_configure(0x0b, sl_bt_sm_io_capability_displayonly );
       app_assert_status(sc);
 
       sc = sl_bt_sm_set_passkey(2342);
@@ -52,6 +51,8 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
       sc = sl_bt_sm_set_bondable_mode(1);
       app_assert_status(sc);
 
+      bond_db_init(gattdb_database_hash, gattdb_service_changed_char);
+
       sc = sl_bt_advertiser_create_set(&advertising_set_handle);
       app_assert_status(sc);
 
@@ -59,20 +60,20 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
                                                  sl_bt_advertiser_general_discoverable);
       app_assert_status(sc);
 
-      sc = sl_bt_advertiser_set_timing(
-        advertising_set_handle,
-        160,
-        160,
-        0,
-        0);
-      app_assert_status(sc);
-
-      sc = sl_bt_legacy_advertiser_start(advertising_set_handle,
-                                         sl_bt_advertiser_connectable_scannable);
+      adv_policy_init(advertising_set_handle,
+                      sl_bt_advertiser_connectable_scannable);
+      sc = adv_policy_start(ADV_POLICY_BOOT);
       app_assert_status(sc);
       break;
 
     case sl_bt_evt_connection_opened_id:
+      open_links++;
+      adv_policy_on_connected();
+      bond_db_on_opened(evt->data.evt_connection_opened.connection,
+                        evt->data.evt_connection_opened.bonding,
+                        evt->data.evt_connection_opened.address_type);
+      printf("Connected after %lu ms\n",
+             (unsigned long)adv_policy_stats()->connect_ms_last);
       sc = sl_bt_sm_increase_security(evt->data.evt_connection_opened.connection);
       app_assert_status(sc);
       break;
@@ -81,7 +82,14 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
       printf("Passkey: %lu\n", evt->data.evt_sm_passkey_display.passkey);
       break;
 
+    case sl_bt_evt_sm_confirm_bonding_id:
+      bond_db_on_confirm(evt->data.evt_sm_confirm_bonding.connection,
+                         evt->data.evt_sm_confirm_bonding.bonding_handle);
+      break;
+
     case sl_bt_evt_sm_bonded_id:
+      bond_db_on_bonded(evt->data.evt_sm_bonded.connection,
+                        evt->data.evt_sm_bonded.bonding);
       printf("Bonding successful\n");
       break;
 
@@ -89,16 +97,59 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
       printf("Bonding failed\n");
       break;
 
+    case sl_bt_evt_connection_parameters_id:
+      bond_db_on_security(evt->data.evt_connection_parameters.connection,
+                          evt->data.evt_connection_parameters.security_mode);
+      button_io_on_parameters(evt->data.evt_connection_parameters.connection,
+                              evt->data.evt_connection_parameters.interval);
+      break;
+
+    case sl_bt_evt_gatt_server_characteristic_status_id:
+      bond_db_on_data(evt->data.evt_gatt_server_characteristic_status.connection);
+      if (evt->data.evt_gatt_server_characteristic_status.characteristic == gattdb_BUTTON_IO) {
+        button_io_on_status(evt->data.evt_gatt_server_characteristic_status.connection,
+                            evt->data.evt_gatt_server_characteristic_status.status_flags,
+                            evt->data.evt_gatt_server_characteristic_status.client_config_flags);
+      }
+      break;
+
+    case sl_bt_evt_gatt_server_attribute_value_id:
+      bond_db_on_data(evt->data.evt_gatt_server_attribute_value.connection);
+      break;
+
+    case sl_bt_evt_gatt_server_user_read_request_id:
+      bond_db_on_data(evt->data.evt_gatt_server_user_read_request.connection);
+      if (evt->data.evt_gatt_server_user_read_request.characteristic == gattdb_BUTTON_IO) {
+        uint8_t len = button_io_read(evt->data.evt_gatt_server_user_read_request.offset,
+                                     value, sizeof(value));
+        sl_bt_gatt_server_send_user_read_response(
+          evt->data.evt_gatt_server_user_read_request.connection,
+          gattdb_BUTTON_IO, 0, len, value, &sent_len);
+      }
+      break;
+
     case sl_bt_evt_connection_closed_id:
+      open_links--;
+      button_io_on_closed(evt->data.evt_connection_closed.connection);
+      bond_db_on_closed(evt->data.evt_connection_closed.connection);
+
       sc = sl_bt_legacy_advertiser_generate_data(advertising_set_handle,
                                                  sl_bt_advertiser_general_discoverable);
       app_assert_status(sc);
 
-      sc = sl_bt_legacy_advertiser_start(advertising_set_handle,
-                                         sl_bt_advertiser_connectable_scannable);
+      sc = adv_policy_start(ADV_POLICY_DISCONNECT);
       app_assert_status(sc);
       break;
 
+    case sl_bt_evt_system_external_signal_id:
+      adv_policy_on_signal(evt->data.evt_system_external_signal.extsignals);
+      if (button_io_process(evt->data.evt_system_external_signal.extsignals) > 0
+          && open_links == 0) {
+        sc = adv_policy_start(ADV_POLICY_BUTTON);
+        app_assert_status(sc);
+      }
+      break;
+
     default:
       break;
   }
@@ -0,0 +1,329 @@
+/***************************************************************************//**
+ * @file
+ * @brief Bonding database policy: LRU eviction, GATT caching, reconnect timing.
+ *
+ * Eviction needs to happen before the stack stores a new bonding, so the
+ * security manager is configured to ask for confirmation first
+ * (sl_bt_evt_sm_confirm_bonding_id). The stack's own "overwrite the oldest"
+ * policy stays on as a fallback for bonds this module never saw.
+ *
+ * Private addresses are resolved by the controller against the IRKs of the
+ * stored bonds, so a bonded phone using an RPA arrives with its bonding
+ * handle in the connection opened event and re-encrypts without pairing.
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "nvm3_default.h"
+#include "sl_bt_api.h"
+#include "sl_sleeptimer.h"
+#include "sl_bluetooth_connection_config.h"
+#include "bond_db.h"
+
+#define RECORD_VERSION      1
+#define NO_BONDING          0xff
+#define GATT_HASH_LEN       16
+
+#define SLOT_CHANGE_AWARE   0x01    // has seen the current GATT database
+
+// sl_bt_sm_store_bonding_configuration() policy: overwrite the oldest
+#define STACK_OVERWRITE_OLDEST  0x01
+
+typedef struct {
+  uint8_t bonding;            // stack bonding handle, NO_BONDING: free
+  uint8_t flags;
+  uint16_t reserved;
+  uint32_t last_use;          // record.seq at the last connection
+} slot_t;
+
+// Stored as one NVM3 object, well under NVM3_DEFAULT_MAX_OBJECT_SIZE
+typedef struct {
+  uint16_t version;
+  uint16_t reserved;
+  uint32_t seq;
+  uint8_t gatt_hash[GATT_HASH_LEN];
+  slot_t slots[BOND_DB_MAX];
+} record_t;
+
+typedef struct {
+  uint8_t connection;         // 0xff: free
+  uint8_t bonding;
+  bool reconnect;             // bonded when the link opened
+  bool measuring;
+  bool encrypted;
+  uint64_t opened_tick;
+  uint32_t encrypted_ms;
+} link_t;
+
+static record_t record;
+static link_t links[SL_BT_CONFIG_MAX_CONNECTIONS];
+static uint16_t service_changed_char;
+static bond_db_stats_t stats;
+
+static uint32_t ms_since(uint64_t tick)
+{
+  uint64_t ms = 0;
+
+  sl_sleeptimer_tick64_to_ms(sl_sleeptimer_get_tick_count64() - tick, &ms);
+  return (uint32_t)ms;
+}
+
+static void save(void)
+{
+  Ecode_t ec = nvm3_writeData(nvm3_defaultHandle, BOND_DB_NVM3_KEY,
+                              &record, sizeof(record));
+
+  if (ec != ECODE_NVM3_OK) {
+    printf("Bond DB: NVM3 write failed (0x%lx)\n", (unsigned long)ec);
+  }
+}
+
+static slot_t *find_slot(uint8_t bonding)
+{
+  for (uint8_t i = 0; i < BOND_DB_MAX; i++) {
+    if (record.slots[i].bonding == bonding) {
+      return &record.slots[i];
+    }
+  }
+  return NULL;
+}
+
+static link_t *find_link(uint8_t connection)
+{
+  for (uint8_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    if (links[i].connection == connection) {
+      return &links[i];
+    }
+  }
+  return NULL;
+}
+
+static bool bonding_connected(uint8_t bonding)
+{
+  for (uint8_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    if (links[i].connection != 0xff && links[i].bonding == bonding) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Least recently used bond that is not connected right now.
+static slot_t *lru_slot(void)
+{
+  slot_t *lru = NULL;
+
+  for (uint8_t i = 0; i < BOND_DB_MAX; i++) {
+    slot_t *s = &record.slots[i];
+    if (s->bonding == NO_BONDING || bonding_connected(s->bonding)) {
+      continue;
+    }
+    if (lru == NULL || (int32_t)(s->last_use - lru->last_use) < 0) {
+      lru = s;
+    }
+  }
+  return lru;
+}
+
+static void touch(slot_t *slot)
+{
+  slot->last_use = ++record.seq;
+}
+
+void bond_db_init(uint16_t hash_char, uint16_t service_changed)
+{
+  uint8_t hash[GATT_HASH_LEN];
+  size_t len = 0;
+  bool loaded;
+
+  service_changed_char = service_changed;
+  for (uint8_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    links[i].connection = 0xff;
+  }
+
+  loaded = nvm3_readData(nvm3_defaultHandle, BOND_DB_NVM3_KEY,
+                         &record, sizeof(record)) == ECODE_NVM3_OK
+           && record.version == RECORD_VERSION;
+  if (!loaded) {
+    memset(&record, 0, sizeof(record));
+    record.version = RECORD_VERSION;
+    for (uint8_t i = 0; i < BOND_DB_MAX; i++) {
+      record.slots[i].bonding = NO_BONDING;
+    }
+  }
+  sl_bt_sm_store_bonding_configuration(BOND_DB_MAX, STACK_OVERWRITE_OLDEST);
+
+  // A new firmware with a different attribute table makes every cached
+  // handle stale; bonded clients are told once, on their next reconnect.
+  if (sl_bt_gatt_server_read_attribute_value(hash_char, 0, sizeof(hash),
+                                             &len, hash) == SL_STATUS_OK
+      && len == sizeof(hash)
+      && memcmp(hash, record.gatt_hash, sizeof(hash)) != 0) {
+    memcpy(record.gatt_hash, hash, sizeof(hash));
+    for (uint8_t i = 0; i < BOND_DB_MAX; i++) {
+      record.slots[i].flags &= ~SLOT_CHANGE_AWARE;
+    }
+    stats.gatt_changed = loaded;
+    save();
+  }
+}
+
+void bond_db_on_opened(uint8_t connection, uint8_t bonding, uint8_t address_type)
+{
+  link_t *link = find_link(0xff);
+  slot_t *slot;
+
+  if (link == NULL) {
+    return;
+  }
+  memset(link, 0, sizeof(*link));
+  link->connection = connection;
+  link->bonding = bonding;
+  link->reconnect = (bonding != NO_BONDING);
+  link->measuring = true;
+  link->opened_tick = sl_sleeptimer_get_tick_count64();
+
+  if (bonding == NO_BONDING) {
+    return;
+  }
+  if (address_type == sl_bt_gap_public_address_resolved_from_rpa
+      || address_type == sl_bt_gap_random_identity_address_resolved_from_rpa) {
+    printf("Link %u: private address resolved to bonding %u\n", connection, bonding);
+  }
+  slot = find_slot(bonding);
+  if (slot == NULL) {
+    // Bonded before this module kept track; assume a stale cache
+    slot = find_slot(NO_BONDING);
+    if (slot == NULL) {
+      return;
+    }
+    slot->bonding = bonding;
+    slot->flags = 0;
+  }
+  touch(slot);
+  save();
+}
+
+void bond_db_on_security(uint8_t connection, uint8_t security)
+{
+  static const uint8_t whole_range[4] = { 0x01, 0x00, 0xff, 0xff };
+  link_t *link = find_link(connection);
+  slot_t *slot;
+
+  if (link == NULL || link->encrypted || security == sl_bt_connection_mode1_level1) {
+    return;
+  }
+  link->encrypted = true;
+  link->encrypted_ms = ms_since(link->opened_tick);
+
+  if (!link->reconnect) {
+    return;
+  }
+  slot = find_slot(link->bonding);
+  if (slot == NULL || (slot->flags & SLOT_CHANGE_AWARE)) {
+    return;
+  }
+  // Fails if the client never enabled Service Changed indications; it
+  // then checks the database hash itself and we try again next time.
+  if (sl_bt_gatt_server_send_indication(connection, service_changed_char,
+                                        sizeof(whole_range), whole_range) == SL_STATUS_OK) {
+    slot->flags |= SLOT_CHANGE_AWARE;
+    stats.service_changed++;
+    save();
+  }
+}
+
+void bond_db_on_confirm(uint8_t connection, int8_t bonding)
+{
+  slot_t *slot;
+
+  // -1: a new bonding rather than a refresh of an existing one
+  if (bonding < 0 && find_slot(NO_BONDING) == NULL) {
+    slot = lru_slot();
+    if (slot != NULL) {
+      printf("Bond DB full, dropping bonding %u\n", slot->bonding);
+      sl_bt_sm_delete_bonding(slot->bonding);
+      slot->bonding = NO_BONDING;
+      stats.evictions++;
+      save();
+    }
+  }
+  sl_bt_sm_bonding_confirm(connection, 1);
+}
+
+void bond_db_on_bonded(uint8_t connection, uint8_t bonding)
+{
+  link_t *link = find_link(connection);
+  slot_t *slot;
+
+  if (bonding == NO_BONDING) {
+    return;                   // paired without bonding
+  }
+  if (link != NULL) {
+    link->bonding = bonding;
+  }
+  slot = find_slot(bonding);
+  if (slot == NULL) {
+    slot = find_slot(NO_BONDING);
+    if (slot == NULL) {
+      slot = lru_slot();      // the stack overwrote one behind our back
+      if (slot == NULL) {
+        return;
+      }
+    }
+    slot->bonding = bonding;
+  } else if (link != NULL && link->reconnect) {
+    return;                   // re-encryption of a known bond
+  }
+  // Discovery on a fresh bond sees the current database
+  slot->flags = SLOT_CHANGE_AWARE;
+  touch(slot);
+  save();
+}
+
+void bond_db_on_data(uint8_t connection)
+{
+  link_t *link = find_link(connection);
+  uint32_t ms;
+
+  if (link == NULL || !link->measuring) {
+    return;
+  }
+  link->measuring = false;
+  ms = ms_since(link->opened_tick);
+  if (link->reconnect) {
+    stats.bonded_links++;
+    stats.bonded_ms_last = ms;
+    stats.bonded_ms_sum += ms;
+    if (ms > stats.bonded_ms_max) {
+      stats.bonded_ms_max = ms;
+    }
+  } else {
+    stats.new_links++;
+    stats.new_ms_sum += ms;
+    if (ms > stats.new_ms_max) {
+      stats.new_ms_max = ms;
+    }
+  }
+  if (link->encrypted) {
+    printf("%s link %u: encrypted after %lu ms, first request after %lu ms\n",
+           link->reconnect ? "Bonded" : "New", connection,
+           (unsigned long)link->encrypted_ms, (unsigned long)ms);
+  } else {
+    printf("%s link %u: first request after %lu ms, not encrypted\n",
+           link->reconnect ? "Bonded" : "New", connection, (unsigned long)ms);
+  }
+}
+
+void bond_db_on_closed(uint8_t connection)
+{
+  link_t *link = find_link(connection);
+
+  if (link != NULL) {
+    link->connection = 0xff;
+  }
+}
+
+const bond_db_stats_t *bond_db_stats(void)
+{
+  return &stats;
+}
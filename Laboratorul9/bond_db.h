@@ -0,0 +1,62 @@
+/***************************************************************************//**
+ * @file
+ * @brief Bonding database policy: LRU eviction, GATT caching, reconnect timing.
+ *
+ * The stack keeps the keys in NVM3; this module keeps one NVM3 object next
+ * to them with the order the bonds were last used in and the GATT database
+ * hash they last saw. When the database is full a new bonding replaces the
+ * least recently used one instead of failing. When the firmware's GATT
+ * database changes, each bonded client gets one Service Changed indication
+ * on its next encrypted reconnect; otherwise bonded clients keep their
+ * cached handles and skip discovery.
+ ******************************************************************************/
+
+#ifndef BOND_DB_H
+#define BOND_DB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BOND_DB_MAX         8
+#define BOND_DB_NVM3_KEY    0x0b0d
+
+typedef struct {
+  uint32_t bonded_links;      ///< reconnects of a stored bond
+  uint32_t new_links;
+  uint32_t bonded_ms_last;    ///< connection opened to first request
+  uint32_t bonded_ms_max;
+  uint32_t bonded_ms_sum;
+  uint32_t new_ms_max;
+  uint32_t new_ms_sum;
+  uint32_t evictions;
+  uint32_t service_changed;   ///< indications sent after a database change
+  bool gatt_changed;          ///< the hash differed from the stored one at boot
+} bond_db_stats_t;
+
+/**************************************************************************//**
+ * Loads the stored order and compares the GATT database hash. Call on
+ * sl_bt_evt_system_boot_id after sl_bt_sm_configure(); hash_char is
+ * gattdb_database_hash and service_changed_char gattdb_service_changed_char.
+ *****************************************************************************/
+void bond_db_init(uint16_t hash_char, uint16_t service_changed_char);
+
+/// sl_bt_evt_connection_opened_id; bonding is 0xff for an unknown peer.
+void bond_db_on_opened(uint8_t connection, uint8_t bonding, uint8_t address_type);
+
+/// sl_bt_evt_connection_parameters_id; security is the security_mode field.
+void bond_db_on_security(uint8_t connection, uint8_t security);
+
+/// sl_bt_evt_sm_confirm_bonding_id: makes room and accepts the bonding.
+void bond_db_on_confirm(uint8_t connection, int8_t bonding);
+
+/// sl_bt_evt_sm_bonded_id.
+void bond_db_on_bonded(uint8_t connection, uint8_t bonding);
+
+/// The first ATT request on a link ends the reconnect measurement.
+void bond_db_on_data(uint8_t connection);
+
+void bond_db_on_closed(uint8_t connection);
+
+const bond_db_stats_t *bond_db_stats(void);
+
+#endif // BOND_DB_H
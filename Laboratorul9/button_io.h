@@ -0,0 +1,63 @@
+/***************************************************************************//**
+ * @file
+ * @brief BUTTON_IO characteristic: button edges notified to subscribers.
+ *
+ * The interrupt only timestamps the edge and raises an external signal;
+ * everything else runs from the Bluetooth event handler.
+ *
+ * Notification/indication payload, little endian:
+ *   state:1 | edges:1 | time_ms:4
+ * state is 1 while pressed, edges counts the edges folded into this update
+ * (more than one when presses outrun the connection interval) and time_ms
+ * is the time of the last edge since boot.
+ *
+ * Read value: state:1 | n:1 | n * (state:1 | time_ms:4), newest first.
+ ******************************************************************************/
+
+#ifndef BUTTON_IO_H
+#define BUTTON_IO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// External signal bit raised by the interrupt and the retry timer
+#define BUTTON_IO_SIGNAL            (1u << 1)
+
+#define BUTTON_IO_HISTORY           8
+#define BUTTON_IO_MAX_SUBSCRIBERS   4
+#define BUTTON_IO_READ_LEN          (2 + BUTTON_IO_HISTORY * 5)
+
+typedef struct {
+  uint32_t edges;             ///< edges taken from the interrupt
+  uint32_t dropped;           ///< edges lost to a full interrupt queue
+  uint32_t sent;              ///< notifications and indications
+  uint32_t coalesced;         ///< edges folded into a later update
+  uint32_t latency_ms_max;    ///< edge to send
+} button_io_stats_t;
+
+/// Configures the pin and its interrupt. characteristic is gattdb_BUTTON_IO.
+void button_io_init(uint16_t characteristic);
+
+/**************************************************************************//**
+ * Drains the interrupt queue and sends what is due. Call on
+ * sl_bt_evt_system_external_signal_id. Returns the number of new presses.
+ *****************************************************************************/
+uint8_t button_io_process(uint32_t signals);
+
+/// sl_bt_evt_gatt_server_characteristic_status_id for BUTTON_IO.
+void button_io_on_status(uint8_t connection, uint8_t status_flags, uint16_t client_config);
+
+/// sl_bt_evt_connection_parameters_id; interval in 1.25 ms units.
+void button_io_on_parameters(uint8_t connection, uint16_t interval);
+
+void button_io_on_closed(uint8_t connection);
+
+/// Fills a read of the value at offset. Returns the length, 0 past the end.
+uint8_t button_io_read(uint16_t offset, uint8_t *value, uint8_t max);
+
+/// 1 while pressed, as of the last button_io_process().
+uint8_t button_io_state(void);
+
+const button_io_stats_t *button_io_stats(void);
+
+#endif // BUTTON_IO_H
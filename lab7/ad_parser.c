@@ -0,0 +1,89 @@
+/***************************************************************************//**
+ * @file
+ * @brief Zero-copy iterator over the AD structures of an advertisement.
+ ******************************************************************************/
+#include <string.h>
+#include "ad_parser.h"
+
+void ad_iter_init(ad_iter_t *it, const uint8_t *data, uint8_t len)
+{
+  it->data = data;
+  it->len = len;
+  it->pos = 0;
+  it->malformed = false;
+}
+
+bool ad_iter_next(ad_iter_t *it, ad_field_t *field)
+{
+  while (it->pos < it->len) {
+    uint8_t ad_len = it->data[it->pos];
+
+    if (ad_len == 0) {
+      it->pos++;
+      continue;
+    }
+    // Length byte + ad_len bytes (type and value) must fit
+    if (ad_len > it->len - it->pos - 1) {
+      it->malformed = true;
+      it->pos = it->len;
+      return false;
+    }
+    field->type = it->data[it->pos + 1];
+    field->len = ad_len - 1;
+    field->value = &it->data[it->pos + 2];
+    it->pos += ad_len + 1;
+    return true;
+  }
+  return false;
+}
+
+bool ad_find(const uint8_t *data, uint8_t len, uint8_t type, ad_field_t *field)
+{
+  ad_iter_t it;
+
+  ad_iter_init(&it, data, len);
+  while (ad_iter_next(&it, field)) {
+    if (field->type == type) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ad_company_id(const uint8_t *data, uint8_t len, uint16_t *company_id)
+{
+  ad_field_t field;
+
+  if (!ad_find(data, len, AD_TYPE_MANUFACTURER, &field) || field.len < 2) {
+    return false;
+  }
+  *company_id = field.value[0] | (field.value[1] << 8);
+  return true;
+}
+
+bool ad_has_uuid(const uint8_t *data, uint8_t len, const uint8_t *uuid, uint8_t uuid_len)
+{
+  ad_iter_t it;
+  ad_field_t field;
+
+  ad_iter_init(&it, data, len);
+  while (ad_iter_next(&it, &field)) {
+    bool list = (uuid_len == 2
+                 && (field.type == AD_TYPE_UUID16_INCOMPLETE
+                     || field.type == AD_TYPE_UUID16_COMPLETE))
+                || (uuid_len == 16
+                    && (field.type == AD_TYPE_UUID128_INCOMPLETE
+                        || field.type == AD_TYPE_UUID128_COMPLETE));
+    if (list) {
+      for (uint8_t i = 0; i + uuid_len <= field.len; i += uuid_len) {
+        if (memcmp(&field.value[i], uuid, uuid_len) == 0) {
+          return true;
+        }
+      }
+    } else if (uuid_len == 2 && field.type == AD_TYPE_SERVICE_DATA_UUID16
+               && field.len >= 2 && memcmp(field.value, uuid, 2) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
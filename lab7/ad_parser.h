@@ -0,0 +1,58 @@
+/***************************************************************************//**
+ * @file
+ * @brief Zero-copy iterator over the AD structures of an advertisement.
+ ******************************************************************************/
+
+#ifndef AD_PARSER_H
+#define AD_PARSER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// AD types used by the scanner (Bluetooth Assigned Numbers, 2.3)
+#define AD_TYPE_FLAGS                0x01
+#define AD_TYPE_UUID16_INCOMPLETE    0x02
+#define AD_TYPE_UUID16_COMPLETE      0x03
+#define AD_TYPE_UUID128_INCOMPLETE   0x06
+#define AD_TYPE_UUID128_COMPLETE     0x07
+#define AD_TYPE_NAME_SHORT           0x08
+#define AD_TYPE_NAME_COMPLETE        0x09
+#define AD_TYPE_SERVICE_DATA_UUID16  0x16
+#define AD_TYPE_MANUFACTURER         0xff
+
+/// Walks the payload in place; fields point into it.
+typedef struct {
+  const uint8_t *data;
+  uint8_t len;
+  uint8_t pos;
+  bool malformed;   ///< a length byte ran past the end of the payload
+} ad_iter_t;
+
+typedef struct {
+  uint8_t type;
+  uint8_t len;            ///< length of value, without the type byte
+  const uint8_t *value;
+} ad_field_t;
+
+void ad_iter_init(ad_iter_t *it, const uint8_t *data, uint8_t len);
+
+/**************************************************************************//**
+ * Next AD structure. Returns false at the end of the payload or at the
+ * first malformed structure (it->malformed tells which). Zero-length
+ * structures are padding and are skipped.
+ *****************************************************************************/
+bool ad_iter_next(ad_iter_t *it, ad_field_t *field);
+
+/// First structure of the given type.
+bool ad_find(const uint8_t *data, uint8_t len, uint8_t type, ad_field_t *field);
+
+/// Company identifier of a manufacturer specific data structure.
+bool ad_company_id(const uint8_t *data, uint8_t len, uint16_t *company_id);
+
+/**************************************************************************//**
+ * True if the payload lists the service UUID, in a UUID list or as service
+ * data. uuid is little endian as on air, uuid_len 2 or 16.
+ *****************************************************************************/
+bool ad_has_uuid(const uint8_t *data, uint8_t len, const uint8_t *uuid, uint8_t uuid_len);
+
+#endif // AD_PARSER_H
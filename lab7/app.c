@@ -29,12 +29,195 @@
  ******************************************************************************/
 #include "em_common.h"
 #include "app_assert.h"
+#include "app_log.h"
 #include "sl_bluetooth.h"
+#include "sl_sleeptimer.h"
+#include "sl_iostream.h"
+#include "sl_iostream_usart_vcom.h"
+#include "ad_parser.h"
+#include "scan_cache.h"
+#include "scan_report.h"
+#include "scan_profile.h"
+#include "bcast_rx.h"
 #include "app.h"
 
+// How often the scanner statistics are printed.
+#define SCAN_STATS_PERIOD_MS  10000
+// Also print a text line per device and dedup window; off by default since
+// the batched binary frames carry the same data in a fraction of the bytes.
+#ifndef SCAN_LOG_DEVICES
+#define SCAN_LOG_DEVICES      0
+#endif
+
+// Reports are dropped before the cache unless they pass all enabled filters.
+typedef struct {
+  int8_t rssi_min;            // weakest report accepted
+  bool match_company_id;
+  uint16_t company_id;        // manufacturer specific data, e.g. 0x004c
+  uint8_t uuid_len;           // 0 (off), 2 or 16
+  uint8_t uuid[16];           // little endian, as on air
+} scan_filter_t;
+
 // The advertising set handle allocated from Bluetooth stack.
 static uint8_t advertising_set_handle = 0xff;
 
+static const scan_filter_t scan_filter = {
+  .rssi_min = -90,
+  .match_company_id = false,
+  .uuid_len = 0,
+};
+
+static uint32_t scan_stats_ms;
+static uint32_t scan_filtered;
+static uint32_t scan_malformed;
+
+// Milliseconds since boot, wrapping after ~49 days.
+static uint32_t now_ms(void)
+{
+  uint64_t ms = 0;
+
+  sl_sleeptimer_tick64_to_ms(sl_sleeptimer_get_tick_count64(), &ms);
+  return (uint32_t)ms;
+}
+
+static bool scan_filter_match(const uint8_t *data, uint8_t len, int8_t rssi)
+{
+  uint16_t company_id;
+
+  if (rssi < scan_filter.rssi_min) {
+    return false;
+  }
+  if (scan_filter.match_company_id
+      && (!ad_company_id(data, len, &company_id)
+          || company_id != scan_filter.company_id)) {
+    return false;
+  }
+  if (scan_filter.uuid_len != 0
+      && !ad_has_uuid(data, len, scan_filter.uuid, scan_filter.uuid_len)) {
+    return false;
+  }
+  return true;
+}
+
+static void scan_on_report(const sl_bt_evt_scanner_legacy_advertisement_report_t *report)
+{
+  const uint8_t *data = report->data.data;
+  uint8_t len = report->data.len;
+  uint32_t now = now_ms();
+  scan_cache_entry_t *entry;
+  ad_iter_t it;
+  ad_field_t field;
+  bool print;
+
+  scan_profile_count_report();
+  if (!scan_filter_match(data, len, report->rssi)) {
+    scan_filtered++;
+    return;
+  }
+  entry = scan_cache_update(&report->address, report->address_type,
+                            report->rssi, now, &print);
+  scan_report_update(entry, now);
+
+  // Walk the whole payload for every accepted report so the malformed
+  // count does not depend on SCAN_LOG_DEVICES or the dedup window
+  ad_iter_init(&it, data, len);
+  while (ad_iter_next(&it, &field)) {
+  }
+  if (it.malformed) {
+    scan_malformed++;
+  }
+  if (!SCAN_LOG_DEVICES || !print) {
+    return;
+  }
+
+  app_log_info("%02x:%02x:%02x:%02x:%02x:%02x/%u rssi %d seen %u ",
+               report->address.addr[5], report->address.addr[4],
+               report->address.addr[3], report->address.addr[2],
+               report->address.addr[1], report->address.addr[0],
+               report->address_type, report->rssi, entry->count);
+  ad_iter_init(&it, data, len);
+  while (ad_iter_next(&it, &field)) {
+    if (field.type == AD_TYPE_MANUFACTURER) {
+      app_log_hexdump_info(field.value, field.len);
+    }
+  }
+  if (it.malformed) {
+    app_log_append("malformed");
+  }
+  app_log_nl();
+}
+
+static void scan_print_stats(void)
+{
+  uint32_t now = now_ms();
+  const scan_cache_stats_t *stats;
+  const scan_report_stats_t *batch;
+  const bcast_rx_stats_t *bcast;
+
+  if ((uint32_t)(now - scan_stats_ms) < SCAN_STATS_PERIOD_MS) {
+    return;
+  }
+  scan_stats_ms = now;
+  stats = scan_cache_stats();
+  batch = scan_report_stats();
+  bcast = bcast_rx_stats();
+  app_log_info("scan: %lu reports, %lu filtered, %lu malformed, "
+               "%u devices, %lu evicted" APP_LOG_NEW_LINE,
+               (unsigned long)stats->reports, (unsigned long)scan_filtered,
+               (unsigned long)scan_malformed, scan_cache_count(now),
+               (unsigned long)stats->evictions);
+  app_log_info("batch: %lu frames, %lu records, %lu bytes, %lu enter, %lu exit"
+               APP_LOG_NEW_LINE,
+               (unsigned long)batch->frames, (unsigned long)batch->records,
+               (unsigned long)batch->bytes, (unsigned long)batch->enters,
+               (unsigned long)batch->exits);
+  app_log_info("bcast: %lu synced, %lu reports, %lu new, %lu repeats, %lu lost, "
+               "%lu bad, %lu closed" APP_LOG_NEW_LINE,
+               (unsigned long)bcast->opened, (unsigned long)bcast->reports,
+               (unsigned long)bcast->decoded, (unsigned long)bcast->repeats,
+               (unsigned long)bcast->lost, (unsigned long)bcast->bad,
+               (unsigned long)bcast->closed);
+
+  for (scan_profile_id_t id = 0; id < SCAN_PROFILE_COUNT; id++) {
+    const scan_profile_stats_t *ps = scan_profile_stats(id, now);
+    if (ps->active_ms == 0) {
+      continue;
+    }
+    app_log_info("%c%-10s %lu s, radio %lu ms, %lu reports/s, ~%lu uA"
+                 APP_LOG_NEW_LINE,
+                 id == scan_profile_current() ? '*' : ' ',
+                 scan_profile_get(id)->name,
+                 (unsigned long)(ps->active_ms / 1000),
+                 (unsigned long)ps->radio_ms,
+                 (unsigned long)((uint64_t)ps->reports * 1000 / ps->active_ms),
+                 (unsigned long)scan_profile_average_ua(ps));
+  }
+}
+
+// Single key commands on the VCOM: 0-2 pick a profile, b starts a burst.
+static void scan_console_poll(void)
+{
+  char c;
+  size_t n = 0;
+  scan_profile_id_t id;
+  sl_status_t sc;
+
+  if (sl_iostream_read(sl_iostream_vcom_handle, &c, 1, &n) != SL_STATUS_OK || n == 0) {
+    return;
+  }
+  if (c >= '0' && c < '0' + SCAN_PROFILE_BURST) {
+    id = (scan_profile_id_t)(c - '0');
+    sc = scan_profile_start(id, now_ms());
+  } else if (c == 'b') {
+    id = SCAN_PROFILE_BURST;
+    sc = scan_profile_burst(now_ms());
+  } else {
+    return;
+  }
+  app_log_info("scan profile %s: 0x%04lx" APP_LOG_NEW_LINE,
+               scan_profile_get(id)->name, (unsigned long)sc);
+}
+
 /**************************************************************************//**
  * Application Init.
  *****************************************************************************/
@@ -44,6 +227,9 @@ SL_WEAK void app_init(void)
   // Put your additional application init code here!                         //
   // This is called once during start-up.                                    //
   /////////////////////////////////////////////////////////////////////////////
+  scan_cache_init();
+  // The console is polled from the main loop
+  sl_iostream_uart_set_read_block(sl_iostream_uart_vcom_handle, false);
 }
 
 /**************************************************************************//**
@@ -56,6 +242,10 @@ SL_WEAK void app_process_action(void)
   // This is called infinitely.                                              //
   // Do not call blocking functions from here!                               //
   /////////////////////////////////////////////////////////////////////////////
+  scan_console_poll();
+  scan_profile_process(now_ms());
+  scan_report_process(now_ms());
+  scan_print_stats();
 }
 
 /**************************************************************************//**
@@ -67,29 +257,29 @@ SL_WEAK void app_process_action(void)
 void sl_bt_on_event(sl_bt_msg_t *evt)
 {
   sl_status_t sc;
-  uint8_t i, tlen, type, len;
 
   switch (SL_BT_MSG_ID(evt->header)) {
     case sl_bt_evt_scanner_legacy_advertisement_report_id:
-//      while(evt->data.evt_scanner_legacy_advertisement_report.data.len)
-//        {
-//          app_log_hexdump_reverse_level_s(APP_LOG_LEVEL_INFO, "", evt->data.evt_scanner_legacy_advertisement_report.address.addr, 6);
-//        }
-      while(i<tlen)
-        {
-          len = evt->data.evt_scanner_legacy_advertisement_report.data.data[i++];
-          type = evt->data.evt_scanner_legacy_advertisement_report.data.data[i++];
-
-          if(len==26 && type == 0xff)
-            {
-              app_log_hexdump_info(&evt->data.evt_scanner_legacy_advertisement_report.data.data[i], 25);
-            }
-          else
-            {
-              i += len-2;
-            }
-          }
+      scan_on_report(&evt->data.evt_scanner_legacy_advertisement_report);
+      break;
+
+    // -------------------------------
+    // Sensor broadcast: announce, then readings over a periodic sync.
+    case sl_bt_evt_scanner_extended_advertisement_report_id:
+      scan_profile_count_report();
+      bcast_rx_on_extended(&evt->data.evt_scanner_extended_advertisement_report);
+      break;
+
+    case sl_bt_evt_periodic_sync_opened_id:
+      bcast_rx_on_opened(&evt->data.evt_periodic_sync_opened);
+      break;
 
+    case sl_bt_evt_periodic_sync_report_id:
+      bcast_rx_on_report(&evt->data.evt_periodic_sync_report);
+      break;
+
+    case sl_bt_evt_sync_closed_id:
+      bcast_rx_on_closed(&evt->data.evt_sync_closed);
       break;
 
     // -------------------------------
@@ -117,7 +307,9 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
       sc = sl_bt_legacy_advertiser_start(advertising_set_handle,
                                          sl_bt_legacy_advertiser_connectable);
       app_assert_status(sc);
-      sc = sl_bt_scanner_start(sl_bt_scanner_scan_phy_1m , sl_bt_scanner_discover_observation);
+      bcast_rx_init();
+      sc = scan_profile_start(SCAN_PROFILE_DEFAULT, now_ms());
+      app_assert_status(sc);
       break;
 
     // -------------------------------
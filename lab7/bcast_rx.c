@@ -0,0 +1,200 @@
+/***************************************************************************//**
+ * @file
+ * @brief Listener for the laborator8 sensor broadcast (bcast_format.h).
+ ******************************************************************************/
+#include <string.h>
+#include "app_log.h"
+#include "ad_parser.h"
+#include "bcast_format.h"
+#include "bcast_rx.h"
+
+#define SYNC_NONE   0xffff
+
+typedef enum {
+  NODE_FREE,
+  NODE_OPENING,
+  NODE_SYNCED,
+} node_state_t;
+
+typedef struct {
+  node_state_t state;
+  uint16_t sync;
+  bd_addr address;
+  uint8_t address_type;
+  uint8_t sid;
+  bool have_seq;
+  uint16_t last_seq;
+} node_t;
+
+static node_t nodes[BCAST_RX_MAX_NODES];
+static bool opening;
+static bcast_rx_stats_t stats;
+
+static uint16_t get_u16(const uint8_t *p)
+{
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// The broadcast AD of a payload, checked up to the kind byte.
+static bool find_bcast(const uint8_t *data, uint8_t len, uint8_t kind,
+                       ad_field_t *field)
+{
+  if (!ad_find(data, len, AD_TYPE_MANUFACTURER, field)
+      || field->len < BCAST_OFF_BODY
+      || get_u16(&field->value[BCAST_OFF_COMPANY]) != BCAST_COMPANY_ID
+      || field->value[BCAST_OFF_MAGIC] != BCAST_MAGIC) {
+    return false;
+  }
+  return (field->value[BCAST_OFF_VERSION_KIND] >> 4) == BCAST_VERSION
+         && (field->value[BCAST_OFF_VERSION_KIND] & 0x0f) == kind;
+}
+
+static node_t *find_node(const bd_addr *address, uint8_t sid)
+{
+  for (uint8_t i = 0; i < BCAST_RX_MAX_NODES; i++) {
+    if (nodes[i].state != NODE_FREE && nodes[i].sid == sid
+        && memcmp(&nodes[i].address, address, sizeof(*address)) == 0) {
+      return &nodes[i];
+    }
+  }
+  return NULL;
+}
+
+static node_t *find_sync(uint16_t sync)
+{
+  for (uint8_t i = 0; i < BCAST_RX_MAX_NODES; i++) {
+    if (nodes[i].state != NODE_FREE && nodes[i].sync == sync) {
+      return &nodes[i];
+    }
+  }
+  return NULL;
+}
+
+static node_t *find_free(void)
+{
+  for (uint8_t i = 0; i < BCAST_RX_MAX_NODES; i++) {
+    if (nodes[i].state == NODE_FREE) {
+      return &nodes[i];
+    }
+  }
+  return NULL;
+}
+
+void bcast_rx_on_extended(const sl_bt_evt_scanner_extended_advertisement_report_t *report)
+{
+  ad_field_t field;
+  node_t *node;
+
+  if (opening || report->periodic_interval == 0
+      || find_node(&report->address, report->adv_sid) != NULL
+      || !find_bcast(report->data.data, report->data.len, BCAST_KIND_ANNOUNCE, &field)) {
+    return;
+  }
+  node = find_free();
+  if (node == NULL) {
+    return;
+  }
+  if (sl_bt_sync_scanner_open(report->address, report->address_type,
+                              report->adv_sid, &node->sync) != SL_STATUS_OK) {
+    return;
+  }
+  node->state = NODE_OPENING;
+  node->address = report->address;
+  node->address_type = report->address_type;
+  node->sid = report->adv_sid;
+  node->have_seq = false;
+  opening = true;
+}
+
+void bcast_rx_on_opened(const sl_bt_evt_periodic_sync_opened_t *opened)
+{
+  node_t *node = find_sync(opened->sync);
+
+  if (node == NULL) {
+    return;
+  }
+  node->state = NODE_SYNCED;
+  opening = false;
+  stats.opened++;
+  app_log_info("bcast %02x:%02x:%02x:%02x:%02x:%02x synced, interval %u ms"
+               APP_LOG_NEW_LINE,
+               node->address.addr[5], node->address.addr[4],
+               node->address.addr[3], node->address.addr[2],
+               node->address.addr[1], node->address.addr[0],
+               opened->adv_interval * 5 / 4);
+}
+
+void bcast_rx_on_report(const sl_bt_evt_periodic_sync_report_t *report)
+{
+  node_t *node = find_sync(report->sync);
+  const uint8_t *body;
+  ad_field_t field;
+  uint16_t seq;
+  int16_t temp_c10;
+
+  // Only complete trains; a truncated one is sent again next interval
+  if (node == NULL || report->data_status != 0) {
+    return;
+  }
+  stats.reports++;
+  if (!find_bcast(report->data.data, report->data.len, BCAST_KIND_READINGS, &field)
+      || field.len < BCAST_OFF_BODY + BCAST_READINGS_LEN) {
+    stats.bad++;
+    return;
+  }
+  body = field.value;
+  seq = get_u16(&body[BCAST_OFF_SEQ]);
+  if (node->have_seq) {
+    if (seq == node->last_seq) {
+      stats.repeats++;
+      return;
+    }
+    stats.lost += (uint16_t)(seq - node->last_seq - 1);
+  }
+  node->have_seq = true;
+  node->last_seq = seq;
+  stats.decoded++;
+
+  temp_c10 = (int16_t)get_u16(&body[BCAST_OFF_TEMP]);
+  app_log_info("bcast %02x:%02x seq %u: %d.%u C, button %u, %u presses, "
+               "%u links, rssi %d" APP_LOG_NEW_LINE,
+               node->address.addr[1], node->address.addr[0], seq,
+               temp_c10 / 10, (unsigned)(temp_c10 < 0 ? -temp_c10 : temp_c10) % 10,
+               body[BCAST_OFF_BUTTON] & BCAST_BUTTON_PRESSED,
+               get_u16(&body[BCAST_OFF_PRESSES]), body[BCAST_OFF_LINKS],
+               report->rssi);
+}
+
+void bcast_rx_on_closed(const sl_bt_evt_sync_closed_t *closed)
+{
+  node_t *node = find_sync(closed->sync);
+
+  if (node == NULL) {
+    return;
+  }
+  // A failed open ends here too
+  if (node->state == NODE_OPENING) {
+    opening = false;
+  }
+  stats.closed++;
+  app_log_info("bcast %02x:%02x sync closed: 0x%04x" APP_LOG_NEW_LINE,
+               node->address.addr[1], node->address.addr[0], closed->reason);
+  node->state = NODE_FREE;
+  node->sync = SYNC_NONE;
+}
+
+void bcast_rx_init(void)
+{
+  for (uint8_t i = 0; i < BCAST_RX_MAX_NODES; i++) {
+    nodes[i].state = NODE_FREE;
+    nodes[i].sync = SYNC_NONE;
+  }
+  opening = false;
+  sl_bt_sync_scanner_set_sync_parameters(0, BCAST_RX_SYNC_TIMEOUT,
+                                         sl_bt_sync_report_all);
+}
+
+const bcast_rx_stats_t *bcast_rx_stats(void)
+{
+  return &stats;
+}
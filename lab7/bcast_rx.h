@@ -0,0 +1,47 @@
+/***************************************************************************//**
+ * @file
+ * @brief Listener for the laborator8 sensor broadcast (bcast_format.h).
+ *
+ * Nodes are found through their extended announce advertisement; each one
+ * gets a periodic sync, after which its readings arrive without scanning
+ * and without a connection. Only one sync is opened at a time, the stack
+ * allows a single pending open.
+ ******************************************************************************/
+
+#ifndef BCAST_RX_H
+#define BCAST_RX_H
+
+#include <stdint.h>
+#include "sl_bt_api.h"
+
+#define BCAST_RX_MAX_NODES      4
+// Sync lost after this long without a train packet (10 ms units)
+#define BCAST_RX_SYNC_TIMEOUT   500
+
+typedef struct {
+  uint32_t opened;            ///< syncs established
+  uint32_t reports;           ///< periodic reports received
+  uint32_t decoded;           ///< new readings
+  uint32_t repeats;           ///< same seq as the last one
+  uint32_t lost;              ///< updates missed, from seq gaps
+  uint32_t bad;               ///< not a payload we understand
+  uint32_t closed;            ///< syncs lost or failed to open
+} bcast_rx_stats_t;
+
+/// Sets the sync parameters. Call on sl_bt_evt_system_boot_id.
+void bcast_rx_init(void);
+
+/// Opens a sync to an announcing node not tracked yet.
+void bcast_rx_on_extended(const sl_bt_evt_scanner_extended_advertisement_report_t *report);
+
+void bcast_rx_on_opened(const sl_bt_evt_periodic_sync_opened_t *opened);
+
+/// Decodes a readings train packet; repeats and truncated data are skipped.
+void bcast_rx_on_report(const sl_bt_evt_periodic_sync_report_t *report);
+
+/// Sync lost, or the open failed.
+void bcast_rx_on_closed(const sl_bt_evt_sync_closed_t *closed);
+
+const bcast_rx_stats_t *bcast_rx_stats(void);
+
+#endif // BCAST_RX_H
@@ -0,0 +1,124 @@
+/***************************************************************************//**
+ * @file
+ * @brief Fixed-size cache of recently seen advertisers, keyed by address.
+ *
+ * Open addressing with linear probing over a static table, so a report never
+ * allocates. Slots are never emptied, only overwritten, which keeps probe
+ * chains intact without tombstones: a lookup scans at most
+ * SCAN_CACHE_MAX_PROBE slots, and a new device takes the first empty or
+ * expired slot in that range, or else the one heard from least recently.
+ ******************************************************************************/
+#include <string.h>
+#include "scan_cache.h"
+
+#define SLOT_EMPTY  0xff
+
+static scan_cache_entry_t cache[SCAN_CACHE_SIZE];
+static scan_cache_stats_t stats;
+
+// FNV-1a over the address and its type
+static uint32_t hash_address(const bd_addr *address, uint8_t address_type)
+{
+  uint32_t h = 2166136261u ^ address_type;
+
+  for (uint8_t i = 0; i < sizeof(address->addr); i++) {
+    h = (h ^ address->addr[i]) * 16777619u;
+  }
+  return h ^ (h >> 16);
+}
+
+void scan_cache_init(void)
+{
+  for (uint16_t i = 0; i < SCAN_CACHE_SIZE; i++) {
+    cache[i].address_type = SLOT_EMPTY;
+  }
+  memset(&stats, 0, sizeof(stats));
+}
+
+scan_cache_entry_t *scan_cache_update(const bd_addr *address, uint8_t address_type,
+                                      int8_t rssi, uint32_t now_ms, bool *report)
+{
+  uint32_t home = hash_address(address, address_type);
+  scan_cache_entry_t *free_slot = NULL;
+  scan_cache_entry_t *stalest = NULL;
+  scan_cache_entry_t *e;
+
+  stats.reports++;
+  for (uint8_t probe = 0; probe < SCAN_CACHE_MAX_PROBE; probe++) {
+    e = &cache[(home + probe) & (SCAN_CACHE_SIZE - 1)];
+
+    if (e->address_type == SLOT_EMPTY) {
+      // Nothing was ever stored past an empty slot
+      if (free_slot == NULL) {
+        free_slot = e;
+      }
+      break;
+    }
+    if (e->address_type == address_type
+        && memcmp(e->address.addr, address->addr, sizeof(address->addr)) == 0) {
+      e->rssi_q4 += (rssi * 16 - e->rssi_q4) / (1 << SCAN_CACHE_RSSI_SHIFT);
+      e->flags |= SCAN_ENTRY_DIRTY;
+      e->last_seen_ms = now_ms;
+      if (e->count < UINT16_MAX) {
+        e->count++;
+      }
+      *report = (uint32_t)(now_ms - e->last_reported_ms) >= SCAN_CACHE_WINDOW_MS;
+      if (*report) {
+        e->last_reported_ms = now_ms;
+        stats.reported++;
+      }
+      return e;
+    }
+    if (free_slot == NULL
+        && (uint32_t)(now_ms - e->last_seen_ms) >= SCAN_CACHE_TTL_MS) {
+      free_slot = e;
+    }
+    if (stalest == NULL || (int32_t)(e->last_seen_ms - stalest->last_seen_ms) < 0) {
+      stalest = e;
+    }
+  }
+
+  if (free_slot != NULL) {
+    e = free_slot;
+  } else {
+    e = stalest;
+    stats.evictions++;
+  }
+  memcpy(e->address.addr, address->addr, sizeof(address->addr));
+  e->address_type = address_type;
+  e->flags = SCAN_ENTRY_DIRTY;
+  e->rssi_q4 = rssi * 16;
+  e->count = 1;
+  e->first_seen_ms = now_ms;
+  e->last_seen_ms = now_ms;
+  e->last_reported_ms = now_ms;
+  stats.reported++;
+  *report = true;
+  return e;
+}
+
+uint16_t scan_cache_count(uint32_t now_ms)
+{
+  uint16_t n = 0;
+
+  for (uint16_t i = 0; i < SCAN_CACHE_SIZE; i++) {
+    if (cache[i].address_type != SLOT_EMPTY
+        && (uint32_t)(now_ms - cache[i].last_seen_ms) < SCAN_CACHE_TTL_MS) {
+      n++;
+    }
+  }
+  return n;
+}
+
+scan_cache_entry_t *scan_cache_slot(uint16_t index)
+{
+  if (index >= SCAN_CACHE_SIZE || cache[index].address_type == SLOT_EMPTY) {
+    return NULL;
+  }
+  return &cache[index];
+}
+
+const scan_cache_stats_t *scan_cache_stats(void)
+{
+  return &stats;
+}
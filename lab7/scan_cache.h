@@ -0,0 +1,74 @@
+/***************************************************************************//**
+ * @file
+ * @brief Fixed-size cache of recently seen advertisers, keyed by address.
+ ******************************************************************************/
+
+#ifndef SCAN_CACHE_H
+#define SCAN_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sl_bt_api.h"
+
+// Power of two, comfortably above the number of advertisers in range;
+// 24 bytes per entry, so the default takes 12 kB of RAM
+#ifndef SCAN_CACHE_SIZE
+#define SCAN_CACHE_SIZE         512
+#endif
+// Slots probed from the home slot before the stalest one is evicted
+#define SCAN_CACHE_MAX_PROBE    32
+// A device is reported again after this long even if it keeps advertising
+#define SCAN_CACHE_WINDOW_MS    5000
+// Entries not heard from for this long are free for reuse
+#define SCAN_CACHE_TTL_MS       60000
+// Smoothing of the per-device RSSI: alpha = 1 / 2^shift
+#define SCAN_CACHE_RSSI_SHIFT   2
+
+// scan_cache_entry_t.flags
+#define SCAN_ENTRY_DIRTY        0x01  ///< updated since the last batch
+#define SCAN_ENTRY_PRESENT      0x02
+#define SCAN_ENTRY_ENTERED      0x04  ///< enter event not sent yet
+#define SCAN_ENTRY_EXITED       0x08  ///< exit event not sent yet
+
+typedef struct {
+  bd_addr address;
+  uint8_t address_type;       ///< 0xff marks an empty slot
+  uint8_t flags;              ///< SCAN_ENTRY_*, owned by the reporter
+  int16_t rssi_q4;            ///< smoothed RSSI in 1/16 dBm
+  uint16_t count;             ///< reports since first seen, saturating
+  uint32_t first_seen_ms;
+  uint32_t last_seen_ms;
+  uint32_t last_reported_ms;
+} scan_cache_entry_t;
+
+typedef struct {
+  uint32_t reports;           ///< advertisement reports looked up
+  uint32_t reported;          ///< reports let through the window
+  uint32_t evictions;         ///< live entries dropped for a new device
+} scan_cache_stats_t;
+
+void scan_cache_init(void);
+
+/**************************************************************************//**
+ * Records a report and returns the device's entry, creating it if needed.
+ * *report is set when the device is new or its window has expired; the
+ * caller is then expected to print it.
+ *****************************************************************************/
+scan_cache_entry_t *scan_cache_update(const bd_addr *address, uint8_t address_type,
+                                      int8_t rssi, uint32_t now_ms, bool *report);
+
+/// Live entries (seen within SCAN_CACHE_TTL_MS)
+uint16_t scan_cache_count(uint32_t now_ms);
+
+/// Slot by index, or NULL if it was never used; for sweeping the table.
+scan_cache_entry_t *scan_cache_slot(uint16_t index);
+
+/// Smoothed RSSI rounded to whole dBm.
+static inline int8_t scan_cache_rssi(const scan_cache_entry_t *entry)
+{
+  return (int8_t)((entry->rssi_q4 + (entry->rssi_q4 < 0 ? -8 : 8)) / 16);
+}
+
+const scan_cache_stats_t *scan_cache_stats(void);
+
+#endif // SCAN_CACHE_H
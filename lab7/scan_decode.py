@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""Decodes the batched scan frames lab7 writes to the VCOM (see scan_report.h).
+
+    scan_decode.py COM5              # live, needs pyserial
+    scan_decode.py capture.bin       # a raw capture
+    scan_decode.py COM5 --table      # redraw a device table every frame
+
+Enter/exit events and the firmware's text log lines are printed as they
+arrive; bytes that are neither are skipped until the next valid frame.
+"""
+import argparse
+import os
+import struct
+import sys
+
+SYNC = b'\xa5\x5a'
+RECORD = struct.Struct('<6sBBbH')
+FLAG_PRESENT, FLAG_ENTER, FLAG_EXIT = 0x01, 0x02, 0x04
+MAX_LEN = 1 + 4 + 1 + 255 * RECORD.size
+
+
+def crc16_ccitt(data, crc=0xffff):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xffff
+    return crc
+
+
+def fmt_addr(raw):
+    return ':'.join('{:02x}'.format(b) for b in reversed(raw))
+
+
+class Decoder:
+    """Feed bytes in, get ('text', line) and ('frame', seq, time_ms, records) out."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.text = bytearray()
+        self.crc_errors = 0
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            i = self.buf.find(SYNC)
+            if i < 0:
+                # Keep a trailing 0xa5, it may be half a sync
+                keep = 1 if self.buf.endswith(SYNC[:1]) else 0
+                yield from self._text(len(self.buf) - keep)
+                return
+            yield from self._text(i)
+            if len(self.buf) < 4:
+                return
+            (length,) = struct.unpack_from('<H', self.buf, 2)
+            if length < 6 or length > MAX_LEN:
+                del self.buf[:1]
+                continue
+            if len(self.buf) < 4 + length + 2:
+                return
+            body = bytes(self.buf[4:4 + length])
+            (crc,) = struct.unpack_from('<H', self.buf, 4 + length)
+            if crc16_ccitt(self.buf[2:4 + length]) != crc:
+                self.crc_errors += 1
+                del self.buf[:1]
+                continue
+            del self.buf[:4 + length + 2]
+            seq, time_ms, n = struct.unpack_from('<BIB', body)
+            if 6 + n * RECORD.size != length:
+                self.crc_errors += 1
+                continue
+            records = [RECORD.unpack_from(body, 6 + k * RECORD.size) for k in range(n)]
+            yield ('frame', seq, time_ms, records)
+
+    def _text(self, n):
+        """Moves the first n bytes to the text buffer and emits whole lines."""
+        self.text += self.buf[:n]
+        del self.buf[:n]
+        *lines, rest = self.text.split(b'\n')
+        self.text = bytearray(rest[-256:])
+        for line in lines:
+            line = line.decode('ascii', 'replace').strip()
+            if line:
+                yield ('text', line)
+
+
+def open_input(path, baud):
+    if os.path.exists(path) and not path.startswith('/dev/'):
+        return open(path, 'rb'), False
+    import serial  # pip install pyserial
+    return serial.Serial(path, baud, timeout=0.1), True
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('input', help='serial port or capture file')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--table', action='store_true', help='print the device table after each frame')
+    parser.add_argument('--quiet', action='store_true', help='hide the firmware text log')
+    args = parser.parse_args()
+
+    src, live = open_input(args.input, args.baud)
+    dec = Decoder()
+    devices = {}
+    last_seq = None
+    lost = 0
+
+    while True:
+        data = src.read(4096)
+        if not data:
+            if live:
+                continue
+            break
+        for item in dec.feed(data):
+            if item[0] == 'text':
+                if not args.quiet:
+                    print('#', item[1])
+                continue
+            _, seq, time_ms, records = item
+            if last_seq is not None:
+                lost += (seq - last_seq - 1) & 0xff
+            last_seq = seq
+            for addr, addr_type, flags, rssi, count in records:
+                key = (fmt_addr(addr), addr_type)
+                devices[key] = (flags & FLAG_PRESENT, rssi, count, time_ms)
+                if flags & FLAG_ENTER:
+                    print('{:10.3f} enter {}/{} {} dBm'.format(time_ms / 1000, key[0], addr_type, rssi))
+                if flags & FLAG_EXIT:
+                    print('{:10.3f} exit  {}/{} {} dBm'.format(time_ms / 1000, key[0], addr_type, rssi))
+            if args.table:
+                print('--- {:.3f} s, {} devices, {} present'.format(
+                    time_ms / 1000, len(devices), sum(1 for d in devices.values() if d[0])))
+                for (addr, addr_type), (present, rssi, count, seen) in sorted(
+                        devices.items(), key=lambda kv: -kv[1][1]):
+                    print('{} {}/{} {:4d} dBm {:6d} reports, {:.1f} s ago'.format(
+                        '*' if present else ' ', addr, addr_type, rssi, count, (time_ms - seen) / 1000))
+        sys.stdout.flush()
+
+    print('{} devices, {} frames lost, {} bad frames'.format(len(devices), lost, dec.crc_errors),
+          file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,143 @@
+/***************************************************************************//**
+ * @file
+ * @brief Scanner duty cycle profiles with radio time and energy estimates.
+ *
+ * The stack does not report how long the receiver was on, so radio time is
+ * derived from the profile: while scanning, the radio listens for window out
+ * of every interval. Time accounting is updated lazily, on profile changes
+ * and when the stats are read.
+ ******************************************************************************/
+#include <stddef.h>
+#include "sl_bt_api.h"
+#include "scan_profile.h"
+
+// All profiles scan the 1M PHY. Since bcast_rx brought in the extended
+// scanner, sl_bt_scanner_scan_phy_1m_and_coded is available, but nothing
+// in these labs advertises on Coded PHY (bcast uses 1M primary, 2M
+// secondary) and scanning both alternates the windows between the PHYs.
+static const scan_profile_t profiles[SCAN_PROFILE_COUNT] = {
+  [SCAN_PROFILE_CONTINUOUS] = {
+    .name = "continuous", .phy = sl_bt_scanner_scan_phy_1m,
+    .mode = sl_bt_scanner_scan_mode_passive,
+    .interval = 16, .window = 16, .duration_ms = 0,
+  },
+  [SCAN_PROFILE_BALANCED] = {
+    .name = "balanced", .phy = sl_bt_scanner_scan_phy_1m,
+    .mode = sl_bt_scanner_scan_mode_passive,
+    .interval = 160, .window = 48, .duration_ms = 0,
+  },
+  [SCAN_PROFILE_LOW_DUTY] = {
+    .name = "low-duty", .phy = sl_bt_scanner_scan_phy_1m,
+    .mode = sl_bt_scanner_scan_mode_passive,
+    .interval = 1600, .window = 48, .duration_ms = 0,
+  },
+  [SCAN_PROFILE_BURST] = {
+    .name = "burst", .phy = sl_bt_scanner_scan_phy_1m,
+    .mode = sl_bt_scanner_scan_mode_active,
+    .interval = 16, .window = 16, .duration_ms = 10000,
+  },
+};
+
+static scan_profile_stats_t stats[SCAN_PROFILE_COUNT];
+static scan_profile_id_t current = SCAN_PROFILE_COUNT;
+static scan_profile_id_t resume = SCAN_PROFILE_DEFAULT;
+static uint32_t started_ms;
+static uint32_t accounted_ms;
+
+static void account(uint32_t now_ms)
+{
+  uint32_t elapsed = now_ms - accounted_ms;
+
+  if (current >= SCAN_PROFILE_COUNT) {
+    return;
+  }
+  stats[current].active_ms += elapsed;
+  stats[current].radio_ms += (uint32_t)((uint64_t)elapsed * profiles[current].window
+                                        / profiles[current].interval);
+  accounted_ms = now_ms;
+}
+
+sl_status_t scan_profile_start(scan_profile_id_t id, uint32_t now_ms)
+{
+  const scan_profile_t *p;
+  sl_status_t sc;
+
+  if (id >= SCAN_PROFILE_COUNT) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+  p = &profiles[id];
+
+  // New parameters only apply when scanning is (re)started
+  if (current < SCAN_PROFILE_COUNT) {
+    account(now_ms);
+    sl_bt_scanner_stop();
+  }
+  sc = sl_bt_scanner_set_parameters(p->mode, p->interval, p->window);
+  if (sc == SL_STATUS_OK) {
+    sc = sl_bt_scanner_start(p->phy, sl_bt_scanner_discover_observation);
+  }
+  if (sc != SL_STATUS_OK) {
+    current = SCAN_PROFILE_COUNT;
+    return sc;
+  }
+  if (id != SCAN_PROFILE_BURST) {
+    resume = id;
+  }
+  current = id;
+  started_ms = now_ms;
+  accounted_ms = now_ms;
+  return SL_STATUS_OK;
+}
+
+sl_status_t scan_profile_burst(uint32_t now_ms)
+{
+  return scan_profile_start(SCAN_PROFILE_BURST, now_ms);
+}
+
+void scan_profile_process(uint32_t now_ms)
+{
+  if (current < SCAN_PROFILE_COUNT && profiles[current].duration_ms != 0
+      && (uint32_t)(now_ms - started_ms) >= profiles[current].duration_ms) {
+    scan_profile_start(resume, now_ms);
+  }
+}
+
+void scan_profile_count_report(void)
+{
+  if (current < SCAN_PROFILE_COUNT) {
+    stats[current].reports++;
+  }
+}
+
+scan_profile_id_t scan_profile_current(void)
+{
+  return current;
+}
+
+const scan_profile_t *scan_profile_get(scan_profile_id_t id)
+{
+  return id < SCAN_PROFILE_COUNT ? &profiles[id] : NULL;
+}
+
+const scan_profile_stats_t *scan_profile_stats(scan_profile_id_t id, uint32_t now_ms)
+{
+  if (id >= SCAN_PROFILE_COUNT) {
+    return NULL;
+  }
+  if (id == current) {
+    account(now_ms);
+  }
+  return &stats[id];
+}
+
+uint32_t scan_profile_average_ua(const scan_profile_stats_t *s)
+{
+  uint64_t charge;
+
+  if (s->active_ms == 0) {
+    return 0;
+  }
+  charge = (uint64_t)s->radio_ms * SCAN_PROFILE_RX_UA
+           + (uint64_t)(s->active_ms - s->radio_ms) * SCAN_PROFILE_SLEEP_UA;
+  return (uint32_t)(charge / s->active_ms);
+}
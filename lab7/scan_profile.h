@@ -0,0 +1,65 @@
+/***************************************************************************//**
+ * @file
+ * @brief Scanner duty cycle profiles with radio time and energy estimates.
+ ******************************************************************************/
+
+#ifndef SCAN_PROFILE_H
+#define SCAN_PROFILE_H
+
+#include <stdint.h>
+#include "sl_status.h"
+
+// Typical EFR32BG22 currents (datasheet, 1M PHY RX and EM2 with RAM
+// retention); only used to turn radio time into an average current.
+#define SCAN_PROFILE_RX_UA      3600
+#define SCAN_PROFILE_SLEEP_UA   2
+
+typedef enum {
+  SCAN_PROFILE_CONTINUOUS,    ///< radio always listening, lowest latency
+  SCAN_PROFILE_BALANCED,      ///< 30 ms of every 100 ms
+  SCAN_PROFILE_LOW_DUTY,      ///< 30 ms of every second, coarse presence
+  SCAN_PROFILE_BURST,         ///< continuous active scan, then back
+  SCAN_PROFILE_COUNT
+} scan_profile_id_t;
+
+typedef struct {
+  const char *name;
+  uint8_t phy;                ///< sl_bt_scanner_scan_phy_*
+  uint8_t mode;               ///< sl_bt_scanner_scan_mode_*
+  uint16_t interval;          ///< 0.625 ms units
+  uint16_t window;            ///< 0.625 ms units, <= interval
+  uint32_t duration_ms;       ///< 0: until changed; else revert afterwards
+} scan_profile_t;
+
+typedef struct {
+  uint32_t active_ms;         ///< time spent in the profile
+  uint32_t radio_ms;          ///< estimated receiver on time
+  uint32_t reports;
+} scan_profile_stats_t;
+
+#ifndef SCAN_PROFILE_DEFAULT
+#define SCAN_PROFILE_DEFAULT    SCAN_PROFILE_BALANCED
+#endif
+
+/// Stops the scanner if needed, applies the profile and starts it again.
+sl_status_t scan_profile_start(scan_profile_id_t id, uint32_t now_ms);
+
+/// Switches to SCAN_PROFILE_BURST; the previous profile resumes after it.
+sl_status_t scan_profile_burst(uint32_t now_ms);
+
+/// Ends a burst once its duration is over. Call from the main loop.
+void scan_profile_process(uint32_t now_ms);
+
+/// Counts one advertisement report against the current profile.
+void scan_profile_count_report(void);
+
+scan_profile_id_t scan_profile_current(void);
+const scan_profile_t *scan_profile_get(scan_profile_id_t id);
+
+/// Per-profile counters, brought up to now_ms for the current profile.
+const scan_profile_stats_t *scan_profile_stats(scan_profile_id_t id, uint32_t now_ms);
+
+/// Average current estimate over the time spent in the profile.
+uint32_t scan_profile_average_ua(const scan_profile_stats_t *stats);
+
+#endif // SCAN_PROFILE_H
@@ -0,0 +1,142 @@
+/***************************************************************************//**
+ * @file
+ * @brief Presence tracking and batched binary scan reports over the VCOM.
+ ******************************************************************************/
+#include <string.h>
+#include "sl_iostream.h"
+#include "sl_iostream_usart_vcom.h"
+#include "scan_report.h"
+
+#define HEADER_SIZE  10  // sync:2, len:2, seq, time:4, n
+#define FRAME_SIZE   (HEADER_SIZE + SCAN_REPORT_MAX_RECORDS * SCAN_REPORT_RECORD_SIZE + 2)
+
+static uint8_t frame[FRAME_SIZE];
+static uint8_t frame_records;
+static uint8_t frame_seq;
+static uint32_t frame_time_ms;
+static uint32_t last_flush_ms;
+static scan_report_stats_t stats;
+
+static uint16_t crc16_ccitt(const uint8_t *data, uint16_t len)
+{
+  uint16_t crc = 0xffff;
+
+  while (len--) {
+    crc ^= (uint16_t)*data++ << 8;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+static void put_le16(uint8_t *p, uint16_t v)
+{
+  p[0] = v & 0xff;
+  p[1] = v >> 8;
+}
+
+static void frame_send(void)
+{
+  uint16_t len = 1 + 4 + 1 + frame_records * SCAN_REPORT_RECORD_SIZE;
+  uint16_t size = 4 + len;
+
+  if (frame_records == 0) {
+    return;
+  }
+  frame[0] = SCAN_REPORT_SYNC0;
+  frame[1] = SCAN_REPORT_SYNC1;
+  put_le16(&frame[2], len);
+  frame[4] = frame_seq++;
+  put_le16(&frame[5], frame_time_ms & 0xffff);
+  put_le16(&frame[7], frame_time_ms >> 16);
+  frame[9] = frame_records;
+  put_le16(&frame[size], crc16_ccitt(&frame[2], size - 2));
+  size += 2;
+
+  sl_iostream_write(sl_iostream_vcom_handle, frame, size);
+  stats.frames++;
+  stats.records += frame_records;
+  stats.bytes += size;
+  frame_records = 0;
+}
+
+static void frame_add(const scan_cache_entry_t *entry, uint8_t flags)
+{
+  uint8_t *r = &frame[HEADER_SIZE + frame_records * SCAN_REPORT_RECORD_SIZE];
+
+  memcpy(r, entry->address.addr, sizeof(entry->address.addr));
+  r[6] = entry->address_type;
+  r[7] = flags;
+  r[8] = (uint8_t)scan_cache_rssi(entry);
+  put_le16(&r[9], entry->count);
+  if (++frame_records == SCAN_REPORT_MAX_RECORDS) {
+    frame_send();
+  }
+}
+
+static void presence_exit(scan_cache_entry_t *entry)
+{
+  entry->flags &= ~(SCAN_ENTRY_PRESENT | SCAN_ENTRY_ENTERED);
+  entry->flags |= SCAN_ENTRY_EXITED | SCAN_ENTRY_DIRTY;
+  stats.exits++;
+}
+
+void scan_report_update(scan_cache_entry_t *entry, uint32_t now_ms)
+{
+  int8_t rssi = scan_cache_rssi(entry);
+
+  (void)now_ms;
+  if (!(entry->flags & SCAN_ENTRY_PRESENT)) {
+    if (rssi >= SCAN_PRESENCE_ENTER_DBM) {
+      entry->flags |= SCAN_ENTRY_PRESENT | SCAN_ENTRY_ENTERED;
+      stats.enters++;
+    }
+  } else if (rssi < SCAN_PRESENCE_EXIT_DBM) {
+    presence_exit(entry);
+  }
+}
+
+void scan_report_process(uint32_t now_ms)
+{
+  scan_cache_entry_t *entry;
+  uint8_t flags;
+
+  if ((uint32_t)(now_ms - last_flush_ms) < SCAN_REPORT_PERIOD_MS) {
+    return;
+  }
+  last_flush_ms = now_ms;
+  frame_time_ms = now_ms;
+
+  for (uint16_t i = 0; i < SCAN_CACHE_SIZE; i++) {
+    entry = scan_cache_slot(i);
+    if (entry == NULL) {
+      continue;
+    }
+    if ((entry->flags & SCAN_ENTRY_PRESENT)
+        && (uint32_t)(now_ms - entry->last_seen_ms) >= SCAN_PRESENCE_TIMEOUT_MS) {
+      presence_exit(entry);
+    }
+    if (!(entry->flags & SCAN_ENTRY_DIRTY)) {
+      continue;
+    }
+    flags = 0;
+    if (entry->flags & SCAN_ENTRY_PRESENT) {
+      flags |= SCAN_REPORT_FLAG_PRESENT;
+    }
+    if (entry->flags & SCAN_ENTRY_ENTERED) {
+      flags |= SCAN_REPORT_FLAG_ENTER;
+    }
+    if (entry->flags & SCAN_ENTRY_EXITED) {
+      flags |= SCAN_REPORT_FLAG_EXIT;
+    }
+    entry->flags &= ~(SCAN_ENTRY_DIRTY | SCAN_ENTRY_ENTERED | SCAN_ENTRY_EXITED);
+    frame_add(entry, flags);
+  }
+  frame_send();
+}
+
+const scan_report_stats_t *scan_report_stats(void)
+{
+  return &stats;
+}
@@ -0,0 +1,62 @@
+/***************************************************************************//**
+ * @file
+ * @brief Presence tracking and batched binary scan reports over the VCOM.
+ *
+ * Frame layout, little endian:
+ *
+ *   0xa5 0x5a | len:2 | seq:1 | time_ms:4 | n:1 | n * record | crc:2
+ *
+ * len counts the bytes from seq to the last record. crc is CRC-16/CCITT
+ * (poly 0x1021, init 0xffff) over the same bytes plus len. A record is
+ *
+ *   address:6 | address_type:1 | flags:1 | rssi:1 | count:2
+ *
+ * with rssi the smoothed value in dBm, count the device's total reports and
+ * flags a mask of SCAN_REPORT_FLAG_*. Text log lines may appear between
+ * frames; a reader resyncs on the sync bytes and the CRC.
+ ******************************************************************************/
+
+#ifndef SCAN_REPORT_H
+#define SCAN_REPORT_H
+
+#include <stdint.h>
+#include "scan_cache.h"
+
+// How often updated devices are flushed
+#ifndef SCAN_REPORT_PERIOD_MS
+#define SCAN_REPORT_PERIOD_MS       1000
+#endif
+// Records per frame; a flush sends as many frames as it needs
+#define SCAN_REPORT_MAX_RECORDS     24
+
+// Presence, with hysteresis on the smoothed RSSI
+#define SCAN_PRESENCE_ENTER_DBM     -80
+#define SCAN_PRESENCE_EXIT_DBM      -88
+#define SCAN_PRESENCE_TIMEOUT_MS    10000
+
+#define SCAN_REPORT_SYNC0           0xa5
+#define SCAN_REPORT_SYNC1           0x5a
+#define SCAN_REPORT_RECORD_SIZE     11
+
+// Record flags
+#define SCAN_REPORT_FLAG_PRESENT    0x01
+#define SCAN_REPORT_FLAG_ENTER      0x02
+#define SCAN_REPORT_FLAG_EXIT       0x04
+
+typedef struct {
+  uint32_t frames;
+  uint32_t records;
+  uint32_t bytes;
+  uint32_t enters;
+  uint32_t exits;
+} scan_report_stats_t;
+
+/// Called after every scan_cache_update(); evaluates enter/exit by RSSI.
+void scan_report_update(scan_cache_entry_t *entry, uint32_t now_ms);
+
+/// Called from the main loop; times out absent devices and flushes.
+void scan_report_process(uint32_t now_ms);
+
+const scan_report_stats_t *scan_report_stats(void);
+
+#endif // SCAN_REPORT_H
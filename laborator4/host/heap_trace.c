@@ -0,0 +1,97 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "heap_trace.h"
+
+/* Keep max_align_t alignment for the caller */
+#define HDR_SIZE 16
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static size_t s_current;
+static size_t s_peak;
+
+/* realloc counts old and new block as live at the same time, which is
+ * what happens when it has to move the data */
+static void account(size_t add, size_t sub)
+{
+    size_t now = __atomic_add_fetch(&s_current, add, __ATOMIC_RELAXED);
+    size_t peak = __atomic_load_n(&s_peak, __ATOMIC_RELAXED);
+    while (now > peak
+            && !__atomic_compare_exchange_n(&s_peak, &peak, now, false,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    __atomic_sub_fetch(&s_current, sub, __ATOMIC_RELAXED);
+}
+
+void *__wrap_malloc(size_t size)
+{
+    uint8_t *p = __real_malloc(size + HDR_SIZE);
+    if (p == NULL) {
+        return NULL;
+    }
+    memcpy(p, &size, sizeof(size));
+    account(size, 0);
+    return p + HDR_SIZE;
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    size_t total = n * size;
+    if (size != 0 && total / size != n) {
+        return NULL;
+    }
+    void *p = __wrap_malloc(total);
+    if (p) {
+        memset(p, 0, total);
+    }
+    return p;
+}
+
+void __wrap_free(void *ptr)
+{
+    size_t size;
+    if (ptr == NULL) {
+        return;
+    }
+    uint8_t *p = (uint8_t *)ptr - HDR_SIZE;
+    memcpy(&size, p, sizeof(size));
+    account(0, size);
+    __real_free(p);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    size_t old;
+    if (ptr == NULL) {
+        return __wrap_malloc(size);
+    }
+    uint8_t *p = (uint8_t *)ptr - HDR_SIZE;
+    memcpy(&old, p, sizeof(old));
+    p = __real_realloc(p, size + HDR_SIZE);
+    if (p == NULL) {
+        return NULL;
+    }
+    memcpy(p, &size, sizeof(size));
+    account(size, old);
+    return p + HDR_SIZE;
+}
+
+size_t heap_trace_current(void)
+{
+    return __atomic_load_n(&s_current, __ATOMIC_RELAXED);
+}
+
+size_t heap_trace_peak(void)
+{
+    return __atomic_load_n(&s_peak, __ATOMIC_RELAXED);
+}
+
+void heap_trace_reset_peak(void)
+{
+    __atomic_store_n(&s_peak, heap_trace_current(), __ATOMIC_RELAXED);
+}
@@ -0,0 +1,239 @@
+/* Host benchmark of the laborator4 OTA path.
+ *
+ * Runs src/ota.c against file-backed flash partitions (stubs/) and an
+ * in-process HTTPS stand-in for server.py, then prints per-stage timing,
+ * throughput and heap use. --min-kbps / --max-heap turn it into a
+ * pass/fail check for CI.
+ *
+ *   cmake -S . -B build && cmake --build build && ./build/ota_bench --runs 3
+ */
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_http_client.h"
+#include "ota.h"
+#include "sim_flash.h"
+#include "standin_server.h"
+#include "heap_trace.h"
+
+#ifndef STANDIN_CERT_DIR
+#define STANDIN_CERT_DIR ".."
+#endif
+
+typedef struct {
+    ota_stats_t ota;
+    sim_flash_stats_t flash;
+    size_t peak_heap;
+} run_result_t;
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --image-kb N        firmware image size (default 900)\n"
+            "  --partition-kb N    app partition size (default 1024)\n"
+            "  --runs N            number of updates (default 3)\n"
+            "  --erase-us N        latency per 4 KiB sector erase (default 20000)\n"
+            "  --write-us N        latency per 256 B page program (default 250)\n"
+            "  --link-kbps N       throttle the stand-in server (default 0 = off)\n"
+            "  --flash-dir DIR     where the partition files go (default: mkdtemp)\n"
+            "  --min-kbps N        fail if average throughput is below N KB/s\n"
+            "  --max-heap N        fail if peak heap of the OTA path exceeds N bytes\n"
+            "  --verbose           firmware logs at INFO level\n", prog);
+}
+
+static double ms(int64_t us)
+{
+    return us / 1000.0;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t image_kb = 900, partition_kb = 1024, link_kbps = 0;
+    uint32_t erase_us = 20000, write_us = 250;
+    int runs = 3;
+    double min_kbps = 0;
+    size_t max_heap = 0;
+    const char *flash_dir = NULL;
+    char tmp_dir[] = "/tmp/ota_bench.XXXXXX";
+
+    static const struct option opts[] = {
+        { "image-kb", required_argument, NULL, 'i' },
+        { "partition-kb", required_argument, NULL, 'p' },
+        { "runs", required_argument, NULL, 'r' },
+        { "erase-us", required_argument, NULL, 'e' },
+        { "write-us", required_argument, NULL, 'w' },
+        { "link-kbps", required_argument, NULL, 'l' },
+        { "flash-dir", required_argument, NULL, 'd' },
+        { "min-kbps", required_argument, NULL, 'm' },
+        { "max-heap", required_argument, NULL, 'H' },
+        { "verbose", no_argument, NULL, 'v' },
+        { "help", no_argument, NULL, 'h' },
+        { 0 }
+    };
+    int c;
+    while ((c = getopt_long(argc, argv, "", opts, NULL)) != -1) {
+        switch (c) {
+        case 'i': image_kb = strtoul(optarg, NULL, 0); break;
+        case 'p': partition_kb = strtoul(optarg, NULL, 0); break;
+        case 'r': runs = atoi(optarg); break;
+        case 'e': erase_us = strtoul(optarg, NULL, 0); break;
+        case 'w': write_us = strtoul(optarg, NULL, 0); break;
+        case 'l': link_kbps = strtoul(optarg, NULL, 0); break;
+        case 'd': flash_dir = optarg; break;
+        case 'm': min_kbps = atof(optarg); break;
+        case 'H': max_heap = strtoul(optarg, NULL, 0); break;
+        case 'v': esp_log_host_level = ESP_LOG_INFO; break;
+        default: usage(argv[0]); return c == 'h' ? 0 : 2;
+        }
+    }
+    if (runs <= 0 || image_kb == 0 || image_kb > partition_kb) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (flash_dir == NULL) {
+        flash_dir = mkdtemp(tmp_dir);
+    }
+
+    sim_flash_config_t flash_config = {
+        .dir = flash_dir,
+        .app_partition_size = partition_kb * 1024,
+        .erase_us_per_sector = erase_us,
+        .write_us_per_page = write_us,
+    };
+    if (flash_dir == NULL || sim_flash_init(&flash_config) != 0) {
+        fprintf(stderr, "Cannot set up flash files\n");
+        return 1;
+    }
+
+    /* Pseudo-random payload behind a valid image header */
+    size_t image_size = (size_t)image_kb * 1024;
+    uint8_t *image = malloc(image_size);
+    uint32_t x = 0x12345678;
+    for (size_t i = 0; i < image_size; i++) {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        image[i] = (uint8_t)x;
+    }
+    image[0] = 0xE9;
+
+    standin_server_config_t server_config = {
+        .cert_file = STANDIN_CERT_DIR "/ca_cert.pem",
+        .key_file = STANDIN_CERT_DIR "/ca_key.pem",
+        .image = image,
+        .image_size = image_size,
+        .version = 1000,
+        .link_kbps = link_kbps,
+    };
+    int port = 0;
+    if (standin_server_start(&server_config, &port) != 0) {
+        fprintf(stderr, "Cannot start the HTTPS stand-in server\n");
+        return 1;
+    }
+
+    /* Same client settings as ota_task */
+    char *cert = NULL;
+    FILE *f = fopen(STANDIN_CERT_DIR "/ca_cert.pem", "rb");
+    if (f) {
+        fseek(f, 0, SEEK_END);
+        long cert_len = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        cert = calloc(1, cert_len + 1);
+        if (fread(cert, 1, cert_len, f) != (size_t)cert_len) {
+            cert[0] = '\0';
+        }
+        fclose(f);
+    }
+    char version_url[64], firmware_url[64];
+    snprintf(version_url, sizeof(version_url), "https://127.0.0.1:%d/version", port);
+    snprintf(firmware_url, sizeof(firmware_url), "https://127.0.0.1:%d/firmware.bin", port);
+    esp_http_client_config_t version_config = {
+        .url = version_url,
+        .cert_pem = cert,
+        .keep_alive_enable = true,
+        .skip_cert_common_name_check = true,
+    };
+    esp_http_client_config_t firmware_config = version_config;
+    firmware_config.url = firmware_url;
+
+    printf("image %u KiB, partition %u KiB, erase %u us/sector, write %u us/page, link %s\n",
+           image_kb, partition_kb, erase_us, write_us, link_kbps ? "throttled" : "unthrottled");
+    printf("%-4s %10s %10s %10s %10s %10s %10s %9s %10s\n", "run", "connect_ms", "erase_ms",
+           "dl_ms", "write_ms", "finish_ms", "total_ms", "KB/s", "heap_peak");
+
+    run_result_t sum = {0};
+    size_t worst_heap = 0;
+    int failures = 0;
+    for (int run = 0; run < runs; run++) {
+        run_result_t r = {0};
+        int version = 0;
+
+        sim_flash_reset_stats();
+        heap_trace_reset_peak();
+        size_t heap_base = heap_trace_current();
+
+        if (ota_fetch_version(&version_config, &version) != ESP_OK || version != server_config.version
+                || ota_perform_update(&firmware_config, &r.ota) != ESP_OK
+                || r.ota.image_size != image_size) {
+            printf("%-4d FAILED\n", run);
+            failures++;
+            continue;
+        }
+        r.peak_heap = heap_trace_peak() - heap_base;
+        sim_flash_get_stats(&r.flash);
+
+        double kbps = r.ota.image_size / 1024.0 / (r.ota.total_us / 1e6);
+        printf("%-4d %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %9.1f %10zu\n", run,
+               ms(r.ota.connect_us), ms(r.ota.erase_us), ms(r.ota.download_us),
+               ms(r.ota.write_us), ms(r.ota.finish_us), ms(r.ota.total_us), kbps, r.peak_heap);
+
+        sum.ota.connect_us += r.ota.connect_us;
+        sum.ota.erase_us += r.ota.erase_us;
+        sum.ota.download_us += r.ota.download_us;
+        sum.ota.write_us += r.ota.write_us;
+        sum.ota.finish_us += r.ota.finish_us;
+        sum.ota.total_us += r.ota.total_us;
+        sum.ota.image_size += r.ota.image_size;
+        sum.flash.sectors_erased += r.flash.sectors_erased;
+        sum.flash.pages_written += r.flash.pages_written;
+        if (r.peak_heap > worst_heap) {
+            worst_heap = r.peak_heap;
+        }
+    }
+
+    standin_server_stop();
+    sim_flash_deinit();
+
+    int ok_runs = runs - failures;
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    int rc = failures ? 1 : 0;
+    if (ok_runs > 0) {
+        double avg_kbps = sum.ota.image_size / 1024.0 / (sum.ota.total_us / 1e6);
+        printf("%-4s %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %9.1f %10zu\n", "avg",
+               ms(sum.ota.connect_us / ok_runs), ms(sum.ota.erase_us / ok_runs),
+               ms(sum.ota.download_us / ok_runs), ms(sum.ota.write_us / ok_runs),
+               ms(sum.ota.finish_us / ok_runs), ms(sum.ota.total_us / ok_runs), avg_kbps, worst_heap);
+        printf("flash: %llu sectors erased, %llu pages written per update\n",
+               (unsigned long long)(sum.flash.sectors_erased / ok_runs),
+               (unsigned long long)(sum.flash.pages_written / ok_runs));
+        if (min_kbps > 0 && avg_kbps < min_kbps) {
+            printf("FAIL: %.1f KB/s is below the %.1f KB/s floor\n", avg_kbps, min_kbps);
+            rc = 1;
+        }
+    }
+    printf("process peak RSS: %ld KiB\n", ru.ru_maxrss);
+    if (max_heap > 0 && worst_heap > max_heap) {
+        printf("FAIL: peak heap %zu B exceeds %zu B\n", worst_heap, max_heap);
+        rc = 1;
+    }
+
+    free(cert);
+    free(image);
+    return rc;
+}
@@ -0,0 +1,148 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+#include "standin_server.h"
+
+#define SEND_CHUNK 1460
+
+static standin_server_config_t s_config;
+static SSL_CTX *s_ctx;
+static int s_listen_fd = -1;
+static pthread_t s_thread;
+static volatile int s_running;
+
+static void throttle(size_t bytes)
+{
+    if (s_config.link_kbps == 0) {
+        return;
+    }
+    long long us = (long long)bytes * 8 * 1000 / s_config.link_kbps;
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+static int send_all(SSL *ssl, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    while (len > 0) {
+        int n = SSL_write(ssl, p, len > SEND_CHUNK ? SEND_CHUNK : (int)len);
+        if (n <= 0) {
+            return -1;
+        }
+        throttle(n);
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static void serve(SSL *ssl)
+{
+    char req[1024];
+    char hdr[256];
+    int len = 0;
+
+    while (len < (int)sizeof(req) - 1) {
+        int n = SSL_read(ssl, req + len, sizeof(req) - 1 - len);
+        if (n <= 0) {
+            return;
+        }
+        len += n;
+        req[len] = '\0';
+        if (strstr(req, "\r\n\r\n")) {
+            break;
+        }
+    }
+
+    if (strncmp(req, "GET /version ", 13) == 0) {
+        char body[16];
+        int body_len = snprintf(body, sizeof(body), "%d", s_config.version);
+        int n = snprintf(hdr, sizeof(hdr),
+                         "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: %d\r\n"
+                         "Connection: close\r\n\r\n", body_len);
+        if (send_all(ssl, hdr, n) == 0) {
+            send_all(ssl, body, body_len);
+        }
+    } else if (strncmp(req, "GET /firmware.bin ", 18) == 0) {
+        int n = snprintf(hdr, sizeof(hdr),
+                         "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\n"
+                         "Content-Length: %zu\r\nConnection: close\r\n\r\n", s_config.image_size);
+        if (send_all(ssl, hdr, n) == 0) {
+            send_all(ssl, s_config.image, s_config.image_size);
+        }
+    } else {
+        const char *nf = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        send_all(ssl, nf, strlen(nf));
+    }
+}
+
+static void *server_thread(void *arg)
+{
+    (void)arg;
+    while (s_running) {
+        int fd = accept(s_listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        SSL *ssl = SSL_new(s_ctx);
+        SSL_set_fd(ssl, fd);
+        if (SSL_accept(ssl) == 1) {
+            serve(ssl);
+            SSL_shutdown(ssl);
+        }
+        SSL_free(ssl);
+        close(fd);
+    }
+    return NULL;
+}
+
+int standin_server_start(const standin_server_config_t *config, int *out_port)
+{
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t addr_len = sizeof(addr);
+
+    s_config = *config;
+    s_ctx = SSL_CTX_new(TLS_server_method());
+    if (s_ctx == NULL
+            || SSL_CTX_use_certificate_file(s_ctx, config->cert_file, SSL_FILETYPE_PEM) != 1
+            || SSL_CTX_use_PrivateKey_file(s_ctx, config->key_file, SSL_FILETYPE_PEM) != 1) {
+        ERR_print_errors_fp(stderr);
+        return -1;
+    }
+
+    s_listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(s_listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(s_listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0
+            || listen(s_listen_fd, 4) != 0
+            || getsockname(s_listen_fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+        perror("standin_server");
+        return -1;
+    }
+    *out_port = ntohs(addr.sin_port);
+
+    s_running = 1;
+    return pthread_create(&s_thread, NULL, server_thread, NULL) == 0 ? 0 : -1;
+}
+
+void standin_server_stop(void)
+{
+    s_running = 0;
+    shutdown(s_listen_fd, SHUT_RDWR);
+    close(s_listen_fd);
+    pthread_join(s_thread, NULL);
+    SSL_CTX_free(s_ctx);
+}
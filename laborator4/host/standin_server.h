@@ -0,0 +1,21 @@
+#ifndef _STANDIN_SERVER_H_
+#define _STANDIN_SERVER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Local HTTPS stand-in for server.py: serves /version and /firmware.bin
+ * from memory on 127.0.0.1, optionally throttled to a link rate */
+typedef struct {
+    const char *cert_file;
+    const char *key_file;
+    const uint8_t *image;
+    size_t image_size;
+    int version;
+    uint32_t link_kbps;     /* 0 = unthrottled */
+} standin_server_config_t;
+
+int standin_server_start(const standin_server_config_t *config, int *out_port);
+void standin_server_stop(void);
+
+#endif
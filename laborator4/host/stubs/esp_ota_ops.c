@@ -0,0 +1,160 @@
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+
+#define ALIGN_UP(x, a) (((x) + (a) - 1) / (a) * (a))
+
+static const char *TAG = "sim_ota";
+
+/* Mirrors the bookkeeping of app_update/esp_ota_ops.c: one open handle,
+ * sequential writes, erase either up front or sector by sector */
+typedef struct {
+    esp_ota_handle_t handle;
+    const esp_partition_t *part;
+    size_t erased_size;
+    size_t wrote_size;
+    bool sequential_erase;
+} ota_ops_entry_t;
+
+static ota_ops_entry_t s_entry;
+static esp_ota_handle_t s_handle_seq;
+static const esp_partition_t *s_boot_partition;
+
+const esp_partition_t *esp_ota_get_running_partition(void)
+{
+    return esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_FACTORY, NULL);
+}
+
+const esp_partition_t *esp_ota_get_boot_partition(void)
+{
+    return s_boot_partition ? s_boot_partition : esp_ota_get_running_partition();
+}
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from)
+{
+    if (start_from == NULL) {
+        start_from = esp_ota_get_running_partition();
+    }
+    if (start_from->subtype == ESP_PARTITION_SUBTYPE_APP_OTA_0) {
+        return esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_1, NULL);
+    }
+    return esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_0, NULL);
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t image_size,
+                        esp_ota_handle_t *out_handle)
+{
+    esp_err_t ret = ESP_OK;
+
+    if (partition == NULL || out_handle == NULL || partition->type != ESP_PARTITION_TYPE_APP) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (partition == esp_ota_get_running_partition()) {
+        return ESP_ERR_OTA_BASE + 0x02; /* ESP_ERR_OTA_PARTITION_CONFLICT */
+    }
+    if (s_entry.handle != 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    memset(&s_entry, 0, sizeof(s_entry));
+    if (image_size == OTA_WITH_SEQUENTIAL_WRITES) {
+        s_entry.sequential_erase = true;
+    } else if (image_size == OTA_SIZE_UNKNOWN) {
+        ret = esp_partition_erase_range(partition, 0, partition->size);
+        s_entry.erased_size = partition->size;
+    } else {
+        if (image_size > partition->size) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        s_entry.erased_size = ALIGN_UP(image_size, SPI_FLASH_SEC_SIZE);
+        ret = esp_partition_erase_range(partition, 0, s_entry.erased_size);
+    }
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    s_entry.part = partition;
+    s_entry.handle = ++s_handle_seq;
+    *out_handle = s_entry.handle;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size)
+{
+    if (handle == 0 || handle != s_entry.handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_entry.wrote_size == 0 && size > 0 && ((const uint8_t *)data)[0] != ESP_IMAGE_HEADER_MAGIC) {
+        ESP_LOGE(TAG, "OTA image has invalid magic byte (expected 0xE9, saw 0x%02x)",
+                 ((const uint8_t *)data)[0]);
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+
+    size_t end = s_entry.wrote_size + size;
+    if (s_entry.sequential_erase && end > s_entry.erased_size) {
+        size_t to_erase = ALIGN_UP(end, SPI_FLASH_SEC_SIZE) - s_entry.erased_size;
+        if (s_entry.erased_size + to_erase > s_entry.part->size) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        esp_err_t ret = esp_partition_erase_range(s_entry.part, s_entry.erased_size, to_erase);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        s_entry.erased_size += to_erase;
+    }
+    if (end > s_entry.erased_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t ret = esp_partition_write(s_entry.part, s_entry.wrote_size, data, size);
+    if (ret == ESP_OK) {
+        s_entry.wrote_size = end;
+    }
+    return ret;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle)
+{
+    uint8_t magic = 0;
+
+    if (handle == 0 || handle != s_entry.handle) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_err_t ret = ESP_OK;
+    if (s_entry.wrote_size == 0
+            || esp_partition_read(s_entry.part, 0, &magic, 1) != ESP_OK
+            || magic != ESP_IMAGE_HEADER_MAGIC) {
+        ret = ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    memset(&s_entry, 0, sizeof(s_entry));
+    return ret;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle)
+{
+    if (handle == 0 || handle != s_entry.handle) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    memset(&s_entry, 0, sizeof(s_entry));
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition)
+{
+    /* The real implementation rewrites one otadata sector per switch */
+    const esp_partition_t *otadata = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                              ESP_PARTITION_SUBTYPE_DATA_OTA, NULL);
+    uint32_t seq = partition->subtype - ESP_PARTITION_SUBTYPE_APP_OTA_0 + 1;
+
+    esp_err_t ret = esp_partition_erase_range(otadata, 0, SPI_FLASH_SEC_SIZE);
+    if (ret == ESP_OK) {
+        ret = esp_partition_write(otadata, 0, &seq, sizeof(seq));
+    }
+    if (ret == ESP_OK) {
+        s_boot_partition = partition;
+    }
+    return ret;
+}
@@ -0,0 +1,188 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_partition.h"
+#include "sim_flash.h"
+
+#define FLASH_PAGE_SIZE 256
+
+static const char *TAG = "sim_flash";
+
+/* Same shape as partitions_two_ota.csv; app sizes come from the config */
+static esp_partition_t s_partitions[] = {
+    { ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_OTA,    0xd000,  0x2000, SPI_FLASH_SEC_SIZE, "otadata", false },
+    { ESP_PARTITION_TYPE_APP,  ESP_PARTITION_SUBTYPE_APP_FACTORY, 0x10000, 0,      SPI_FLASH_SEC_SIZE, "factory", false },
+    { ESP_PARTITION_TYPE_APP,  ESP_PARTITION_SUBTYPE_APP_OTA_0,   0,       0,      SPI_FLASH_SEC_SIZE, "ota_0",   false },
+    { ESP_PARTITION_TYPE_APP,  ESP_PARTITION_SUBTYPE_APP_OTA_1,   0,       0,      SPI_FLASH_SEC_SIZE, "ota_1",   false },
+};
+#define PARTITION_COUNT (sizeof(s_partitions) / sizeof(s_partitions[0]))
+
+static int s_fds[PARTITION_COUNT] = { -1, -1, -1, -1 };
+static sim_flash_config_t s_config;
+static sim_flash_stats_t s_stats;
+
+static void sim_busy(int64_t us)
+{
+    if (us <= 0) {
+        return;
+    }
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000 };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+    s_stats.busy_us += us;
+}
+
+static int partition_index(const esp_partition_t *partition)
+{
+    for (size_t i = 0; i < PARTITION_COUNT; i++) {
+        if (partition == &s_partitions[i]) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+int sim_flash_init(const sim_flash_config_t *config)
+{
+    char path[512];
+    static uint8_t erased[SPI_FLASH_SEC_SIZE];
+
+    s_config = *config;
+    memset(erased, 0xff, sizeof(erased));
+    memset(&s_stats, 0, sizeof(s_stats));
+
+    uint32_t address = s_partitions[1].address;
+    for (size_t i = 1; i < PARTITION_COUNT; i++) {
+        s_partitions[i].address = address;
+        s_partitions[i].size = config->app_partition_size;
+        address += config->app_partition_size;
+    }
+
+    for (size_t i = 0; i < PARTITION_COUNT; i++) {
+        snprintf(path, sizeof(path), "%s/%s.bin", config->dir, s_partitions[i].label);
+        s_fds[i] = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (s_fds[i] < 0) {
+            ESP_LOGE(TAG, "Cannot create %s: %s", path, strerror(errno));
+            return -1;
+        }
+        /* A fresh chip reads back as all ones */
+        for (uint32_t off = 0; off < s_partitions[i].size; off += sizeof(erased)) {
+            if (pwrite(s_fds[i], erased, sizeof(erased), off) != (ssize_t)sizeof(erased)) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+void sim_flash_get_stats(sim_flash_stats_t *stats)
+{
+    *stats = s_stats;
+}
+
+void sim_flash_reset_stats(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+}
+
+void sim_flash_deinit(void)
+{
+    for (size_t i = 0; i < PARTITION_COUNT; i++) {
+        if (s_fds[i] >= 0) {
+            close(s_fds[i]);
+            s_fds[i] = -1;
+        }
+    }
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype,
+                                                const char *label)
+{
+    for (size_t i = 0; i < PARTITION_COUNT; i++) {
+        const esp_partition_t *p = &s_partitions[i];
+        if (p->type == type
+                && (subtype == ESP_PARTITION_SUBTYPE_ANY || p->subtype == subtype)
+                && (label == NULL || strcmp(label, p->label) == 0)) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset,
+                             void *dst, size_t size)
+{
+    int idx = partition_index(partition);
+    if (idx < 0 || src_offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return pread(s_fds[idx], dst, size, src_offset) == (ssize_t)size ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset,
+                              const void *src, size_t size)
+{
+    uint8_t page[FLASH_PAGE_SIZE];
+    const uint8_t *in = src;
+    int idx = partition_index(partition);
+    if (idx < 0 || dst_offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    while (size > 0) {
+        size_t chunk = FLASH_PAGE_SIZE - (dst_offset % FLASH_PAGE_SIZE);
+        if (chunk > size) {
+            chunk = size;
+        }
+        if (pread(s_fds[idx], page, chunk, dst_offset) != (ssize_t)chunk) {
+            return ESP_FAIL;
+        }
+        /* NOR programming can only clear bits */
+        for (size_t i = 0; i < chunk; i++) {
+            if ((page[i] & in[i]) != in[i]) {
+                ESP_LOGW(TAG, "%s: write to non-erased byte at 0x%zx",
+                         partition->label, dst_offset + i);
+            }
+            page[i] &= in[i];
+        }
+        if (pwrite(s_fds[idx], page, chunk, dst_offset) != (ssize_t)chunk) {
+            return ESP_FAIL;
+        }
+        sim_busy(s_config.write_us_per_page);
+        s_stats.pages_written++;
+        s_stats.bytes_written += chunk;
+        in += chunk;
+        dst_offset += chunk;
+        size -= chunk;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset,
+                                    size_t size)
+{
+    static uint8_t erased[SPI_FLASH_SEC_SIZE];
+    int idx = partition_index(partition);
+    if (idx < 0 || offset % SPI_FLASH_SEC_SIZE || size % SPI_FLASH_SEC_SIZE
+            || offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(erased, 0xff, sizeof(erased));
+    for (size_t off = offset; off < offset + size; off += SPI_FLASH_SEC_SIZE) {
+        if (pwrite(s_fds[idx], erased, sizeof(erased), off) != (ssize_t)sizeof(erased)) {
+            return ESP_FAIL;
+        }
+        sim_busy(s_config.erase_us_per_sector);
+        s_stats.sectors_erased++;
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,28 @@
+#ifndef _SIM_FLASH_H_
+#define _SIM_FLASH_H_
+
+#include <stdint.h>
+
+/* File-backed stand-in for the SPI flash. Every partition of the
+ * two-OTA layout lives in its own <dir>/<label>.bin file and every
+ * erase/program operation costs the configured latency. */
+typedef struct {
+    const char *dir;
+    uint32_t app_partition_size;
+    uint32_t erase_us_per_sector;   /* 4 KiB sector erase */
+    uint32_t write_us_per_page;     /* 256 byte page program */
+} sim_flash_config_t;
+
+typedef struct {
+    uint64_t sectors_erased;
+    uint64_t pages_written;
+    uint64_t bytes_written;
+    int64_t busy_us;
+} sim_flash_stats_t;
+
+int sim_flash_init(const sim_flash_config_t *config);
+void sim_flash_get_stats(sim_flash_stats_t *stats);
+void sim_flash_reset_stats(void);
+void sim_flash_deinit(void);
+
+#endif
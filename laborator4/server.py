@@ -1,7 +1,15 @@
 import io
+import socket
 from flask import Flask, send_file
 import os.path
 
+try:
+    from zeroconf import ServiceInfo, Zeroconf
+except ImportError:
+    Zeroconf = None
+
+PORT = 5000
+
 app = Flask(__name__)
 
 @app.route('/firmware.bin')
@@ -17,5 +25,35 @@ def firm():
 def hello():
     return "Hello World!"
 
+def advertise():
+    """Announce the server as _esp-ota._tcp so the ESP32 finds it by name
+    (pip install zeroconf). Without it the device falls back to the IP in
+    main.c."""
+    if Zeroconf is None:
+        print('zeroconf not installed, not advertising over mDNS')
+        return None
+    s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    s.connect(('8.8.8.8', 80))  # no traffic, only picks the outgoing interface
+    ip = s.getsockname()[0]
+    s.close()
+    with open('versioning') as f:
+        version = f.readline().strip()
+    info = ServiceInfo('_esp-ota._tcp.local.',
+                       '{}._esp-ota._tcp.local.'.format(socket.gethostname()),
+                       addresses=[socket.inet_aton(ip)], port=PORT,
+                       properties={'path': '/firmware.bin', 'version': version})
+    zc = Zeroconf()
+    zc.register_service(info)
+    print('Advertising _esp-ota._tcp on {}:{}'.format(ip, PORT))
+    return zc
+
 if __name__ == '__main__':
-    app.run(host='0.0.0.0', ssl_context=('ca_cert.pem', 'ca_key.pem'), debug=True)
\ No newline at end of file
+    zc = advertise()
+    try:
+        # No reloader: it would start a second process and register twice
+        app.run(host='0.0.0.0', port=PORT, ssl_context=('ca_cert.pem', 'ca_key.pem'),
+                debug=True, use_reloader=False)
+    finally:
+        if zc:
+            zc.unregister_all_services()
+            zc.close()
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef _DISCOVERY_H_
+#define _DISCOVERY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_netif_ip_addr.h"
+#include "mdns.h"
+
+/* mDNS host name + DNS-SD services, and a small cache of names resolved
+ * on the local network so a peer's IP is not baked into the firmware */
+
+#define DISCOVERY_CACHE_SIZE        8
+#define DISCOVERY_QUERY_TIMEOUT_MS  1500
+#define DISCOVERY_DEFAULT_TTL_S     120     /* when the answer carries none */
+#define DISCOVERY_NEGATIVE_TTL_S    10      /* "not found" is remembered too */
+
+/* host_prefix gets the last 3 bytes of the MAC appended, e.g. esp32-a1b2c3 */
+esp_err_t discovery_init(const char *host_prefix, const char *instance_name);
+const char *discovery_hostname(void);
+
+esp_err_t discovery_advertise(const char *service, const char *proto, uint16_t port,
+                              mdns_txt_item_t *txt, size_t txt_count);
+
+/* "name" or "name.local" to IPv4 */
+esp_err_t discovery_resolve_host(const char *host, esp_ip4_addr_t *addr);
+
+/* First instance of _service._proto that is not this device */
+esp_err_t discovery_find_service(const char *service, const char *proto,
+                                 esp_ip4_addr_t *addr, uint16_t *port);
+
+/* Forget a cached answer, e.g. after the peer stopped responding */
+void discovery_invalidate(const char *name);
+
+#endif
@@ -17,7 +17,6 @@
 #include "esp_log.h"
 #include "nvs_flash.h"
 #include "esp_http_client.h"
-#include "esp_https_ota.h"
 #include "esp_tls.h"
 
 #include "lwip/err.h"
@@ -26,15 +25,21 @@
 #include "lwip/sockets.h"
 #include "lwip/netdb.h"
 #include "version.h"
+#include "ota.h"
+#include "discovery.h"
 
 #define CONFIG_ESP_WIFI_SSID      "lab-iot"
 #define CONFIG_ESP_WIFI_PASS      "IoT-IoT-IoT"
 #define CONFIG_ESP_MAXIMUM_RETRY  5
 #define CONFIG_LOCAL_PORT         10001
 
-//TODO: Modificati adresa IP de mai jos pentru a coincide cu cea a PC-ul pe care rulati scriptul python
+/* server.py advertises itself as _esp-ota._tcp over mDNS; these URLs are
+ * only used when nobody answers */
 #define CONFIG_EXAMPLE_FIRMWARE_UPGRADE_URL "https://192.168.250.166:5000/firmware.bin"
 #define GET_VERSION_NUMBER_URL              "https://192.168.250.166:5000/version"
+#define OTA_SERVICE                         "_esp-ota"
+#define OTA_SERVICE_PROTO                   "_tcp"
+#define OTA_URL_LEN                         96
 
 #define GPIO_OUTPUT_IO 4
 #define GPIO_OUTPUT_PIN_SEL (1ULL<<GPIO_OUTPUT_IO)
@@ -55,8 +60,6 @@ extern const uint8_t server_cert_pem_end[] asm("_binary_ca_cert_pem_end");
 
 static int s_retry_num = 0;
 
-static char *response_buffer = NULL;
-
 esp_err_t _http_event_handler(esp_http_client_event_t *evt)
 {
     switch (evt->event_id) {
@@ -82,21 +85,8 @@ esp_err_t _http_event_handler(esp_http_client_event_t *evt)
     case HTTP_EVENT_REDIRECT:
         ESP_LOGI(TAG, "HTTP_EVENT_REDIRECT");
         break;
-        case HTTP_EVENT_ON_DATA:
-        ESP_LOGI(TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
-        if (evt->data && evt->data_len) {
-            if (response_buffer == NULL) {
-                response_buffer = malloc(evt->data_len + 1);
-                if (response_buffer == NULL) {
-                    ESP_LOGE("HTTP_EVENT", "Failed to allocate memory for response buffer");
-                    break;
-                }
-            }
-
-            // Copy the response data into the buffer
-            memcpy(response_buffer, evt->data, evt->data_len);
-            response_buffer[evt->data_len] = '\0';  // Null-terminate the string
-        }
+    case HTTP_EVENT_ON_DATA:
+        ESP_LOGD(TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
         break;
     }
     return ESP_OK;
@@ -184,13 +174,34 @@ bool wifi_init_sta(void)
     return false;
 }
 
+/* Looks the update server up by service name, so a new DHCP lease on the
+ * PC does not need a reflash. Returns false when the fallback URLs are used. */
+static bool ota_server_urls(char *version_url, char *firmware_url)
+{
+    esp_ip4_addr_t addr;
+    uint16_t port;
+
+    if (discovery_find_service(OTA_SERVICE, OTA_SERVICE_PROTO, &addr, &port) == ESP_OK) {
+        snprintf(version_url, OTA_URL_LEN, "https://" IPSTR ":%u/version", IP2STR(&addr), port);
+        snprintf(firmware_url, OTA_URL_LEN, "https://" IPSTR ":%u/firmware.bin", IP2STR(&addr), port);
+        return true;
+    }
+    strlcpy(version_url, GET_VERSION_NUMBER_URL, OTA_URL_LEN);
+    strlcpy(firmware_url, CONFIG_EXAMPLE_FIRMWARE_UPGRADE_URL, OTA_URL_LEN);
+    return false;
+}
+
 static void ota_task(void *pvParameters)
 {
+    char version_url[OTA_URL_LEN];
+    char firmware_url[OTA_URL_LEN];
+
     xEventGroupWaitBits(s_event_start_ota, BIT_BTN_PRESSED, pdTRUE, pdTRUE, portMAX_DELAY);
 
     ESP_LOGI(TAG, "Starting OTA example task");
+    bool discovered = ota_server_urls(version_url, firmware_url);
     esp_http_client_config_t getVersionConfig = {
-        .url = GET_VERSION_NUMBER_URL,
+        .url = version_url,
         .cert_pem = (char *)server_cert_pem_start,
         .cert_len = 1422,
         .event_handler = _http_event_handler,
@@ -200,7 +211,7 @@ static void ota_task(void *pvParameters)
     };
 
     esp_http_client_config_t config = {
-        .url = CONFIG_EXAMPLE_FIRMWARE_UPGRADE_URL,
+        .url = firmware_url,
         .cert_pem = (char *)server_cert_pem_start,
         .cert_len = 1422,
         .event_handler = _http_event_handler,
@@ -209,35 +220,30 @@ static void ota_task(void *pvParameters)
         .skip_cert_common_name_check = true
     };
 
-    esp_https_ota_config_t ota_config = {
-        .http_config = &config,
-    };
-    
     ESP_ERROR_CHECK(esp_tls_init_global_ca_store());
     ESP_ERROR_CHECK(esp_tls_set_global_ca_store((unsigned char*)server_cert_pem_start, server_cert_pem_end - server_cert_pem_start));
 
     ESP_LOGI(TAG, "Attempting to get version update from %s", getVersionConfig.url);
-    ESP_LOGI(TAG, "Attempting to download update from %s", config.url);
-    esp_http_client_handle_t client = esp_http_client_init(&getVersionConfig);
-
-    esp_err_t err = esp_http_client_perform(client);
-
     int versionNumber = 0;
-    if (err == ESP_OK) {
-        ESP_LOGI("HTTP", "HTTPS Status = %d", esp_http_client_get_status_code(client));
-        ESP_LOGI("BUILD_NUMBER", "BUILD_NUMBER: %s", BUILD_NUMBER);
-    }
-    if (response_buffer != NULL) {
-        ESP_LOGI("HTTP", "Response Body: %s", response_buffer);
-        versionNumber = response_buffer;
-        free(response_buffer);
+    if (ota_fetch_version(&getVersionConfig, &versionNumber) != ESP_OK) {
+        ESP_LOGE(TAG, "Could not read the version from the server");
+        if (discovered) {
+            /* Stale answer: ask the network again next time */
+            discovery_invalidate(OTA_SERVICE "." OTA_SERVICE_PROTO);
+        }
     }
+    ESP_LOGI("BUILD_NUMBER", "BUILD_NUMBER: %s", BUILD_NUMBER);
     ESP_LOGI("versionNumber", "versionNumber: %d", versionNumber);
+
     if (false)
     {
-        esp_err_t ret = esp_https_ota(&ota_config);
+        ESP_LOGI(TAG, "Attempting to download update from %s", config.url);
+        ota_stats_t stats;
+        esp_err_t ret = ota_perform_update(&config, &stats);
         if (ret == ESP_OK) {
-            ESP_LOGI(TAG, "OTA Succeed, Rebooting...");
+            ESP_LOGI(TAG, "OTA Succeed, %u bytes at %lld KB/s, Rebooting...",
+                     (unsigned)stats.image_size,
+                     stats.total_us ? (long long)stats.image_size * 1000000 / 1024 / stats.total_us : 0);
             esp_restart();
         } else {
             ESP_LOGE(TAG, "Firmware upgrade failed");
@@ -313,8 +319,18 @@ void app_main(void)
     bool connected = wifi_init_sta();
 
     if (connected) {
+        /* esp32-ota-xxxxxx.local, with the running build in a TXT record */
+        mdns_txt_item_t txt[] = {
+            { "version", BUILD_NUMBER },
+            { "caps", "ota" },
+        };
+        if (discovery_init("esp32-ota", "Lab4 OTA client") == ESP_OK) {
+            /* Port 0: a description of the device, not a service to connect to */
+            discovery_advertise("_device-info", "_tcp", 0, txt, sizeof(txt) / sizeof(txt[0]));
+        }
+
         s_event_start_ota = xEventGroupCreate();
         xTaskCreate(ota_task, "ota_task", 8192, NULL, 5, NULL);
         xTaskCreate(button_task, "button_task", 4096, NULL, 5, NULL);
     }
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "esp_http_client.h"
+
+#include "ota.h"
+
+static const char *TAG = "ota";
+
+/* The whole image goes through this buffer, so RAM use does not grow
+ * with the image size. Only ota_task touches it. */
+static char ota_buf[OTA_BUF_SIZE];
+
+esp_err_t ota_fetch_version(const esp_http_client_config_t *config, int *version)
+{
+    char body[16];
+    int body_len = 0;
+
+    esp_http_client_handle_t client = esp_http_client_init(config);
+    if (client == NULL) {
+        ESP_LOGE(TAG, "Failed to initialise HTTP connection");
+        return ESP_FAIL;
+    }
+
+    esp_err_t err = esp_http_client_open(client, 0);
+    if (err == ESP_OK) {
+        esp_http_client_fetch_headers(client);
+        while (body_len < (int)sizeof(body) - 1) {
+            int n = esp_http_client_read(client, body + body_len, sizeof(body) - 1 - body_len);
+            if (n <= 0) {
+                break;
+            }
+            body_len += n;
+        }
+        body[body_len] = '\0';
+
+        int status = esp_http_client_get_status_code(client);
+        ESP_LOGI(TAG, "HTTPS Status = %d, version = %s", status, body);
+        if (status == 200 && body_len > 0) {
+            *version = atoi(body);
+        } else {
+            err = ESP_FAIL;
+        }
+    } else {
+        ESP_LOGE(TAG, "Failed to open HTTP connection: %s", esp_err_to_name(err));
+    }
+
+    esp_http_client_close(client);
+    esp_http_client_cleanup(client);
+    return err;
+}
+
+esp_err_t ota_perform_update(const esp_http_client_config_t *config, ota_stats_t *stats)
+{
+    ota_stats_t st = {0};
+    esp_ota_handle_t update_handle = 0;
+    int64_t t_start = esp_timer_get_time();
+    int64_t t;
+
+    const esp_partition_t *update_partition = esp_ota_get_next_update_partition(NULL);
+    if (update_partition == NULL) {
+        ESP_LOGE(TAG, "No OTA partition to write to");
+        return ESP_ERR_NOT_FOUND;
+    }
+    ESP_LOGI(TAG, "Writing to partition %s at offset 0x%" PRIx32,
+             update_partition->label, update_partition->address);
+
+    esp_http_client_handle_t client = esp_http_client_init(config);
+    if (client == NULL) {
+        ESP_LOGE(TAG, "Failed to initialise HTTP connection");
+        return ESP_FAIL;
+    }
+
+    t = esp_timer_get_time();
+    esp_err_t err = esp_http_client_open(client, 0);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open HTTP connection: %s", esp_err_to_name(err));
+        esp_http_client_cleanup(client);
+        return err;
+    }
+    int64_t content_length = esp_http_client_fetch_headers(client);
+    int status = esp_http_client_get_status_code(client);
+    st.connect_us = esp_timer_get_time() - t;
+    if (status != 200) {
+        ESP_LOGE(TAG, "Unexpected HTTP status %d", status);
+        err = ESP_FAIL;
+        goto cleanup;
+    }
+
+    /* With a known length only the sectors the image needs get erased,
+     * instead of the whole partition */
+    t = esp_timer_get_time();
+    err = esp_ota_begin(update_partition,
+                        content_length > 0 ? (size_t)content_length : OTA_SIZE_UNKNOWN,
+                        &update_handle);
+    st.erase_us = esp_timer_get_time() - t;
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_ota_begin failed: %s", esp_err_to_name(err));
+        goto cleanup;
+    }
+
+    while (1) {
+        t = esp_timer_get_time();
+        int n = esp_http_client_read(client, ota_buf, sizeof(ota_buf));
+        st.download_us += esp_timer_get_time() - t;
+        if (n < 0) {
+            ESP_LOGE(TAG, "SSL data read error");
+            err = ESP_FAIL;
+            break;
+        }
+        if (n == 0) {
+            if (!esp_http_client_is_complete_data_received(client)) {
+                ESP_LOGE(TAG, "Connection closed before the whole image was received");
+                err = ESP_FAIL;
+            }
+            break;
+        }
+
+        t = esp_timer_get_time();
+        err = esp_ota_write(update_handle, ota_buf, n);
+        st.write_us += esp_timer_get_time() - t;
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "esp_ota_write failed: %s", esp_err_to_name(err));
+            break;
+        }
+        st.image_size += n;
+    }
+
+    if (err != ESP_OK) {
+        esp_ota_abort(update_handle);
+        goto cleanup;
+    }
+
+    t = esp_timer_get_time();
+    err = esp_ota_end(update_handle);
+    if (err == ESP_OK) {
+        err = esp_ota_set_boot_partition(update_partition);
+    }
+    st.finish_us = esp_timer_get_time() - t;
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Image validation / boot switch failed: %s", esp_err_to_name(err));
+    }
+
+cleanup:
+    esp_http_client_close(client);
+    esp_http_client_cleanup(client);
+
+    st.total_us = esp_timer_get_time() - t_start;
+    if (stats) {
+        *stats = st;
+    }
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Wrote %u bytes in %lld ms (erase %lld ms, download %lld ms, write %lld ms)",
+                 (unsigned)st.image_size, (long long)(st.total_us / 1000),
+                 (long long)(st.erase_us / 1000), (long long)(st.download_us / 1000),
+                 (long long)(st.write_us / 1000));
+    }
+    return err;
+}
@@ -0,0 +1,27 @@
+#ifndef _OTA_H_
+#define _OTA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_http_client.h"
+
+/* Size of the single transfer buffer the image is streamed through */
+#define OTA_BUF_SIZE 1024
+
+/* Per-stage timing of one update, all durations in microseconds */
+typedef struct {
+    int64_t connect_us;     /* TCP/TLS connect + response headers */
+    int64_t erase_us;       /* esp_ota_begin(), erases the target sectors */
+    int64_t download_us;    /* time spent in esp_http_client_read() */
+    int64_t write_us;       /* time spent in esp_ota_write() */
+    int64_t finish_us;      /* image validation + boot partition switch */
+    int64_t total_us;
+    size_t image_size;
+} ota_stats_t;
+
+esp_err_t ota_fetch_version(const esp_http_client_config_t *config, int *version);
+esp_err_t ota_perform_update(const esp_http_client_config_t *config, ota_stats_t *stats);
+
+#endif
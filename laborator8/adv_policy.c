@@ -0,0 +1,141 @@
+/***************************************************************************//**
+ * @file
+ * @brief Advertising interval policy: fast bursts stepping back to slow.
+ *
+ * Advertising starts fast so a central that is looking connects quickly,
+ * then backs off in steps (intervals from Apple's accessory guidelines).
+ * Stage changes are timed with a sleeptimer whose callback only raises an
+ * external signal, so the stack calls happen in the event handler and the
+ * device can stay in EM2 between stages.
+ ******************************************************************************/
+#include <stdbool.h>
+#include "sl_sleeptimer.h"
+#include "app_trace.h"
+#include "adv_policy.h"
+
+static const adv_policy_stage_t stages[ADV_POLICY_STAGES] = {
+  { 32,   48,   30000 },   // 20-30 ms for 30 s
+  { 244,  256,  60000 },   // 152.5-160 ms for a minute
+  { 1636, 1700, 0 },       // ~1 s until the next trigger
+};
+
+static uint8_t adv_handle = 0xff;
+static uint8_t adv_connect_mode;
+static uint8_t stage;
+static bool advertising;
+static uint64_t start_tick;     // last adv_policy_start()
+static uint64_t stage_tick;     // last stage change
+static sl_sleeptimer_timer_handle_t stage_timer;
+static adv_policy_stats_t stats;
+
+static uint32_t ms_since(uint64_t tick)
+{
+  uint64_t ms = 0;
+
+  sl_sleeptimer_tick64_to_ms(sl_sleeptimer_get_tick_count64() - tick, &ms);
+  return (uint32_t)ms;
+}
+
+static void stage_timer_cb(sl_sleeptimer_timer_handle_t *handle, void *data)
+{
+  (void)handle;
+  (void)data;
+  app_trace(APP_TRACE_ISR, APP_TRACE_ISR_ADV_STAGE);
+  sl_bt_external_signal(ADV_POLICY_SIGNAL);
+  app_trace(APP_TRACE_END(APP_TRACE_ISR), APP_TRACE_ISR_ADV_STAGE);
+}
+
+// Adds the time spent in the current stage to the counters.
+static void account_stage(void)
+{
+  uint32_t elapsed = ms_since(stage_tick);
+
+  stats.stage_ms[stage] += elapsed;
+  // The stack adds a random 0-10 ms to every interval. In 64 bits since
+  // elapsed * 8 wraps after six days in the last stage.
+  stats.events[stage] += (uint32_t)((uint64_t)elapsed * 8
+                                    / (stages[stage].interval_max * 5 + 40));
+  stage_tick = sl_sleeptimer_get_tick_count64();
+}
+
+static sl_status_t enter_stage(uint8_t next)
+{
+  sl_status_t sc;
+
+  if (advertising) {
+    account_stage();
+    sl_bt_advertiser_stop(adv_handle);
+  }
+  sl_sleeptimer_stop_timer(&stage_timer);
+
+  // Timing only applies when advertising is (re)started
+  sc = sl_bt_advertiser_set_timing(adv_handle, stages[next].interval_min,
+                                   stages[next].interval_max, 0, 0);
+  if (sc == SL_STATUS_OK) {
+    sc = sl_bt_legacy_advertiser_start(adv_handle, adv_connect_mode);
+  }
+  advertising = (sc == SL_STATUS_OK);
+  if (!advertising) {
+    return sc;
+  }
+  stage = next;
+  stage_tick = sl_sleeptimer_get_tick_count64();
+  if (stages[stage].duration_ms != 0) {
+    sl_sleeptimer_start_timer_ms(&stage_timer, stages[stage].duration_ms,
+                                 stage_timer_cb, NULL, 0, 0);
+  }
+  return SL_STATUS_OK;
+}
+
+void adv_policy_init(uint8_t handle, uint8_t connect_mode)
+{
+  adv_handle = handle;
+  adv_connect_mode = connect_mode;
+}
+
+sl_status_t adv_policy_start(adv_policy_reason_t reason)
+{
+  sl_status_t sc = enter_stage(0);
+
+  if (sc == SL_STATUS_OK) {
+    stats.starts[reason]++;
+    start_tick = stage_tick;
+  }
+  return sc;
+}
+
+void adv_policy_on_signal(uint32_t signals)
+{
+  if ((signals & ADV_POLICY_SIGNAL) && advertising
+      && stage + 1 < ADV_POLICY_STAGES) {
+    enter_stage(stage + 1);
+  }
+}
+
+void adv_policy_on_connected(void)
+{
+  uint32_t ms;
+
+  if (!advertising) {
+    return;
+  }
+  account_stage();
+  sl_sleeptimer_stop_timer(&stage_timer);
+  advertising = false;
+
+  ms = ms_since(start_tick);
+  stats.connections[stage]++;
+  stats.connect_ms_last = ms;
+  stats.connect_ms_sum += ms;
+  if (ms > stats.connect_ms_max) {
+    stats.connect_ms_max = ms;
+  }
+}
+
+const adv_policy_stats_t *adv_policy_stats(void)
+{
+  if (advertising) {
+    account_stage();
+  }
+  return &stats;
+}
@@ -27,26 +27,73 @@
  * 3. This notice may not be removed or altered from any source distribution.
  *
  ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
 #include "em_common.h"
 #include "app_assert.h"
 #include "sl_bluetooth.h"
 #include "app.h"
 
 #include "em_cmu.h"
+#include "em_emu.h"
 #include "em_gpio.h"
-#define gattdb_LED_IO 27
-#define gattdb_BUTTON_IO 29
+#include "gatt_db.h"
+#include "app_sched.h"
+#include "app_trace.h"
+#include "conn_table.h"
+#include "adv_policy.h"
+#include "led_io.h"
+#include "button_io.h"
+#include "throughput.h"
+#include "bcast.h"
 
 // The advertising set handle allocated from Bluetooth stack.
 static uint8_t advertising_set_handle = 0xff;
 
-void GPIO_ODD_IRQHandler(void)
+// Die temperature in 0.1 C, sampled by temp_job
+static int16_t temp_last;
+static int16_t temp_min = INT16_MAX;
+static int16_t temp_max = INT16_MIN;
+
+static void temp_sample(void *ctx)
+{
+  (void)ctx;
+  temp_last = (int16_t)(EMU_TemperatureGet() * 10);
+  if (temp_last < temp_min) {
+    temp_min = temp_last;
+  }
+  if (temp_last > temp_max) {
+    temp_max = temp_last;
+  }
+  bcast_set_temperature(temp_last);
+}
+
+static void report(void *ctx)
 {
-  // Stergere flag intrerupere
-  uint32_t interruptMask = GPIO_IntGet();
-  GPIO_IntClear(interruptMask);
+  const led_io_stats_t *led = led_io_stats();
+  uint32_t led_count = led->writes + led->commands;
+
+  (void)ctx;
+  printf("Temperature %d.%d C (min %d.%d, max %d.%d), %u links\n",
+         temp_last / 10, abs(temp_last % 10), temp_min / 10, abs(temp_min % 10),
+         temp_max / 10, abs(temp_max % 10), conn_table_count());
+  app_sched_print();
+  printf("LED_IO: %lu writes, %lu commands, %lu rejected, "
+         "%lu cycles avg, %lu max\n",
+         (unsigned long)led->writes, (unsigned long)led->commands,
+         (unsigned long)led->rejected,
+         (unsigned long)(led_count ? led->cycles_sum / led_count : 0),
+         (unsigned long)led->cycles_max);
+  printf("Trace: %lu records, %lu lost, ring max %lu words\n",
+         (unsigned long)app_trace_stats()->records,
+         (unsigned long)app_trace_stats()->lost,
+         (unsigned long)app_trace_stats()->ring_max);
 }
 
+// Slack lets the two share wakeups: the report waits for the next sample
+static app_sched_job_t temp_job = APP_SCHED_JOB("temp", temp_sample, NULL, 10000, 2000, 0);
+static app_sched_job_t report_job = APP_SCHED_JOB("report", report, NULL, 60000, 10000, 0);
+
 /**************************************************************************//**
  * Application Init.
  *****************************************************************************/
@@ -57,18 +104,19 @@ SL_WEAK void app_init(void)
   // This is called once during start-up.                                    //
   /////////////////////////////////////////////////////////////////////////////
 
+  // First, so boot and everything after it is on the trace
+  app_trace_init();
+
   // Activare ramura clock periferic GPIO
   CMU_ClockEnable(cmuClock_GPIO, true);
+  conn_table_init();
   // Configurare GPIOA 04 ca iesire (LED)
-  GPIO_PinModeSet(gpioPortA, 4, gpioModePushPull, 1);
-  // Configurare GPIOC 07 ca intrare (buton)
-  GPIO_PinModeSet(gpioPortC, 7, gpioModeInputPullFilter, 1);
-  // Configurare intrerupere pentru buton pe ambele fronturi
-  GPIO_ExtIntConfig(gpioPortC, 7, 1, true, true, true);
-  // Activare intrerupere
-  NVIC_ClearPendingIRQ(GPIO_ODD_IRQn);
-  NVIC_EnableIRQ(GPIO_ODD_IRQn);
+  led_io_init();
+  // Configurare GPIOC 07 ca intrare (buton) cu intrerupere pe ambele fronturi
+  button_io_init(gattdb_BUTTON_IO);
 
+  app_sched_add(&temp_job, 0);
+  app_sched_add(&report_job, 60000);
 }
 
 /**************************************************************************//**
@@ -81,6 +129,21 @@ SL_WEAK void app_process_action(void)
   // This is called infinitely.                                              //
   // Do not call blocking functions from here!                               //
   /////////////////////////////////////////////////////////////////////////////
+  app_sched_run();
+  throughput_process();
+}
+
+/**************************************************************************//**
+ * Power manager hooks: stay awake until a due job has run.
+ *****************************************************************************/
+bool app_is_ok_to_sleep(void)
+{
+  return app_sched_is_ok_to_sleep();
+}
+
+sl_power_manager_on_isr_exit_t app_sleep_on_isr_exit(void)
+{
+  return app_sched_sleep_on_isr_exit();
 }
 
 /**************************************************************************//**
@@ -93,32 +156,114 @@ SL_WEAK void app_process_action(void)
 
 void sl_bt_on_event(sl_bt_msg_t *evt)
 {
-  uint8_t recv_val;
-  size_t recv_len;
+  // Taken first so LED_IO timing includes the dispatch of the event
+  uint32_t event_start = led_io_timestamp();
+  uint8_t value[LED_IO_MAX_LEN];
+  size_t len;
+  uint16_t sent_len;
+  uint8_t att_err;
+  uint8_t presses;
   sl_status_t sc;
 
+  app_trace(APP_TRACE_EVENT, APP_TRACE_EVENT_ARG(SL_BT_MSG_ID(evt->header)));
   switch (SL_BT_MSG_ID(evt->header)) {
     // -------------------------------
-    // This event indicates the device has started and the radio is ready.
-    // Do not call any stack command before receiving this boot event!
-    case sl_bt_evt_gatt_server_attribute_value_id:
-      if (gattdb_LED_IO == evt->data.evt_gatt_server_characteristic_status.characteristic) {
-          sl_bt_gatt_server_read_attribute_value(gattdb_LED_IO,
-                                                 0,
-                                                 sizeof(recv_val),
-                                                 &recv_len,
-                                                 &recv_val);
-      if (recv_val)
-      {
-
+    // LED_IO is a user-type characteristic: writes go straight to the pins
+    // from the event payload, reads are answered from the pin states.
+    case sl_bt_evt_gatt_server_user_write_request_id:
+      conn_table_touch(evt->data.evt_gatt_server_user_write_request.connection);
+      if (evt->data.evt_gatt_server_user_write_request.characteristic == gattdb_LED_IO) {
+        bool acked = evt->data.evt_gatt_server_user_write_request.att_opcode
+                     == sl_bt_gatt_write_request;
+        att_err = led_io_write(evt->data.evt_gatt_server_user_write_request.value.data,
+                               evt->data.evt_gatt_server_user_write_request.value.len,
+                               evt->data.evt_gatt_server_user_write_request.offset,
+                               acked, event_start);
+        if (acked) {
+          sl_bt_gatt_server_send_user_write_response(
+            evt->data.evt_gatt_server_user_write_request.connection,
+            gattdb_LED_IO, att_err);
+        }
+      } else if (evt->data.evt_gatt_server_user_write_request.characteristic == gattdb_tp_control) {
+        att_err = throughput_control(evt->data.evt_gatt_server_user_write_request.connection,
+                                     evt->data.evt_gatt_server_user_write_request.value.data,
+                                     evt->data.evt_gatt_server_user_write_request.value.len);
+        sl_bt_gatt_server_send_user_write_response(
+          evt->data.evt_gatt_server_user_write_request.connection,
+          gattdb_tp_control, att_err);
       }
-      else
-      {
+      break;
 
+    case sl_bt_evt_gatt_server_user_read_request_id:
+      conn_table_touch(evt->data.evt_gatt_server_user_read_request.connection);
+      if (evt->data.evt_gatt_server_user_read_request.characteristic == gattdb_LED_IO) {
+        len = led_io_read(value, sizeof(value));
+        sl_bt_gatt_server_send_user_read_response(
+          evt->data.evt_gatt_server_user_read_request.connection,
+          gattdb_LED_IO, 0, len, value, &sent_len);
+      } else if (evt->data.evt_gatt_server_user_read_request.characteristic == gattdb_BUTTON_IO) {
+        uint8_t history[BUTTON_IO_READ_LEN];
+        len = button_io_read(evt->data.evt_gatt_server_user_read_request.offset,
+                             history, sizeof(history));
+        sl_bt_gatt_server_send_user_read_response(
+          evt->data.evt_gatt_server_user_read_request.connection,
+          gattdb_BUTTON_IO, 0, len, history, &sent_len);
+      } else if (evt->data.evt_gatt_server_user_read_request.characteristic == gattdb_tp_control) {
+        uint8_t result[THROUGHPUT_RESULT_LEN];
+        len = throughput_read(evt->data.evt_gatt_server_user_read_request.offset,
+                              result, sizeof(result));
+        sl_bt_gatt_server_send_user_read_response(
+          evt->data.evt_gatt_server_user_read_request.connection,
+          gattdb_tp_control, 0, len, result, &sent_len);
       }
+      break;
+
+    // -------------------------------
+    // Subscriptions are recorded per link; BUTTON_IO also needs the
+    // indication confirmations.
+    case sl_bt_evt_gatt_server_characteristic_status_id:
+      conn_table_on_status(evt->data.evt_gatt_server_characteristic_status.connection,
+                           evt->data.evt_gatt_server_characteristic_status.characteristic,
+                           evt->data.evt_gatt_server_characteristic_status.status_flags,
+                           evt->data.evt_gatt_server_characteristic_status.client_config_flags);
+      if (evt->data.evt_gatt_server_characteristic_status.characteristic == gattdb_BUTTON_IO) {
+        button_io_on_status(evt->data.evt_gatt_server_characteristic_status.connection,
+                            evt->data.evt_gatt_server_characteristic_status.status_flags,
+                            evt->data.evt_gatt_server_characteristic_status.client_config_flags);
+      } else if (evt->data.evt_gatt_server_characteristic_status.characteristic == gattdb_tp_data) {
+        throughput_on_status(evt->data.evt_gatt_server_characteristic_status.connection,
+                             evt->data.evt_gatt_server_characteristic_status.status_flags,
+                             evt->data.evt_gatt_server_characteristic_status.client_config_flags);
       }
       break;
 
+    // -------------------------------
+    // Link updates go to the connection table; button pacing reads the
+    // interval from there.
+    case sl_bt_evt_connection_parameters_id:
+      conn_table_on_parameters(evt->data.evt_connection_parameters.connection,
+                               evt->data.evt_connection_parameters.interval,
+                               evt->data.evt_connection_parameters.security_mode);
+      break;
+
+    case sl_bt_evt_gatt_mtu_exchanged_id:
+      conn_table_on_mtu(evt->data.evt_gatt_mtu_exchanged.connection,
+                        evt->data.evt_gatt_mtu_exchanged.mtu);
+      break;
+
+    case sl_bt_evt_connection_phy_status_id:
+      conn_table_on_phy(evt->data.evt_connection_phy_status.connection,
+                        evt->data.evt_connection_phy_status.phy);
+      break;
+
+    case sl_bt_evt_connection_data_length_id:
+      conn_table_on_data_length(evt->data.evt_connection_data_length.connection,
+                                evt->data.evt_connection_data_length.tx_data_len);
+      break;
+
+    // -------------------------------
+    // This event indicates the device has started and the radio is ready.
+    // Do not call any stack command before receiving this boot event!
     case sl_bt_evt_system_boot_id:
       // Create an advertising set.
       sc = sl_bt_advertiser_create_set(&advertising_set_handle);
@@ -129,39 +274,73 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
                                                  sl_bt_advertiser_general_discoverable);
       app_assert_status(sc);
 
-      // Set advertising interval to 100ms.
-      sc = sl_bt_advertiser_set_timing(
-        advertising_set_handle,
-        160, // min. adv. interval (milliseconds * 1.6)
-        160, // max. adv. interval (milliseconds * 1.6)
-        0,   // adv. duration
-        0);  // max. num. adv. events
+      throughput_init(gattdb_tp_data);
+
+      // Readings for any number of scanners, on a set of its own
+      sc = bcast_start();
       app_assert_status(sc);
-      // Start advertising and enable connections.
-      sc = sl_bt_legacy_advertiser_start(advertising_set_handle,
-                                         sl_bt_advertiser_connectable_scannable);
+
+      // Start advertising fast and let the policy step the interval back.
+      adv_policy_init(advertising_set_handle,
+                      sl_bt_advertiser_connectable_scannable);
+      sc = adv_policy_start(ADV_POLICY_BOOT);
       app_assert_status(sc);
       break;
 
     // -------------------------------
     // This event indicates that a new connection was opened.
     case sl_bt_evt_connection_opened_id:
+      adv_policy_on_connected();
+      conn_table_on_opened(evt->data.evt_connection_opened.connection,
+                           &evt->data.evt_connection_opened.address,
+                           evt->data.evt_connection_opened.address_type,
+                           evt->data.evt_connection_opened.bonding);
+      printf("Connected after %lu ms, %u of %u links\n",
+             (unsigned long)adv_policy_stats()->connect_ms_last,
+             conn_table_count(), CONN_TABLE_SIZE);
+      bcast_set_links(conn_table_count());
+
+      // The stack stops advertising on a connection; keep accepting
+      // centrals while there is room for them.
+      if (!conn_table_full()) {
+        sc = adv_policy_start(ADV_POLICY_CONNECTED);
+        app_assert_status(sc);
+      }
       break;
 
     // -------------------------------
     // This event indicates that a connection was closed.
     case sl_bt_evt_connection_closed_id:
+      button_io_on_closed(evt->data.evt_connection_closed.connection);
+      throughput_on_closed(evt->data.evt_connection_closed.connection);
+      conn_table_on_closed(evt->data.evt_connection_closed.connection);
+      bcast_set_links(conn_table_count());
+
       // Generate data for advertising
       sc = sl_bt_legacy_advertiser_generate_data(advertising_set_handle,
                                                  sl_bt_advertiser_general_discoverable);
       app_assert_status(sc);
 
-      // Restart advertising after client has disconnected.
-      sc = sl_bt_legacy_advertiser_start(advertising_set_handle,
-                                         sl_bt_advertiser_connectable_scannable);
+      // Restart advertising after client has disconnected. If other links
+      // kept it running this just goes back to the fast stage.
+      sc = adv_policy_start(ADV_POLICY_DISCONNECT);
       app_assert_status(sc);
       break;
 
+    // -------------------------------
+    // Advertising stage timeouts and button edges.
+    case sl_bt_evt_system_external_signal_id:
+      adv_policy_on_signal(evt->data.evt_system_external_signal.extsignals);
+      presses = button_io_process(evt->data.evt_system_external_signal.extsignals);
+      if (evt->data.evt_system_external_signal.extsignals & BUTTON_IO_SIGNAL) {
+        bcast_set_button(button_io_state(), presses);
+      }
+      if (presses > 0 && !conn_table_full()) {
+        sc = adv_policy_start(ADV_POLICY_BUTTON);
+        app_assert_status(sc);
+      }
+      break;
+
     ///////////////////////////////////////////////////////////////////////////
     // Add additional event handlers here as your application requires!      //
     ///////////////////////////////////////////////////////////////////////////
@@ -171,4 +350,5 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
     default:
       break;
   }
+  app_trace(APP_TRACE_END(APP_TRACE_EVENT), APP_TRACE_EVENT_ARG(SL_BT_MSG_ID(evt->header)));
 }
@@ -0,0 +1,256 @@
+/***************************************************************************//**
+ * @file
+ * @brief Cooperative job scheduler for app_process_action(), sleeptimer driven.
+ *
+ * The timer callback only records that a deadline passed (and takes the
+ * EM1 requirement a job asked for); the power manager hooks then keep the
+ * core awake until app_sched_run() has served it. Run times come from the
+ * DWT cycle counter.
+ ******************************************************************************/
+#include <stdio.h>
+#include "em_device.h"
+#include "sl_core.h"
+#include "sl_sleeptimer.h"
+#include "app_sched.h"
+#include "app_trace.h"
+
+static app_sched_job_t *head;           // earliest deadline first
+static sl_sleeptimer_timer_handle_t timer;
+static volatile bool fired;
+static bool em1_held;
+static bool armed_em1;                  // a job due at the armed wakeup needs EM1
+static bool dirty;                      // the list changed since the last arm()
+static uint32_t wakeups;
+
+static uint64_t now_tick(void)
+{
+  return sl_sleeptimer_get_tick_count64();
+}
+
+static uint64_t deadline(const app_sched_job_t *job)
+{
+  return job->due + job->slack_ticks;
+}
+
+static void insert(app_sched_job_t *job)
+{
+  app_sched_job_t **link = &head;
+
+  while (*link != NULL && deadline(*link) <= deadline(job)) {
+    link = &(*link)->next;
+  }
+  job->next = *link;
+  *link = job;
+  job->queued = true;
+  dirty = true;
+}
+
+static void unlink_job(app_sched_job_t *job)
+{
+  app_sched_job_t **link = &head;
+
+  while (*link != NULL && *link != job) {
+    link = &(*link)->next;
+  }
+  if (*link == job) {
+    *link = job->next;
+  }
+  job->next = NULL;
+  job->queued = false;
+  dirty = true;
+}
+
+// Taken from the timer interrupt as well, hence the critical sections.
+static void hold_em1(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if (!em1_held) {
+    sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
+    em1_held = true;
+  }
+  CORE_EXIT_ATOMIC();
+}
+
+static void release_em1(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if (em1_held) {
+    sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
+    em1_held = false;
+  }
+  CORE_EXIT_ATOMIC();
+}
+
+static void timer_cb(sl_sleeptimer_timer_handle_t *handle, void *data)
+{
+  (void)handle;
+  (void)data;
+  app_trace(APP_TRACE_ISR, APP_TRACE_ISR_SCHED);
+  fired = true;
+  if (armed_em1) {
+    hold_em1();
+  }
+  app_trace(APP_TRACE_END(APP_TRACE_ISR), APP_TRACE_ISR_SCHED);
+}
+
+// One timer for the whole list, set to the earliest deadline.
+static void arm(void)
+{
+  uint64_t now = now_tick();
+  uint64_t when;
+  uint64_t ticks;
+
+  dirty = false;
+  sl_sleeptimer_stop_timer(&timer);
+  if (head == NULL) {
+    return;
+  }
+  when = deadline(head);
+  armed_em1 = false;
+  for (app_sched_job_t *job = head; job != NULL; job = job->next) {
+    if (job->due <= when && (job->flags & APP_SCHED_EM1)) {
+      armed_em1 = true;
+    }
+  }
+  ticks = (when > now) ? when - now : 1;
+  if (ticks > UINT32_MAX) {
+    ticks = UINT32_MAX;
+  }
+  sl_sleeptimer_start_timer(&timer, (uint32_t)ticks, timer_cb, NULL, 0, 0);
+}
+
+static void run(app_sched_job_t *job, uint64_t now, bool own_wakeup)
+{
+  uint64_t dl = deadline(job);
+  uint64_t late_ms = 0;
+  uint32_t start;
+  uint32_t cycles;
+
+  if (now > dl) {
+    sl_sleeptimer_tick64_to_ms(now - dl, &late_ms);
+    if (late_ms > job->stats.late_ms_max) {
+      job->stats.late_ms_max = (uint32_t)late_ms;
+    }
+  }
+
+  // Rescheduled before the call so the job may remove or re-add itself
+  unlink_job(job);
+  if (job->period_ticks != 0) {
+    job->due += job->period_ticks;
+    if (job->due <= now) {
+      // Missed periods are skipped, not caught up
+      job->due = now + job->period_ticks;
+    }
+    insert(job);
+  }
+
+  if (job->flags & APP_SCHED_EM1) {
+    hold_em1();
+  }
+  start = DWT->CYCCNT;
+  job->fn(job->ctx);
+  cycles = DWT->CYCCNT - start;
+
+  job->stats.runs++;
+  job->stats.wakeups += own_wakeup;
+  job->stats.cycles_last = cycles;
+  job->stats.cycles_sum += cycles;
+  if (cycles > job->stats.cycles_max) {
+    job->stats.cycles_max = cycles;
+  }
+}
+
+void app_sched_add(app_sched_job_t *job, uint32_t delay_ms)
+{
+  uint32_t delay_ticks = 0;
+
+  if (job->queued) {
+    unlink_job(job);
+  }
+  sl_sleeptimer_ms32_to_tick(job->period_ms, &job->period_ticks);
+  sl_sleeptimer_ms32_to_tick(job->slack_ms, &job->slack_ticks);
+  sl_sleeptimer_ms32_to_tick(delay_ms, &delay_ticks);
+  job->due = now_tick() + delay_ticks;
+  insert(job);
+
+  // The cycle counter may not be running yet
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  arm();
+}
+
+void app_sched_remove(app_sched_job_t *job)
+{
+  if (job->queued) {
+    unlink_job(job);
+  }
+}
+
+void app_sched_run(void)
+{
+  // Whichever job heads the list is the one the timer woke up for
+  app_sched_job_t *woken_for = NULL;
+  uint64_t now;
+
+  if (fired) {
+    fired = false;
+    wakeups++;
+    woken_for = head;
+  }
+  now = now_tick();
+  for (;;) {
+    app_sched_job_t *job = head;
+
+    // Earliest deadline first among the jobs already due
+    while (job != NULL && job->due > now) {
+      job = job->next;
+    }
+    if (job == NULL) {
+      break;
+    }
+    run(job, now, job == woken_for);
+    if (job == woken_for) {
+      woken_for = NULL;
+    }
+  }
+  release_em1();
+  if (dirty) {
+    arm();
+  }
+}
+
+bool app_sched_is_ok_to_sleep(void)
+{
+  return !fired;
+}
+
+sl_power_manager_on_isr_exit_t app_sched_sleep_on_isr_exit(void)
+{
+  return fired ? SL_POWER_MANAGER_WAKEUP : SL_POWER_MANAGER_IGNORE;
+}
+
+uint32_t app_sched_wakeups(void)
+{
+  return wakeups;
+}
+
+void app_sched_print(void)
+{
+  uint32_t cycles_per_us = SystemCoreClock / 1000000;
+
+  printf("Scheduler: %lu timer wakeups\n", (unsigned long)wakeups);
+  for (app_sched_job_t *job = head; job != NULL; job = job->next) {
+    uint32_t avg = job->stats.runs
+                   ? (uint32_t)(job->stats.cycles_sum / job->stats.runs) : 0;
+    printf("  %-8s %6lu runs %6lu wakeups, %lu us avg %lu us max, %lu ms late max\n",
+           job->name, (unsigned long)job->stats.runs,
+           (unsigned long)job->stats.wakeups,
+           (unsigned long)(avg / cycles_per_us),
+           (unsigned long)(job->stats.cycles_max / cycles_per_us),
+           (unsigned long)job->stats.late_ms_max);
+  }
+}
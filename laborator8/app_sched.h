@@ -0,0 +1,73 @@
+/***************************************************************************//**
+ * @file
+ * @brief Cooperative job scheduler for app_process_action(), sleeptimer driven.
+ *
+ * Jobs run from the main loop, never from an interrupt. Each job has a due
+ * time and a slack; the list is kept in deadline (due + slack) order and a
+ * single sleeptimer is armed for the earliest deadline, so jobs that fall
+ * due close together share one wakeup instead of each waking the core from
+ * EM2. A job whose due time has passed also runs on any other wakeup.
+ ******************************************************************************/
+
+#ifndef APP_SCHED_H
+#define APP_SCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sl_power_manager.h"
+
+// Keep EM1 from the wakeup until the job returns (HF clocked peripherals)
+#define APP_SCHED_EM1     0x01
+
+typedef void (*app_sched_fn_t)(void *ctx);
+
+typedef struct {
+  uint32_t runs;
+  uint32_t wakeups;           ///< runs that needed a timer wakeup of their own
+  uint32_t cycles_last;
+  uint32_t cycles_max;
+  uint64_t cycles_sum;
+  uint32_t late_ms_max;       ///< run after the deadline
+} app_sched_stats_t;
+
+typedef struct app_sched_job {
+  const char *name;
+  app_sched_fn_t fn;
+  void *ctx;
+  uint32_t period_ms;         ///< 0: run once
+  uint32_t slack_ms;          ///< how late the job may run
+  uint8_t flags;              ///< APP_SCHED_*
+  // Owned by the scheduler
+  bool queued;
+  uint64_t due;
+  uint32_t period_ticks;
+  uint32_t slack_ticks;
+  struct app_sched_job *next;
+  app_sched_stats_t stats;
+} app_sched_job_t;
+
+#define APP_SCHED_JOB(name_, fn_, ctx_, period_ms_, slack_ms_, flags_) \
+  { .name = (name_), .fn = (fn_), .ctx = (ctx_), .period_ms = (period_ms_), \
+    .slack_ms = (slack_ms_), .flags = (flags_) }
+
+/// Queues a job to run first after delay_ms, then every period_ms.
+void app_sched_add(app_sched_job_t *job, uint32_t delay_ms);
+
+void app_sched_remove(app_sched_job_t *job);
+
+/// Runs the jobs that are due. Call from app_process_action().
+void app_sched_run(void);
+
+/// For app_is_ok_to_sleep(): false while a timer wakeup is unserved.
+bool app_sched_is_ok_to_sleep(void);
+
+/// For app_sleep_on_isr_exit(): wakes the main loop when a job is due.
+sl_power_manager_on_isr_exit_t app_sched_sleep_on_isr_exit(void);
+
+/// Timer wakeups since boot.
+uint32_t app_sched_wakeups(void);
+
+/// Prints one line per job.
+void app_sched_print(void);
+
+#endif // APP_SCHED_H
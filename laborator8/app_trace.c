@@ -0,0 +1,122 @@
+/***************************************************************************//**
+ * @file
+ * @brief Cycle stamped event trace over SWO.
+ *
+ * Producers (main loop and interrupts) add whole records under a critical
+ * section, taking the cycle count inside it so the ring stays in time
+ * order; app_trace_flush() is the only consumer. When the ring is full
+ * records are dropped and counted, and the count goes out as a LOST record
+ * as soon as there is room again.
+ ******************************************************************************/
+#include <stdbool.h>
+#include "em_device.h"
+#include "sl_core.h"
+#include "sl_debug_swo.h"
+#include "sl_power_manager.h"
+#include "sl_sleeptimer.h"
+#include "app_trace.h"
+
+#define RING_MASK     (APP_TRACE_RING_WORDS - 1)
+
+static uint32_t ring[APP_TRACE_RING_WORDS];
+static volatile uint32_t head;
+static volatile uint32_t tail;
+static uint32_t lost;                   // since the last LOST record
+static bool port_enabled;
+static app_trace_stats_t stats;
+
+static void on_em_transition(sl_power_manager_em_t from, sl_power_manager_em_t to);
+
+static sl_power_manager_em_transition_event_handle_t em_handle;
+static const sl_power_manager_em_transition_event_info_t em_info = {
+  .event_mask = SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM0
+                | SL_POWER_MANAGER_EVENT_TRANSITION_LEAVING_EM0,
+  .on_event = on_em_transition,
+};
+
+// Caller holds the critical section and has checked for room.
+static void put(uint32_t word, uint32_t second)
+{
+  ring[head & RING_MASK] = word;
+  ring[(head + 1) & RING_MASK] = second;
+  head += 2;
+}
+
+static void record(uint32_t word, bool cycles, uint32_t second)
+{
+  uint32_t used;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  used = head - tail;
+  if (lost != 0 && used <= APP_TRACE_RING_WORDS - 4) {
+    put(APP_TRACE_WORD(APP_TRACE_LOST, lost), DWT->CYCCNT);
+    lost = 0;
+    used += 2;
+  }
+  if (used <= APP_TRACE_RING_WORDS - 2) {
+    put(word, cycles ? DWT->CYCCNT : second);
+    stats.records++;
+    if (used + 2 > stats.ring_max) {
+      stats.ring_max = used + 2;
+    }
+  } else {
+    lost++;
+    stats.lost++;
+  }
+  CORE_EXIT_ATOMIC();
+}
+
+// Called by the power manager with interrupts disabled.
+static void on_em_transition(sl_power_manager_em_t from, sl_power_manager_em_t to)
+{
+  uint32_t tick = sl_sleeptimer_get_tick_count();
+
+  if (from == SL_POWER_MANAGER_EM0) {
+    record(APP_TRACE_WORD(APP_TRACE_SLEEP, APP_TRACE_SLEEP_ARG(to, tick)), true, 0);
+  } else if (to == SL_POWER_MANAGER_EM0) {
+    record(APP_TRACE_WORD(APP_TRACE_WAKE, APP_TRACE_SLEEP_ARG(0, tick)), true, 0);
+  }
+}
+
+void app_trace_init(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  port_enabled = sl_debug_swo_enable_itm(APP_TRACE_ITM_PORT) == SL_STATUS_OK;
+  sl_power_manager_subscribe_em_transition_event(&em_handle, &em_info);
+
+  // Lets the decoder turn cycles and ticks into time
+  record(APP_TRACE_WORD(APP_TRACE_INFO, sl_sleeptimer_get_timer_frequency()),
+         false, SystemCoreClock);
+}
+
+void app_trace(uint8_t kind, uint32_t arg)
+{
+  record(APP_TRACE_WORD(kind, arg), true, 0);
+}
+
+void app_trace_flush(void)
+{
+  uint32_t end;
+
+  if (head == tail) {
+    return;
+  }
+  app_trace(APP_TRACE_FLUSH, 0);
+  // Records added from here on wait for the next flush, the end of this
+  // one among them
+  end = head;
+  while (tail != end) {
+    if (port_enabled) {
+      sl_debug_swo_write_u32(APP_TRACE_ITM_PORT, ring[tail & RING_MASK]);
+    }
+    tail++;
+  }
+  app_trace(APP_TRACE_END(APP_TRACE_FLUSH), 0);
+}
+
+const app_trace_stats_t *app_trace_stats(void)
+{
+  return &stats;
+}
@@ -0,0 +1,44 @@
+/***************************************************************************//**
+ * @file
+ * @brief Cycle stamped event trace over SWO.
+ *
+ * Trace points around sl_bt_step(), sl_bt_on_event(), app_process_action(),
+ * the application's interrupt handlers and every sleep. A trace point only
+ * stamps a record with DWT->CYCCNT into a RAM ring, a few dozen cycles;
+ * main.c drains the ring to the ITM right before the core sleeps, so
+ * the SWO line speed never shows up inside a traced handler. The drain is
+ * traced too (APP_TRACE_FLUSH). Record layout in app_trace_format.h,
+ * decoder in host/swo_trace.c.
+ *
+ * At the default 875 kHz SWO clock one record takes about 115 us on the
+ * wire; raise SL_DEBUG_SWO_FREQ if the probe keeps up and the flushes get
+ * long, or look at the lost count.
+ ******************************************************************************/
+
+#ifndef APP_TRACE_H
+#define APP_TRACE_H
+
+#include <stdint.h>
+#include "app_trace_format.h"
+
+#define APP_TRACE_RING_WORDS    512     // power of two, two words per record
+
+typedef struct {
+  uint32_t records;
+  uint32_t lost;              ///< the ring was full
+  uint32_t ring_max;          ///< most words waiting for a flush
+} app_trace_stats_t;
+
+/// Starts the cycle counter, enables the stimulus port and hooks the
+/// power manager's sleep transitions. Call first in app_init().
+void app_trace_init(void);
+
+/// Records kind (APP_TRACE_*) with arg. Safe from interrupts.
+void app_trace(uint8_t kind, uint32_t arg);
+
+/// Writes the queued records to the ITM. Main loop only, before sleeping.
+void app_trace_flush(void);
+
+const app_trace_stats_t *app_trace_stats(void);
+
+#endif // APP_TRACE_H
@@ -0,0 +1,53 @@
+/***************************************************************************//**
+ * @file
+ * @brief SWO event trace: record layout on the ITM stimulus port.
+ *
+ * Shared by the firmware (app_trace.c) and the decoder (host/swo_trace.c);
+ * keep the two in step.
+ *
+ * Every record is two 32-bit writes to stimulus port APP_TRACE_ITM_PORT:
+ *   kind:8 | arg:24, then DWT->CYCCNT when the record was taken
+ * Spans have an even kind for the start and kind + 1 for the end. The
+ * cycle counter stops while the core sleeps, so SLEEP and WAKE carry the
+ * sleeptimer tick as well; the decoder times sleeps from those.
+ ******************************************************************************/
+
+#ifndef APP_TRACE_FORMAT_H
+#define APP_TRACE_FORMAT_H
+
+#define APP_TRACE_ITM_PORT      8
+
+#define APP_TRACE_KIND(word)    ((word) >> 24)
+#define APP_TRACE_ARG(word)     ((word) & 0xffffff)
+#define APP_TRACE_WORD(kind, arg) (((uint32_t)(kind) << 24) | ((arg) & 0xffffff))
+
+// Single records
+#define APP_TRACE_INFO          0x01    // arg: sleeptimer Hz, second word: SystemCoreClock
+#define APP_TRACE_LOST          0x02    // arg: records dropped on a full ring
+#define APP_TRACE_SLEEP         0x03    // arg: EM:2 | sleeptimer tick:22
+#define APP_TRACE_WAKE          0x04    // arg: sleeptimer tick:22
+
+// Spans, end = start + 1
+#define APP_TRACE_STEP          0x10    // sl_system_process_action(): sl_bt_step()
+#define APP_TRACE_APP           0x12    // app_process_action()
+#define APP_TRACE_EVENT         0x14    // sl_bt_on_event(), arg: event ID >> 8
+#define APP_TRACE_ISR           0x16    // arg: APP_TRACE_ISR_*
+#define APP_TRACE_FLUSH         0x18    // draining the ring to the ITM
+
+#define APP_TRACE_END(kind)     ((kind) | 1)
+
+#define APP_TRACE_TICK_BITS     22      // 128 s at 32768 Hz
+#define APP_TRACE_SLEEP_ARG(em, tick) \
+  (((uint32_t)(em) << APP_TRACE_TICK_BITS) | ((tick) & ((1UL << APP_TRACE_TICK_BITS) - 1)))
+
+// Event IDs are 0xMMCC00A0: message, class, then the constant event type
+#define APP_TRACE_EVENT_ARG(id) ((id) >> 8)
+#define APP_TRACE_EVENT_ID(arg) (((uint32_t)(arg) << 8) | 0xa0)
+
+// Interrupt handlers and sleeptimer callbacks of the application
+#define APP_TRACE_ISR_BUTTON        1   // GPIO_ODD_IRQHandler
+#define APP_TRACE_ISR_BUTTON_RETRY  2   // button_io retry timer
+#define APP_TRACE_ISR_ADV_STAGE     3   // adv_policy stage timer
+#define APP_TRACE_ISR_SCHED         4   // app_sched wakeup timer
+
+#endif // APP_TRACE_FORMAT_H
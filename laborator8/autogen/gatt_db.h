@@ -22,8 +22,10 @@ extern const sli_bt_gattdb_t gattdb;
 #define gattdb_system_id                      24
 #define gattdb_LED_IO                         27
 #define gattdb_BUTTON_IO                      29
-#define gattdb_ota                            31
-#define gattdb_ota_control                    33
+#define gattdb_tp_data                        33
+#define gattdb_tp_control                     36
+#define gattdb_ota                            37
+#define gattdb_ota_control                    39
 
 
 #endif // __GATT_DB_H
@@ -0,0 +1,152 @@
+/***************************************************************************//**
+ * @file
+ * @brief Connectionless sensor broadcast over extended + periodic advertising.
+ *
+ * Payload updates are double buffered: the setters only touch the staged
+ * readings, and once per periodic interval a scheduler job encodes them
+ * into the buffer the stack does not hold and hands that one over. If the
+ * stack refuses it the previous payload stays on air untouched and the
+ * update is retried on the next interval.
+ ******************************************************************************/
+#include "app_sched.h"
+#include "bcast.h"
+
+#define AD_TYPE_MANUFACTURER    0xff
+#define AD_LEN(value_len)       (2 + (value_len))
+#define COMMIT_PERIOD_MS        (BCAST_PERIODIC_INTERVAL * 5 / 4)
+
+static uint8_t bcast_handle = 0xff;
+static bcast_readings_t staged;
+static bool dirty;
+static uint8_t buffers[2][AD_LEN(BCAST_OFF_BODY + BCAST_READINGS_LEN)];
+static uint8_t front;                   // the buffer the stack last took
+static bcast_stats_t stats;
+
+static void commit(void *ctx);
+static app_sched_job_t commit_job =
+  APP_SCHED_JOB("bcast", commit, NULL, COMMIT_PERIOD_MS, 250, 0);
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+// Writes the AD header and returns a pointer to the value.
+static uint8_t *put_header(uint8_t *ad, uint8_t kind, uint8_t body_len)
+{
+  uint8_t *value = &ad[2];
+
+  ad[0] = 1 + BCAST_OFF_BODY + body_len;
+  ad[1] = AD_TYPE_MANUFACTURER;
+  put_u16(&value[BCAST_OFF_COMPANY], BCAST_COMPANY_ID);
+  value[BCAST_OFF_MAGIC] = BCAST_MAGIC;
+  value[BCAST_OFF_VERSION_KIND] = (BCAST_VERSION << 4) | kind;
+  return value;
+}
+
+static void commit(void *ctx)
+{
+  uint8_t back = front ^ 1;
+  uint8_t *value;
+  sl_status_t sc;
+
+  (void)ctx;
+  if (!dirty) {
+    stats.unchanged++;
+    return;
+  }
+  value = put_header(buffers[back], BCAST_KIND_READINGS, BCAST_READINGS_LEN);
+  put_u16(&value[BCAST_OFF_SEQ], staged.seq + 1);
+  put_u16(&value[BCAST_OFF_TEMP], (uint16_t)staged.temp_c10);
+  value[BCAST_OFF_BUTTON] = staged.button;
+  put_u16(&value[BCAST_OFF_PRESSES], staged.presses);
+  value[BCAST_OFF_LINKS] = staged.links;
+
+  sc = sl_bt_periodic_advertiser_set_data(bcast_handle, sizeof(buffers[back]),
+                                          buffers[back]);
+  if (sc != SL_STATUS_OK) {
+    stats.busy++;
+    return;
+  }
+  front = back;
+  staged.seq++;
+  dirty = false;
+  stats.commits++;
+}
+
+sl_status_t bcast_start(void)
+{
+  uint8_t announce[AD_LEN(BCAST_OFF_BODY)];
+  sl_status_t sc;
+
+  sc = sl_bt_advertiser_create_set(&bcast_handle);
+  if (sc != SL_STATUS_OK) {
+    return sc;
+  }
+  sc = sl_bt_advertiser_set_timing(bcast_handle, BCAST_ADV_INTERVAL,
+                                   BCAST_ADV_INTERVAL, 0, 0);
+  if (sc != SL_STATUS_OK) {
+    return sc;
+  }
+  // Secondary channel and train on 2M: half the air time of 1M
+  sc = sl_bt_extended_advertiser_set_phy(bcast_handle, sl_bt_gap_phy_1m, sl_bt_gap_phy_2m);
+  if (sc != SL_STATUS_OK) {
+    return sc;
+  }
+  put_header(announce, BCAST_KIND_ANNOUNCE, 0);
+  sc = sl_bt_extended_advertiser_set_data(bcast_handle, sizeof(announce), announce);
+  if (sc != SL_STATUS_OK) {
+    return sc;
+  }
+  sc = sl_bt_periodic_advertiser_start(bcast_handle, BCAST_PERIODIC_INTERVAL,
+                                       BCAST_PERIODIC_INTERVAL, 0);
+  if (sc != SL_STATUS_OK) {
+    return sc;
+  }
+  dirty = true;
+  commit(NULL);
+  sc = sl_bt_extended_advertiser_start(bcast_handle,
+                                       sl_bt_extended_advertiser_non_connectable, 0);
+  if (sc == SL_STATUS_OK) {
+    app_sched_add(&commit_job, COMMIT_PERIOD_MS);
+  }
+  return sc;
+}
+
+void bcast_set_temperature(int16_t temp_c10)
+{
+  if (temp_c10 != staged.temp_c10) {
+    staged.temp_c10 = temp_c10;
+    dirty = true;
+  }
+}
+
+void bcast_set_button(uint8_t pressed, uint8_t new_presses)
+{
+  uint8_t button = pressed ? BCAST_BUTTON_PRESSED : 0;
+
+  if (button != staged.button || new_presses != 0) {
+    staged.button = button;
+    staged.presses += new_presses;
+    dirty = true;
+  }
+}
+
+void bcast_set_links(uint8_t links)
+{
+  if (links != staged.links) {
+    staged.links = links;
+    dirty = true;
+  }
+}
+
+const bcast_readings_t *bcast_readings(void)
+{
+  return &staged;
+}
+
+const bcast_stats_t *bcast_stats(void)
+{
+  return &stats;
+}
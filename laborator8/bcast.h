@@ -0,0 +1,39 @@
+/***************************************************************************//**
+ * @file
+ * @brief Connectionless sensor broadcast over extended + periodic advertising.
+ *
+ * A second, non-connectable advertising set announces the node with an
+ * extended advertisement and carries the readings in a periodic train
+ * (payload in bcast_format.h). Any number of scanners can sync to the
+ * train; the node's radio time does not depend on how many do.
+ ******************************************************************************/
+
+#ifndef BCAST_H
+#define BCAST_H
+
+#include <stdint.h>
+#include "sl_bt_api.h"
+#include "bcast_format.h"
+
+#define BCAST_ADV_INTERVAL        1600    // 1 s, 0.625 ms units
+#define BCAST_PERIODIC_INTERVAL   800     // 1 s, 1.25 ms units
+
+typedef struct {
+  uint32_t commits;           ///< payloads handed to the stack
+  uint32_t unchanged;         ///< intervals with nothing new
+  uint32_t busy;              ///< set_data refused; retried next interval
+} bcast_stats_t;
+
+/// Creates the set and starts both trains. Call on sl_bt_evt_system_boot_id.
+sl_status_t bcast_start(void);
+
+// Setters only stage the value; it goes on air at the next interval.
+void bcast_set_temperature(int16_t temp_c10);
+void bcast_set_button(uint8_t pressed, uint8_t new_presses);
+void bcast_set_links(uint8_t links);
+
+const bcast_readings_t *bcast_readings(void);
+
+const bcast_stats_t *bcast_stats(void);
+
+#endif // BCAST_H
@@ -0,0 +1,55 @@
+/***************************************************************************//**
+ * @file
+ * @brief Connectionless sensor broadcast: on-air payload layout.
+ *
+ * Shared by the broadcaster (laborator8) and the listener (lab7); keep the
+ * two copies identical.
+ *
+ * Both payloads are a single manufacturer specific AD structure:
+ *   len:1 | 0xff | company:2 | magic:1 | version:4 kind:4 | body
+ * The extended advertisement (kind ANNOUNCE) has no body; it lets a scanner
+ * recognise the node and sync to its periodic train, which carries the
+ * readings (kind READINGS), little endian:
+ *   seq:2 | temp_c10:2 | button:1 | presses:2 | links:1
+ * seq changes whenever the readings do, so a listener can tell repeats from
+ * updates and count the ones it missed. Fields are only ever appended: a
+ * longer body with a known version is fine, an unknown version is ignored.
+ ******************************************************************************/
+
+#ifndef BCAST_FORMAT_H
+#define BCAST_FORMAT_H
+
+#include <stdint.h>
+
+#define BCAST_COMPANY_ID        0x02ff    // Silicon Laboratories
+#define BCAST_MAGIC             0xbc
+#define BCAST_VERSION           1
+
+#define BCAST_KIND_ANNOUNCE     0
+#define BCAST_KIND_READINGS     1
+
+// Offsets into the AD value, after the type byte
+#define BCAST_OFF_COMPANY       0
+#define BCAST_OFF_MAGIC         2
+#define BCAST_OFF_VERSION_KIND  3
+#define BCAST_OFF_BODY          4
+
+#define BCAST_OFF_SEQ           (BCAST_OFF_BODY + 0)
+#define BCAST_OFF_TEMP          (BCAST_OFF_BODY + 2)
+#define BCAST_OFF_BUTTON        (BCAST_OFF_BODY + 4)
+#define BCAST_OFF_PRESSES       (BCAST_OFF_BODY + 5)
+#define BCAST_OFF_LINKS         (BCAST_OFF_BODY + 7)
+#define BCAST_READINGS_LEN      8
+
+// button byte
+#define BCAST_BUTTON_PRESSED    0x01
+
+typedef struct {
+  uint16_t seq;
+  int16_t temp_c10;           ///< 0.1 C
+  uint8_t button;             ///< BCAST_BUTTON_*
+  uint16_t presses;           ///< since boot, wrapping
+  uint8_t links;              ///< centrals connected
+} bcast_readings_t;
+
+#endif // BCAST_FORMAT_H
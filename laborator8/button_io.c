@@ -0,0 +1,297 @@
+/***************************************************************************//**
+ * @file
+ * @brief BUTTON_IO characteristic: button edges notified to subscribers.
+ *
+ * Edges go through a single-producer queue from the interrupt to the event
+ * handler. Each subscriber gets at most one update per connection interval;
+ * edges in between are folded into the next one, so a burst of presses
+ * costs one packet instead of filling the stack's buffers. Indications
+ * wait for the confirmation of the previous one.
+ ******************************************************************************/
+#include <string.h>
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "sl_bt_api.h"
+#include "sl_sleeptimer.h"
+#include "app_trace.h"
+#include "conn_table.h"
+#include "button_io.h"
+
+// PC7, active low, on external interrupt 1
+#define BUTTON_PORT       gpioPortC
+#define BUTTON_PIN        7
+#define BUTTON_INT        1
+
+#define EDGE_QUEUE_LEN    16    // power of two
+#define RETRY_MS          10    // when the stack is out of buffers
+
+typedef struct {
+  uint64_t tick;
+  uint8_t pressed;
+} edge_t;
+
+typedef struct {
+  uint32_t time_ms;
+  uint8_t pressed;
+} history_t;
+
+typedef struct {
+  uint8_t connection;         // 0xff: free
+  uint8_t client_config;      // sl_bt_gatt_notification / indication
+  bool pending;
+  bool in_flight;             // indication not confirmed yet
+  uint8_t edges;
+  uint32_t sent_ms;
+} subscriber_t;
+
+static volatile edge_t queue[EDGE_QUEUE_LEN];
+static volatile uint8_t queue_head;     // written by the interrupt
+static volatile uint8_t queue_tail;
+static volatile uint32_t queue_dropped;
+
+static uint16_t button_char;
+static uint8_t state;
+static uint32_t last_edge_ms;
+static history_t history[BUTTON_IO_HISTORY];
+static uint8_t history_next;
+static uint8_t history_count;
+static subscriber_t subscribers[BUTTON_IO_MAX_SUBSCRIBERS];
+static sl_sleeptimer_timer_handle_t retry_timer;
+static button_io_stats_t stats;
+
+static uint32_t tick_to_ms(uint64_t tick)
+{
+  uint64_t ms = 0;
+
+  sl_sleeptimer_tick64_to_ms(tick, &ms);
+  return (uint32_t)ms;
+}
+
+void GPIO_ODD_IRQHandler(void)
+{
+  uint32_t interruptMask;
+  uint8_t head = queue_head;
+
+  app_trace(APP_TRACE_ISR, APP_TRACE_ISR_BUTTON);
+  interruptMask = GPIO_IntGet();
+  GPIO_IntClear(interruptMask);
+  if (interruptMask & (1 << BUTTON_INT)) {
+    if ((uint8_t)(head - queue_tail) < EDGE_QUEUE_LEN) {
+      queue[head & (EDGE_QUEUE_LEN - 1)].tick = sl_sleeptimer_get_tick_count64();
+      queue[head & (EDGE_QUEUE_LEN - 1)].pressed = !GPIO_PinInGet(BUTTON_PORT, BUTTON_PIN);
+      queue_head = head + 1;
+    } else {
+      queue_dropped++;
+    }
+    sl_bt_external_signal(BUTTON_IO_SIGNAL);
+  }
+  app_trace(APP_TRACE_END(APP_TRACE_ISR), APP_TRACE_ISR_BUTTON);
+}
+
+static void retry_cb(sl_sleeptimer_timer_handle_t *handle, void *data)
+{
+  (void)handle;
+  (void)data;
+  app_trace(APP_TRACE_ISR, APP_TRACE_ISR_BUTTON_RETRY);
+  sl_bt_external_signal(BUTTON_IO_SIGNAL);
+  app_trace(APP_TRACE_END(APP_TRACE_ISR), APP_TRACE_ISR_BUTTON_RETRY);
+}
+
+static void retry_in(uint32_t ms)
+{
+  bool running = false;
+
+  sl_sleeptimer_is_timer_running(&retry_timer, &running);
+  if (!running) {
+    sl_sleeptimer_start_timer_ms(&retry_timer, ms, retry_cb, NULL, 0, 0);
+  }
+}
+
+static subscriber_t *find(uint8_t connection)
+{
+  for (uint8_t i = 0; i < BUTTON_IO_MAX_SUBSCRIBERS; i++) {
+    if (subscribers[i].connection == connection) {
+      return &subscribers[i];
+    }
+  }
+  return NULL;
+}
+
+// The link's connection interval in ms, whenever its parameters event came
+static uint32_t interval_ms(uint8_t connection)
+{
+  const conn_table_entry_t *link = conn_table_find(connection);
+
+  return link != NULL ? link->interval * 5 / 4 : 30;
+}
+
+static void flush(subscriber_t *sub, uint32_t now)
+{
+  uint8_t payload[6];
+  uint32_t since = now - sub->sent_ms;
+  uint32_t interval;
+  sl_status_t sc;
+
+  if (!sub->pending || sub->in_flight) {
+    return;
+  }
+  interval = interval_ms(sub->connection);
+  if (since < interval) {
+    retry_in(interval - since);
+    return;
+  }
+  payload[0] = state;
+  payload[1] = sub->edges;
+  memcpy(&payload[2], &last_edge_ms, sizeof(last_edge_ms));
+
+  if (sub->client_config == sl_bt_gatt_indication) {
+    sc = sl_bt_gatt_server_send_indication(sub->connection, button_char,
+                                           sizeof(payload), payload);
+  } else {
+    sc = sl_bt_gatt_server_send_notification(sub->connection, button_char,
+                                             sizeof(payload), payload);
+  }
+  if (sc != SL_STATUS_OK) {
+    retry_in(RETRY_MS);
+    return;
+  }
+  if (sub->edges > 1) {
+    stats.coalesced += sub->edges - 1;
+  }
+  if (now - last_edge_ms > stats.latency_ms_max) {
+    stats.latency_ms_max = now - last_edge_ms;
+  }
+  stats.sent++;
+  sub->pending = false;
+  sub->in_flight = (sub->client_config == sl_bt_gatt_indication);
+  sub->edges = 0;
+  sub->sent_ms = now;
+}
+
+void button_io_init(uint16_t characteristic)
+{
+  button_char = characteristic;
+  for (uint8_t i = 0; i < BUTTON_IO_MAX_SUBSCRIBERS; i++) {
+    subscribers[i].connection = 0xff;
+  }
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  GPIO_PinModeSet(BUTTON_PORT, BUTTON_PIN, gpioModeInputPullFilter, 1);
+  state = !GPIO_PinInGet(BUTTON_PORT, BUTTON_PIN);
+  // Both edges, so releases are reported too
+  GPIO_ExtIntConfig(BUTTON_PORT, BUTTON_PIN, BUTTON_INT, true, true, true);
+  NVIC_ClearPendingIRQ(GPIO_ODD_IRQn);
+  NVIC_EnableIRQ(GPIO_ODD_IRQn);
+}
+
+uint8_t button_io_process(uint32_t signals)
+{
+  uint8_t presses = 0;
+  uint8_t edges = 0;
+  uint32_t now;
+
+  if (!(signals & BUTTON_IO_SIGNAL)) {
+    return 0;
+  }
+  while (queue_tail != queue_head) {
+    volatile edge_t *e = &queue[queue_tail & (EDGE_QUEUE_LEN - 1)];
+
+    // Switch bounce can repeat a level; only changes count
+    if (e->pressed != state) {
+      state = e->pressed;
+      last_edge_ms = tick_to_ms(e->tick);
+      history[history_next].time_ms = last_edge_ms;
+      history[history_next].pressed = state;
+      history_next = (history_next + 1) % BUTTON_IO_HISTORY;
+      if (history_count < BUTTON_IO_HISTORY) {
+        history_count++;
+      }
+      presses += state;
+      edges++;
+    }
+    queue_tail++;
+  }
+  stats.edges += edges;
+  stats.dropped = queue_dropped;
+
+  now = tick_to_ms(sl_sleeptimer_get_tick_count64());
+  for (uint8_t i = 0; i < BUTTON_IO_MAX_SUBSCRIBERS; i++) {
+    subscriber_t *sub = &subscribers[i];
+    if (sub->connection == 0xff || sub->client_config == 0) {
+      continue;
+    }
+    if (edges != 0) {
+      sub->pending = true;
+      sub->edges = (sub->edges + edges > 0xff) ? 0xff : sub->edges + edges;
+    }
+    flush(sub, now);
+  }
+  return presses;
+}
+
+void button_io_on_status(uint8_t connection, uint8_t status_flags, uint16_t client_config)
+{
+  subscriber_t *sub = find(connection);
+
+  if (status_flags == sl_bt_gatt_server_confirmation) {
+    if (sub != NULL) {
+      sub->in_flight = false;
+      flush(sub, tick_to_ms(sl_sleeptimer_get_tick_count64()));
+    }
+    return;
+  }
+  if (status_flags != sl_bt_gatt_server_client_config) {
+    return;
+  }
+  if (sub == NULL) {
+    sub = find(0xff);
+    if (sub == NULL) {
+      return;
+    }
+    memset(sub, 0, sizeof(*sub));
+    sub->connection = connection;
+  }
+  sub->client_config = (uint8_t)client_config;
+  sub->in_flight = false;
+}
+
+void button_io_on_closed(uint8_t connection)
+{
+  subscriber_t *sub = find(connection);
+
+  if (sub != NULL) {
+    sub->connection = 0xff;
+  }
+}
+
+uint8_t button_io_read(uint16_t offset, uint8_t *value, uint8_t max)
+{
+  uint8_t full[BUTTON_IO_READ_LEN];
+  uint8_t len = 2;
+  uint8_t n;
+
+  full[0] = state;
+  full[1] = history_count;
+  for (n = 0; n < history_count; n++) {
+    const history_t *h = &history[(history_next + BUTTON_IO_HISTORY - 1 - n) % BUTTON_IO_HISTORY];
+    full[len++] = h->pressed;
+    memcpy(&full[len], &h->time_ms, sizeof(h->time_ms));
+    len += sizeof(h->time_ms);
+  }
+  if (offset >= len) {
+    return 0;
+  }
+  n = (len - offset < max) ? len - offset : max;
+  memcpy(value, &full[offset], n);
+  return n;
+}
+
+uint8_t button_io_state(void)
+{
+  return state;
+}
+
+const button_io_stats_t *button_io_stats(void)
+{
+  return &stats;
+}
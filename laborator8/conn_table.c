@@ -0,0 +1,188 @@
+/***************************************************************************//**
+ * @file
+ * @brief Per-connection state for a peripheral serving several centrals.
+ *
+ * The table is sized to the stack's connection limit, so a slot is always
+ * free when the stack accepts a connection. Lookups are a linear scan; with
+ * a handful of links that is cheaper than anything smarter.
+ ******************************************************************************/
+#include <string.h>
+#include "sl_sleeptimer.h"
+#include "conn_table.h"
+
+static conn_table_entry_t table[CONN_TABLE_SIZE];
+static uint8_t open_count;
+
+// Also finds a free slot when given 0xff
+static conn_table_entry_t *lookup(uint8_t connection)
+{
+  for (uint8_t i = 0; i < CONN_TABLE_SIZE; i++) {
+    if (table[i].connection == connection) {
+      return &table[i];
+    }
+  }
+  return NULL;
+}
+
+static uint32_t now_ms(void)
+{
+  uint64_t ms = 0;
+
+  sl_sleeptimer_tick64_to_ms(sl_sleeptimer_get_tick_count64(), &ms);
+  return (uint32_t)ms;
+}
+
+void conn_table_init(void)
+{
+  for (uint8_t i = 0; i < CONN_TABLE_SIZE; i++) {
+    table[i].connection = 0xff;
+  }
+  open_count = 0;
+}
+
+conn_table_entry_t *conn_table_on_opened(uint8_t connection, const bd_addr *address,
+                                         uint8_t address_type, uint8_t bonding)
+{
+  conn_table_entry_t *e = conn_table_find(connection);
+
+  if (e == NULL) {
+    e = lookup(0xff);
+    if (e == NULL) {
+      return NULL;
+    }
+    open_count++;
+  }
+  memset(e, 0, sizeof(*e));
+  e->connection = connection;
+  e->address = *address;
+  e->address_type = address_type;
+  e->bonding = bonding;
+  // Link layer defaults until the stack reports otherwise
+  e->phy = sl_bt_gap_phy_1m;
+  e->mtu = 23;
+  e->tx_len = 27;
+  e->interval = 24;
+  e->opened_ms = now_ms();
+  e->activity_ms = e->opened_ms;
+  return e;
+}
+
+void conn_table_on_closed(uint8_t connection)
+{
+  conn_table_entry_t *e = conn_table_find(connection);
+
+  if (e != NULL) {
+    e->connection = 0xff;
+    open_count--;
+  }
+}
+
+void conn_table_on_parameters(uint8_t connection, uint16_t interval, uint8_t security)
+{
+  conn_table_entry_t *e = conn_table_find(connection);
+
+  if (e != NULL) {
+    e->interval = interval;
+    e->security = security;
+  }
+}
+
+void conn_table_on_mtu(uint8_t connection, uint16_t mtu)
+{
+  conn_table_entry_t *e = conn_table_find(connection);
+
+  if (e != NULL) {
+    e->mtu = mtu;
+  }
+}
+
+void conn_table_on_phy(uint8_t connection, uint8_t phy)
+{
+  conn_table_entry_t *e = conn_table_find(connection);
+
+  if (e != NULL) {
+    e->phy = phy;
+  }
+}
+
+void conn_table_on_data_length(uint8_t connection, uint16_t tx_len)
+{
+  conn_table_entry_t *e = conn_table_find(connection);
+
+  if (e != NULL) {
+    e->tx_len = tx_len;
+  }
+}
+
+void conn_table_on_status(uint8_t connection, uint16_t characteristic,
+                          uint8_t status_flags, uint16_t client_config)
+{
+  conn_table_entry_t *e = conn_table_find(connection);
+  conn_table_cccd_t *free_cccd = NULL;
+
+  if (e == NULL || status_flags != sl_bt_gatt_server_client_config) {
+    return;
+  }
+  e->activity_ms = now_ms();
+  for (uint8_t i = 0; i < CONN_TABLE_MAX_CCCD; i++) {
+    if (e->cccd[i].characteristic == characteristic) {
+      e->cccd[i].client_config = (uint8_t)client_config;
+      return;
+    }
+    if (free_cccd == NULL && e->cccd[i].client_config == 0) {
+      free_cccd = &e->cccd[i];
+    }
+  }
+  // Unsubscribed slots are reused; a full table just loses the newest one
+  if (free_cccd != NULL && client_config != 0) {
+    free_cccd->characteristic = characteristic;
+    free_cccd->client_config = (uint8_t)client_config;
+  }
+}
+
+void conn_table_touch(uint8_t connection)
+{
+  conn_table_entry_t *e = conn_table_find(connection);
+
+  if (e != NULL) {
+    e->activity_ms = now_ms();
+  }
+}
+
+conn_table_entry_t *conn_table_find(uint8_t connection)
+{
+  return (connection == 0xff) ? NULL : lookup(connection);
+}
+
+conn_table_entry_t *conn_table_get(uint8_t index)
+{
+  if (index >= CONN_TABLE_SIZE || table[index].connection == 0xff) {
+    return NULL;
+  }
+  return &table[index];
+}
+
+uint8_t conn_table_client_config(uint8_t connection, uint16_t characteristic)
+{
+  conn_table_entry_t *e = conn_table_find(connection);
+
+  if (e == NULL) {
+    return 0;
+  }
+  for (uint8_t i = 0; i < CONN_TABLE_MAX_CCCD; i++) {
+    if (e->cccd[i].characteristic == characteristic) {
+      return e->cccd[i].client_config;
+    }
+  }
+  return 0;
+}
+
+uint8_t conn_table_count(void)
+{
+  return open_count;
+}
+
+bool conn_table_full(void)
+{
+  return open_count >= CONN_TABLE_SIZE;
+}
@@ -0,0 +1,71 @@
+/***************************************************************************//**
+ * @file
+ * @brief Per-connection state for a peripheral serving several centrals.
+ *
+ * One slot per link the stack can hold. sl_bt_on_event() feeds the link
+ * events in; the other modules look a connection up here instead of
+ * tracking "the" connection themselves.
+ ******************************************************************************/
+
+#ifndef CONN_TABLE_H
+#define CONN_TABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sl_bt_api.h"
+#include "sl_bluetooth_connection_config.h"
+
+#define CONN_TABLE_SIZE       SL_BT_CONFIG_MAX_CONNECTIONS
+#define CONN_TABLE_MAX_CCCD   4     // subscribed characteristics per link
+
+typedef struct {
+  uint16_t characteristic;
+  uint8_t client_config;      ///< sl_bt_gatt_notification / indication
+} conn_table_cccd_t;
+
+typedef struct {
+  uint8_t connection;         ///< 0xff: free
+  bd_addr address;
+  uint8_t address_type;
+  uint8_t bonding;            ///< 0xff: not bonded
+  uint8_t security;           ///< sl_bt_connection_mode1_level*
+  uint8_t phy;                ///< sl_bt_gap_phy_*
+  uint16_t mtu;
+  uint16_t tx_len;            ///< link layer payload
+  uint16_t interval;          ///< 1.25 ms units
+  uint32_t opened_ms;
+  uint32_t activity_ms;       ///< last request or subscription change
+  conn_table_cccd_t cccd[CONN_TABLE_MAX_CCCD];
+} conn_table_entry_t;
+
+void conn_table_init(void);
+
+/// sl_bt_evt_connection_opened_id. Returns NULL if every slot is taken.
+conn_table_entry_t *conn_table_on_opened(uint8_t connection, const bd_addr *address,
+                                         uint8_t address_type, uint8_t bonding);
+void conn_table_on_closed(uint8_t connection);
+void conn_table_on_parameters(uint8_t connection, uint16_t interval, uint8_t security);
+void conn_table_on_mtu(uint8_t connection, uint16_t mtu);
+void conn_table_on_phy(uint8_t connection, uint8_t phy);
+void conn_table_on_data_length(uint8_t connection, uint16_t tx_len);
+
+/// sl_bt_evt_gatt_server_characteristic_status_id, any characteristic.
+void conn_table_on_status(uint8_t connection, uint16_t characteristic,
+                          uint8_t status_flags, uint16_t client_config);
+
+/// Marks a read or write request from the link.
+void conn_table_touch(uint8_t connection);
+
+conn_table_entry_t *conn_table_find(uint8_t connection);
+
+/// Slot index, NULL if the slot is free. For walking every open link.
+conn_table_entry_t *conn_table_get(uint8_t index);
+
+/// CCCD value the link wrote for characteristic, 0 if none.
+uint8_t conn_table_client_config(uint8_t connection, uint16_t characteristic);
+
+uint8_t conn_table_count(void);
+
+bool conn_table_full(void);
+
+#endif // CONN_TABLE_H
@@ -0,0 +1,364 @@
+/* Scripted stimulus generator, see bt_gen.h */
+#include <stdbool.h>
+#include <string.h>
+
+#include "bt_script.h"
+#include "bt_gen.h"
+#include "../bcast_format.h"
+
+#define PEERS           16
+#define BOND_PEERS      12
+#define BROADCASTERS    3
+
+static uint32_t rng_state;
+
+static uint32_t rnd(void)
+{
+  // xorshift32
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static uint32_t below(uint32_t n)
+{
+  return n ? rnd() % n : 0;
+}
+
+static bool chance(uint32_t percent)
+{
+  return below(100) < percent;
+}
+
+static bool has(const char *name)
+{
+  return bt_script_char_handle(name) >= 0;
+}
+
+static void put_hex(FILE *out, const uint8_t *data, size_t len)
+{
+  for (size_t i = 0; i < len; i++) {
+    fprintf(out, "%02x", data[i]);
+  }
+}
+
+static void put_addr(FILE *out, uint32_t peer)
+{
+  // Static random addresses: top two bits set
+  fprintf(out, " addr=c0:%02x:%02x:00:00:%02x type=1",
+          (peer >> 16) & 0xff, (peer >> 8) & 0xff, peer & 0xff);
+}
+
+/* Legacy advertising payload, valid most of the time */
+static size_t make_ad(uint8_t *ad, uint32_t peer)
+{
+  static const char *const names[] = { "Thermo", "BG22 Node", "iTag", "Sensor-42", "" };
+  size_t n = 0;
+  const char *name = names[peer % 5];
+  size_t name_len = strlen(name);
+
+  ad[n++] = 2;
+  ad[n++] = 0x01;
+  ad[n++] = 0x06;
+  if (peer % 3 == 0) {
+    ad[n++] = 5;
+    ad[n++] = 0x03;
+    ad[n++] = 0x0f;
+    ad[n++] = 0x18;
+    ad[n++] = 0x1a;
+    ad[n++] = 0x18;
+  }
+  if (peer % 4 == 1) {
+    ad[n++] = 7;
+    ad[n++] = 0xff;
+    ad[n++] = 0xff;
+    ad[n++] = 0x02;
+    for (int i = 0; i < 4; i++) {
+      ad[n++] = (uint8_t)rnd();
+    }
+  }
+  if (name_len > 31 - n - 2) {
+    name_len = 31 - n - 2;
+  }
+  ad[n++] = (uint8_t)(name_len + 1);
+  ad[n++] = (peer & 1) ? 0x09 : 0x08;
+  memcpy(&ad[n], name, name_len);
+  n += name_len;
+
+  if (!chance(20)) {
+    return n;
+  }
+  // The kinds of damage seen on air and in buggy firmware
+  switch (below(5)) {
+    case 0:                   // length running past the end
+      ad[n - name_len - 2] = (uint8_t)(name_len + 1 + 1 + below(40));
+      break;
+    case 1:                   // cut short
+      n = below((uint32_t)n);
+      break;
+    case 2:                   // zero padding in the middle
+      memmove(&ad[3], &ad[0], n - 3 < 28 ? n - 3 : 28);
+      ad[0] = ad[1] = ad[2] = 0;
+      break;
+    case 3:                   // length byte 1: type only
+      ad[0] = 1;
+      break;
+    default:                  // noise
+      n = 1 + below(31);
+      for (size_t i = 0; i < n; i++) {
+        ad[i] = (uint8_t)rnd();
+      }
+      break;
+  }
+  return n;
+}
+
+static void gen_scan(FILE *out, unsigned count)
+{
+  uint8_t ad[31];
+
+  fprintf(out, "0 boot\n");
+  for (unsigned i = 0; i < count; i++) {
+    uint32_t peer = below(48);
+    size_t len = make_ad(ad, peer);
+
+    fprintf(out, "+%.3f adv", 0.2 + below(5000) / 1000.0);
+    put_addr(out, peer);
+    fprintf(out, " rssi=%d flags=%u data=", -30 - (int)below(70), chance(70) ? 0x13 : 0x00);
+    put_hex(out, ad, len);
+    fprintf(out, "\n");
+    if (chance(2)) {
+      // Extended reports that are not broadcasts, some of them junk
+      fprintf(out, "+0.5 ext_adv");
+      put_addr(out, 100 + below(8));
+      fprintf(out, " sid=%u interval=%u data=", below(16), chance(50) ? 800 : 0);
+      len = below(31);
+      for (size_t j = 0; j < len; j++) {
+        ad[j] = (uint8_t)rnd();
+      }
+      put_hex(out, ad, len);
+      fprintf(out, "\n");
+    }
+    if (i % 2000 == 1999) {
+      fprintf(out, "+1 key text=%c\n", chance(30) ? 'b' : '0' + below(3));
+    }
+  }
+}
+
+static void put_bcast_header(uint8_t *ad, uint8_t kind, uint8_t body_len)
+{
+  ad[0] = 1 + BCAST_OFF_BODY + body_len;
+  ad[1] = 0xff;
+  ad[2 + BCAST_OFF_COMPANY] = BCAST_COMPANY_ID & 0xff;
+  ad[2 + BCAST_OFF_COMPANY + 1] = BCAST_COMPANY_ID >> 8;
+  ad[2 + BCAST_OFF_MAGIC] = BCAST_MAGIC;
+  ad[2 + BCAST_OFF_VERSION_KIND] = (BCAST_VERSION << 4) | kind;
+}
+
+static void gen_bcast(FILE *out, unsigned count)
+{
+  uint8_t ad[2 + BCAST_OFF_BODY + BCAST_READINGS_LEN];
+  uint16_t seq[BROADCASTERS] = { 0 };
+  unsigned reports = 0;
+
+  fprintf(out, "0 boot\n");
+  while (reports < count) {
+    for (uint32_t b = 0; b < BROADCASTERS && reports < count; b++) {
+      uint8_t *v = &ad[2];
+      size_t len = sizeof(ad);
+
+      // The announcement goes out every advertising interval; the
+      // listener only syncs on the first one it takes
+      put_bcast_header(ad, BCAST_KIND_ANNOUNCE, 0);
+      fprintf(out, "+%.3f ext_adv", 1.0 + below(20));
+      put_addr(out, 200 + b);
+      fprintf(out, " sid=%u interval=800 data=", b);
+      put_hex(out, ad, 2 + BCAST_OFF_BODY);
+      fprintf(out, "\n");
+
+      put_bcast_header(ad, BCAST_KIND_READINGS, BCAST_READINGS_LEN);
+      if (chance(10)) {
+        seq[b] += 1 + below(3);     // updates lost on air
+      } else if (!chance(10)) {
+        seq[b]++;                   // else a repeat
+      }
+      v[BCAST_OFF_SEQ] = seq[b] & 0xff;
+      v[BCAST_OFF_SEQ + 1] = seq[b] >> 8;
+      v[BCAST_OFF_TEMP] = (uint8_t)(200 + below(60));
+      v[BCAST_OFF_TEMP + 1] = 0;
+      v[BCAST_OFF_BUTTON] = chance(20) ? BCAST_BUTTON_PRESSED : 0;
+      v[BCAST_OFF_PRESSES] = seq[b] & 0xff;
+      v[BCAST_OFF_PRESSES + 1] = 0;
+      v[BCAST_OFF_LINKS] = (uint8_t)below(5);
+      if (chance(3)) {
+        v[BCAST_OFF_VERSION_KIND] = (uint8_t)((BCAST_VERSION + 1) << 4 | BCAST_KIND_READINGS);
+      } else if (chance(3)) {
+        len = 2 + BCAST_OFF_BODY + below(BCAST_READINGS_LEN);
+      }
+      fprintf(out, "+%.3f sync_report", 150.0 + below(200));
+      put_addr(out, 200 + b);
+      fprintf(out, " sid=%u counter=%u data=", b, seq[b] & 0xff);
+      put_hex(out, ad, len);
+      fprintf(out, "\n");
+      reports++;
+    }
+    fprintf(out, "+%u run\n", 400 + below(200));
+  }
+}
+
+static void gen_button(FILE *out, bool bounce)
+{
+  fprintf(out, "+%u button down\n", 1 + below(20));
+  if (bounce) {
+    // Contact bounce: a few edges well inside the debounce time
+    for (uint32_t i = below(4); i > 0; i--) {
+      fprintf(out, "+0.3 button up\n+0.4 button down\n");
+    }
+  }
+  fprintf(out, "+%u button up\n", 30 + below(400));
+}
+
+static void gen_conn(FILE *out, unsigned count, uint8_t max_links)
+{
+  bool led = has("LED_IO");
+  bool button = has("BUTTON_IO");
+  bool open[256] = { false };
+  uint8_t links = 0;
+
+  fprintf(out, "0 boot\n");
+  for (unsigned i = 0; i < count; i++) {
+    uint8_t conn = (uint8_t)(1 + below(max_links));
+    uint32_t what = below(100);
+
+    fprintf(out, "+%u run\n", 1 + below(60));
+    if (!open[conn]) {
+      if (links == max_links) {
+        continue;
+      }
+      // The replay decides whether the app is advertising connectable
+      fprintf(out, "+0 open conn=%u adv=auto", conn);
+      put_addr(out, below(PEERS));
+      fprintf(out, "\n+1 mtu conn=%u mtu=%u\n", conn, chance(20) ? 23 : 23 + below(225));
+      fprintf(out, "+%u params conn=%u interval=%u\n", 10 + below(30), conn, 6 + below(80));
+      if (button) {
+        fprintf(out, "+%u status conn=%u char=BUTTON_IO config=2\n", 5 + below(20), conn);
+      }
+      open[conn] = true;
+      links++;
+    } else if (what < 8) {
+      fprintf(out, "+0 close conn=%u reason=%u\n", conn, chance(50) ? 0x13 : 0x08);
+      open[conn] = false;
+      links--;
+    } else if (what < 45 && led) {
+      uint8_t value[8];
+      uint32_t len = chance(80) ? 1 + below(4) : below(8);
+
+      for (uint32_t j = 0; j < len; j++) {
+        value[j] = (uint8_t)below(chance(90) ? 2 : 256);
+      }
+      fprintf(out, "+0 write conn=%u char=LED_IO offset=%u cmd=%u data=", conn,
+              chance(90) ? 0 : below(4), chance(30));
+      put_hex(out, value, len);
+      fprintf(out, "\n");
+    } else if (what < 60 && (led || button)) {
+      fprintf(out, "+0 read conn=%u char=%s offset=%u\n", conn,
+              (led && chance(50)) || !button ? "LED_IO" : "BUTTON_IO",
+              chance(80) ? 0 : below(60));
+    } else if (what < 65 && button) {
+      fprintf(out, "+0 status conn=%u char=BUTTON_IO config=%u\n", conn, below(3));
+    } else if (what < 75) {
+      fprintf(out, "+0 params conn=%u interval=%u latency=%u\n", conn, 6 + below(400),
+              chance(80) ? 0 : below(4));
+    } else {
+      gen_button(out, chance(30));
+    }
+  }
+}
+
+static void gen_bond(FILE *out, unsigned count)
+{
+  uint8_t hash[16];
+  bool bonded[BOND_PEERS] = { false };
+
+  fprintf(out, "0 boot\n");
+  for (unsigned i = 0; i < count; i++) {
+    uint32_t peer = below(BOND_PEERS);
+
+    if (has("database_hash") && (i == 0 || chance(3))) {
+      // A new database hash, as after a firmware update
+      for (int j = 0; j < 16; j++) {
+        hash[j] = (uint8_t)rnd();
+      }
+      fprintf(out, "+0 attr char=database_hash data=");
+      put_hex(out, hash, sizeof(hash));
+      fprintf(out, "\n");
+    }
+    fprintf(out, "+%u open conn=1 bonding=auto", 20 + below(200));
+    put_addr(out, 0x100 + peer);
+    fprintf(out, "\n");
+    if (bonded[peer] && chance(90)) {
+      fprintf(out, "+30 params conn=1 security=2\n");
+    } else {
+      fprintf(out, "+20 passkey conn=1 passkey=2342\n");
+      fprintf(out, "+%u confirm_bonding conn=1 bonding=auto\n", 500 + below(3000));
+      if (chance(10)) {
+        fprintf(out, "+50 bond_failed conn=1\n");
+      } else {
+        fprintf(out, "+50 bonded conn=1 bonding=auto\n");
+        fprintf(out, "+10 params conn=1 security=2\n");
+        bonded[peer] = true;
+      }
+    }
+    if (has("service_changed_char")) {
+      fprintf(out, "+%u status conn=1 char=service_changed_char config=2\n", 5 + below(50));
+    }
+    if (has("BUTTON_IO")) {
+      fprintf(out, "+%u status conn=1 char=BUTTON_IO config=2\n", 5 + below(50));
+      fprintf(out, "+%u read conn=1 char=BUTTON_IO\n", 5 + below(50));
+    }
+    if (chance(30)) {
+      gen_button(out, false);
+    }
+    fprintf(out, "+%u close conn=1\n", 100 + below(2000));
+  }
+}
+
+static void gen_tp(FILE *out, unsigned count)
+{
+  fprintf(out, "0 boot\n");
+  if (!has("tp_data") || !has("tp_control")) {
+    return;
+  }
+  for (unsigned i = 0; i < count; i++) {
+    uint32_t ms = 500 + below(2000);
+
+    fprintf(out, "+%u open conn=1", 50 + below(100));
+    put_addr(out, below(PEERS));
+    fprintf(out, "\n+5 mtu conn=1 mtu=%u\n", chance(20) ? 23 + below(100) : 247);
+    fprintf(out, "+5 status conn=1 char=tp_data config=1\n");
+    fprintf(out, "+5 write conn=1 char=tp_control data=01%02x%02x0000\n", ms & 0xff, ms >> 8);
+    fprintf(out, "+%u read conn=1 char=tp_control\n", ms + 100);
+    fprintf(out, "+5 close conn=1\n");
+  }
+}
+
+int bt_gen(FILE *out, const char *scenario, unsigned count, uint32_t seed, uint8_t max_links)
+{
+  rng_state = seed ? seed : 1;
+  fprintf(out, "# bt_host --gen %s:%u --seed %u\n", scenario, count, (unsigned)seed);
+  if (strcmp(scenario, "scan") == 0) {
+    gen_scan(out, count);
+  } else if (strcmp(scenario, "bcast") == 0) {
+    gen_bcast(out, count);
+  } else if (strcmp(scenario, "conn") == 0) {
+    gen_conn(out, count, max_links);
+  } else if (strcmp(scenario, "bond") == 0) {
+    gen_bond(out, count);
+  } else if (strcmp(scenario, "tp") == 0) {
+    gen_tp(out, count);
+  } else {
+    return -1;
+  }
+  return 0;
+}
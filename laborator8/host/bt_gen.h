@@ -0,0 +1,27 @@
+#ifndef _BT_GEN_H_
+#define _BT_GEN_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* Scripted stimulus generator for bt_host. Writes a script (bt_script.h
+ * format, relative times) for one scenario:
+ *
+ *   scan   legacy reports from a few dozen scanners' worth of devices,
+ *          a fifth of them malformed or fuzzed, and console keys
+ *   bcast  sensor broadcasters (bcast_format.h): announcements and
+ *          periodic readings with lost, repeated and garbled updates
+ *   conn   centrals coming and going up to the link limit, writes with
+ *          odd lengths and offsets, reads, subscriptions, link updates
+ *          and a bouncing button
+ *   bond   a dozen peers pairing and reconnecting, more than the bond
+ *          database holds
+ *   tp     back-to-back throughput tests
+ *
+ * count scales the run (events or sessions). Characteristics the
+ * application under test lacks are left out. Returns -1 for an unknown
+ * scenario. */
+int bt_gen(FILE *out, const char *scenario, unsigned count, uint32_t seed,
+           uint8_t max_links);
+
+#endif
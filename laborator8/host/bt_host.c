@@ -0,0 +1,715 @@
+/* Host replay and benchmark harness for the EFR32 labs.
+ *
+ * Links one lab's app.c (and the modules next to it) against the stubs in
+ * stubs/: bt_mock.c answers the sl_bt_* commands, host_platform.c stands
+ * in for the sleeptimer, GPIO, power manager, NVM3 and VCOM. The harness
+ * plays the main loop of main.c on a simulated clock: stimuli from a
+ * script (bt_script.h) or the generator (bt_gen.h) go to sl_bt_on_event
+ * and the GPIO handlers, sleeptimer callbacks fire when the clock passes
+ * them, and app_process_action() runs until the application settles.
+ *
+ * Every handler call is timed on the host clock. The report gives count,
+ * mean, p99 and worst time per event type, the events per second the
+ * handlers could take, the worst single event with the script line behind
+ * it, simulated EM1/EM2 time and per-command stack call counts.
+ *
+ *   ./build/bt_host_l8 script.txt            # replay a script or trace
+ *   ./build/bt_host_l8 --gen conn:5000 --seed 7 --strict --record conn.trace
+ *   ./build/bt_host_lab7 --gen scan:200000 --max-us 50 --min-eps 100000
+ *
+ * Options:
+ *   --gen S[:N]     generate scenario S (scan, bcast, conn, bond, tp)
+ *   --seed N        generator seed (default 1)
+ *   --record FILE   write the stimuli as delivered, absolute times
+ *   --vcom FILE     application output (default: discarded, -v: stdout)
+ *   --nvm FILE      NVM3 contents, loaded before and saved after the run
+ *   --swo FILE      raw SWO capture of the lab's app_trace records, for
+ *                   swo_trace (laborator8)
+ *   --no-auto       no stack events in reply to commands; script them
+ *   --tx-slots N    notification buffers (default 10)
+ *   --tx-per-ms N   buffers the radio frees per ms (default 2)
+ *   --tail MS       simulated time to run after the last stimulus (2000)
+ *   --max-us N      fail if any event but boot took longer
+ *   --min-eps N     fail if the handlers manage fewer events per second
+ *   --strict        fail on stimuli the stack could not have produced
+ *
+ * Exit status: 0 pass, 1 a limit or --strict check failed, 2 an assert
+ * fired in the application or the script is broken.
+ */
+#include <getopt.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sl_bluetooth.h"
+#include "sl_core.h"
+#include "sl_sleeptimer.h"
+#include "app.h"
+#include "bt_gen.h"
+#include "bt_mock.h"
+#include "bt_script.h"
+#include "host_platform.h"
+
+/* laborator8 traces its handlers to the SWO (app_trace.h). Its main.c
+ * brackets the loop passes and drains the ring before sleeping; the
+ * harness does the same for it. */
+#if __has_include("app_trace.h")
+#include "app_trace.h"
+#define TRACE(kind)       app_trace(APP_TRACE_##kind, 0)
+#define TRACE_END(kind)   app_trace(APP_TRACE_END(APP_TRACE_##kind), 0)
+#define TRACE_FLUSH()     app_trace_flush()
+#else
+#define TRACE(kind)       ((void)0)
+#define TRACE_END(kind)   ((void)0)
+#define TRACE_FLUSH()     ((void)0)
+#endif
+
+#define MAX_TIMINGS     40
+#define HIST_BUCKETS    (8 * 48)    /* 8 per octave of ns */
+#define SETTLE_MAX      64          /* main loop passes per wakeup */
+#define MAX_SCRIPTS     16
+
+typedef struct {
+  const char *name;
+  bool bt_event;              /* went through sl_bt_on_event */
+  uint64_t count;
+  uint64_t sum_ns;
+  uint64_t max_ns;
+  char max_where[96];
+  uint32_t hist[HIST_BUCKETS];
+} timing_t;
+
+static struct {
+  const char *gen;
+  unsigned gen_count;
+  uint32_t seed;
+  const char *record;
+  const char *vcom;
+  bool verbose;
+  const char *nvm;
+  const char *swo;
+  bool strict;
+  double tail_ms;
+  double max_us;
+  double min_eps;
+  bt_mock_config_t mock;
+  const char *scripts[MAX_SCRIPTS];
+  int script_count;
+} opt = {
+  .seed = 1,
+  .tail_ms = 2000,
+  .mock = { .tx_slots = 10, .tx_per_ms = 2, .auto_events = true },
+};
+
+static timing_t timings[MAX_TIMINGS];
+static int timing_count;
+static FILE *record;
+static char where[96] = "start-up";
+static uint64_t events;
+static uint64_t rejected;
+static uint64_t unsynced;
+static uint64_t missed_opens;
+static bool missed[256];      /* adv=auto open found nothing connectable */
+static uint64_t busy_loops;
+static uint64_t radio_wakeups;
+static char first_rejected[160];
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static unsigned bucket(uint64_t ns)
+{
+  unsigned msb;
+  unsigned b;
+
+  if (ns < 2) {
+    return 0;
+  }
+  msb = 63 - (unsigned)__builtin_clzll(ns);
+  // Three bits below the leading one pick the eighth of the octave
+  b = msb * 8 + (unsigned)((msb >= 3 ? ns >> (msb - 3) : ns << (3 - msb)) & 7);
+  return b < HIST_BUCKETS ? b : HIST_BUCKETS - 1;
+}
+
+static double bucket_top_ns(unsigned b)
+{
+  unsigned msb = b / 8;
+
+  return (double)(8 + b % 8 + 1) * (double)(1ull << msb) / 8.0;
+}
+
+static timing_t *timing(const char *name, bool bt_event)
+{
+  for (int i = 0; i < timing_count; i++) {
+    if (strcmp(timings[i].name, name) == 0) {
+      return &timings[i];
+    }
+  }
+  if (timing_count == MAX_TIMINGS) {
+    return &timings[MAX_TIMINGS - 1];
+  }
+  timings[timing_count].name = name;
+  timings[timing_count].bt_event = bt_event;
+  return &timings[timing_count++];
+}
+
+static void account(timing_t *t, uint64_t ns)
+{
+  t->count++;
+  t->sum_ns += ns;
+  t->hist[bucket(ns)]++;
+  if (ns > t->max_ns) {
+    t->max_ns = ns;
+    snprintf(t->max_where, sizeof(t->max_where), "%s", where);
+  }
+}
+
+/* What is running, for the report and for a failed app_assert() */
+static void set_where(const char *fmt, ...)
+{
+  va_list ap;
+  int n;
+
+  va_start(ap, fmt);
+  n = vsnprintf(where, sizeof(where), fmt, ap);
+  va_end(ap);
+  if (n >= 0 && (size_t)n < sizeof(where)) {
+    snprintf(where + n, sizeof(where) - (size_t)n, " at %.3f ms",
+             bt_script_tick_to_ms(host_now_tick()));
+  }
+  host_set_context(where);
+}
+
+static void check_balanced(void)
+{
+  if (host_core_atomic_depth != 0) {
+    fprintf(stderr, "%s: CORE_ENTER/EXIT unbalanced (depth %d)\n", where,
+            host_core_atomic_depth);
+    exit(2);
+  }
+}
+
+static void deliver(sl_bt_msg_t *evt, const char *name)
+{
+  const char *why = NULL;
+  uint64_t t0;
+
+  if (!bt_mock_on_event(evt, &why)) {
+    if (rejected++ == 0) {
+      snprintf(first_rejected, sizeof(first_rejected), "%s: %s", where, why);
+    }
+    if (opt.verbose) {
+      printf("%s: not delivered: %s\n", where, why);
+    }
+    return;
+  }
+  TRACE(STEP);
+  t0 = now_ns();
+  sl_bt_on_event(evt);
+  account(timing(name, true), now_ns() - t0);
+  TRACE_END(STEP);
+  check_balanced();
+  events++;
+}
+
+/* The main loop after a wakeup: stack events first (sl_bt_step), then
+ * app_process_action(), again while anything moves or the application
+ * keeps the core from sleeping */
+static void settle(void)
+{
+  for (int pass = 0; pass < SETTLE_MAX; pass++) {
+    uint32_t signals = bt_mock_take_signals();
+    uint32_t calls;
+    uint64_t t0;
+
+    if (signals != 0) {
+      sl_bt_msg_t evt;
+
+      memset(&evt, 0, sizeof(evt));
+      evt.header = sl_bt_evt_system_external_signal_id;
+      evt.data.evt_system_external_signal.extsignals = signals;
+      deliver(&evt, "ext_signal");
+    }
+    calls = bt_mock_ok_calls();
+    TRACE(APP);
+    t0 = now_ns();
+    app_process_action();
+    account(timing("process", false), now_ns() - t0);
+    TRACE_END(APP);
+    check_balanced();
+    TRACE_FLUSH();
+    if (signals == 0 && bt_mock_ok_calls() == calls && host_power_try_sleep()) {
+      return;
+    }
+  }
+  busy_loops++;
+}
+
+static void advance(uint64_t tick)
+{
+  host_set_now(tick);
+  bt_mock_advance(host_now_tick());
+}
+
+static uint64_t min3(uint64_t a, uint64_t b, uint64_t c)
+{
+  uint64_t m = a < b ? a : b;
+
+  return m < c ? m : c;
+}
+
+/* Lets the clock run to target, serving timers and the stack on the way */
+static void run_until(uint64_t target)
+{
+  for (;;) {
+    uint64_t next = min3(host_next_timer_tick(), bt_mock_next_event_tick(),
+                         bt_mock_next_radio_tick());
+    sl_bt_msg_t evt;
+
+    if (next > target) {
+      break;
+    }
+    advance(next);
+    if (host_next_timer_tick() <= host_now_tick()) {
+      uint64_t t0;
+
+      set_where("sleeptimer callback");
+      t0 = now_ns();
+      host_run_next_timer();
+      account(timing("timer", false), now_ns() - t0);
+      check_balanced();
+      host_power_isr_exit();
+    } else if (bt_mock_take_event(host_now_tick(), &evt)) {
+      const char *name = bt_script_event_name(SL_BT_MSG_ID(evt.header));
+
+      set_where("%s from the stack", name);
+      deliver(&evt, name);
+    } else {
+      radio_wakeups++;
+      bt_mock_advance(host_now_tick());
+    }
+    settle();
+  }
+  advance(target);
+}
+
+/* Fills in what only the stack state at delivery time decides */
+static bool resolve(bt_stim_t *stim)
+{
+  sl_bt_msg_t *e = &stim->evt;
+  uint8_t conn = bt_mock_event_link(e);
+  uint8_t bonding;
+
+  // The central never got in: nothing happens on that link until the
+  // script closes it
+  if (conn != 0xff && missed[conn]) {
+    if (SL_BT_MSG_ID(e->header) == sl_bt_evt_connection_closed_id) {
+      missed[conn] = false;
+    }
+    return false;
+  }
+  if (stim->adv_auto) {
+    uint8_t set = bt_mock_connectable_set();
+
+    if (set == 0xff) {
+      missed[conn] = true;
+      missed_opens++;
+      return false;
+    }
+    e->data.evt_connection_opened.advertiser = set;
+  }
+  if (stim->sync_by_addr) {
+    uint16_t sync = bt_mock_sync_for(&stim->sync_address, stim->sync_sid);
+
+    // No sync, no report: the listener has not synced to this train yet
+    if (sync == 0xffff) {
+      unsynced++;
+      return false;
+    }
+    e->data.evt_periodic_sync_report.sync = sync;
+  }
+  if (stim->bonding_auto) {
+    switch (SL_BT_MSG_ID(e->header)) {
+      case sl_bt_evt_connection_opened_id:
+        e->data.evt_connection_opened.bonding =
+          bt_mock_bonding_for(&e->data.evt_connection_opened.address);
+        break;
+      case sl_bt_evt_sm_confirm_bonding_id:
+        bonding = bt_mock_bonding_for(bt_mock_link_address(
+                                        e->data.evt_sm_confirm_bonding.connection));
+        e->data.evt_sm_confirm_bonding.bonding_handle = bonding == 0xff ? -1 : (int8_t)bonding;
+        break;
+      case sl_bt_evt_sm_bonded_id:
+        bonding = bt_mock_bonding_for(bt_mock_link_address(e->data.evt_sm_bonded.connection));
+        e->data.evt_sm_bonded.bonding = bonding != 0xff ? bonding : bt_mock_new_bonding();
+        break;
+      default:
+        break;
+    }
+  }
+  return true;
+}
+
+static void apply(bt_stim_t *stim, const char *path)
+{
+  uint64_t t0;
+
+  set_where("%s:%u %s", path, stim->line, stim->name);
+  if (record != NULL) {
+    fprintf(record, "%.3f %s\n", bt_script_tick_to_ms(stim->tick), stim->text);
+  }
+  switch (stim->kind) {
+    case BT_STIM_EVENT:
+      if (resolve(stim)) {
+        deliver(&stim->evt, stim->name);
+      }
+      break;
+
+    case BT_STIM_BUTTON:
+      t0 = now_ns();
+      if (host_gpio_drive(stim->u.button.port, stim->u.button.pin, stim->u.button.level)) {
+        account(timing("gpio_isr", false), now_ns() - t0);
+        check_balanced();
+        host_power_isr_exit();
+      }
+      break;
+
+    case BT_STIM_KEY:
+      host_vcom_input(stim->u.bytes.data, stim->u.bytes.len);
+      break;
+
+    case BT_STIM_TEMP:
+      host_set_temperature(stim->u.temp_c);
+      break;
+
+    case BT_STIM_FAIL:
+      bt_mock_fail((bt_cmd_t)stim->u.fail.cmd, stim->u.fail.status, stim->u.fail.count);
+      break;
+
+    case BT_STIM_ATTR:
+      bt_mock_set_attribute(stim->u.bytes.attribute, stim->u.bytes.data, stim->u.bytes.len);
+      break;
+
+    case BT_STIM_RUN:
+      break;
+  }
+  settle();
+}
+
+static double percentile_ns(const timing_t *t, double p)
+{
+  uint64_t want = (uint64_t)(t->count * p);
+  uint64_t seen = 0;
+
+  for (unsigned b = 0; b < HIST_BUCKETS; b++) {
+    seen += t->hist[b];
+    if (seen > want) {
+      double top = bucket_top_ns(b);
+
+      return top < (double)t->max_ns ? top : (double)t->max_ns;
+    }
+  }
+  return (double)t->max_ns;
+}
+
+static int report(double wall_s)
+{
+  const host_power_stats_t *power = host_power_stats();
+  uint64_t handler_ns = 0;
+  uint64_t handler_events = 0;
+  const timing_t *worst = NULL;
+  double sim_s = bt_script_tick_to_ms(host_now_tick()) / 1000.0;
+  double eps;
+  int status = 0;
+
+  printf("\n%-16s %10s %10s %10s %10s\n", "handler", "count", "avg us", "p99 us", "max us");
+  for (int i = 0; i < timing_count; i++) {
+    const timing_t *t = &timings[i];
+
+    printf("%-16s %10llu %10.2f %10.2f %10.2f\n", t->name, (unsigned long long)t->count,
+           t->count ? t->sum_ns / 1000.0 / t->count : 0.0, percentile_ns(t, 0.99) / 1000.0,
+           t->max_ns / 1000.0);
+    if (t->bt_event) {
+      handler_ns += t->sum_ns;
+      handler_events += t->count;
+      // Boot sets everything up once; it is not what a regression is about
+      if (strcmp(t->name, "boot") != 0 && (worst == NULL || t->max_ns > worst->max_ns)) {
+        worst = t;
+      }
+    }
+  }
+  eps = handler_ns ? handler_events * 1e9 / handler_ns : 0;
+  printf("\n%llu events in %.1f s simulated, %.3f s wall: %.0f events/s in sl_bt_on_event, "
+         "%.0f events/s overall\n", (unsigned long long)events, sim_s, wall_s, eps,
+         wall_s > 0 ? events / wall_s : 0.0);
+  if (worst != NULL) {
+    printf("worst event: %s, %.2f us at %s\n", worst->name, worst->max_ns / 1000.0,
+           worst->max_where);
+  }
+  printf("simulated time: EM1 %.3f s, EM2 %.3f s; %u sleeps, %u vetoed, %u ISR wakeups, "
+         "%llu radio wakeups\n",
+         bt_script_tick_to_ms(power->em1_ticks) / 1000.0,
+         bt_script_tick_to_ms(power->em2_ticks) / 1000.0,
+         (unsigned)power->sleeps, (unsigned)power->vetoed, (unsigned)power->isr_wakeups,
+         (unsigned long long)radio_wakeups);
+
+  printf("\n%-44s %10s %8s %8s\n", "stack command", "calls", "failed", "injected");
+  for (int i = 0; i < BT_CMD_COUNT; i++) {
+    const bt_cmd_stats_t *s = bt_mock_cmd_stats((bt_cmd_t)i);
+
+    if (s->calls != 0) {
+      printf("%-44s %10lu %8lu %8lu\n", bt_mock_cmd_name((bt_cmd_t)i), (unsigned long)s->calls,
+             (unsigned long)s->failed, (unsigned long)s->injected);
+    }
+  }
+
+  if (unsynced != 0) {
+    printf("\n%llu sync reports dropped: no sync to that train yet\n",
+           (unsigned long long)unsynced);
+  }
+  if (missed_opens != 0) {
+    printf("%llu connection attempts missed: no connectable advertising running\n",
+           (unsigned long long)missed_opens);
+  }
+  if (rejected != 0) {
+    printf("%llu stimuli the stack could not have produced, first %s\n",
+           (unsigned long long)rejected, first_rejected);
+    if (opt.strict) {
+      status = 1;
+    }
+  }
+  if (busy_loops != 0) {
+    printf("%llu wakeups where the main loop never settled (%d passes)\n",
+           (unsigned long long)busy_loops, SETTLE_MAX);
+  }
+  if (opt.max_us > 0 && worst != NULL && worst->max_ns / 1000.0 > opt.max_us) {
+    printf("FAIL: %s took %.2f us, limit %.2f us\n", worst->name, worst->max_ns / 1000.0,
+           opt.max_us);
+    status = 1;
+  }
+  if (opt.min_eps > 0 && eps < opt.min_eps) {
+    printf("FAIL: %.0f events/s, limit %.0f\n", eps, opt.min_eps);
+    status = 1;
+  }
+  return status;
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [options] [script ...]\n"
+          "  --gen S[:N] --seed N --record FILE --vcom FILE --nvm FILE --swo FILE -v\n"
+          "  --no-auto --tx-slots N --tx-per-ms N --tail MS\n"
+          "  --max-us N --min-eps N --strict\n", prog);
+  exit(2);
+}
+
+static void parse_options(int argc, char **argv)
+{
+  static const struct option options[] = {
+    { "gen", required_argument, NULL, 'g' },
+    { "seed", required_argument, NULL, 's' },
+    { "record", required_argument, NULL, 'r' },
+    { "vcom", required_argument, NULL, 'c' },
+    { "nvm", required_argument, NULL, 'n' },
+    { "swo", required_argument, NULL, 'w' },
+    { "no-auto", no_argument, NULL, 'A' },
+    { "tx-slots", required_argument, NULL, 'T' },
+    { "tx-per-ms", required_argument, NULL, 'R' },
+    { "tail", required_argument, NULL, 't' },
+    { "max-us", required_argument, NULL, 'M' },
+    { "min-eps", required_argument, NULL, 'E' },
+    { "strict", no_argument, NULL, 'S' },
+    { "verbose", no_argument, NULL, 'v' },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 },
+  };
+  char *colon;
+  int c;
+
+  while ((c = getopt_long(argc, argv, "vh", options, NULL)) != -1) {
+    switch (c) {
+      case 'g':
+        opt.gen = optarg;
+        opt.gen_count = 1000;
+        colon = strchr(optarg, ':');
+        if (colon != NULL) {
+          *colon = '\0';
+          opt.gen_count = (unsigned)strtoul(colon + 1, NULL, 0);
+        }
+        break;
+      case 's':
+        opt.seed = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'r':
+        opt.record = optarg;
+        break;
+      case 'c':
+        opt.vcom = optarg;
+        break;
+      case 'n':
+        opt.nvm = optarg;
+        break;
+      case 'w':
+        opt.swo = optarg;
+        break;
+      case 'A':
+        opt.mock.auto_events = false;
+        break;
+      case 'T':
+        opt.mock.tx_slots = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'R':
+        opt.mock.tx_per_ms = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 't':
+        opt.tail_ms = strtod(optarg, NULL);
+        break;
+      case 'M':
+        opt.max_us = strtod(optarg, NULL);
+        break;
+      case 'E':
+        opt.min_eps = strtod(optarg, NULL);
+        break;
+      case 'S':
+        opt.strict = true;
+        break;
+      case 'v':
+        opt.verbose = true;
+        break;
+      default:
+        usage(argv[0]);
+    }
+  }
+  for (; optind < argc && opt.script_count < MAX_SCRIPTS; optind++) {
+    opt.scripts[opt.script_count++] = argv[optind];
+  }
+  if (opt.gen == NULL && opt.script_count == 0) {
+    usage(argv[0]);
+  }
+}
+
+/* Plays one script; returns false if it was broken */
+static bool play(FILE *file, const char *path, uint64_t *last_tick, bool *booted)
+{
+  bt_script_t script;
+  bt_stim_t stim;
+  int r;
+
+  bt_script_open(&script, file, path);
+  script.last_tick = *last_tick;
+  while ((r = bt_script_next(&script, &stim)) > 0) {
+    if (!*booted && !(stim.kind == BT_STIM_EVENT
+                      && stim.evt.header == sl_bt_evt_system_boot_id)) {
+      // The stack always boots first
+      sl_bt_msg_t boot;
+
+      memset(&boot, 0, sizeof(boot));
+      boot.header = sl_bt_evt_system_boot_id;
+      set_where("%s:%u boot, implied", path, stim.line);
+      deliver(&boot, "boot");
+      settle();
+    }
+    *booted = true;
+    run_until(stim.tick);
+    apply(&stim, path);
+  }
+  *last_tick = script.last_tick;
+  return r == 0;
+}
+
+int main(int argc, char **argv)
+{
+  FILE *vcom = NULL;
+  FILE *swo = NULL;
+  FILE *file;
+  uint64_t last_tick = 0;
+  uint64_t t0;
+  bool booted = false;
+  bool ok = true;
+  int status;
+
+  parse_options(argc, argv);
+
+  if (opt.record != NULL) {
+    record = fopen(opt.record, "w");
+    if (record == NULL) {
+      perror(opt.record);
+      return 2;
+    }
+  }
+  if (opt.vcom != NULL) {
+    vcom = fopen(opt.vcom, "w");
+    if (vcom == NULL) {
+      perror(opt.vcom);
+      return 2;
+    }
+  }
+  if (opt.swo != NULL) {
+    swo = fopen(opt.swo, "wb");
+    if (swo == NULL) {
+      perror(opt.swo);
+      return 2;
+    }
+  }
+  host_platform_init();
+  host_vcom_output(vcom, opt.verbose);
+  host_swo_output(swo);
+  if (opt.nvm != NULL && host_nvm_load(opt.nvm) < 0 && opt.verbose) {
+    printf("%s: starting with empty NVM3\n", opt.nvm);
+  }
+  bt_mock_init(&opt.mock);
+
+  t0 = now_ns();
+  app_init();
+  check_balanced();
+
+  if (opt.gen != NULL) {
+    file = tmpfile();
+    if (file == NULL || bt_gen(file, opt.gen, opt.gen_count, opt.seed,
+                               bt_mock_max_links()) < 0) {
+      fprintf(stderr, "unknown scenario %s\n", opt.gen);
+      return 2;
+    }
+    rewind(file);
+    ok = play(file, opt.gen, &last_tick, &booted);
+    fclose(file);
+  }
+  for (int i = 0; ok && i < opt.script_count; i++) {
+    file = fopen(opt.scripts[i], "r");
+    if (file == NULL) {
+      perror(opt.scripts[i]);
+      return 2;
+    }
+    ok = play(file, opt.scripts[i], &last_tick, &booted);
+    fclose(file);
+  }
+  if (!ok) {
+    return 2;
+  }
+  set_where("after the last line");
+  run_until(host_now_tick() + bt_script_ms_to_tick(opt.tail_ms));
+
+  status = report((now_ns() - t0) / 1e9);
+  if (opt.nvm != NULL && host_nvm_save(opt.nvm) < 0) {
+    perror(opt.nvm);
+    status = 2;
+  }
+  if (record != NULL) {
+    fclose(record);
+  }
+  if (vcom != NULL) {
+    fclose(vcom);
+  }
+  if (swo != NULL) {
+    TRACE_FLUSH();
+    fclose(swo);
+  }
+  return status;
+}
@@ -0,0 +1,594 @@
+/* Parser for the bt_host script and trace format, see bt_script.h */
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sl_sleeptimer.h"
+#include "bt_mock.h"
+#include "bt_script.h"
+
+#define MAX_KEYS    16
+
+typedef struct {
+  const char *name;
+  uint32_t id;
+} event_name_t;
+
+static const event_name_t event_names[] = {
+#include "bt_events.inc"
+};
+
+/* gatt_db.h of the application under test, generated by CMakeLists.txt */
+static const struct {
+  const char *name;
+  uint16_t handle;
+} gatt_names[] = {
+#include "bt_gatt_names.inc"
+  { NULL, 0 }
+};
+
+typedef struct {
+  bt_script_t *script;
+  unsigned n;
+  char *key[MAX_KEYS];
+  char *value[MAX_KEYS];
+  bool used[MAX_KEYS];
+  bool failed;
+} args_t;
+
+uint64_t bt_script_ms_to_tick(double ms)
+{
+  return (uint64_t)(ms * HOST_SLEEPTIMER_FREQUENCY / 1000.0 + 0.5);
+}
+
+double bt_script_tick_to_ms(uint64_t tick)
+{
+  return (double)tick * 1000.0 / HOST_SLEEPTIMER_FREQUENCY;
+}
+
+const char *bt_script_event_name(uint32_t id)
+{
+  for (size_t i = 0; i < sizeof(event_names) / sizeof(event_names[0]); i++) {
+    if (event_names[i].id == id) {
+      return event_names[i].name;
+    }
+  }
+  return "other";
+}
+
+int bt_script_char_handle(const char *name)
+{
+  if (strncmp(name, "gattdb_", 7) == 0) {
+    name += 7;
+  }
+  for (int i = 0; gatt_names[i].name != NULL; i++) {
+    if (strcmp(gatt_names[i].name, name) == 0) {
+      return gatt_names[i].handle;
+    }
+  }
+  return -1;
+}
+
+static void error(args_t *args, const char *fmt, const char *what)
+{
+  fprintf(stderr, "%s:%u: ", args->script->path, args->script->line);
+  fprintf(stderr, fmt, what);
+  fprintf(stderr, "\n");
+  args->failed = true;
+}
+
+static const char *arg(args_t *args, const char *key)
+{
+  for (unsigned i = 0; i < args->n; i++) {
+    if (strcmp(args->key[i], key) == 0) {
+      args->used[i] = true;
+      return args->value[i];
+    }
+  }
+  return NULL;
+}
+
+static long num(args_t *args, const char *key, long def)
+{
+  const char *v = arg(args, key);
+  char *end;
+  long n;
+
+  if (v == NULL) {
+    return def;
+  }
+  n = strtol(v, &end, 0);
+  if (*v == '\0' || *end != '\0') {
+    error(args, "bad number for %s", key);
+    return def;
+  }
+  return n;
+}
+
+static int hex_digit(char c)
+{
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  c = (char)tolower((unsigned char)c);
+  return (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+}
+
+/* Hex digits, ':' and '-' are skipped. Returns the length, -1 if bad. */
+static int hex(const char *v, uint8_t *out, size_t max)
+{
+  size_t n = 0;
+  int hi = -1;
+
+  for (; *v != '\0'; v++) {
+    int d;
+
+    if (*v == ':' || *v == '-') {
+      continue;
+    }
+    d = hex_digit(*v);
+    if (d < 0) {
+      return -1;
+    }
+    if (hi < 0) {
+      hi = d;
+    } else {
+      if (n == max) {
+        return -1;
+      }
+      out[n++] = (uint8_t)(hi << 4 | d);
+      hi = -1;
+    }
+  }
+  return hi < 0 ? (int)n : -1;
+}
+
+static size_t data(args_t *args, const char *key, uint8_t *out, size_t max)
+{
+  const char *v = arg(args, key);
+  int n;
+
+  if (v == NULL) {
+    return 0;
+  }
+  n = hex(v, out, max);
+  if (n < 0) {
+    error(args, "bad or too long hex for %s", key);
+    return 0;
+  }
+  return (size_t)n;
+}
+
+static void array(args_t *args, uint8array *a)
+{
+  a->len = (uint8_t)data(args, "data", a->data, sizeof(a->data));
+}
+
+/* bd_addr is little endian, the script writes addresses the way they are
+ * printed */
+static bd_addr address(args_t *args, uint8_t conn)
+{
+  const char *v = arg(args, "addr");
+  bd_addr a = { { conn, 0x00, 0x00, 0x00, 0x00, 0x02 } };
+  uint8_t be[6];
+
+  if (v == NULL) {
+    return a;
+  }
+  if (hex(v, be, sizeof(be)) != 6) {
+    error(args, "bad address for %s", "addr");
+    return a;
+  }
+  for (int i = 0; i < 6; i++) {
+    a.addr[i] = be[5 - i];
+  }
+  return a;
+}
+
+/* bonding=auto: the handle the stack would use, looked up on delivery */
+static long bonding(args_t *args, bt_stim_t *stim, long def)
+{
+  const char *v = arg(args, "bonding");
+
+  if (v != NULL && strcmp(v, "auto") == 0) {
+    stim->bonding_auto = true;
+    return def;
+  }
+  return num(args, "bonding", def);
+}
+
+/* adv=auto: the running connectable set, looked up on delivery */
+static long advertiser(args_t *args, bt_stim_t *stim)
+{
+  const char *v = arg(args, "adv");
+
+  if (v != NULL && strcmp(v, "auto") == 0) {
+    stim->adv_auto = true;
+    return 0;
+  }
+  return num(args, "adv", 0);
+}
+
+static uint16_t characteristic(args_t *args)
+{
+  const char *v = arg(args, "char");
+  char *end;
+  long n;
+  int handle;
+
+  if (v == NULL) {
+    error(args, "%s= missing", "char");
+    return 0;
+  }
+  n = strtol(v, &end, 0);
+  if (*v != '\0' && *end == '\0') {
+    return (uint16_t)n;
+  }
+  handle = bt_script_char_handle(v);
+  if (handle < 0) {
+    error(args, "no characteristic %s in gatt_db.h", v);
+    return 0;
+  }
+  return (uint16_t)handle;
+}
+
+static uint32_t event_id(const char *name)
+{
+  for (size_t i = 0; i < sizeof(event_names) / sizeof(event_names[0]); i++) {
+    if (strcmp(event_names[i].name, name) == 0) {
+      return event_names[i].id;
+    }
+  }
+  return 0;
+}
+
+static void parse_event(args_t *args, bt_stim_t *stim, uint32_t id)
+{
+  sl_bt_msg_t *e = &stim->evt;
+  uint8_t conn = (uint8_t)num(args, "conn", 1);
+
+  memset(e, 0, sizeof(*e));
+  e->header = id;
+  switch (id) {
+    case sl_bt_evt_system_boot_id:
+      e->data.evt_system_boot.major = 7;
+      e->data.evt_system_boot.hash = (uint32_t)num(args, "hash", 0);
+      break;
+
+    case sl_bt_evt_system_external_signal_id:
+      e->data.evt_system_external_signal.extsignals = (uint32_t)num(args, "signals", 0);
+      break;
+
+    case sl_bt_evt_scanner_legacy_advertisement_report_id: {
+      sl_bt_evt_scanner_legacy_advertisement_report_t *r =
+        &e->data.evt_scanner_legacy_advertisement_report;
+      r->address = address(args, conn);
+      r->address_type = (uint8_t)num(args, "type", 0);
+      r->rssi = (int8_t)num(args, "rssi", -60);
+      r->event_flags = (uint8_t)num(args, "flags", 0x13);
+      r->channel = (uint8_t)num(args, "channel", 37);
+      r->bonding = 0xff;
+      array(args, &r->data);
+      break;
+    }
+
+    case sl_bt_evt_scanner_extended_advertisement_report_id: {
+      sl_bt_evt_scanner_extended_advertisement_report_t *r =
+        &e->data.evt_scanner_extended_advertisement_report;
+      r->address = address(args, conn);
+      r->address_type = (uint8_t)num(args, "type", 0);
+      r->rssi = (int8_t)num(args, "rssi", -60);
+      r->event_flags = (uint8_t)num(args, "flags", 0);
+      r->adv_sid = (uint8_t)num(args, "sid", 0);
+      r->periodic_interval = (uint16_t)num(args, "interval", 0);
+      r->primary_phy = sl_bt_gap_phy_1m;
+      r->secondary_phy = (uint8_t)num(args, "phy", sl_bt_gap_phy_2m);
+      r->tx_power = 127;
+      r->bonding = 0xff;
+      r->channel = 0xff;
+      array(args, &r->data);
+      break;
+    }
+
+    case sl_bt_evt_periodic_sync_opened_id: {
+      sl_bt_evt_periodic_sync_opened_t *o = &e->data.evt_periodic_sync_opened;
+      o->sync = (uint16_t)num(args, "sync", 0);
+      o->address = address(args, conn);
+      o->address_type = (uint8_t)num(args, "type", 0);
+      o->adv_sid = (uint8_t)num(args, "sid", 0);
+      o->adv_interval = (uint16_t)num(args, "interval", 800);
+      o->adv_phy = sl_bt_gap_phy_2m;
+      o->bonding = 0xff;
+      break;
+    }
+
+    case sl_bt_evt_periodic_sync_report_id: {
+      sl_bt_evt_periodic_sync_report_t *r = &e->data.evt_periodic_sync_report;
+      if (arg(args, "sync") == NULL) {
+        // Resolved when delivered; the sync handle is not known up front
+        stim->sync_by_addr = true;
+        stim->sync_address = address(args, conn);
+        stim->sync_sid = (uint8_t)num(args, "sid", 0);
+        (void)num(args, "type", 0);
+      }
+      r->sync = (uint16_t)num(args, "sync", 0);
+      r->rssi = (int8_t)num(args, "rssi", -60);
+      r->data_status = (uint8_t)num(args, "status", 0);
+      r->counter = (uint8_t)num(args, "counter", 0);
+      r->tx_power = 127;
+      r->cte_type = 0xff;
+      array(args, &r->data);
+      break;
+    }
+
+    case sl_bt_evt_sync_closed_id:
+      e->data.evt_sync_closed.sync = (uint16_t)num(args, "sync", 0);
+      e->data.evt_sync_closed.reason = (uint16_t)num(args, "reason", 0x3e);
+      break;
+
+    case sl_bt_evt_connection_opened_id:
+      e->data.evt_connection_opened.connection = conn;
+      e->data.evt_connection_opened.address = address(args, conn);
+      e->data.evt_connection_opened.address_type = (uint8_t)num(args, "type", 0);
+      e->data.evt_connection_opened.bonding = (uint8_t)bonding(args, stim, 0xff);
+      e->data.evt_connection_opened.advertiser = (uint8_t)advertiser(args, stim);
+      e->data.evt_connection_opened.master = (uint8_t)num(args, "master", 0);
+      e->data.evt_connection_opened.sync = 0xffff;
+      break;
+
+    case sl_bt_evt_connection_closed_id:
+      e->data.evt_connection_closed.connection = conn;
+      e->data.evt_connection_closed.reason = (uint16_t)num(args, "reason", 0x13);
+      break;
+
+    case sl_bt_evt_connection_parameters_id:
+      e->data.evt_connection_parameters.connection = conn;
+      e->data.evt_connection_parameters.interval = (uint16_t)num(args, "interval", 24);
+      e->data.evt_connection_parameters.latency = (uint16_t)num(args, "latency", 0);
+      e->data.evt_connection_parameters.timeout = (uint16_t)num(args, "timeout", 100);
+      e->data.evt_connection_parameters.security_mode = (uint8_t)num(args, "security", 1);
+      e->data.evt_connection_parameters.txsize = 27;
+      break;
+
+    case sl_bt_evt_connection_phy_status_id:
+      e->data.evt_connection_phy_status.connection = conn;
+      e->data.evt_connection_phy_status.phy = (uint8_t)num(args, "phy", sl_bt_gap_phy_1m);
+      break;
+
+    case sl_bt_evt_connection_data_length_id:
+      e->data.evt_connection_data_length.connection = conn;
+      e->data.evt_connection_data_length.tx_data_len = (uint16_t)num(args, "tx", 251);
+      e->data.evt_connection_data_length.rx_data_len = (uint16_t)num(args, "rx", 251);
+      e->data.evt_connection_data_length.tx_time_us =
+        (e->data.evt_connection_data_length.tx_data_len + 14) * 8;
+      e->data.evt_connection_data_length.rx_time_us =
+        (e->data.evt_connection_data_length.rx_data_len + 14) * 8;
+      break;
+
+    case sl_bt_evt_gatt_mtu_exchanged_id:
+      e->data.evt_gatt_mtu_exchanged.connection = conn;
+      e->data.evt_gatt_mtu_exchanged.mtu = (uint16_t)num(args, "mtu", 247);
+      break;
+
+    case sl_bt_evt_gatt_server_attribute_value_id:
+      e->data.evt_gatt_server_attribute_value.connection = conn;
+      e->data.evt_gatt_server_attribute_value.attribute = characteristic(args);
+      e->data.evt_gatt_server_attribute_value.offset = (uint16_t)num(args, "offset", 0);
+      e->data.evt_gatt_server_attribute_value.att_opcode =
+        num(args, "cmd", 0) ? sl_bt_gatt_write_command : sl_bt_gatt_write_request;
+      array(args, &e->data.evt_gatt_server_attribute_value.value);
+      break;
+
+    case sl_bt_evt_gatt_server_user_read_request_id:
+      e->data.evt_gatt_server_user_read_request.connection = conn;
+      e->data.evt_gatt_server_user_read_request.characteristic = characteristic(args);
+      e->data.evt_gatt_server_user_read_request.offset = (uint16_t)num(args, "offset", 0);
+      e->data.evt_gatt_server_user_read_request.att_opcode =
+        e->data.evt_gatt_server_user_read_request.offset ? sl_bt_gatt_read_blob_request
+        : sl_bt_gatt_read_request;
+      break;
+
+    case sl_bt_evt_gatt_server_user_write_request_id:
+      e->data.evt_gatt_server_user_write_request.connection = conn;
+      e->data.evt_gatt_server_user_write_request.characteristic = characteristic(args);
+      e->data.evt_gatt_server_user_write_request.offset = (uint16_t)num(args, "offset", 0);
+      e->data.evt_gatt_server_user_write_request.att_opcode =
+        num(args, "cmd", 0) ? sl_bt_gatt_write_command : sl_bt_gatt_write_request;
+      array(args, &e->data.evt_gatt_server_user_write_request.value);
+      break;
+
+    case sl_bt_evt_gatt_server_characteristic_status_id:
+      e->data.evt_gatt_server_characteristic_status.connection = conn;
+      e->data.evt_gatt_server_characteristic_status.characteristic = characteristic(args);
+      e->data.evt_gatt_server_characteristic_status.status_flags =
+        (uint8_t)num(args, "flags", sl_bt_gatt_server_client_config);
+      e->data.evt_gatt_server_characteristic_status.client_config_flags =
+        (uint16_t)num(args, "config", 0);
+      break;
+
+    case sl_bt_evt_sm_passkey_display_id:
+      e->data.evt_sm_passkey_display.connection = conn;
+      e->data.evt_sm_passkey_display.passkey = (uint32_t)num(args, "passkey", 0);
+      break;
+
+    case sl_bt_evt_sm_bonded_id:
+      e->data.evt_sm_bonded.connection = conn;
+      e->data.evt_sm_bonded.bonding = (uint8_t)bonding(args, stim, 0);
+      e->data.evt_sm_bonded.security_mode = (uint8_t)num(args, "security", 2);
+      break;
+
+    case sl_bt_evt_sm_bonding_failed_id:
+      e->data.evt_sm_bonding_failed.connection = conn;
+      e->data.evt_sm_bonding_failed.reason = (uint16_t)num(args, "reason", 0x1006);
+      break;
+
+    case sl_bt_evt_sm_confirm_bonding_id:
+      e->data.evt_sm_confirm_bonding.connection = conn;
+      e->data.evt_sm_confirm_bonding.bonding_handle = (int8_t)bonding(args, stim, -1);
+      break;
+
+    default:
+      break;
+  }
+}
+
+static void parse_stimulus(args_t *args, bt_stim_t *stim, const char *what, const char *word)
+{
+  const char *v;
+
+  if (strcmp(what, "button") == 0) {
+    stim->kind = BT_STIM_BUTTON;
+    stim->name = "button";
+    v = arg(args, "port");
+    stim->u.button.port = (v != NULL && toupper((unsigned char)v[0]) >= 'A'
+                           && toupper((unsigned char)v[0]) <= 'D')
+                          ? (GPIO_Port_TypeDef)(toupper((unsigned char)v[0]) - 'A') : gpioPortC;
+    stim->u.button.pin = (unsigned int)num(args, "pin", 7);
+    if (word != NULL && strcmp(word, "down") == 0) {
+      stim->u.button.level = 0;
+    } else if (word != NULL && strcmp(word, "up") == 0) {
+      stim->u.button.level = 1;
+    } else {
+      error(args, "button wants %s", "down or up");
+    }
+  } else if (strcmp(what, "key") == 0) {
+    stim->kind = BT_STIM_KEY;
+    stim->name = "key";
+    v = arg(args, "text");
+    if (v != NULL) {
+      stim->u.bytes.len = strlen(v) < BT_SCRIPT_BYTES_MAX ? strlen(v) : BT_SCRIPT_BYTES_MAX;
+      memcpy(stim->u.bytes.data, v, stim->u.bytes.len);
+    } else {
+      stim->u.bytes.len = data(args, "data", stim->u.bytes.data, BT_SCRIPT_BYTES_MAX);
+    }
+  } else if (strcmp(what, "temp") == 0) {
+    stim->kind = BT_STIM_TEMP;
+    stim->name = "temp";
+    v = arg(args, "c");
+    stim->u.temp_c = v != NULL ? strtof(v, NULL) : 25.0f;
+  } else if (strcmp(what, "fail") == 0) {
+    stim->kind = BT_STIM_FAIL;
+    stim->name = "fail";
+    v = arg(args, "cmd");
+    stim->u.fail.cmd = v != NULL ? bt_mock_find_cmd(v) : -1;
+    if (stim->u.fail.cmd < 0) {
+      error(args, "unknown command %s", v != NULL ? v : "(none)");
+    }
+    stim->u.fail.status = (sl_status_t)num(args, "status", SL_STATUS_NO_MORE_RESOURCE);
+    stim->u.fail.count = (uint32_t)num(args, "count", 1);
+  } else if (strcmp(what, "attr") == 0) {
+    stim->kind = BT_STIM_ATTR;
+    stim->name = "attr";
+    stim->u.bytes.attribute = characteristic(args);
+    stim->u.bytes.len = data(args, "data", stim->u.bytes.data, BT_SCRIPT_BYTES_MAX);
+  } else if (strcmp(what, "run") == 0) {
+    stim->kind = BT_STIM_RUN;
+    stim->name = "run";
+  } else {
+    error(args, "unknown event or stimulus %s", what);
+  }
+}
+
+void bt_script_open(bt_script_t *script, FILE *file, const char *path)
+{
+  script->file = file;
+  script->path = path;
+  script->line = 0;
+  script->last_tick = 0;
+}
+
+int bt_script_next(bt_script_t *script, bt_stim_t *stim)
+{
+  char line[BT_SCRIPT_LINE_MAX];
+  char *p;
+  char *tok;
+  char *save;
+  char *what;
+  char *word = NULL;
+  args_t args;
+  uint32_t id;
+  double ms;
+  bool relative;
+
+  for (;;) {
+    if (fgets(line, sizeof(line), script->file) == NULL) {
+      return 0;
+    }
+    script->line++;
+    p = strchr(line, '#');
+    if (p != NULL) {
+      *p = '\0';
+    }
+    p = line + strlen(line);
+    while (p > line && isspace((unsigned char)p[-1])) {
+      *--p = '\0';
+    }
+    p = line;
+    while (isspace((unsigned char)*p)) {
+      p++;
+    }
+    if (*p != '\0') {
+      break;
+    }
+  }
+
+  memset(&args, 0, sizeof(args));
+  args.script = script;
+  memset(stim, 0, sizeof(*stim));
+  stim->line = script->line;
+
+  tok = strtok_r(p, " \t", &save);
+  relative = tok[0] == '+';
+  ms = strtod(tok + relative, &p);
+  if (*p != '\0' || ms < 0) {
+    error(&args, "bad time %s", tok);
+    return -1;
+  }
+  what = strtok_r(NULL, " \t", &save);
+  if (what == NULL) {
+    error(&args, "%s", "nothing after the time");
+    return -1;
+  }
+  // What follows the time, put back together for --record
+  snprintf(stim->text, sizeof(stim->text), "%s", what);
+  while ((tok = strtok_r(NULL, " \t", &save)) != NULL) {
+    size_t used = strlen(stim->text);
+
+    snprintf(stim->text + used, sizeof(stim->text) - used, " %s", tok);
+    p = strchr(tok, '=');
+    if (p == NULL) {
+      word = tok;
+      continue;
+    }
+    if (args.n == MAX_KEYS) {
+      error(&args, "more than %s keys", "16");
+      return -1;
+    }
+    *p = '\0';
+    args.key[args.n] = tok;
+    args.value[args.n++] = p + 1;
+  }
+
+  stim->tick = relative ? script->last_tick + bt_script_ms_to_tick(ms)
+               : bt_script_ms_to_tick(ms);
+  if (stim->tick < script->last_tick) {
+    error(&args, "time %s goes backwards", what);
+    return -1;
+  }
+  script->last_tick = stim->tick;
+
+  id = event_id(what);
+  if (id != 0) {
+    stim->kind = BT_STIM_EVENT;
+    stim->name = bt_script_event_name(id);
+    parse_event(&args, stim, id);
+  } else {
+    parse_stimulus(&args, stim, what, word);
+  }
+  for (unsigned i = 0; i < args.n; i++) {
+    if (!args.used[i]) {
+      error(&args, "%s= is not a key of this line", args.key[i]);
+    }
+  }
+  return args.failed ? -1 : 1;
+}
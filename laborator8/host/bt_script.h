@@ -0,0 +1,125 @@
+/* Script and trace format of bt_host.
+ *
+ * One stimulus per line, '#' starts a comment:
+ *
+ *   <time> <what> [key=value ...]
+ *
+ * <time> is in simulated milliseconds since start-up, fractions allowed;
+ * "+N" is relative to the line before. Traces written with --record use
+ * absolute times only, so a run replays exactly. <what> is a Bluetooth
+ * event (delivered to sl_bt_on_event) or one of the stimuli below.
+ *
+ * Events and their keys (all optional, defaults in brackets):
+ *   boot
+ *   adv          addr type rssi[-60] flags[0x13] channel data=HEX
+ *   ext_adv      addr type rssi sid[0] interval[0] flags[0x0] data=HEX
+ *   sync_opened  sync addr type sid interval[800]
+ *   sync_report  sync | addr+sid, rssi status[0] counter data=HEX
+ *   sync_closed  sync reason[0x3e]
+ *   open         conn[1] addr type bonding[0xff] adv[0] master[0]
+ *   close        conn reason[0x13]
+ *   params       conn interval[24] latency[0] timeout[100] security[1]
+ *   mtu          conn mtu[247]
+ *   phy          conn phy[1]
+ *   data_len     conn tx[251] rx[251]
+ *   write        conn char offset[0] cmd[0] data=HEX    user write request
+ *   value        conn char offset[0] cmd[0] data=HEX    attribute value
+ *   read         conn char offset[0]                   user read request
+ *   status       conn char flags[1] config[0]           characteristic status
+ *   confirm_bonding conn bonding[-1]
+ *   bonded       conn bonding[0] security[2]
+ *   bond_failed  conn reason[0x1006]
+ *   passkey      conn passkey[0]
+ *
+ * Stimuli:
+ *   button down|up [port=C pin=7]   drives the pin (active low)
+ *   key text=STR | data=HEX         VCOM input
+ *   temp c=FLOAT                    die temperature
+ *   fail cmd=NAME status[0x1a] count[1]   next calls of a command fail
+ *   attr char data=HEX              value read_attribute_value() returns
+ *   run                             nothing; lets the clock run
+ *
+ * bonding=auto stands for the handle the stack would report for the peer
+ * (open, confirm_bonding) or give a new bonding (bonded).
+ * adv=auto connects through whichever connectable set is running. With
+ * none running the central does not get in: the open and the link's
+ * events up to its close are dropped, like a scanner that saw nothing.
+ * char= takes a number or a gatt_db.h name with or without "gattdb_";
+ * addr= takes aa:bb:cc:dd:ee:ff or 12 hex digits, most significant first.
+ */
+#ifndef _BT_SCRIPT_H_
+#define _BT_SCRIPT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "em_gpio.h"
+#include "sl_bt_api.h"
+
+#define BT_SCRIPT_LINE_MAX    1024
+#define BT_SCRIPT_BYTES_MAX   64
+
+typedef enum {
+  BT_STIM_EVENT,
+  BT_STIM_BUTTON,
+  BT_STIM_KEY,
+  BT_STIM_TEMP,
+  BT_STIM_FAIL,
+  BT_STIM_ATTR,
+  BT_STIM_RUN,
+} bt_stim_kind_t;
+
+typedef struct {
+  bt_stim_kind_t kind;
+  uint64_t tick;              /* absolute simulated time */
+  unsigned line;
+  const char *name;           /* the <what> keyword */
+  char text[BT_SCRIPT_LINE_MAX]; /* the line after <time>, for --record */
+  sl_bt_msg_t evt;
+  bool sync_by_addr;          /* sync_report: look the sync up when delivered */
+  bd_addr sync_address;
+  uint8_t sync_sid;
+  bool bonding_auto;          /* open, bonded, confirm_bonding: bonding=auto */
+  bool adv_auto;              /* open: adv=auto */
+  union {
+    struct {
+      GPIO_Port_TypeDef port;
+      unsigned int pin;
+      unsigned int level;
+    } button;
+    struct {
+      uint16_t attribute;
+      size_t len;
+      uint8_t data[BT_SCRIPT_BYTES_MAX];
+    } bytes;
+    float temp_c;
+    struct {
+      int cmd;
+      sl_status_t status;
+      uint32_t count;
+    } fail;
+  } u;
+} bt_stim_t;
+
+typedef struct {
+  FILE *file;
+  const char *path;
+  unsigned line;
+  uint64_t last_tick;
+} bt_script_t;
+
+void bt_script_open(bt_script_t *script, FILE *file, const char *path);
+
+/* 1: a stimulus, 0: end of the script, -1: error (printed) */
+int bt_script_next(bt_script_t *script, bt_stim_t *stim);
+
+/* Name of an event for the report, from the script keywords */
+const char *bt_script_event_name(uint32_t id);
+
+/* gatt_db.h handle for a name, -1 if unknown */
+int bt_script_char_handle(const char *name);
+
+uint64_t bt_script_ms_to_tick(double ms);
+double bt_script_tick_to_ms(uint64_t tick);
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef _HOST_APP_ASSERT_H_
+#define _HOST_APP_ASSERT_H_
+
+#include "sl_status.h"
+
+/* A failed assert stops the run and names the script line that led to it */
+void host_assert_failed(const char *file, int line, const char *expr, const char *fmt, ...)
+__attribute__((noreturn, format(printf, 4, 5)));
+
+#define app_assert(expr, ...) \
+  do { if (!(expr)) host_assert_failed(__FILE__, __LINE__, #expr, __VA_ARGS__); } while (0)
+
+#define app_assert_status(sc) \
+  app_assert((sc) == SL_STATUS_OK, "[E: 0x%04x]", (unsigned)(sc))
+
+#define app_assert_status_f(sc, ...) \
+  app_assert((sc) == SL_STATUS_OK, __VA_ARGS__)
+
+#endif
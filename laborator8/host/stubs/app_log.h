@@ -0,0 +1,22 @@
+#ifndef _HOST_APP_LOG_H_
+#define _HOST_APP_LOG_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* app_log goes to the simulated VCOM, like on the board */
+#define APP_LOG_NEW_LINE  "\n"
+
+int host_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+void host_hexdump(const void *data, size_t len);
+
+#define app_log(...)                  host_printf(__VA_ARGS__)
+#define app_log_debug(...)            host_printf(__VA_ARGS__)
+#define app_log_info(...)             host_printf(__VA_ARGS__)
+#define app_log_warning(...)          host_printf(__VA_ARGS__)
+#define app_log_error(...)            host_printf(__VA_ARGS__)
+#define app_log_append(...)           host_printf(__VA_ARGS__)
+#define app_log_nl()                  host_printf(APP_LOG_NEW_LINE)
+#define app_log_hexdump_info(p, len)  host_hexdump((p), (len))
+
+#endif
@@ -0,0 +1,1090 @@
+/* Bluetooth stack stand-in: the sl_bt_* commands the labs call, answered
+ * from the state bt_mock_on_event() keeps. See bt_mock.h. */
+#include <stdio.h>
+#include <string.h>
+
+#include "sl_sleeptimer.h"
+#include "bt_mock.h"
+
+#if __has_include("sl_bluetooth_connection_config.h")
+#include "sl_bluetooth_connection_config.h"
+#endif
+#if __has_include("sl_bluetooth_advertiser_config.h")
+#include "sl_bluetooth_advertiser_config.h"
+#endif
+
+/* SDK defaults for the projects without a config/ directory */
+#ifndef SL_BT_CONFIG_MAX_CONNECTIONS
+#define SL_BT_CONFIG_MAX_CONNECTIONS      4
+#endif
+#ifndef SL_BT_CONFIG_USER_ADVERTISERS
+#define SL_BT_CONFIG_USER_ADVERTISERS     1
+#endif
+#ifndef SL_BT_CONFIG_MAX_PERIODIC_ADVERTISING_SYNC
+#define SL_BT_CONFIG_MAX_PERIODIC_ADVERTISING_SYNC  4
+#endif
+
+#define MAX_CHARS         8       /* subscriptions tracked per link */
+#define MAX_BONDINGS      32
+#define MAX_ATTRIBUTES    8
+#define MAX_QUEUED        64
+#define MAX_BROADCASTERS  16
+#define SYNC_NONE         0xffff
+
+/* Link updates the stack would negotiate after a request */
+#define UPDATE_DELAY_INTERVALS    6
+#define SYNC_OPEN_DELAY_MS        150
+
+typedef struct {
+  bool open;
+  uint8_t address_type;
+  bd_addr address;
+  uint16_t interval;          /* 1.25 ms units */
+  uint16_t latency;
+  uint16_t timeout;
+  uint8_t security;
+  bool indication_pending;
+  struct {
+    uint16_t characteristic;
+    uint16_t config;
+  } cccd[MAX_CHARS];
+} link_t;
+
+typedef struct {
+  bool created;
+  bool running;
+  bool connectable;
+  bool periodic;
+} adv_set_t;
+
+typedef struct {
+  bool used;
+  bool synced;
+  bd_addr address;
+  uint8_t address_type;
+  uint8_t adv_sid;
+} sync_t;
+
+typedef struct {
+  bd_addr address;
+  uint8_t adv_sid;
+  uint16_t periodic_interval;
+} broadcaster_t;
+
+typedef struct {
+  uint64_t due;
+  uint32_t seq;               /* keeps events due together in order */
+  sl_bt_msg_t evt;
+} queued_t;
+
+typedef struct {
+  uint16_t handle;
+  uint8_t len;
+  uint8_t value[32];
+} attribute_t;
+
+static const char *const cmd_names[BT_CMD_COUNT] = {
+#define BT_MOCK_CMD_NAME(name) #name,
+  BT_MOCK_COMMANDS(BT_MOCK_CMD_NAME)
+#undef BT_MOCK_CMD_NAME
+};
+
+static bt_mock_config_t config;
+static bt_cmd_stats_t cmd_stats[BT_CMD_COUNT];
+static struct {
+  sl_status_t status;
+  uint32_t remaining;         /* 0: until cleared */
+  bool active;
+} inject[BT_CMD_COUNT];
+static uint32_t ok_calls;
+
+static link_t links[256];
+static uint8_t open_links;
+static adv_set_t adv_sets[SL_BT_CONFIG_USER_ADVERTISERS];
+static sync_t syncs[SL_BT_CONFIG_MAX_PERIODIC_ADVERTISING_SYNC];
+static bool sync_opening;
+static broadcaster_t broadcasters[MAX_BROADCASTERS];
+static uint8_t broadcaster_next;
+static struct {
+  bool used;
+  bd_addr address;
+} bondings[MAX_BONDINGS];
+static uint8_t max_bondings = MAX_BONDINGS;
+static attribute_t attributes[MAX_ATTRIBUTES];
+static uint16_t max_mtu = 247;
+
+static queued_t queue[MAX_QUEUED];
+static uint32_t queue_len;
+static uint32_t queue_seq;
+
+static uint32_t signals;
+
+static uint32_t tx_used;
+static uint64_t tx_drained_tick;
+
+static uint64_t ms_to_tick(uint32_t ms)
+{
+  return (uint64_t)ms * HOST_SLEEPTIMER_FREQUENCY / 1000;
+}
+
+static uint64_t interval_tick(uint16_t interval)
+{
+  return (uint64_t)interval * 5 * HOST_SLEEPTIMER_FREQUENCY / 4000;
+}
+
+static sl_status_t result(bt_cmd_t cmd, sl_status_t sc)
+{
+  cmd_stats[cmd].calls++;
+  if (inject[cmd].active) {
+    sc = inject[cmd].status;
+    cmd_stats[cmd].injected++;
+    if (inject[cmd].remaining != 0 && --inject[cmd].remaining == 0) {
+      inject[cmd].active = false;
+    }
+  }
+  if (sc == SL_STATUS_OK) {
+    ok_calls++;
+  } else {
+    cmd_stats[cmd].failed++;
+  }
+  return sc;
+}
+
+/* Whether the command may touch its outputs: an injected failure must
+ * leave them alone like a real one */
+static bool will_fail(bt_cmd_t cmd)
+{
+  return inject[cmd].active;
+}
+
+static void enqueue(uint64_t delay, const sl_bt_msg_t *evt)
+{
+  uint64_t due = sl_sleeptimer_get_tick_count64() + delay;
+  uint32_t i;
+
+  if (!config.auto_events || queue_len == MAX_QUEUED) {
+    return;
+  }
+  // Sorted by due time, FIFO among equals
+  for (i = queue_len; i > 0 && queue[i - 1].due > due; i--) {
+    queue[i] = queue[i - 1];
+  }
+  queue[i].due = due;
+  queue[i].seq = queue_seq++;
+  queue[i].evt = *evt;
+  queue_len++;
+}
+
+/* Link an event is about, 0xff for the others (and for opened/closed,
+ * which are checked on their own) */
+static uint8_t link_of(const sl_bt_msg_t *evt)
+{
+  switch (SL_BT_MSG_ID(evt->header)) {
+    case sl_bt_evt_connection_parameters_id:
+      return evt->data.evt_connection_parameters.connection;
+    case sl_bt_evt_connection_phy_status_id:
+      return evt->data.evt_connection_phy_status.connection;
+    case sl_bt_evt_connection_data_length_id:
+      return evt->data.evt_connection_data_length.connection;
+    case sl_bt_evt_gatt_mtu_exchanged_id:
+      return evt->data.evt_gatt_mtu_exchanged.connection;
+    case sl_bt_evt_gatt_server_attribute_value_id:
+      return evt->data.evt_gatt_server_attribute_value.connection;
+    case sl_bt_evt_gatt_server_user_read_request_id:
+      return evt->data.evt_gatt_server_user_read_request.connection;
+    case sl_bt_evt_gatt_server_user_write_request_id:
+      return evt->data.evt_gatt_server_user_write_request.connection;
+    case sl_bt_evt_gatt_server_characteristic_status_id:
+      return evt->data.evt_gatt_server_characteristic_status.connection;
+    case sl_bt_evt_sm_passkey_display_id:
+      return evt->data.evt_sm_passkey_display.connection;
+    case sl_bt_evt_sm_bonded_id:
+      return evt->data.evt_sm_bonded.connection;
+    case sl_bt_evt_sm_bonding_failed_id:
+      return evt->data.evt_sm_bonding_failed.connection;
+    case sl_bt_evt_sm_confirm_bonding_id:
+      return evt->data.evt_sm_confirm_bonding.connection;
+    default:
+      return 0xff;
+  }
+}
+
+static void drop_queued(uint8_t connection)
+{
+  uint32_t n = 0;
+
+  // Everything queued for a link goes when it closes
+  for (uint32_t i = 0; i < queue_len; i++) {
+    if (link_of(&queue[i].evt) != connection) {
+      queue[n++] = queue[i];
+    }
+  }
+  queue_len = n;
+}
+
+static uint16_t *cccd_of(link_t *link, uint16_t characteristic, bool add)
+{
+  for (int i = 0; i < MAX_CHARS; i++) {
+    if (link->cccd[i].characteristic == characteristic) {
+      return &link->cccd[i].config;
+    }
+  }
+  if (!add) {
+    return NULL;
+  }
+  for (int i = 0; i < MAX_CHARS; i++) {
+    if (link->cccd[i].characteristic == 0) {
+      link->cccd[i].characteristic = characteristic;
+      return &link->cccd[i].config;
+    }
+  }
+  return NULL;
+}
+
+static broadcaster_t *broadcaster(const bd_addr *address, uint8_t adv_sid, bool add)
+{
+  broadcaster_t *b;
+
+  for (int i = 0; i < MAX_BROADCASTERS; i++) {
+    b = &broadcasters[i];
+    if (b->periodic_interval != 0 && b->adv_sid == adv_sid
+        && memcmp(&b->address, address, sizeof(*address)) == 0) {
+      return b;
+    }
+  }
+  if (!add) {
+    return NULL;
+  }
+  // Oldest entry makes room
+  b = &broadcasters[broadcaster_next];
+  broadcaster_next = (broadcaster_next + 1) % MAX_BROADCASTERS;
+  memset(b, 0, sizeof(*b));
+  b->address = *address;
+  b->adv_sid = adv_sid;
+  return b;
+}
+
+void bt_mock_init(const bt_mock_config_t *cfg)
+{
+  config = *cfg;
+  tx_used = 0;
+  tx_drained_tick = 0;
+  for (uint16_t i = 0; i < SL_BT_CONFIG_MAX_PERIODIC_ADVERTISING_SYNC; i++) {
+    syncs[i].used = false;
+  }
+}
+
+bool bt_mock_on_event(const sl_bt_msg_t *evt, const char **why)
+{
+  link_t *link;
+  uint16_t *cccd;
+  uint8_t conn = link_of(evt);
+
+  if (conn != 0xff && !links[conn].open) {
+    *why = "link event on a connection that is not open";
+    return false;
+  }
+  switch (SL_BT_MSG_ID(evt->header)) {
+    case sl_bt_evt_connection_opened_id:
+      link = &links[evt->data.evt_connection_opened.connection];
+      if (link->open) {
+        *why = "connection handle already open";
+        return false;
+      }
+      if (open_links == SL_BT_CONFIG_MAX_CONNECTIONS) {
+        *why = "more links than SL_BT_CONFIG_MAX_CONNECTIONS";
+        return false;
+      }
+      // A central only gets in through a running connectable set
+      if (!evt->data.evt_connection_opened.master
+          && (evt->data.evt_connection_opened.advertiser >= SL_BT_CONFIG_USER_ADVERTISERS
+              || !adv_sets[evt->data.evt_connection_opened.advertiser].running
+              || !adv_sets[evt->data.evt_connection_opened.advertiser].connectable)) {
+        *why = "no connectable advertising on that set";
+        return false;
+      }
+      memset(link, 0, sizeof(*link));
+      link->open = true;
+      link->address = evt->data.evt_connection_opened.address;
+      link->address_type = evt->data.evt_connection_opened.address_type;
+      link->interval = 24;
+      open_links++;
+      // The stack stops a connectable set when a central connects
+      if (!evt->data.evt_connection_opened.master) {
+        adv_sets[evt->data.evt_connection_opened.advertiser].running = false;
+      }
+      return true;
+
+    case sl_bt_evt_connection_closed_id:
+      link = &links[evt->data.evt_connection_closed.connection];
+      if (!link->open) {
+        *why = "closing a connection that is not open";
+        return false;
+      }
+      link->open = false;
+      open_links--;
+      drop_queued(evt->data.evt_connection_closed.connection);
+      return true;
+
+    case sl_bt_evt_connection_parameters_id:
+      link = &links[evt->data.evt_connection_parameters.connection];
+      link->interval = evt->data.evt_connection_parameters.interval;
+      link->latency = evt->data.evt_connection_parameters.latency;
+      link->timeout = evt->data.evt_connection_parameters.timeout;
+      link->security = evt->data.evt_connection_parameters.security_mode;
+      break;
+
+    case sl_bt_evt_gatt_server_characteristic_status_id:
+      link = &links[evt->data.evt_gatt_server_characteristic_status.connection];
+      if (evt->data.evt_gatt_server_characteristic_status.status_flags
+          == sl_bt_gatt_server_confirmation) {
+        link->indication_pending = false;
+      } else {
+        cccd = cccd_of(link, evt->data.evt_gatt_server_characteristic_status.characteristic,
+                       true);
+        if (cccd != NULL) {
+          *cccd = evt->data.evt_gatt_server_characteristic_status.client_config_flags;
+        }
+      }
+      break;
+
+    case sl_bt_evt_scanner_extended_advertisement_report_id:
+      if (evt->data.evt_scanner_extended_advertisement_report.periodic_interval != 0) {
+        broadcaster_t *b =
+          broadcaster(&evt->data.evt_scanner_extended_advertisement_report.address,
+                      evt->data.evt_scanner_extended_advertisement_report.adv_sid, true);
+        b->periodic_interval =
+          evt->data.evt_scanner_extended_advertisement_report.periodic_interval;
+      }
+      return true;
+
+    case sl_bt_evt_periodic_sync_opened_id:
+      if (evt->data.evt_periodic_sync_opened.sync >= SL_BT_CONFIG_MAX_PERIODIC_ADVERTISING_SYNC
+          || !syncs[evt->data.evt_periodic_sync_opened.sync].used) {
+        *why = "sync handle was not opened";
+        return false;
+      }
+      syncs[evt->data.evt_periodic_sync_opened.sync].synced = true;
+      sync_opening = false;
+      return true;
+
+    case sl_bt_evt_sync_closed_id:
+      if (evt->data.evt_sync_closed.sync >= SL_BT_CONFIG_MAX_PERIODIC_ADVERTISING_SYNC
+          || !syncs[evt->data.evt_sync_closed.sync].used) {
+        *why = "sync handle was not opened";
+        return false;
+      }
+      if (!syncs[evt->data.evt_sync_closed.sync].synced) {
+        sync_opening = false;
+      }
+      syncs[evt->data.evt_sync_closed.sync].used = false;
+      syncs[evt->data.evt_sync_closed.sync].synced = false;
+      return true;
+
+    case sl_bt_evt_sm_bonded_id:
+      if (evt->data.evt_sm_bonded.bonding < max_bondings) {
+        bondings[evt->data.evt_sm_bonded.bonding].used = true;
+        bondings[evt->data.evt_sm_bonded.bonding].address =
+          links[evt->data.evt_sm_bonded.connection].address;
+      }
+      return true;
+
+    default:
+      return true;
+  }
+
+  return true;
+}
+
+void bt_mock_advance(uint64_t now_tick)
+{
+  uint64_t freed;
+
+  if (tx_used == 0) {
+    tx_drained_tick = now_tick;
+    return;
+  }
+  if (now_tick <= tx_drained_tick) {
+    return;
+  }
+  freed = (now_tick - tx_drained_tick) * config.tx_per_ms * 1000 / HOST_SLEEPTIMER_FREQUENCY;
+  if (freed == 0) {
+    return;
+  }
+  tx_used = freed >= tx_used ? 0 : tx_used - (uint32_t)freed;
+  tx_drained_tick = now_tick;
+}
+
+uint64_t bt_mock_next_event_tick(void)
+{
+  return queue_len ? queue[0].due : UINT64_MAX;
+}
+
+uint64_t bt_mock_next_radio_tick(void)
+{
+  if (tx_used == 0 || config.tx_per_ms == 0) {
+    return UINT64_MAX;
+  }
+  return tx_drained_tick + ms_to_tick(1);
+}
+
+bool bt_mock_take_event(uint64_t now_tick, sl_bt_msg_t *evt)
+{
+  if (queue_len == 0 || queue[0].due > now_tick) {
+    return false;
+  }
+  *evt = queue[0].evt;
+  queue_len--;
+  memmove(&queue[0], &queue[1], queue_len * sizeof(queue[0]));
+  return true;
+}
+
+uint32_t bt_mock_take_signals(void)
+{
+  uint32_t s = signals;
+
+  signals = 0;
+  return s;
+}
+
+void bt_mock_fail(bt_cmd_t cmd, sl_status_t status, uint32_t count)
+{
+  inject[cmd].status = status;
+  inject[cmd].remaining = count;
+  inject[cmd].active = status != SL_STATUS_OK;
+}
+
+int bt_mock_find_cmd(const char *name)
+{
+  size_t len = strlen(name);
+  int found = -1;
+
+  // The full name, or any unambiguous tail of it: send_indication
+  for (int i = 0; i < BT_CMD_COUNT; i++) {
+    size_t n = strlen(cmd_names[i]);
+
+    if (strcmp(cmd_names[i], name) == 0) {
+      return i;
+    }
+    if (n > len && cmd_names[i][n - len - 1] == '_' && strcmp(cmd_names[i] + n - len, name) == 0) {
+      if (found >= 0) {
+        return -1;
+      }
+      found = i;
+    }
+  }
+  return found;
+}
+
+const char *bt_mock_cmd_name(bt_cmd_t cmd)
+{
+  return cmd_names[cmd];
+}
+
+const bt_cmd_stats_t *bt_mock_cmd_stats(bt_cmd_t cmd)
+{
+  return &cmd_stats[cmd];
+}
+
+uint32_t bt_mock_ok_calls(void)
+{
+  return ok_calls;
+}
+
+uint16_t bt_mock_sync_for(const bd_addr *address, uint8_t adv_sid)
+{
+  for (uint16_t i = 0; i < SL_BT_CONFIG_MAX_PERIODIC_ADVERTISING_SYNC; i++) {
+    if (syncs[i].synced && syncs[i].adv_sid == adv_sid
+        && memcmp(&syncs[i].address, address, sizeof(*address)) == 0) {
+      return i;
+    }
+  }
+  return SYNC_NONE;
+}
+
+void bt_mock_set_attribute(uint16_t attribute, const uint8_t *value, size_t len)
+{
+  attribute_t *free_slot = NULL;
+
+  if (len > sizeof(attributes[0].value)) {
+    len = sizeof(attributes[0].value);
+  }
+  for (int i = 0; i < MAX_ATTRIBUTES; i++) {
+    if (attributes[i].handle == attribute) {
+      free_slot = &attributes[i];
+      break;
+    }
+    if (attributes[i].handle == 0 && free_slot == NULL) {
+      free_slot = &attributes[i];
+    }
+  }
+  if (free_slot != NULL) {
+    free_slot->handle = attribute;
+    free_slot->len = (uint8_t)len;
+    memcpy(free_slot->value, value, len);
+  }
+}
+
+uint8_t bt_mock_open_links(void)
+{
+  return open_links;
+}
+
+const bd_addr *bt_mock_link_address(uint8_t connection)
+{
+  return &links[connection].address;
+}
+
+uint8_t bt_mock_connectable_set(void)
+{
+  for (uint8_t i = 0; i < SL_BT_CONFIG_USER_ADVERTISERS; i++) {
+    if (adv_sets[i].running && adv_sets[i].connectable) {
+      return i;
+    }
+  }
+  return 0xff;
+}
+
+uint8_t bt_mock_event_link(const sl_bt_msg_t *evt)
+{
+  switch (SL_BT_MSG_ID(evt->header)) {
+    case sl_bt_evt_connection_opened_id:
+      return evt->data.evt_connection_opened.connection;
+    case sl_bt_evt_connection_closed_id:
+      return evt->data.evt_connection_closed.connection;
+    default:
+      return link_of(evt);
+  }
+}
+
+uint8_t bt_mock_max_links(void)
+{
+  return SL_BT_CONFIG_MAX_CONNECTIONS;
+}
+
+uint8_t bt_mock_bonding_for(const bd_addr *address)
+{
+  for (uint8_t i = 0; i < max_bondings; i++) {
+    if (bondings[i].used && memcmp(&bondings[i].address, address, sizeof(*address)) == 0) {
+      return i;
+    }
+  }
+  return 0xff;
+}
+
+uint8_t bt_mock_new_bonding(void)
+{
+  for (uint8_t i = 0; i < max_bondings; i++) {
+    if (!bondings[i].used) {
+      return i;
+    }
+  }
+  // The labs configure the stack to overwrite the oldest; which one that
+  // is does not matter here
+  return 0;
+}
+
+/* Commands ---------------------------------------------------------------- */
+
+sl_status_t sl_bt_external_signal(uint32_t s)
+{
+  if (!will_fail(BT_CMD_sl_bt_external_signal)) {
+    signals |= s;
+  }
+  return result(BT_CMD_sl_bt_external_signal, SL_STATUS_OK);
+}
+
+sl_status_t sl_bt_advertiser_create_set(uint8_t *handle)
+{
+  if (will_fail(BT_CMD_sl_bt_advertiser_create_set)) {
+    return result(BT_CMD_sl_bt_advertiser_create_set, SL_STATUS_OK);
+  }
+  for (uint8_t i = 0; i < SL_BT_CONFIG_USER_ADVERTISERS; i++) {
+    if (!adv_sets[i].created) {
+      adv_sets[i].created = true;
+      *handle = i;
+      return result(BT_CMD_sl_bt_advertiser_create_set, SL_STATUS_OK);
+    }
+  }
+  return result(BT_CMD_sl_bt_advertiser_create_set, SL_STATUS_NO_MORE_RESOURCE);
+}
+
+static sl_status_t check_set(uint8_t handle)
+{
+  if (handle >= SL_BT_CONFIG_USER_ADVERTISERS || !adv_sets[handle].created) {
+    return SL_STATUS_INVALID_HANDLE;
+  }
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_advertiser_set_timing(uint8_t advertising_set, uint32_t interval_min,
+                                        uint32_t interval_max, uint16_t duration,
+                                        uint8_t maxevents)
+{
+  sl_status_t sc = check_set(advertising_set);
+
+  (void)duration;
+  (void)maxevents;
+  if (sc == SL_STATUS_OK && (interval_min < 0x20 || interval_max < interval_min)) {
+    sc = SL_STATUS_INVALID_PARAMETER;
+  }
+  return result(BT_CMD_sl_bt_advertiser_set_timing, sc);
+}
+
+sl_status_t sl_bt_advertiser_stop(uint8_t advertising_set)
+{
+  sl_status_t sc = check_set(advertising_set);
+
+  if (sc == SL_STATUS_OK && !will_fail(BT_CMD_sl_bt_advertiser_stop)) {
+    adv_sets[advertising_set].running = false;
+  }
+  return result(BT_CMD_sl_bt_advertiser_stop, sc);
+}
+
+sl_status_t sl_bt_legacy_advertiser_generate_data(uint8_t advertising_set, uint8_t discover)
+{
+  sl_status_t sc = check_set(advertising_set);
+
+  if (sc == SL_STATUS_OK && discover > sl_bt_advertiser_broadcast) {
+    sc = SL_STATUS_INVALID_PARAMETER;
+  }
+  return result(BT_CMD_sl_bt_legacy_advertiser_generate_data, sc);
+}
+
+sl_status_t sl_bt_legacy_advertiser_set_data(uint8_t advertising_set, uint8_t type,
+                                             size_t data_len, const uint8_t *data)
+{
+  sl_status_t sc = check_set(advertising_set);
+
+  (void)data;
+  if (sc == SL_STATUS_OK && (type > sl_bt_advertiser_scan_response_packet || data_len > 31)) {
+    sc = SL_STATUS_INVALID_PARAMETER;
+  }
+  return result(BT_CMD_sl_bt_legacy_advertiser_set_data, sc);
+}
+
+static sl_status_t start_set(uint8_t advertising_set, bool connectable)
+{
+  sl_status_t sc = check_set(advertising_set);
+
+  if (sc != SL_STATUS_OK) {
+    return sc;
+  }
+  // No room for the central a connectable set would accept
+  if (connectable && open_links == SL_BT_CONFIG_MAX_CONNECTIONS) {
+    return SL_STATUS_NO_MORE_RESOURCE;
+  }
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_legacy_advertiser_start(uint8_t advertising_set, uint8_t connect)
+{
+  bool connectable = connect == sl_bt_legacy_advertiser_connectable;
+  sl_status_t sc = start_set(advertising_set, connectable);
+
+  if (sc == SL_STATUS_OK && !will_fail(BT_CMD_sl_bt_legacy_advertiser_start)) {
+    adv_sets[advertising_set].running = true;
+    adv_sets[advertising_set].connectable = connectable;
+  }
+  return result(BT_CMD_sl_bt_legacy_advertiser_start, sc);
+}
+
+sl_status_t sl_bt_extended_advertiser_set_phy(uint8_t advertising_set, uint8_t primary_phy,
+                                              uint8_t secondary_phy)
+{
+  sl_status_t sc = check_set(advertising_set);
+
+  // The primary channels carry 1M or coded only
+  if (sc == SL_STATUS_OK && (primary_phy == sl_bt_gap_phy_2m || secondary_phy == 0)) {
+    sc = SL_STATUS_INVALID_PARAMETER;
+  }
+  return result(BT_CMD_sl_bt_extended_advertiser_set_phy, sc);
+}
+
+sl_status_t sl_bt_extended_advertiser_set_data(uint8_t advertising_set, size_t data_len,
+                                               const uint8_t *data)
+{
+  sl_status_t sc = check_set(advertising_set);
+
+  (void)data;
+  if (sc == SL_STATUS_OK && data_len > 251) {
+    sc = SL_STATUS_INVALID_PARAMETER;
+  }
+  return result(BT_CMD_sl_bt_extended_advertiser_set_data, sc);
+}
+
+sl_status_t sl_bt_extended_advertiser_start(uint8_t advertising_set, uint8_t connect,
+                                            uint32_t flags)
+{
+  bool connectable = connect == sl_bt_extended_advertiser_connectable;
+  sl_status_t sc = start_set(advertising_set, connectable);
+
+  (void)flags;
+  if (sc == SL_STATUS_OK && !will_fail(BT_CMD_sl_bt_extended_advertiser_start)) {
+    adv_sets[advertising_set].running = true;
+    adv_sets[advertising_set].connectable = connectable;
+  }
+  return result(BT_CMD_sl_bt_extended_advertiser_start, sc);
+}
+
+sl_status_t sl_bt_periodic_advertiser_start(uint8_t advertising_set, uint16_t interval_min,
+                                            uint16_t interval_max, uint32_t flags)
+{
+  sl_status_t sc = check_set(advertising_set);
+
+  (void)flags;
+  if (sc == SL_STATUS_OK && (interval_min < 6 || interval_max < interval_min)) {
+    sc = SL_STATUS_INVALID_PARAMETER;
+  }
+  if (sc == SL_STATUS_OK && !will_fail(BT_CMD_sl_bt_periodic_advertiser_start)) {
+    adv_sets[advertising_set].periodic = true;
+  }
+  return result(BT_CMD_sl_bt_periodic_advertiser_start, sc);
+}
+
+sl_status_t sl_bt_periodic_advertiser_set_data(uint8_t advertising_set, size_t data_len,
+                                               const uint8_t *data)
+{
+  sl_status_t sc = check_set(advertising_set);
+
+  (void)data;
+  if (sc == SL_STATUS_OK && !adv_sets[advertising_set].periodic) {
+    sc = SL_STATUS_INVALID_STATE;
+  } else if (sc == SL_STATUS_OK && data_len > 252) {
+    sc = SL_STATUS_INVALID_PARAMETER;
+  }
+  return result(BT_CMD_sl_bt_periodic_advertiser_set_data, sc);
+}
+
+sl_status_t sl_bt_scanner_set_parameters(uint8_t mode, uint16_t interval, uint16_t window)
+{
+  sl_status_t sc = SL_STATUS_OK;
+
+  if (mode > sl_bt_scanner_scan_mode_active || interval < 4 || window < 4 || window > interval) {
+    sc = SL_STATUS_INVALID_PARAMETER;
+  }
+  return result(BT_CMD_sl_bt_scanner_set_parameters, sc);
+}
+
+sl_status_t sl_bt_scanner_start(uint8_t scanning_phy, uint8_t discover_mode)
+{
+  (void)scanning_phy;
+  (void)discover_mode;
+  return result(BT_CMD_sl_bt_scanner_start, SL_STATUS_OK);
+}
+
+sl_status_t sl_bt_scanner_stop(void)
+{
+  return result(BT_CMD_sl_bt_scanner_stop, SL_STATUS_OK);
+}
+
+sl_status_t sl_bt_sync_scanner_set_sync_parameters(uint16_t skip, uint16_t timeout,
+                                                   uint8_t reporting_mode)
+{
+  sl_status_t sc = SL_STATUS_OK;
+
+  (void)skip;
+  if (timeout < 0x0a || timeout > 0x4000 || reporting_mode > sl_bt_sync_report_all) {
+    sc = SL_STATUS_INVALID_PARAMETER;
+  }
+  return result(BT_CMD_sl_bt_sync_scanner_set_sync_parameters, sc);
+}
+
+sl_status_t sl_bt_sync_scanner_open(bd_addr address, uint8_t address_type, uint8_t adv_sid,
+                                    uint16_t *sync)
+{
+  broadcaster_t *b;
+  sl_bt_msg_t evt;
+  uint16_t i;
+
+  if (will_fail(BT_CMD_sl_bt_sync_scanner_open)) {
+    return result(BT_CMD_sl_bt_sync_scanner_open, SL_STATUS_OK);
+  }
+  // The controller takes one pending sync at a time
+  if (sync_opening) {
+    return result(BT_CMD_sl_bt_sync_scanner_open, SL_STATUS_INVALID_STATE);
+  }
+  for (i = 0; i < SL_BT_CONFIG_MAX_PERIODIC_ADVERTISING_SYNC && syncs[i].used; i++) {
+  }
+  if (i == SL_BT_CONFIG_MAX_PERIODIC_ADVERTISING_SYNC) {
+    return result(BT_CMD_sl_bt_sync_scanner_open, SL_STATUS_NO_MORE_RESOURCE);
+  }
+  syncs[i].used = true;
+  syncs[i].synced = false;
+  syncs[i].address = address;
+  syncs[i].address_type = address_type;
+  syncs[i].adv_sid = adv_sid;
+  sync_opening = true;
+  *sync = i;
+
+  b = broadcaster(&address, adv_sid, false);
+  if (b != NULL) {
+    memset(&evt, 0, sizeof(evt));
+    evt.header = sl_bt_evt_periodic_sync_opened_id;
+    evt.data.evt_periodic_sync_opened.sync = i;
+    evt.data.evt_periodic_sync_opened.adv_sid = adv_sid;
+    evt.data.evt_periodic_sync_opened.address = address;
+    evt.data.evt_periodic_sync_opened.address_type = address_type;
+    evt.data.evt_periodic_sync_opened.adv_phy = sl_bt_gap_phy_2m;
+    evt.data.evt_periodic_sync_opened.adv_interval = b->periodic_interval;
+    evt.data.evt_periodic_sync_opened.bonding = 0xff;
+    enqueue(ms_to_tick(SYNC_OPEN_DELAY_MS), &evt);
+  }
+  return result(BT_CMD_sl_bt_sync_scanner_open, SL_STATUS_OK);
+}
+
+static sl_status_t check_link(uint8_t connection)
+{
+  return links[connection].open ? SL_STATUS_OK : SL_STATUS_INVALID_HANDLE;
+}
+
+sl_status_t sl_bt_connection_set_parameters(uint8_t connection, uint16_t min_interval,
+                                            uint16_t max_interval, uint16_t latency,
+                                            uint16_t timeout, uint16_t min_ce_length,
+                                            uint16_t max_ce_length)
+{
+  sl_status_t sc = check_link(connection);
+  link_t *link = &links[connection];
+  sl_bt_msg_t evt;
+
+  (void)min_ce_length;
+  (void)max_ce_length;
+  if (sc == SL_STATUS_OK && (min_interval < 6 || max_interval < min_interval
+                             || max_interval > 3200 || timeout < 10)) {
+    sc = SL_STATUS_INVALID_PARAMETER;
+  }
+  if (sc == SL_STATUS_OK && !will_fail(BT_CMD_sl_bt_connection_set_parameters)) {
+    // The central settles on the longest interval it was offered
+    memset(&evt, 0, sizeof(evt));
+    evt.header = sl_bt_evt_connection_parameters_id;
+    evt.data.evt_connection_parameters.connection = connection;
+    evt.data.evt_connection_parameters.interval = max_interval;
+    evt.data.evt_connection_parameters.latency = latency;
+    evt.data.evt_connection_parameters.timeout = timeout;
+    evt.data.evt_connection_parameters.security_mode = link->security;
+    evt.data.evt_connection_parameters.txsize = 251;
+    enqueue(UPDATE_DELAY_INTERVALS * interval_tick(link->interval), &evt);
+  }
+  return result(BT_CMD_sl_bt_connection_set_parameters, sc);
+}
+
+sl_status_t sl_bt_connection_set_preferred_phy(uint8_t connection, uint8_t preferred_phy,
+                                               uint8_t accepted_phy)
+{
+  sl_status_t sc = check_link(connection);
+  sl_bt_msg_t evt;
+
+  (void)accepted_phy;
+  if (sc == SL_STATUS_OK && !will_fail(BT_CMD_sl_bt_connection_set_preferred_phy)) {
+    memset(&evt, 0, sizeof(evt));
+    evt.header = sl_bt_evt_connection_phy_status_id;
+    evt.data.evt_connection_phy_status.connection = connection;
+    evt.data.evt_connection_phy_status.phy = (preferred_phy & sl_bt_gap_phy_2m)
+                                             ? sl_bt_gap_phy_2m : sl_bt_gap_phy_1m;
+    enqueue(2 * interval_tick(links[connection].interval), &evt);
+  }
+  return result(BT_CMD_sl_bt_connection_set_preferred_phy, sc);
+}
+
+sl_status_t sl_bt_connection_set_data_length(uint8_t connection, uint16_t tx_data_len,
+                                             uint16_t tx_time_us)
+{
+  sl_status_t sc = check_link(connection);
+  sl_bt_msg_t evt;
+
+  (void)tx_time_us;
+  if (sc == SL_STATUS_OK && (tx_data_len < 27 || tx_data_len > 251)) {
+    sc = SL_STATUS_INVALID_PARAMETER;
+  }
+  if (sc == SL_STATUS_OK && !will_fail(BT_CMD_sl_bt_connection_set_data_length)) {
+    memset(&evt, 0, sizeof(evt));
+    evt.header = sl_bt_evt_connection_data_length_id;
+    evt.data.evt_connection_data_length.connection = connection;
+    evt.data.evt_connection_data_length.tx_data_len = tx_data_len;
+    evt.data.evt_connection_data_length.tx_time_us = (tx_data_len + 14) * 8;
+    evt.data.evt_connection_data_length.rx_data_len = 251;
+    evt.data.evt_connection_data_length.rx_time_us = (251 + 14) * 8;
+    enqueue(2 * interval_tick(links[connection].interval), &evt);
+  }
+  return result(BT_CMD_sl_bt_connection_set_data_length, sc);
+}
+
+sl_status_t sl_bt_gatt_server_set_max_mtu(uint16_t mtu, uint16_t *max_mtu_out)
+{
+  sl_status_t sc = SL_STATUS_OK;
+
+  if (mtu < 23 || mtu > 250) {
+    sc = SL_STATUS_INVALID_PARAMETER;
+  } else if (!will_fail(BT_CMD_sl_bt_gatt_server_set_max_mtu)) {
+    max_mtu = mtu;
+    *max_mtu_out = mtu;
+  }
+  return result(BT_CMD_sl_bt_gatt_server_set_max_mtu, sc);
+}
+
+sl_status_t sl_bt_gatt_server_read_attribute_value(uint16_t attribute, uint16_t offset,
+                                                   size_t max_value_size, size_t *value_len,
+                                                   uint8_t *value)
+{
+  for (int i = 0; i < MAX_ATTRIBUTES; i++) {
+    if (attributes[i].handle == attribute && attribute != 0) {
+      size_t n;
+
+      if (offset > attributes[i].len) {
+        return result(BT_CMD_sl_bt_gatt_server_read_attribute_value,
+                      SL_STATUS_INVALID_PARAMETER);
+      }
+      n = attributes[i].len - offset;
+      if (n > max_value_size) {
+        n = max_value_size;
+      }
+      if (!will_fail(BT_CMD_sl_bt_gatt_server_read_attribute_value)) {
+        memcpy(value, &attributes[i].value[offset], n);
+        *value_len = n;
+      }
+      return result(BT_CMD_sl_bt_gatt_server_read_attribute_value, SL_STATUS_OK);
+    }
+  }
+  return result(BT_CMD_sl_bt_gatt_server_read_attribute_value, SL_STATUS_NOT_FOUND);
+}
+
+static sl_status_t send_value(uint8_t connection, uint16_t characteristic, size_t value_len,
+                              uint16_t flag)
+{
+  link_t *link = &links[connection];
+  uint16_t *cccd;
+
+  if (!link->open) {
+    return SL_STATUS_INVALID_HANDLE;
+  }
+  cccd = cccd_of(link, characteristic, false);
+  if (cccd == NULL || !(*cccd & flag)) {
+    return SL_STATUS_INVALID_STATE;
+  }
+  if (value_len > (size_t)max_mtu - 3) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+  if (tx_used >= config.tx_slots) {
+    return SL_STATUS_NO_MORE_RESOURCE;
+  }
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_server_send_notification(uint8_t connection, uint16_t characteristic,
+                                                size_t value_len, const uint8_t *value)
+{
+  sl_status_t sc = send_value(connection, characteristic, value_len, sl_bt_gatt_notification);
+
+  (void)value;
+  if (sc == SL_STATUS_OK && !will_fail(BT_CMD_sl_bt_gatt_server_send_notification)) {
+    tx_used++;
+  }
+  return result(BT_CMD_sl_bt_gatt_server_send_notification, sc);
+}
+
+sl_status_t sl_bt_gatt_server_send_indication(uint8_t connection, uint16_t characteristic,
+                                              size_t value_len, const uint8_t *value)
+{
+  sl_status_t sc = send_value(connection, characteristic, value_len, sl_bt_gatt_indication);
+  link_t *link = &links[connection];
+  sl_bt_msg_t evt;
+
+  (void)value;
+  // ATT allows one outstanding indication per link
+  if (sc == SL_STATUS_OK && link->indication_pending) {
+    sc = SL_STATUS_INVALID_STATE;
+  }
+  if (sc == SL_STATUS_OK && !will_fail(BT_CMD_sl_bt_gatt_server_send_indication)) {
+    tx_used++;
+    link->indication_pending = true;
+    memset(&evt, 0, sizeof(evt));
+    evt.header = sl_bt_evt_gatt_server_characteristic_status_id;
+    evt.data.evt_gatt_server_characteristic_status.connection = connection;
+    evt.data.evt_gatt_server_characteristic_status.characteristic = characteristic;
+    evt.data.evt_gatt_server_characteristic_status.status_flags = sl_bt_gatt_server_confirmation;
+    enqueue(2 * interval_tick(link->interval), &evt);
+  }
+  return result(BT_CMD_sl_bt_gatt_server_send_indication, sc);
+}
+
+sl_status_t sl_bt_gatt_server_send_user_read_response(uint8_t connection,
+                                                      uint16_t characteristic,
+                                                      uint8_t att_errorcode,
+                                                      size_t value_len,
+                                                      const uint8_t *value,
+                                                      uint16_t *sent_len)
+{
+  sl_status_t sc = check_link(connection);
+
+  (void)characteristic;
+  (void)att_errorcode;
+  (void)value;
+  if (sc == SL_STATUS_OK && !will_fail(BT_CMD_sl_bt_gatt_server_send_user_read_response)) {
+    *sent_len = (uint16_t)(value_len < (size_t)max_mtu - 1 ? value_len : (size_t)max_mtu - 1);
+  }
+  return result(BT_CMD_sl_bt_gatt_server_send_user_read_response, sc);
+}
+
+sl_status_t sl_bt_gatt_server_send_user_write_response(uint8_t connection,
+                                                       uint16_t characteristic,
+                                                       uint8_t att_errorcode)
+{
+  (void)characteristic;
+  (void)att_errorcode;
+  return result(BT_CMD_sl_bt_gatt_server_send_user_write_response, check_link(connection));
+}
+
+sl_status_t sl_bt_sm_configure(uint8_t flags, uint8_t io_capabilities)
+{
+  (void)flags;
+  return result(BT_CMD_sl_bt_sm_configure,
+                io_capabilities > sl_bt_sm_io_capability_keyboarddisplay
+                ? SL_STATUS_INVALID_PARAMETER : SL_STATUS_OK);
+}
+
+sl_status_t sl_bt_sm_set_passkey(int32_t passkey)
+{
+  return result(BT_CMD_sl_bt_sm_set_passkey,
+                passkey > 999999 ? SL_STATUS_INVALID_PARAMETER : SL_STATUS_OK);
+}
+
+sl_status_t sl_bt_sm_set_bondable_mode(uint8_t bondable)
+{
+  (void)bondable;
+  return result(BT_CMD_sl_bt_sm_set_bondable_mode, SL_STATUS_OK);
+}
+
+sl_status_t sl_bt_sm_increase_security(uint8_t connection)
+{
+  return result(BT_CMD_sl_bt_sm_increase_security, check_link(connection));
+}
+
+sl_status_t sl_bt_sm_store_bonding_configuration(uint8_t max_bonding_count,
+                                                 uint8_t policy_flags)
+{
+  (void)policy_flags;
+  if (max_bonding_count == 0 || max_bonding_count > MAX_BONDINGS) {
+    return result(BT_CMD_sl_bt_sm_store_bonding_configuration, SL_STATUS_INVALID_PARAMETER);
+  }
+  if (!will_fail(BT_CMD_sl_bt_sm_store_bonding_configuration)) {
+    max_bondings = max_bonding_count;
+  }
+  return result(BT_CMD_sl_bt_sm_store_bonding_configuration, SL_STATUS_OK);
+}
+
+sl_status_t sl_bt_sm_delete_bonding(uint8_t bonding)
+{
+  if (bonding >= max_bondings || !bondings[bonding].used) {
+    return result(BT_CMD_sl_bt_sm_delete_bonding, SL_STATUS_NOT_FOUND);
+  }
+  if (!will_fail(BT_CMD_sl_bt_sm_delete_bonding)) {
+    bondings[bonding].used = false;
+  }
+  return result(BT_CMD_sl_bt_sm_delete_bonding, SL_STATUS_OK);
+}
+
+sl_status_t sl_bt_sm_bonding_confirm(uint8_t connection, uint8_t confirm)
+{
+  (void)confirm;
+  return result(BT_CMD_sl_bt_sm_bonding_confirm, check_link(connection));
+}
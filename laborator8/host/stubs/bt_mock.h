@@ -0,0 +1,127 @@
+#ifndef _BT_MOCK_H_
+#define _BT_MOCK_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sl_bt_api.h"
+
+/* Harness side of the Bluetooth mock in bt_mock.c.
+ *
+ * The mock keeps just enough stack state to answer commands the way the
+ * stack would: advertising sets, open links with their interval and
+ * subscriptions, a TX buffer pool that drains with simulated time, sync
+ * handles and bondings. Events the stack would raise in reply to a
+ * command (indication confirmations, link updates after a request,
+ * a sync after an open) are queued with a due time for the harness to
+ * deliver; --no-auto leaves them all to the script. */
+
+#define BT_MOCK_COMMANDS(X)                   \
+  X(sl_bt_external_signal)                    \
+  X(sl_bt_advertiser_create_set)              \
+  X(sl_bt_advertiser_set_timing)              \
+  X(sl_bt_advertiser_stop)                    \
+  X(sl_bt_legacy_advertiser_generate_data)    \
+  X(sl_bt_legacy_advertiser_set_data)         \
+  X(sl_bt_legacy_advertiser_start)            \
+  X(sl_bt_extended_advertiser_set_phy)        \
+  X(sl_bt_extended_advertiser_set_data)       \
+  X(sl_bt_extended_advertiser_start)          \
+  X(sl_bt_periodic_advertiser_start)          \
+  X(sl_bt_periodic_advertiser_set_data)       \
+  X(sl_bt_scanner_set_parameters)             \
+  X(sl_bt_scanner_start)                      \
+  X(sl_bt_scanner_stop)                       \
+  X(sl_bt_sync_scanner_set_sync_parameters)   \
+  X(sl_bt_sync_scanner_open)                  \
+  X(sl_bt_connection_set_parameters)          \
+  X(sl_bt_connection_set_preferred_phy)       \
+  X(sl_bt_connection_set_data_length)         \
+  X(sl_bt_gatt_server_set_max_mtu)            \
+  X(sl_bt_gatt_server_read_attribute_value)   \
+  X(sl_bt_gatt_server_send_notification)      \
+  X(sl_bt_gatt_server_send_indication)        \
+  X(sl_bt_gatt_server_send_user_read_response) \
+  X(sl_bt_gatt_server_send_user_write_response) \
+  X(sl_bt_sm_configure)                       \
+  X(sl_bt_sm_set_passkey)                     \
+  X(sl_bt_sm_set_bondable_mode)               \
+  X(sl_bt_sm_increase_security)               \
+  X(sl_bt_sm_store_bonding_configuration)     \
+  X(sl_bt_sm_delete_bonding)                  \
+  X(sl_bt_sm_bonding_confirm)
+
+#define BT_MOCK_CMD_ENUM(name) BT_CMD_##name,
+typedef enum {
+  BT_MOCK_COMMANDS(BT_MOCK_CMD_ENUM)
+  BT_CMD_COUNT
+} bt_cmd_t;
+#undef BT_MOCK_CMD_ENUM
+
+typedef struct {
+  uint32_t calls;
+  uint32_t failed;            /* returned anything but SL_STATUS_OK */
+  uint32_t injected;          /* of those, failures asked for by the script */
+} bt_cmd_stats_t;
+
+typedef struct {
+  uint32_t tx_slots;          /* notification/indication buffers */
+  uint32_t tx_per_ms;         /* buffers the radio frees per simulated ms */
+  bool auto_events;
+} bt_mock_config_t;
+
+void bt_mock_init(const bt_mock_config_t *config);
+
+/* Keeps the link, subscription and sync state in step with an event the
+ * harness is about to deliver. Returns false (with a reason) for an event
+ * the stack could not raise, e.g. a fifth link on a four-link config. */
+bool bt_mock_on_event(const sl_bt_msg_t *evt, const char **why);
+
+/* Called by the harness as simulated time moves on */
+void bt_mock_advance(uint64_t now_tick);
+
+/* Earliest queued stack event, UINT64_MAX if none */
+uint64_t bt_mock_next_event_tick(void);
+bool bt_mock_take_event(uint64_t now_tick, sl_bt_msg_t *evt);
+
+/* While buffers are queued the radio keeps the stack, and with it the main
+ * loop, running: next time buffers are freed, UINT64_MAX when idle */
+uint64_t bt_mock_next_radio_tick(void);
+
+/* Signals raised by sl_bt_external_signal() since the last call */
+uint32_t bt_mock_take_signals(void);
+
+/* Fail the next count calls of a command (0: every call) with status.
+ * Commands are found by full name or an unambiguous tail of it. */
+void bt_mock_fail(bt_cmd_t cmd, sl_status_t status, uint32_t count);
+int bt_mock_find_cmd(const char *name);
+const char *bt_mock_cmd_name(bt_cmd_t cmd);
+const bt_cmd_stats_t *bt_mock_cmd_stats(bt_cmd_t cmd);
+
+/* Commands answered with SL_STATUS_OK since start-up; the harness keeps
+ * calling app_process_action() while this moves */
+uint32_t bt_mock_ok_calls(void);
+
+/* Open sync for a broadcaster, 0xffff if none */
+uint16_t bt_mock_sync_for(const bd_addr *address, uint8_t adv_sid);
+
+/* Values for sl_bt_gatt_server_read_attribute_value() */
+void bt_mock_set_attribute(uint16_t attribute, const uint8_t *value, size_t len);
+
+uint8_t bt_mock_open_links(void);
+uint8_t bt_mock_max_links(void);
+const bd_addr *bt_mock_link_address(uint8_t connection);
+
+/* Running connectable advertising set a central could connect through,
+ * 0xff if none */
+uint8_t bt_mock_connectable_set(void);
+
+/* Connection an event is about, opened and closed included; 0xff if none */
+uint8_t bt_mock_event_link(const sl_bt_msg_t *evt);
+
+/* Bonding the stack would report for a peer, 0xff if none, and the handle
+ * a new bonding would get */
+uint8_t bt_mock_bonding_for(const bd_addr *address);
+uint8_t bt_mock_new_bonding(void);
+
+#endif
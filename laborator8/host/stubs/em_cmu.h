@@ -0,0 +1,14 @@
+#ifndef _HOST_EM_CMU_H_
+#define _HOST_EM_CMU_H_
+
+#include <stdbool.h>
+#include "em_device.h"
+
+typedef enum {
+  cmuClock_GPIO,
+  cmuClock_PRS,
+} CMU_Clock_TypeDef;
+
+void CMU_ClockEnable(CMU_Clock_TypeDef clock, bool enable);
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef _HOST_EM_COMMON_H_
+#define _HOST_EM_COMMON_H_
+
+#define SL_WEAK             __attribute__((weak))
+#define SL_ATTRIBUTE_PACKED __attribute__((packed))
+
+#endif
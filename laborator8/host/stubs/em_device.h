@@ -0,0 +1,37 @@
+#ifndef _HOST_EM_DEVICE_H_
+#define _HOST_EM_DEVICE_H_
+
+#include <stdint.h>
+
+/* BG22 core clock with the 38.4 MHz HFXO doubled */
+extern uint32_t SystemCoreClock;
+
+typedef struct {
+  volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+typedef struct {
+  volatile uint32_t CTRL;
+  volatile uint32_t CYCCNT;
+} DWT_Type;
+
+#define CoreDebug_DEMCR_TRCENA_Msk  (1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk      (1UL << 0)
+
+/* Every DWT access samples the host clock scaled to SystemCoreClock, so
+ * the cycle counts the labs take are real host time. */
+DWT_Type *host_dwt(void);
+extern CoreDebug_Type host_core_debug;
+#define DWT         (host_dwt())
+#define CoreDebug   (&host_core_debug)
+
+typedef enum {
+  GPIO_EVEN_IRQn,
+  GPIO_ODD_IRQn,
+} IRQn_Type;
+
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef _HOST_EM_EMU_H_
+#define _HOST_EM_EMU_H_
+
+#include "em_device.h"
+
+/* Die temperature in C, set from the script ("temp c=...") */
+float EMU_TemperatureGet(void);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef _HOST_EM_GPIO_H_
+#define _HOST_EM_GPIO_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "em_device.h"
+
+/* Pin levels and external interrupts of a four-port device. Input pins
+ * read their pull (the DOUT bit) until the script drives them; an edge on
+ * a pin with an enabled external interrupt runs GPIO_EVEN/ODD_IRQHandler. */
+typedef enum {
+  gpioPortA,
+  gpioPortB,
+  gpioPortC,
+  gpioPortD,
+} GPIO_Port_TypeDef;
+
+typedef enum {
+  gpioModeDisabled,
+  gpioModeInput,
+  gpioModeInputPull,
+  gpioModeInputPullFilter,
+  gpioModePushPull,
+  gpioModeWiredAnd,
+} GPIO_Mode_TypeDef;
+
+void GPIO_PinModeSet(GPIO_Port_TypeDef port, unsigned int pin,
+                     GPIO_Mode_TypeDef mode, unsigned int out);
+unsigned int GPIO_PinInGet(GPIO_Port_TypeDef port, unsigned int pin);
+unsigned int GPIO_PinOutGet(GPIO_Port_TypeDef port, unsigned int pin);
+void GPIO_PinOutSet(GPIO_Port_TypeDef port, unsigned int pin);
+void GPIO_PinOutClear(GPIO_Port_TypeDef port, unsigned int pin);
+void GPIO_PinOutToggle(GPIO_Port_TypeDef port, unsigned int pin);
+void GPIO_ExtIntConfig(GPIO_Port_TypeDef port, unsigned int pin, unsigned int intNo,
+                       bool risingEdge, bool fallingEdge, bool enable);
+uint32_t GPIO_IntGet(void);
+uint32_t GPIO_IntGetEnabled(void);
+void GPIO_IntClear(uint32_t flags);
+
+void GPIO_EVEN_IRQHandler(void);
+void GPIO_ODD_IRQHandler(void);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef _HOST_COMPAT_H_
+#define _HOST_COMPAT_H_
+
+/* Forced into the lab sources only: their stdout (iostream_retarget_stdio
+ * on the board) goes to the simulated VCOM */
+#include <stdio.h>
+
+int host_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+#define printf(...)   host_printf(__VA_ARGS__)
+
+#endif
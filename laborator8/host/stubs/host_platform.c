@@ -0,0 +1,775 @@
+/* Host stand-ins for the emlib, sleeptimer, power manager, NVM3, iostream
+ * and app_log pieces the labs use. See host_platform.h. */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "em_cmu.h"
+#include "em_common.h"
+#include "em_device.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "app_assert.h"
+#include "app_log.h"
+#include "nvm3_default.h"
+#include "sl_core.h"
+#include "sl_debug_swo.h"
+#include "sl_iostream_usart_vcom.h"
+#include "sl_power_manager.h"
+#include "sl_sleeptimer.h"
+#include "host_platform.h"
+
+#define GPIO_PORTS        4
+#define GPIO_PINS         16
+#define NVM_OBJECTS       64
+#define VCOM_INPUT_SIZE   1024
+
+uint32_t SystemCoreClock = 76800000;
+CoreDebug_Type host_core_debug;
+int host_core_atomic_depth;
+
+static uint64_t now;
+static sl_sleeptimer_timer_handle_t *timers;
+static const char *context = "start-up";
+
+/* Clock and DWT ----------------------------------------------------------- */
+
+uint64_t host_now_tick(void)
+{
+  return now;
+}
+
+DWT_Type *host_dwt(void)
+{
+  static DWT_Type dwt;
+  static struct timespec start;
+  struct timespec ts;
+  uint64_t ns;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  if (start.tv_sec == 0 && start.tv_nsec == 0) {
+    start = ts;
+  }
+  if (dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk) {
+    ns = (uint64_t)(ts.tv_sec - start.tv_sec) * 1000000000u + (uint64_t)ts.tv_nsec
+         - (uint64_t)start.tv_nsec;
+    dwt.CYCCNT = (uint32_t)(ns * (SystemCoreClock / 1000000) / 1000);
+  }
+  return &dwt;
+}
+
+/* Sleeptimer -------------------------------------------------------------- */
+
+static void timer_unlink(sl_sleeptimer_timer_handle_t *handle)
+{
+  sl_sleeptimer_timer_handle_t **link = &timers;
+
+  while (*link != NULL && *link != handle) {
+    link = &(*link)->next;
+  }
+  if (*link == handle) {
+    *link = handle->next;
+  }
+  handle->next = NULL;
+  handle->running = false;
+}
+
+static void timer_insert(sl_sleeptimer_timer_handle_t *handle)
+{
+  sl_sleeptimer_timer_handle_t **link = &timers;
+
+  // Expiry order, FIFO among equals like the RTCC driver
+  while (*link != NULL && (*link)->expiry <= handle->expiry) {
+    link = &(*link)->next;
+  }
+  handle->next = *link;
+  *link = handle;
+  handle->running = true;
+}
+
+static sl_status_t timer_start(sl_sleeptimer_timer_handle_t *handle, uint32_t timeout,
+                               uint32_t period, sl_sleeptimer_timer_callback_t callback,
+                               void *callback_data, uint8_t priority, uint16_t option_flags)
+{
+  if (handle == NULL) {
+    return SL_STATUS_NULL_POINTER;
+  }
+  if (handle->running) {
+    return SL_STATUS_NOT_READY;
+  }
+  handle->callback = callback;
+  handle->callback_data = callback_data;
+  handle->priority = priority;
+  handle->option_flags = option_flags;
+  handle->timeout_periodic = period;
+  handle->expiry = now + timeout;
+  timer_insert(handle);
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_sleeptimer_start_timer(sl_sleeptimer_timer_handle_t *handle, uint32_t timeout,
+                                      sl_sleeptimer_timer_callback_t callback,
+                                      void *callback_data, uint8_t priority,
+                                      uint16_t option_flags)
+{
+  return timer_start(handle, timeout, 0, callback, callback_data, priority, option_flags);
+}
+
+sl_status_t sl_sleeptimer_start_timer_ms(sl_sleeptimer_timer_handle_t *handle,
+                                         uint32_t timeout_ms,
+                                         sl_sleeptimer_timer_callback_t callback,
+                                         void *callback_data, uint8_t priority,
+                                         uint16_t option_flags)
+{
+  uint32_t ticks = 0;
+
+  sl_sleeptimer_ms32_to_tick(timeout_ms, &ticks);
+  return timer_start(handle, ticks, 0, callback, callback_data, priority, option_flags);
+}
+
+sl_status_t sl_sleeptimer_start_periodic_timer(sl_sleeptimer_timer_handle_t *handle,
+                                               uint32_t timeout,
+                                               sl_sleeptimer_timer_callback_t callback,
+                                               void *callback_data, uint8_t priority,
+                                               uint16_t option_flags)
+{
+  if (timeout == 0) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+  return timer_start(handle, timeout, timeout, callback, callback_data, priority,
+                     option_flags);
+}
+
+sl_status_t sl_sleeptimer_start_periodic_timer_ms(sl_sleeptimer_timer_handle_t *handle,
+                                                  uint32_t timeout_ms,
+                                                  sl_sleeptimer_timer_callback_t callback,
+                                                  void *callback_data, uint8_t priority,
+                                                  uint16_t option_flags)
+{
+  uint32_t ticks = 0;
+
+  sl_sleeptimer_ms32_to_tick(timeout_ms, &ticks);
+  return sl_sleeptimer_start_periodic_timer(handle, ticks, callback, callback_data, priority,
+                                            option_flags);
+}
+
+sl_status_t sl_sleeptimer_stop_timer(sl_sleeptimer_timer_handle_t *handle)
+{
+  if (handle == NULL) {
+    return SL_STATUS_NULL_POINTER;
+  }
+  if (!handle->running) {
+    return SL_STATUS_INVALID_STATE;
+  }
+  timer_unlink(handle);
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_sleeptimer_is_timer_running(sl_sleeptimer_timer_handle_t *handle,
+                                           bool *running)
+{
+  if (handle == NULL || running == NULL) {
+    return SL_STATUS_NULL_POINTER;
+  }
+  *running = handle->running;
+  return SL_STATUS_OK;
+}
+
+uint32_t sl_sleeptimer_get_tick_count(void)
+{
+  return (uint32_t)now;
+}
+
+uint64_t sl_sleeptimer_get_tick_count64(void)
+{
+  return now;
+}
+
+uint32_t sl_sleeptimer_get_timer_frequency(void)
+{
+  return HOST_SLEEPTIMER_FREQUENCY;
+}
+
+uint32_t sl_sleeptimer_tick_to_ms(uint32_t tick)
+{
+  return (uint32_t)((uint64_t)tick * 1000 / HOST_SLEEPTIMER_FREQUENCY);
+}
+
+sl_status_t sl_sleeptimer_tick64_to_ms(uint64_t tick, uint64_t *ms)
+{
+  if (ms == NULL) {
+    return SL_STATUS_NULL_POINTER;
+  }
+  if (tick > UINT64_MAX / 1000) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+  *ms = tick * 1000 / HOST_SLEEPTIMER_FREQUENCY;
+  return SL_STATUS_OK;
+}
+
+uint32_t sl_sleeptimer_ms_to_tick(uint16_t time_ms)
+{
+  return (uint32_t)time_ms * HOST_SLEEPTIMER_FREQUENCY / 1000;
+}
+
+sl_status_t sl_sleeptimer_ms32_to_tick(uint32_t time_ms, uint32_t *tick)
+{
+  uint64_t t = (uint64_t)time_ms * HOST_SLEEPTIMER_FREQUENCY / 1000;
+
+  if (tick == NULL) {
+    return SL_STATUS_NULL_POINTER;
+  }
+  if (t > UINT32_MAX) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+  *tick = (uint32_t)t;
+  return SL_STATUS_OK;
+}
+
+uint64_t host_next_timer_tick(void)
+{
+  return timers != NULL ? timers->expiry : UINT64_MAX;
+}
+
+bool host_run_next_timer(void)
+{
+  sl_sleeptimer_timer_handle_t *handle = timers;
+
+  if (handle == NULL || handle->expiry > now) {
+    return false;
+  }
+  timer_unlink(handle);
+  if (handle->timeout_periodic != 0) {
+    handle->expiry += handle->timeout_periodic;
+    timer_insert(handle);
+  }
+  // The callback may restart or stop its own timer
+  handle->callback(handle, handle->callback_data);
+  return true;
+}
+
+/* Power manager ------------------------------------------------------------ */
+
+static uint32_t em1_requirements;
+static host_power_stats_t power;
+static sl_power_manager_em_transition_event_handle_t *em_subscribers;
+static bool asleep;
+static sl_power_manager_em_t sleep_em;
+
+void sl_power_manager_subscribe_em_transition_event(
+  sl_power_manager_em_transition_event_handle_t *event_handle,
+  const sl_power_manager_em_transition_event_info_t *event_info)
+{
+  event_handle->info = event_info;
+  event_handle->next = em_subscribers;
+  em_subscribers = event_handle;
+}
+
+static void em_transition(sl_power_manager_em_t from, sl_power_manager_em_t to)
+{
+  // ENTERING_EMn is bit 2n, LEAVING_EMn bit 2n + 1
+  uint32_t mask = (1UL << (2 * to)) | (1UL << (2 * from + 1));
+
+  for (sl_power_manager_em_transition_event_handle_t *h = em_subscribers; h != NULL;
+       h = h->next) {
+    if (h->info->event_mask & mask) {
+      h->info->on_event(from, to);
+    }
+  }
+}
+
+void sl_power_manager_add_em_requirement(sl_power_manager_em_t em)
+{
+  if (em == SL_POWER_MANAGER_EM1) {
+    em1_requirements++;
+  }
+}
+
+void sl_power_manager_remove_em_requirement(sl_power_manager_em_t em)
+{
+  if (em == SL_POWER_MANAGER_EM1) {
+    app_assert(em1_requirements > 0, "EM1 requirement removed more often than added\n");
+    em1_requirements--;
+  }
+}
+
+SL_WEAK bool app_is_ok_to_sleep(void)
+{
+  return true;
+}
+
+SL_WEAK sl_power_manager_on_isr_exit_t app_sleep_on_isr_exit(void)
+{
+  return SL_POWER_MANAGER_IGNORE;
+}
+
+void host_set_now(uint64_t tick)
+{
+  if (tick > now) {
+    if (em1_requirements > 0) {
+      power.em1_ticks += tick - now;
+    } else {
+      power.em2_ticks += tick - now;
+    }
+    now = tick;
+  }
+  // Whatever moves the clock is what woke the core
+  if (asleep) {
+    asleep = false;
+    em_transition(sleep_em, SL_POWER_MANAGER_EM0);
+  }
+}
+
+bool host_power_try_sleep(void)
+{
+  if (!app_is_ok_to_sleep()) {
+    power.vetoed++;
+    return false;
+  }
+  power.sleeps++;
+  sleep_em = em1_requirements > 0 ? SL_POWER_MANAGER_EM1 : SL_POWER_MANAGER_EM2;
+  if (!asleep) {
+    asleep = true;
+    em_transition(SL_POWER_MANAGER_EM0, sleep_em);
+  }
+  return true;
+}
+
+bool host_power_isr_exit(void)
+{
+  if (app_sleep_on_isr_exit() == SL_POWER_MANAGER_WAKEUP) {
+    power.isr_wakeups++;
+    return true;
+  }
+  return false;
+}
+
+const host_power_stats_t *host_power_stats(void)
+{
+  return &power;
+}
+
+/* SWO ---------------------------------------------------------------------- */
+
+static FILE *swo;
+static uint32_t swo_ports;
+
+void host_swo_output(FILE *file)
+{
+  // A synchronisation packet first, as the probe would see after reset
+  static const uint8_t sync[] = { 0, 0, 0, 0, 0, 0x80 };
+
+  swo = file;
+  if (swo != NULL) {
+    fwrite(sync, 1, sizeof(sync), swo);
+  }
+}
+
+sl_status_t sl_debug_swo_enable_itm(uint32_t channel)
+{
+  if (channel >= 32) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+  swo_ports |= 1UL << channel;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_debug_swo_write_u32(uint32_t channel, uint32_t value)
+{
+  // Instrumentation packet: port:5 | 0 | size 4
+  uint8_t packet[5] = { (uint8_t)((channel << 3) | 0x03), (uint8_t)value,
+                        (uint8_t)(value >> 8), (uint8_t)(value >> 16),
+                        (uint8_t)(value >> 24) };
+
+  if (channel >= 32 || !(swo_ports & (1UL << channel))) {
+    return SL_STATUS_INVALID_STATE;
+  }
+  if (swo != NULL) {
+    fwrite(packet, 1, sizeof(packet), swo);
+  }
+  return SL_STATUS_OK;
+}
+
+/* GPIO --------------------------------------------------------------------- */
+
+static struct {
+  GPIO_Mode_TypeDef mode;
+  uint8_t out;
+  uint8_t in;
+  bool driven;
+} pins[GPIO_PORTS][GPIO_PINS];
+static struct {
+  GPIO_Port_TypeDef port;
+  unsigned int pin;
+  bool rising;
+  bool falling;
+} ext_int[GPIO_PINS];
+static uint32_t int_enabled;
+static uint32_t int_flags;
+
+void CMU_ClockEnable(CMU_Clock_TypeDef clock, bool enable)
+{
+  (void)clock;
+  (void)enable;
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type irq)
+{
+  (void)irq;
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq)
+{
+  (void)irq;
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq)
+{
+  (void)irq;
+}
+
+void GPIO_PinModeSet(GPIO_Port_TypeDef port, unsigned int pin, GPIO_Mode_TypeDef mode,
+                     unsigned int out)
+{
+  pins[port][pin].mode = mode;
+  pins[port][pin].out = out ? 1 : 0;
+}
+
+unsigned int GPIO_PinInGet(GPIO_Port_TypeDef port, unsigned int pin)
+{
+  // An undriven input reads its pull, which DOUT selects
+  if (pins[port][pin].driven) {
+    return pins[port][pin].in;
+  }
+  return pins[port][pin].mode == gpioModeInput ? 0 : pins[port][pin].out;
+}
+
+unsigned int GPIO_PinOutGet(GPIO_Port_TypeDef port, unsigned int pin)
+{
+  return pins[port][pin].out;
+}
+
+void GPIO_PinOutSet(GPIO_Port_TypeDef port, unsigned int pin)
+{
+  pins[port][pin].out = 1;
+}
+
+void GPIO_PinOutClear(GPIO_Port_TypeDef port, unsigned int pin)
+{
+  pins[port][pin].out = 0;
+}
+
+void GPIO_PinOutToggle(GPIO_Port_TypeDef port, unsigned int pin)
+{
+  pins[port][pin].out ^= 1;
+}
+
+void GPIO_ExtIntConfig(GPIO_Port_TypeDef port, unsigned int pin, unsigned int intNo,
+                       bool risingEdge, bool fallingEdge, bool enable)
+{
+  ext_int[intNo].port = port;
+  ext_int[intNo].pin = pin;
+  ext_int[intNo].rising = risingEdge;
+  ext_int[intNo].falling = fallingEdge;
+  int_flags &= ~(1u << intNo);
+  if (enable) {
+    int_enabled |= 1u << intNo;
+  } else {
+    int_enabled &= ~(1u << intNo);
+  }
+}
+
+uint32_t GPIO_IntGet(void)
+{
+  return int_flags;
+}
+
+uint32_t GPIO_IntGetEnabled(void)
+{
+  return int_flags & int_enabled;
+}
+
+void GPIO_IntClear(uint32_t flags)
+{
+  int_flags &= ~flags;
+}
+
+SL_WEAK void GPIO_EVEN_IRQHandler(void)
+{
+  int_flags &= ~0x5555u;
+}
+
+SL_WEAK void GPIO_ODD_IRQHandler(void)
+{
+  int_flags &= ~0xaaaau;
+}
+
+bool host_gpio_drive(GPIO_Port_TypeDef port, unsigned int pin, unsigned int level)
+{
+  unsigned int before = GPIO_PinInGet(port, pin);
+
+  pins[port][pin].driven = true;
+  pins[port][pin].in = level ? 1 : 0;
+  if (pins[port][pin].in == before) {
+    return false;
+  }
+  for (unsigned int n = 0; n < GPIO_PINS; n++) {
+    if (ext_int[n].port != port || ext_int[n].pin != pin || !(int_enabled & (1u << n))) {
+      continue;
+    }
+    if ((level && ext_int[n].rising) || (!level && ext_int[n].falling)) {
+      int_flags |= 1u << n;
+      if (n & 1) {
+        GPIO_ODD_IRQHandler();
+      } else {
+        GPIO_EVEN_IRQHandler();
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+/* EMU ---------------------------------------------------------------------- */
+
+static float temperature = 25.0f;
+
+float EMU_TemperatureGet(void)
+{
+  return temperature;
+}
+
+void host_set_temperature(float celsius)
+{
+  temperature = celsius;
+}
+
+/* NVM3 --------------------------------------------------------------------- */
+
+static struct {
+  bool used;
+  nvm3_ObjectKey_t key;
+  size_t len;
+  uint8_t data[NVM3_DEFAULT_MAX_OBJECT_SIZE];
+} nvm[NVM_OBJECTS];
+nvm3_Handle_t *nvm3_defaultHandle = (nvm3_Handle_t *)&nvm;
+
+static int nvm_find(nvm3_ObjectKey_t key)
+{
+  for (int i = 0; i < NVM_OBJECTS; i++) {
+    if (nvm[i].used && nvm[i].key == key) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+Ecode_t nvm3_readData(nvm3_Handle_t *h, nvm3_ObjectKey_t key, void *value, size_t len)
+{
+  int i = nvm_find(key);
+
+  (void)h;
+  if (i < 0) {
+    return ECODE_NVM3_ERR_KEY_NOT_FOUND;
+  }
+  // Like the real one, reading more than was stored is an error
+  if (len > nvm[i].len) {
+    return ECODE_NVM3_ERR_PARAMETER;
+  }
+  memcpy(value, nvm[i].data, len);
+  return ECODE_NVM3_OK;
+}
+
+Ecode_t nvm3_writeData(nvm3_Handle_t *h, nvm3_ObjectKey_t key, const void *value, size_t len)
+{
+  int i = nvm_find(key);
+
+  (void)h;
+  if (len > NVM3_DEFAULT_MAX_OBJECT_SIZE) {
+    return ECODE_NVM3_ERR_PARAMETER;
+  }
+  for (int j = 0; i < 0 && j < NVM_OBJECTS; j++) {
+    if (!nvm[j].used) {
+      i = j;
+    }
+  }
+  if (i < 0) {
+    return ECODE_NVM3_ERR_STORAGE_FULL;
+  }
+  nvm[i].used = true;
+  nvm[i].key = key;
+  nvm[i].len = len;
+  memcpy(nvm[i].data, value, len);
+  return ECODE_NVM3_OK;
+}
+
+Ecode_t nvm3_deleteObject(nvm3_Handle_t *h, nvm3_ObjectKey_t key)
+{
+  int i = nvm_find(key);
+
+  (void)h;
+  if (i < 0) {
+    return ECODE_NVM3_ERR_KEY_NOT_FOUND;
+  }
+  nvm[i].used = false;
+  return ECODE_NVM3_OK;
+}
+
+/* File format: per object a 32-bit key, a 32-bit length and the data, in
+ * host byte order */
+int host_nvm_load(const char *path)
+{
+  FILE *f = fopen(path, "rb");
+  uint32_t hdr[2];
+  int n = 0;
+
+  if (f == NULL) {
+    return -1;
+  }
+  while (n < NVM_OBJECTS && fread(hdr, sizeof(hdr), 1, f) == 1) {
+    if (hdr[1] > NVM3_DEFAULT_MAX_OBJECT_SIZE || fread(nvm[n].data, 1, hdr[1], f) != hdr[1]) {
+      fclose(f);
+      return -1;
+    }
+    nvm[n].used = true;
+    nvm[n].key = hdr[0];
+    nvm[n].len = hdr[1];
+    n++;
+  }
+  fclose(f);
+  return n;
+}
+
+int host_nvm_save(const char *path)
+{
+  FILE *f = fopen(path, "wb");
+  int n = 0;
+
+  if (f == NULL) {
+    return -1;
+  }
+  for (int i = 0; i < NVM_OBJECTS; i++) {
+    uint32_t hdr[2] = { nvm[i].key, (uint32_t)nvm[i].len };
+
+    if (nvm[i].used) {
+      fwrite(hdr, sizeof(hdr), 1, f);
+      fwrite(nvm[i].data, 1, nvm[i].len, f);
+      n++;
+    }
+  }
+  return fclose(f) == 0 ? n : -1;
+}
+
+/* VCOM and logging --------------------------------------------------------- */
+
+static FILE *vcom_file;
+static bool vcom_echo;
+static uint8_t vcom_in[VCOM_INPUT_SIZE];
+static size_t vcom_in_head;
+static size_t vcom_in_len;
+
+sl_iostream_t *sl_iostream_vcom_handle = (sl_iostream_t *)&vcom_file;
+sl_iostream_uart_t *sl_iostream_uart_vcom_handle = (sl_iostream_uart_t *)&vcom_file;
+
+void host_vcom_output(FILE *file, bool echo)
+{
+  vcom_file = file;
+  vcom_echo = echo;
+}
+
+void host_vcom_input(const uint8_t *data, size_t len)
+{
+  for (size_t i = 0; i < len && vcom_in_len < VCOM_INPUT_SIZE; i++) {
+    vcom_in[(vcom_in_head + vcom_in_len++) % VCOM_INPUT_SIZE] = data[i];
+  }
+}
+
+sl_status_t sl_iostream_write(sl_iostream_t *stream, const void *buffer, size_t buffer_length)
+{
+  (void)stream;
+  if (vcom_file != NULL) {
+    fwrite(buffer, 1, buffer_length, vcom_file);
+  }
+  if (vcom_echo) {
+    fwrite(buffer, 1, buffer_length, stdout);
+  }
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_iostream_read(sl_iostream_t *stream, void *buffer, size_t buffer_length,
+                             size_t *bytes_read)
+{
+  uint8_t *p = buffer;
+  size_t n = 0;
+
+  (void)stream;
+  while (n < buffer_length && vcom_in_len > 0) {
+    p[n++] = vcom_in[vcom_in_head];
+    vcom_in_head = (vcom_in_head + 1) % VCOM_INPUT_SIZE;
+    vcom_in_len--;
+  }
+  if (bytes_read != NULL) {
+    *bytes_read = n;
+  }
+  // Non-blocking read with nothing pending
+  return n > 0 ? SL_STATUS_OK : SL_STATUS_EMPTY;
+}
+
+void sl_iostream_uart_set_read_block(sl_iostream_uart_t *uart, bool enable)
+{
+  (void)uart;
+  (void)enable;
+}
+
+int host_printf(const char *fmt, ...)
+{
+  char buf[512];
+  va_list ap;
+  int n;
+
+  va_start(ap, fmt);
+  n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (n > 0) {
+    sl_iostream_write(sl_iostream_vcom_handle, buf,
+                      (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+  }
+  return n;
+}
+
+void host_hexdump(const void *data, size_t len)
+{
+  const uint8_t *p = data;
+
+  for (size_t i = 0; i < len; i++) {
+    host_printf("%02X ", p[i]);
+  }
+}
+
+/* Asserts ------------------------------------------------------------------ */
+
+void host_set_context(const char *where)
+{
+  context = where;
+}
+
+void host_assert_failed(const char *file, int line, const char *expr, const char *fmt, ...)
+{
+  va_list ap;
+
+  fprintf(stderr, "%s:%d: assertion '%s' failed during %s: ", file, line, expr, context);
+  va_start(ap, fmt);
+  vfprintf(stderr, fmt, ap);
+  va_end(ap);
+  fprintf(stderr, "\n");
+  exit(2);
+}
+
+void host_platform_init(void)
+{
+  now = 0;
+  timers = NULL;
+  host_core_atomic_depth = 0;
+}
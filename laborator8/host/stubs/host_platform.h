@@ -0,0 +1,67 @@
+#ifndef _HOST_PLATFORM_H_
+#define _HOST_PLATFORM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "em_gpio.h"
+
+/* Harness side of host_platform.c: the simulated clock with the
+ * sleeptimers on it, pins, die temperature, VCOM, NVM3 and the power
+ * manager. Nothing in here runs on its own; the harness moves the clock
+ * and calls whatever is due, timing each call. */
+
+typedef struct {
+  uint64_t em1_ticks;         /* simulated time with an EM1 requirement */
+  uint64_t em2_ticks;         /* ... and without, i.e. asleep in EM2 */
+  uint32_t sleeps;            /* times the core would have gone to sleep */
+  uint32_t vetoed;            /* app_is_ok_to_sleep() said no */
+  uint32_t isr_wakeups;       /* app_sleep_on_isr_exit() asked for the loop */
+} host_power_stats_t;
+
+void host_platform_init(void);
+
+uint64_t host_now_tick(void);
+
+/* Moves the clock forward, charging the time to EM1 or EM2 */
+void host_set_now(uint64_t tick);
+
+/* Expiry of the earliest running sleeptimer, UINT64_MAX if none */
+uint64_t host_next_timer_tick(void);
+
+/* Runs the callback of one expired timer (rearming it if periodic).
+ * Returns false when none is due. */
+bool host_run_next_timer(void);
+
+/* Drives an input pin; an edge the external interrupt is configured for
+ * runs the GPIO handler. Returns true if it did. */
+bool host_gpio_drive(GPIO_Port_TypeDef port, unsigned int pin, unsigned int level);
+
+void host_set_temperature(float celsius);
+
+/* Queued for sl_iostream_read() on the VCOM */
+void host_vcom_input(const uint8_t *data, size_t len);
+void host_vcom_output(FILE *file, bool echo);
+
+/* ITM instrumentation packets written to the SWO go to file, as a raw
+ * capture (NULL: discarded) */
+void host_swo_output(FILE *file);
+
+int host_nvm_load(const char *path);
+int host_nvm_save(const char *path);
+
+/* The main loop asks whether it may sleep; called by the harness where
+ * main.c would call sl_power_manager_sleep(). If so the core counts as
+ * asleep until host_set_now() is next called. */
+bool host_power_try_sleep(void);
+
+/* After an "interrupt": whether the application asked to run the loop */
+bool host_power_isr_exit(void);
+
+const host_power_stats_t *host_power_stats(void);
+
+/* Named in the message of a failed app_assert() */
+void host_set_context(const char *context);
+
+#endif
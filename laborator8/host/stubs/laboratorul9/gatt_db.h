@@ -0,0 +1,27 @@
+#ifndef __GATT_DB_H
+#define __GATT_DB_H
+
+/* Laboratorul9 has no autogen/ in the tree. These are the handles SLC
+ * assigns for its config/btconf: the same database as laborator8 up to
+ * the Device Information service, then BUTTON_IO and the OTA service. */
+
+#include "sli_bt_gattdb_def.h"
+
+extern const sli_bt_gattdb_t gattdb;
+
+#define gattdb_generic_attribute              1
+#define gattdb_service_changed_char           3
+#define gattdb_database_hash                  6
+#define gattdb_client_support_features        8
+#define gattdb_device_name                    11
+#define gattdb_device_information             14
+#define gattdb_manufacturer_name_string       16
+#define gattdb_model_number_string            18
+#define gattdb_hardware_revision_string       20
+#define gattdb_firmware_revision_string       22
+#define gattdb_system_id                      24
+#define gattdb_BUTTON_IO                      27
+#define gattdb_ota                            29
+#define gattdb_ota_control                    31
+
+#endif // __GATT_DB_H
@@ -0,0 +1,31 @@
+#ifndef _HOST_NVM3_DEFAULT_H_
+#define _HOST_NVM3_DEFAULT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#if __has_include("nvm3_default_config.h")
+#include "nvm3_default_config.h"
+#endif
+
+#ifndef NVM3_DEFAULT_MAX_OBJECT_SIZE
+#define NVM3_DEFAULT_MAX_OBJECT_SIZE  254
+#endif
+
+/* Objects live in RAM; --nvm FILE loads them at start-up and writes them
+ * back at exit, so bonds survive from one run to the next. */
+typedef uint32_t Ecode_t;
+typedef uint32_t nvm3_ObjectKey_t;
+typedef struct nvm3_Handle nvm3_Handle_t;
+
+#define ECODE_NVM3_OK                   0x00000000
+#define ECODE_NVM3_ERR_KEY_NOT_FOUND    0xf000000e
+#define ECODE_NVM3_ERR_STORAGE_FULL     0xf0000005
+#define ECODE_NVM3_ERR_PARAMETER        0xf0000009
+
+extern nvm3_Handle_t *nvm3_defaultHandle;
+
+Ecode_t nvm3_readData(nvm3_Handle_t *h, nvm3_ObjectKey_t key, void *value, size_t len);
+Ecode_t nvm3_writeData(nvm3_Handle_t *h, nvm3_ObjectKey_t key, const void *value, size_t len);
+Ecode_t nvm3_deleteObject(nvm3_Handle_t *h, nvm3_ObjectKey_t key);
+
+#endif
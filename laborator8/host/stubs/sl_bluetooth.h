@@ -0,0 +1,9 @@
+#ifndef _HOST_SL_BLUETOOTH_H_
+#define _HOST_SL_BLUETOOTH_H_
+
+#include "sl_bt_api.h"
+
+/* Implemented by the lab's app.c, called by the harness */
+void sl_bt_on_event(sl_bt_msg_t *evt);
+
+#endif
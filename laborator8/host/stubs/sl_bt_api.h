@@ -0,0 +1,417 @@
+#ifndef _HOST_SL_BT_API_H_
+#define _HOST_SL_BT_API_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sl_status.h"
+
+/* The part of the Silicon Labs Bluetooth API (simplicity_sdk 2024.6) the
+ * labs use, with the same names, fields and event header layout
+ * (class << 16 | id << 24 | 0xa0). Commands are answered by bt_mock.c;
+ * events come from the harness. */
+
+typedef struct {
+  uint8_t addr[6];
+} bd_addr;
+
+// Variable length on the board; sized for the longest payload here
+typedef struct {
+  uint8_t len;
+  uint8_t data[255];
+} uint8array;
+
+#define SL_BT_MSG_ID(HDR) ((HDR) & 0xffff00f8)
+
+/* Events ------------------------------------------------------------------ */
+
+#define sl_bt_evt_system_boot_id                            0x000100a0
+#define sl_bt_evt_system_external_signal_id                 0x030100a0
+#define sl_bt_evt_scanner_legacy_advertisement_report_id    0x000500a0
+#define sl_bt_evt_scanner_extended_advertisement_report_id  0x020500a0
+#define sl_bt_evt_periodic_sync_opened_id                   0x004e00a0
+#define sl_bt_evt_periodic_sync_report_id                   0x014e00a0
+#define sl_bt_evt_sync_closed_id                            0x014200a0
+#define sl_bt_evt_connection_opened_id                      0x000600a0
+#define sl_bt_evt_connection_closed_id                      0x010600a0
+#define sl_bt_evt_connection_parameters_id                  0x020600a0
+#define sl_bt_evt_connection_phy_status_id                  0x040600a0
+#define sl_bt_evt_connection_data_length_id                 0x120600a0
+#define sl_bt_evt_gatt_mtu_exchanged_id                     0x000900a0
+#define sl_bt_evt_gatt_server_attribute_value_id            0x000a00a0
+#define sl_bt_evt_gatt_server_user_read_request_id          0x010a00a0
+#define sl_bt_evt_gatt_server_user_write_request_id         0x020a00a0
+#define sl_bt_evt_gatt_server_characteristic_status_id      0x030a00a0
+#define sl_bt_evt_sm_passkey_display_id                     0x000f00a0
+#define sl_bt_evt_sm_bonded_id                              0x030f00a0
+#define sl_bt_evt_sm_bonding_failed_id                      0x040f00a0
+#define sl_bt_evt_sm_confirm_bonding_id                     0x090f00a0
+
+typedef struct {
+  uint16_t major;
+  uint16_t minor;
+  uint16_t patch;
+  uint16_t build;
+  uint32_t bootloader;
+  uint16_t hw;
+  uint32_t hash;
+} sl_bt_evt_system_boot_t;
+
+typedef struct {
+  uint32_t extsignals;
+} sl_bt_evt_system_external_signal_t;
+
+typedef struct {
+  uint8_t event_flags;
+  bd_addr address;
+  uint8_t address_type;
+  uint8_t bonding;
+  int8_t rssi;
+  uint8_t channel;
+  bd_addr target_address;
+  uint8_t target_address_type;
+  uint8array data;
+} sl_bt_evt_scanner_legacy_advertisement_report_t;
+
+typedef struct {
+  uint8_t event_flags;
+  bd_addr address;
+  uint8_t address_type;
+  uint8_t bonding;
+  int8_t rssi;
+  uint8_t channel;
+  bd_addr target_address;
+  uint8_t target_address_type;
+  uint8_t adv_sid;
+  uint8_t primary_phy;
+  uint8_t secondary_phy;
+  int8_t tx_power;
+  uint16_t periodic_interval;
+  uint8_t data_completeness;
+  uint8_t counter;
+  uint8array data;
+} sl_bt_evt_scanner_extended_advertisement_report_t;
+
+typedef struct {
+  uint16_t sync;
+  uint8_t adv_sid;
+  bd_addr address;
+  uint8_t address_type;
+  uint8_t adv_phy;
+  uint16_t adv_interval;
+  uint16_t clock_accuracy;
+  uint8_t bonding;
+} sl_bt_evt_periodic_sync_opened_t;
+
+typedef struct {
+  uint16_t sync;
+  int8_t tx_power;
+  int8_t rssi;
+  uint8_t cte_type;
+  uint8_t data_status;
+  uint8_t counter;
+  uint8array data;
+} sl_bt_evt_periodic_sync_report_t;
+
+typedef struct {
+  uint16_t reason;
+  uint16_t sync;
+} sl_bt_evt_sync_closed_t;
+
+typedef struct {
+  bd_addr address;
+  uint8_t address_type;
+  uint8_t master;
+  uint8_t connection;
+  uint8_t bonding;
+  uint8_t advertiser;
+  uint16_t sync;
+} sl_bt_evt_connection_opened_t;
+
+typedef struct {
+  uint16_t reason;
+  uint8_t connection;
+} sl_bt_evt_connection_closed_t;
+
+typedef struct {
+  uint8_t connection;
+  uint16_t interval;
+  uint16_t latency;
+  uint16_t timeout;
+  uint8_t security_mode;
+  uint16_t txsize;
+} sl_bt_evt_connection_parameters_t;
+
+typedef struct {
+  uint8_t connection;
+  uint8_t phy;
+} sl_bt_evt_connection_phy_status_t;
+
+typedef struct {
+  uint8_t connection;
+  uint16_t tx_data_len;
+  uint16_t tx_time_us;
+  uint16_t rx_data_len;
+  uint16_t rx_time_us;
+} sl_bt_evt_connection_data_length_t;
+
+typedef struct {
+  uint8_t connection;
+  uint16_t mtu;
+} sl_bt_evt_gatt_mtu_exchanged_t;
+
+typedef struct {
+  uint8_t connection;
+  uint16_t attribute;
+  uint8_t att_opcode;
+  uint16_t offset;
+  uint8array value;
+} sl_bt_evt_gatt_server_attribute_value_t;
+
+typedef struct {
+  uint8_t connection;
+  uint16_t characteristic;
+  uint8_t att_opcode;
+  uint16_t offset;
+} sl_bt_evt_gatt_server_user_read_request_t;
+
+typedef struct {
+  uint8_t connection;
+  uint16_t characteristic;
+  uint8_t att_opcode;
+  uint16_t offset;
+  uint8array value;
+} sl_bt_evt_gatt_server_user_write_request_t;
+
+typedef struct {
+  uint8_t connection;
+  uint16_t characteristic;
+  uint8_t status_flags;
+  uint16_t client_config_flags;
+  uint16_t client_config;
+} sl_bt_evt_gatt_server_characteristic_status_t;
+
+typedef struct {
+  uint8_t connection;
+  uint32_t passkey;
+} sl_bt_evt_sm_passkey_display_t;
+
+typedef struct {
+  uint8_t connection;
+  uint8_t bonding;
+  uint8_t security_mode;
+} sl_bt_evt_sm_bonded_t;
+
+typedef struct {
+  uint8_t connection;
+  uint16_t reason;
+} sl_bt_evt_sm_bonding_failed_t;
+
+typedef struct {
+  uint8_t connection;
+  int8_t bonding_handle;
+} sl_bt_evt_sm_confirm_bonding_t;
+
+typedef struct {
+  uint32_t header;
+  union {
+    sl_bt_evt_system_boot_t evt_system_boot;
+    sl_bt_evt_system_external_signal_t evt_system_external_signal;
+    sl_bt_evt_scanner_legacy_advertisement_report_t evt_scanner_legacy_advertisement_report;
+    sl_bt_evt_scanner_extended_advertisement_report_t evt_scanner_extended_advertisement_report;
+    sl_bt_evt_periodic_sync_opened_t evt_periodic_sync_opened;
+    sl_bt_evt_periodic_sync_report_t evt_periodic_sync_report;
+    sl_bt_evt_sync_closed_t evt_sync_closed;
+    sl_bt_evt_connection_opened_t evt_connection_opened;
+    sl_bt_evt_connection_closed_t evt_connection_closed;
+    sl_bt_evt_connection_parameters_t evt_connection_parameters;
+    sl_bt_evt_connection_phy_status_t evt_connection_phy_status;
+    sl_bt_evt_connection_data_length_t evt_connection_data_length;
+    sl_bt_evt_gatt_mtu_exchanged_t evt_gatt_mtu_exchanged;
+    sl_bt_evt_gatt_server_attribute_value_t evt_gatt_server_attribute_value;
+    sl_bt_evt_gatt_server_user_read_request_t evt_gatt_server_user_read_request;
+    sl_bt_evt_gatt_server_user_write_request_t evt_gatt_server_user_write_request;
+    sl_bt_evt_gatt_server_characteristic_status_t evt_gatt_server_characteristic_status;
+    sl_bt_evt_sm_passkey_display_t evt_sm_passkey_display;
+    sl_bt_evt_sm_bonded_t evt_sm_bonded;
+    sl_bt_evt_sm_bonding_failed_t evt_sm_bonding_failed;
+    sl_bt_evt_sm_confirm_bonding_t evt_sm_confirm_bonding;
+  } data;
+} sl_bt_msg_t;
+
+/* Enumerations ------------------------------------------------------------ */
+
+typedef enum {
+  sl_bt_gap_public_address = 0x0,
+  sl_bt_gap_static_address = 0x1,
+  sl_bt_gap_random_resolvable_address = 0x2,
+  sl_bt_gap_random_nonresolvable_address = 0x3,
+  sl_bt_gap_public_address_resolved_from_rpa = 0x4,
+  sl_bt_gap_random_identity_address_resolved_from_rpa = 0x5,
+} sl_bt_gap_address_type_t;
+
+typedef enum {
+  sl_bt_gap_phy_1m = 0x1,
+  sl_bt_gap_phy_2m = 0x2,
+  sl_bt_gap_phy_coded = 0x4,
+  sl_bt_gap_phy_any = 0xff,
+} sl_bt_gap_phy_t;
+
+typedef enum {
+  sl_bt_advertiser_non_discoverable = 0x0,
+  sl_bt_advertiser_limited_discoverable = 0x1,
+  sl_bt_advertiser_general_discoverable = 0x2,
+  sl_bt_advertiser_broadcast = 0x3,
+  sl_bt_advertiser_user_data = 0x4,
+} sl_bt_advertiser_discovery_mode_t;
+
+typedef enum {
+  sl_bt_advertiser_non_connectable = 0x0,
+  sl_bt_advertiser_connectable_scannable = 0x2,
+  sl_bt_advertiser_scannable_non_connectable = 0x3,
+  sl_bt_advertiser_connectable_non_scannable = 0x4,
+} sl_bt_advertiser_connection_mode_t;
+
+typedef enum {
+  sl_bt_legacy_advertiser_non_connectable = 0x0,
+  sl_bt_legacy_advertiser_connectable = 0x2,
+  sl_bt_legacy_advertiser_scannable = 0x3,
+} sl_bt_legacy_advertiser_connection_mode_t;
+
+typedef enum {
+  sl_bt_extended_advertiser_non_connectable = 0x0,
+  sl_bt_extended_advertiser_scannable = 0x3,
+  sl_bt_extended_advertiser_connectable = 0x4,
+} sl_bt_extended_advertiser_connection_mode_t;
+
+typedef enum {
+  sl_bt_advertiser_advertising_data_packet = 0x0,
+  sl_bt_advertiser_scan_response_packet = 0x1,
+} sl_bt_advertiser_packet_type_t;
+
+typedef enum {
+  sl_bt_scanner_scan_phy_1m = 0x1,
+  sl_bt_scanner_scan_phy_coded = 0x4,
+  sl_bt_scanner_scan_phy_1m_and_coded = 0x5,
+} sl_bt_scanner_scan_phy_t;
+
+typedef enum {
+  sl_bt_scanner_scan_mode_passive = 0x0,
+  sl_bt_scanner_scan_mode_active = 0x1,
+} sl_bt_scanner_scan_mode_t;
+
+typedef enum {
+  sl_bt_scanner_discover_limited = 0x0,
+  sl_bt_scanner_discover_generic = 0x1,
+  sl_bt_scanner_discover_observation = 0x2,
+} sl_bt_scanner_discover_mode_t;
+
+typedef enum {
+  sl_bt_sync_report_none = 0x0,
+  sl_bt_sync_report_all = 0x1,
+} sl_bt_sync_reporting_mode_t;
+
+typedef enum {
+  sl_bt_connection_mode1_level1 = 0x0,
+  sl_bt_connection_mode1_level2 = 0x1,
+  sl_bt_connection_mode1_level3 = 0x2,
+  sl_bt_connection_mode1_level4 = 0x3,
+} sl_bt_connection_security_t;
+
+typedef enum {
+  sl_bt_gatt_disable = 0x0,
+  sl_bt_gatt_notification = 0x1,
+  sl_bt_gatt_indication = 0x2,
+} sl_bt_gatt_client_config_flag_t;
+
+typedef enum {
+  sl_bt_gatt_read_request = 0xa,
+  sl_bt_gatt_read_blob_request = 0xc,
+  sl_bt_gatt_write_request = 0x12,
+  sl_bt_gatt_write_command = 0x52,
+  sl_bt_gatt_prepare_write_request = 0x16,
+  sl_bt_gatt_execute_write_request = 0x18,
+} sl_bt_gatt_att_opcode_t;
+
+typedef enum {
+  sl_bt_gatt_server_client_config = 0x1,
+  sl_bt_gatt_server_confirmation = 0x2,
+} sl_bt_gatt_server_characteristic_status_flag_t;
+
+typedef enum {
+  sl_bt_sm_io_capability_displayonly = 0x0,
+  sl_bt_sm_io_capability_displayyesno = 0x1,
+  sl_bt_sm_io_capability_keyboardonly = 0x2,
+  sl_bt_sm_io_capability_noinputnooutput = 0x3,
+  sl_bt_sm_io_capability_keyboarddisplay = 0x4,
+} sl_bt_sm_io_capability_t;
+
+/* Commands ---------------------------------------------------------------- */
+
+sl_status_t sl_bt_external_signal(uint32_t signals);
+
+sl_status_t sl_bt_advertiser_create_set(uint8_t *handle);
+sl_status_t sl_bt_advertiser_set_timing(uint8_t advertising_set, uint32_t interval_min,
+                                        uint32_t interval_max, uint16_t duration,
+                                        uint8_t maxevents);
+sl_status_t sl_bt_advertiser_stop(uint8_t advertising_set);
+sl_status_t sl_bt_legacy_advertiser_generate_data(uint8_t advertising_set, uint8_t discover);
+sl_status_t sl_bt_legacy_advertiser_set_data(uint8_t advertising_set, uint8_t type,
+                                             size_t data_len, const uint8_t *data);
+sl_status_t sl_bt_legacy_advertiser_start(uint8_t advertising_set, uint8_t connect);
+sl_status_t sl_bt_extended_advertiser_set_phy(uint8_t advertising_set, uint8_t primary_phy,
+                                              uint8_t secondary_phy);
+sl_status_t sl_bt_extended_advertiser_set_data(uint8_t advertising_set, size_t data_len,
+                                               const uint8_t *data);
+sl_status_t sl_bt_extended_advertiser_start(uint8_t advertising_set, uint8_t connect,
+                                            uint32_t flags);
+sl_status_t sl_bt_periodic_advertiser_start(uint8_t advertising_set, uint16_t interval_min,
+                                            uint16_t interval_max, uint32_t flags);
+sl_status_t sl_bt_periodic_advertiser_set_data(uint8_t advertising_set, size_t data_len,
+                                               const uint8_t *data);
+
+sl_status_t sl_bt_scanner_set_parameters(uint8_t mode, uint16_t interval, uint16_t window);
+sl_status_t sl_bt_scanner_start(uint8_t scanning_phy, uint8_t discover_mode);
+sl_status_t sl_bt_scanner_stop(void);
+sl_status_t sl_bt_sync_scanner_set_sync_parameters(uint16_t skip, uint16_t timeout,
+                                                   uint8_t reporting_mode);
+sl_status_t sl_bt_sync_scanner_open(bd_addr address, uint8_t address_type, uint8_t adv_sid,
+                                    uint16_t *sync);
+
+sl_status_t sl_bt_connection_set_parameters(uint8_t connection, uint16_t min_interval,
+                                            uint16_t max_interval, uint16_t latency,
+                                            uint16_t timeout, uint16_t min_ce_length,
+                                            uint16_t max_ce_length);
+sl_status_t sl_bt_connection_set_preferred_phy(uint8_t connection, uint8_t preferred_phy,
+                                               uint8_t accepted_phy);
+sl_status_t sl_bt_connection_set_data_length(uint8_t connection, uint16_t tx_data_len,
+                                             uint16_t tx_time_us);
+
+sl_status_t sl_bt_gatt_server_set_max_mtu(uint16_t max_mtu, uint16_t *max_mtu_out);
+sl_status_t sl_bt_gatt_server_read_attribute_value(uint16_t attribute, uint16_t offset,
+                                                   size_t max_value_size, size_t *value_len,
+                                                   uint8_t *value);
+sl_status_t sl_bt_gatt_server_send_notification(uint8_t connection, uint16_t characteristic,
+                                                size_t value_len, const uint8_t *value);
+sl_status_t sl_bt_gatt_server_send_indication(uint8_t connection, uint16_t characteristic,
+                                              size_t value_len, const uint8_t *value);
+sl_status_t sl_bt_gatt_server_send_user_read_response(uint8_t connection,
+                                                      uint16_t characteristic,
+                                                      uint8_t att_errorcode,
+                                                      size_t value_len,
+                                                      const uint8_t *value,
+                                                      uint16_t *sent_len);
+sl_status_t sl_bt_gatt_server_send_user_write_response(uint8_t connection,
+                                                       uint16_t characteristic,
+                                                       uint8_t att_errorcode);
+
+sl_status_t sl_bt_sm_configure(uint8_t flags, uint8_t io_capabilities);
+sl_status_t sl_bt_sm_set_passkey(int32_t passkey);
+sl_status_t sl_bt_sm_set_bondable_mode(uint8_t bondable);
+sl_status_t sl_bt_sm_increase_security(uint8_t connection);
+sl_status_t sl_bt_sm_store_bonding_configuration(uint8_t max_bonding_count,
+                                                 uint8_t policy_flags);
+sl_status_t sl_bt_sm_delete_bonding(uint8_t bonding);
+sl_status_t sl_bt_sm_bonding_confirm(uint8_t connection, uint8_t confirm);
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef _HOST_SL_CORE_H_
+#define _HOST_SL_CORE_H_
+
+#include <stdint.h>
+
+/* "Interrupts" (GPIO handlers, sleeptimer callbacks) only run between two
+ * calls into the application, so the critical sections have nothing to
+ * keep out. They are counted to catch unbalanced enter/exit pairs. */
+typedef uint32_t CORE_irqState_t;
+
+extern int host_core_atomic_depth;
+
+#define CORE_DECLARE_IRQ_STATE  CORE_irqState_t irqState = 0
+#define CORE_ENTER_ATOMIC()     do { (void)irqState; host_core_atomic_depth++; } while (0)
+#define CORE_EXIT_ATOMIC()      do { (void)irqState; host_core_atomic_depth--; } while (0)
+#define CORE_ENTER_CRITICAL()   CORE_ENTER_ATOMIC()
+#define CORE_EXIT_CRITICAL()    CORE_EXIT_ATOMIC()
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef _HOST_SL_DEBUG_SWO_H_
+#define _HOST_SL_DEBUG_SWO_H_
+
+#include <stdint.h>
+#include "sl_status.h"
+
+/* Writes go to the capture file set with host_swo_output(), if any */
+sl_status_t sl_debug_swo_enable_itm(uint32_t channel);
+sl_status_t sl_debug_swo_write_u32(uint32_t channel, uint32_t value);
+
+#endif
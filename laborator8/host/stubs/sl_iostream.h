@@ -0,0 +1,13 @@
+#ifndef _HOST_SL_IOSTREAM_H_
+#define _HOST_SL_IOSTREAM_H_
+
+#include <stddef.h>
+#include "sl_status.h"
+
+typedef struct sl_iostream sl_iostream_t;
+
+sl_status_t sl_iostream_write(sl_iostream_t *stream, const void *buffer, size_t buffer_length);
+sl_status_t sl_iostream_read(sl_iostream_t *stream, void *buffer, size_t buffer_length,
+                             size_t *bytes_read);
+
+#endif
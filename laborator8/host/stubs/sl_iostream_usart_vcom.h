@@ -0,0 +1,16 @@
+#ifndef _HOST_SL_IOSTREAM_USART_VCOM_H_
+#define _HOST_SL_IOSTREAM_USART_VCOM_H_
+
+#include <stdbool.h>
+#include "sl_iostream.h"
+
+/* The VCOM: output goes to --vcom FILE (and stdout with -v), input comes
+ * from the script ("key data=...") */
+typedef struct sl_iostream_uart sl_iostream_uart_t;
+
+extern sl_iostream_t *sl_iostream_vcom_handle;
+extern sl_iostream_uart_t *sl_iostream_uart_vcom_handle;
+
+void sl_iostream_uart_set_read_block(sl_iostream_uart_t *uart, bool enable);
+
+#endif
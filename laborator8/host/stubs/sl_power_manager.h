@@ -0,0 +1,57 @@
+#ifndef _HOST_SL_POWER_MANAGER_H_
+#define _HOST_SL_POWER_MANAGER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Requirements are counted; the harness charges the simulated time
+ * between wakeups to EM1 while one is held and to EM2 otherwise. */
+typedef enum {
+  SL_POWER_MANAGER_EM0,
+  SL_POWER_MANAGER_EM1,
+  SL_POWER_MANAGER_EM2,
+  SL_POWER_MANAGER_EM3,
+} sl_power_manager_em_t;
+
+typedef enum {
+  SL_POWER_MANAGER_IGNORE = (1UL << 0),
+  SL_POWER_MANAGER_SLEEP = (1UL << 1),
+  SL_POWER_MANAGER_WAKEUP = (1UL << 2),
+} sl_power_manager_on_isr_exit_t;
+
+/* Transitions are reported when the harness lets the core sleep
+ * (host_power_try_sleep) and when it next moves the clock */
+typedef uint32_t sl_power_manager_em_transition_event_t;
+
+#define SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM0  (1UL << 0)
+#define SL_POWER_MANAGER_EVENT_TRANSITION_LEAVING_EM0   (1UL << 1)
+#define SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM1  (1UL << 2)
+#define SL_POWER_MANAGER_EVENT_TRANSITION_LEAVING_EM1   (1UL << 3)
+#define SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM2  (1UL << 4)
+#define SL_POWER_MANAGER_EVENT_TRANSITION_LEAVING_EM2   (1UL << 5)
+
+typedef void (*sl_power_manager_em_transition_on_event_t)(sl_power_manager_em_t from,
+                                                          sl_power_manager_em_t to);
+
+typedef struct {
+  const sl_power_manager_em_transition_event_t event_mask;
+  const sl_power_manager_em_transition_on_event_t on_event;
+} sl_power_manager_em_transition_event_info_t;
+
+typedef struct sl_power_manager_em_transition_event_handle {
+  struct sl_power_manager_em_transition_event_handle *next;
+  const sl_power_manager_em_transition_event_info_t *info;
+} sl_power_manager_em_transition_event_handle_t;
+
+void sl_power_manager_subscribe_em_transition_event(
+  sl_power_manager_em_transition_event_handle_t *event_handle,
+  const sl_power_manager_em_transition_event_info_t *event_info);
+
+void sl_power_manager_add_em_requirement(sl_power_manager_em_t em);
+void sl_power_manager_remove_em_requirement(sl_power_manager_em_t em);
+
+// Application hooks, weak defaults in the mock
+bool app_is_ok_to_sleep(void);
+sl_power_manager_on_isr_exit_t app_sleep_on_isr_exit(void);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef _HOST_SL_STATUS_H_
+#define _HOST_SL_STATUS_H_
+
+#include <stdint.h>
+
+/* The subset of the Gecko SDK status codes the labs and the mocks use */
+typedef uint32_t sl_status_t;
+
+#define SL_STATUS_OK                  ((sl_status_t)0x0000)
+#define SL_STATUS_FAIL                ((sl_status_t)0x0001)
+#define SL_STATUS_INVALID_STATE       ((sl_status_t)0x0002)
+#define SL_STATUS_NOT_READY           ((sl_status_t)0x0003)
+#define SL_STATUS_BUSY                ((sl_status_t)0x0004)
+#define SL_STATUS_ALLOCATION_FAILED   ((sl_status_t)0x0019)
+#define SL_STATUS_NO_MORE_RESOURCE    ((sl_status_t)0x001a)
+#define SL_STATUS_EMPTY               ((sl_status_t)0x001b)
+#define SL_STATUS_INVALID_PARAMETER   ((sl_status_t)0x0021)
+#define SL_STATUS_NULL_POINTER        ((sl_status_t)0x0022)
+#define SL_STATUS_INVALID_HANDLE      ((sl_status_t)0x0025)
+#define SL_STATUS_NOT_FOUND           ((sl_status_t)0x0030)
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef _HOST_SLI_BT_GATTDB_DEF_H_
+#define _HOST_SLI_BT_GATTDB_DEF_H_
+
+/* autogen/gatt_db.h declares the database; the host build only needs the
+ * handles, not the table in gatt_db.c */
+typedef struct sli_bt_gattdb sli_bt_gattdb_t;
+
+#endif
@@ -0,0 +1,617 @@
+/* Decoder for the laborator8 SWO event trace (app_trace.h).
+ *
+ * Reads a raw SWO capture, i.e. the ITM byte stream as the probe receives
+ * it, keeps the instrumentation packets of stimulus port APP_TRACE_ITM_PORT
+ * and rebuilds the records of app_trace_format.h. Awake time comes from
+ * the DWT cycle stamps; sleeps are timed from the sleeptimer ticks on
+ * SLEEP and WAKE, since the cycle counter stops with the core.
+ *
+ * The report has one line per kind of span: sl_bt_step() without the
+ * handler (stack), sl_bt_on_event() per event ID, app_process_action(),
+ * each interrupt, the SWO drain itself and the sleeps, with count, mean,
+ * p99, max and total, and a histogram by octave under each. Times are self
+ * times: an interrupt taken inside a handler is charged to the interrupt.
+ *
+ *   ./build/swo_trace capture.swo
+ *   ./build/swo_trace --timeline --from 1000 --to 1200 capture.swo
+ *   ./build/bt_host_l8 --gen conn:200 --swo conn.swo && ./build/swo_trace conn.swo
+ *
+ * Options:
+ *   --timeline      every span in start order, nested, with its length
+ *   --from MS       timeline window, capture time
+ *   --to MS
+ *   --no-hist       summary lines only
+ *   --hz N          core clock until the capture's INFO record says
+ */
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sl_bluetooth.h"
+#include "app_trace_format.h"
+
+#define HIST_BUCKETS    (8 * 48)    /* 8 per octave of ns */
+#define MAX_STATS       64
+#define MAX_DEPTH       16
+#define MAX_PENDING     512         /* timeline lines held until the top span ends */
+#define TICK_MASK       ((1UL << APP_TRACE_TICK_BITS) - 1)
+
+typedef struct {
+  uint8_t kind;               /* span start kind, or APP_TRACE_SLEEP */
+  uint32_t arg;
+  uint64_t count;
+  uint64_t sum_ns;
+  uint64_t max_ns;
+  double max_at_ms;
+  uint32_t hist[HIST_BUCKETS];
+} stat_t;
+
+typedef struct {
+  uint8_t kind;
+  uint32_t arg;
+  uint64_t start;             /* cycles since the first record */
+  uint64_t nested;            /* cycles spent in spans inside this one */
+} frame_t;
+
+typedef struct {
+  uint64_t start;
+  uint64_t length;
+  uint64_t self;
+  int depth;
+  uint8_t kind;
+  uint32_t arg;
+} line_t;
+
+typedef struct {
+  const char *name;
+  uint32_t id;
+} event_name_t;
+
+static const event_name_t event_names[] = {
+#include "bt_events.inc"
+};
+
+static const char *const isr_names[] = {
+  [APP_TRACE_ISR_BUTTON] = "button",
+  [APP_TRACE_ISR_BUTTON_RETRY] = "button_retry",
+  [APP_TRACE_ISR_ADV_STAGE] = "adv_stage",
+  [APP_TRACE_ISR_SCHED] = "sched",
+};
+
+static struct {
+  bool timeline;
+  bool hist;
+  double from_ms;
+  double to_ms;
+  double hz;
+} opt = {
+  .hist = true,
+  .to_ms = 1e300,
+  .hz = 76800000,
+};
+
+static stat_t stats[MAX_STATS];
+static int stat_count;
+static frame_t stack[MAX_DEPTH];
+static int depth;
+static line_t pending[MAX_PENDING];
+static int pending_count;
+
+static double cpu_hz;
+static double tick_hz = 32768;
+static bool have_time;
+static uint64_t now;                /* cycles since the first record */
+static uint32_t last_cycles;
+static bool asleep;
+static uint64_t sleep_start;
+static uint32_t sleep_tick;
+static uint32_t sleep_em;
+
+static struct {
+  uint64_t records;
+  uint64_t lost;              /* LOST records: the ring was full */
+  uint64_t overflows;         /* ITM overflow packets: the FIFO was */
+  uint64_t misaligned;        /* words dropped to find a record start */
+  uint64_t unmatched;         /* span ends without a start */
+  uint64_t too_deep;
+  uint64_t jumps;             /* cycle stamps that made no sense */
+  uint64_t other_packets;
+  uint64_t sleep_cycles;
+  uint32_t sleeps;
+} totals;
+
+static double to_ms(uint64_t cycles)
+{
+  return cycles * 1000.0 / cpu_hz;
+}
+
+static uint64_t to_ns(uint64_t cycles)
+{
+  return (uint64_t)(cycles * 1e9 / cpu_hz);
+}
+
+static unsigned bucket(uint64_t ns)
+{
+  unsigned msb;
+  unsigned b;
+
+  if (ns < 2) {
+    return 0;
+  }
+  msb = 63 - (unsigned)__builtin_clzll(ns);
+  // Three bits below the leading one pick the eighth of the octave
+  b = msb * 8 + (unsigned)((msb >= 3 ? ns >> (msb - 3) : ns << (3 - msb)) & 7);
+  return b < HIST_BUCKETS ? b : HIST_BUCKETS - 1;
+}
+
+static double bucket_top_ns(unsigned b)
+{
+  unsigned msb = b / 8;
+
+  return (double)(8 + b % 8 + 1) * (double)(1ull << msb) / 8.0;
+}
+
+static const char *name_of(uint8_t kind, uint32_t arg, char *buf, size_t size)
+{
+  switch (kind) {
+    case APP_TRACE_STEP:
+      return "stack (sl_bt_step)";
+    case APP_TRACE_APP:
+      return "app_process_action";
+    case APP_TRACE_FLUSH:
+      return "swo flush";
+    case APP_TRACE_SLEEP:
+      snprintf(buf, size, "sleep EM%u", (unsigned)arg);
+      return buf;
+    case APP_TRACE_ISR:
+      if (arg < sizeof(isr_names) / sizeof(isr_names[0]) && isr_names[arg] != NULL) {
+        snprintf(buf, size, "isr %s", isr_names[arg]);
+      } else {
+        snprintf(buf, size, "isr %u", (unsigned)arg);
+      }
+      return buf;
+    case APP_TRACE_EVENT:
+      for (size_t i = 0; i < sizeof(event_names) / sizeof(event_names[0]); i++) {
+        if (event_names[i].id == APP_TRACE_EVENT_ID(arg)) {
+          snprintf(buf, size, "evt %s", event_names[i].name);
+          return buf;
+        }
+      }
+      snprintf(buf, size, "evt 0x%08x", (unsigned)APP_TRACE_EVENT_ID(arg));
+      return buf;
+    default:
+      snprintf(buf, size, "kind 0x%02x", kind);
+      return buf;
+  }
+}
+
+static void account(uint8_t kind, uint32_t arg, uint64_t start, uint64_t cycles)
+{
+  stat_t *s = NULL;
+  uint64_t ns = to_ns(cycles);
+
+  // Only events and interrupts are told apart by their argument
+  if (kind != APP_TRACE_EVENT && kind != APP_TRACE_ISR && kind != APP_TRACE_SLEEP) {
+    arg = 0;
+  }
+  for (int i = 0; i < stat_count; i++) {
+    if (stats[i].kind == kind && stats[i].arg == arg) {
+      s = &stats[i];
+      break;
+    }
+  }
+  if (s == NULL) {
+    s = &stats[stat_count < MAX_STATS ? stat_count++ : MAX_STATS - 1];
+    s->kind = kind;
+    s->arg = arg;
+  }
+  s->count++;
+  s->sum_ns += ns;
+  s->hist[bucket(ns)]++;
+  if (ns > s->max_ns) {
+    s->max_ns = ns;
+    s->max_at_ms = to_ms(start);
+  }
+}
+
+static int by_start(const void *a, const void *b)
+{
+  const line_t *x = a;
+  const line_t *y = b;
+
+  if (x->start != y->start) {
+    return x->start < y->start ? -1 : 1;
+  }
+  return x->depth - y->depth;
+}
+
+static void print_pending(void)
+{
+  char buf[48];
+
+  // Spans end innermost first; the timeline reads better in start order
+  qsort(pending, (size_t)pending_count, sizeof(pending[0]), by_start);
+  for (int i = 0; i < pending_count; i++) {
+    const line_t *l = &pending[i];
+
+    printf("%12.3f ms %*s%-*s %10.2f us", to_ms(l->start), 2 * l->depth, "",
+           28 - 2 * l->depth, name_of(l->kind, l->arg, buf, sizeof(buf)),
+           to_ns(l->length) / 1000.0);
+    if (l->self != l->length) {
+      printf("  (self %.2f us)", to_ns(l->self) / 1000.0);
+    }
+    putchar('\n');
+  }
+  pending_count = 0;
+}
+
+static void timeline(uint8_t kind, uint32_t arg, uint64_t start, uint64_t length,
+                     uint64_t self, int at_depth)
+{
+  double ms = to_ms(start);
+
+  if (!opt.timeline || ms < opt.from_ms || ms > opt.to_ms) {
+    return;
+  }
+  if (pending_count == MAX_PENDING) {
+    print_pending();
+  }
+  pending[pending_count++] = (line_t){ start, length, self, at_depth, kind, arg };
+  if (at_depth == 0) {
+    print_pending();
+  }
+}
+
+static void note(const char *fmt, unsigned long long value)
+{
+  if (opt.timeline && to_ms(now) >= opt.from_ms && to_ms(now) <= opt.to_ms) {
+    print_pending();
+    printf("%12.3f ms ", to_ms(now));
+    printf(fmt, value);
+    putchar('\n');
+  }
+}
+
+static void span_end(uint8_t kind)
+{
+  uint64_t length;
+  uint64_t self;
+  int i = depth - 1;
+
+  while (i >= 0 && stack[i].kind != kind) {
+    i--;
+  }
+  if (i < 0) {
+    totals.unmatched++;
+    return;
+  }
+  // Starts whose end got lost are closed here as well
+  totals.unmatched += (uint64_t)(depth - 1 - i);
+  depth = i;
+  length = now - stack[i].start;
+  self = length > stack[i].nested ? length - stack[i].nested : 0;
+  account(kind, stack[i].arg, stack[i].start, self);
+  if (i > 0) {
+    stack[i - 1].nested += length;
+  }
+  timeline(kind, stack[i].arg, stack[i].start, length, self, i);
+}
+
+static void on_record(uint32_t word, uint32_t second)
+{
+  uint8_t kind = APP_TRACE_KIND(word);
+  uint32_t arg = APP_TRACE_ARG(word);
+
+  totals.records++;
+  if (kind == APP_TRACE_INFO) {
+    tick_hz = arg;
+    cpu_hz = second;
+    return;
+  }
+
+  if (!have_time) {
+    have_time = true;
+    now = 0;
+  } else if (kind == APP_TRACE_WAKE && asleep) {
+    uint32_t ticks = (arg - sleep_tick) & TICK_MASK;
+
+    now = sleep_start + (uint64_t)(ticks * cpu_hz / tick_hz);
+  } else {
+    uint32_t cycles = second - last_cycles;
+
+    // The loop leaves a record on every pass; a second without one is a
+    // record decoded out of step after a loss, not time
+    if (cycles <= cpu_hz) {
+      now += cycles;
+    } else {
+      totals.jumps++;
+    }
+  }
+  last_cycles = second;
+
+  switch (kind) {
+    case APP_TRACE_SLEEP:
+      asleep = true;
+      sleep_start = now;
+      sleep_tick = arg & TICK_MASK;
+      sleep_em = arg >> APP_TRACE_TICK_BITS;
+      break;
+
+    case APP_TRACE_WAKE:
+      if (asleep) {
+        asleep = false;
+        totals.sleeps++;
+        totals.sleep_cycles += now - sleep_start;
+        account(APP_TRACE_SLEEP, sleep_em, sleep_start, now - sleep_start);
+        timeline(APP_TRACE_SLEEP, sleep_em, sleep_start, now - sleep_start,
+                 now - sleep_start, depth);
+      }
+      break;
+
+    case APP_TRACE_LOST:
+      totals.lost += arg;
+      note("-- %llu records lost, ring full --", arg);
+      break;
+
+    default:
+      if (kind & 1) {
+        span_end(kind - 1);
+      } else if (depth < MAX_DEPTH) {
+        stack[depth++] = (frame_t){ kind, arg, now, 0 };
+      } else {
+        totals.too_deep++;
+      }
+      break;
+  }
+}
+
+static bool known_kind(uint8_t kind)
+{
+  return (kind >= APP_TRACE_INFO && kind <= APP_TRACE_WAKE)
+         || (kind >= APP_TRACE_STEP && kind <= APP_TRACE_END(APP_TRACE_FLUSH));
+}
+
+/* Pairs the port's words into records. A word lost in an ITM overflow
+ * would shift every record after it, so a first word has to look like one. */
+static bool have_first;
+static uint32_t first;
+
+static void on_word(uint32_t word)
+{
+  if (!have_first) {
+    if (known_kind(APP_TRACE_KIND(word))) {
+      first = word;
+      have_first = true;
+    } else {
+      totals.misaligned++;
+    }
+    return;
+  }
+  have_first = false;
+  on_record(first, word);
+}
+
+static int skip_continuation(FILE *f, int c)
+{
+  while (c != EOF && (c & 0x80)) {
+    c = getc(f);
+  }
+  return c;
+}
+
+/* ITM packet layer, ARMv8-M architecture reference, appendix D */
+static void parse(FILE *f)
+{
+  unsigned zeros = 0;
+  int c;
+
+  while ((c = getc(f)) != EOF) {
+    if (c == 0x00) {
+      zeros++;
+      continue;
+    }
+    if (c == 0x80 && zeros >= 5) {
+      // End of a synchronisation packet
+      zeros = 0;
+      continue;
+    }
+    zeros = 0;
+    if (c == 0x70) {
+      totals.overflows++;
+      have_first = false;
+    } else if ((c & 0x0f) == 0x00) {
+      // Local timestamp
+      if (c & 0x80) {
+        skip_continuation(f, getc(f));
+      }
+    } else if ((c & 0xdf) == 0x94) {
+      // Global timestamp
+      skip_continuation(f, getc(f));
+    } else if ((c & 0x0b) == 0x08) {
+      // Extension
+      if (c & 0x80) {
+        skip_continuation(f, getc(f));
+      }
+    } else if (c & 0x03) {
+      unsigned size = (c & 0x03) == 3 ? 4 : (unsigned)(c & 0x03);
+      uint32_t value = 0;
+
+      for (unsigned i = 0; i < size; i++) {
+        int b = getc(f);
+
+        if (b == EOF) {
+          return;
+        }
+        value |= (uint32_t)b << (8 * i);
+      }
+      // Software source on our port only; PC samples and the like are not ours
+      if (!(c & 0x04) && (unsigned)(c >> 3) == APP_TRACE_ITM_PORT && size == 4) {
+        on_word(value);
+      } else {
+        totals.other_packets++;
+      }
+    }
+  }
+}
+
+static double percentile_ns(const stat_t *s, double p)
+{
+  uint64_t want = (uint64_t)(s->count * p);
+  uint64_t seen = 0;
+
+  for (unsigned b = 0; b < HIST_BUCKETS; b++) {
+    seen += s->hist[b];
+    if (seen > want) {
+      double top = bucket_top_ns(b);
+
+      return top < (double)s->max_ns ? top : (double)s->max_ns;
+    }
+  }
+  return (double)s->max_ns;
+}
+
+static void print_hist(const stat_t *s)
+{
+  uint64_t octaves[HIST_BUCKETS / 8] = { 0 };
+  uint64_t most = 0;
+  unsigned lo = HIST_BUCKETS / 8;
+  unsigned hi = 0;
+
+  for (unsigned b = 0; b < HIST_BUCKETS; b++) {
+    octaves[b / 8] += s->hist[b];
+  }
+  for (unsigned o = 0; o < HIST_BUCKETS / 8; o++) {
+    if (octaves[o] != 0) {
+      lo = o < lo ? o : lo;
+      hi = o;
+      most = octaves[o] > most ? octaves[o] : most;
+    }
+  }
+  for (unsigned o = lo; o <= hi && most != 0; o++) {
+    int bar = (int)((octaves[o] * 40 + most - 1) / most);
+
+    printf("    %10.2f us .. %-10.2f %8llu %.*s\n", (double)(1ull << o) / 1000.0,
+           (double)(2ull << o) / 1000.0, (unsigned long long)octaves[o], bar,
+           "########################################");
+  }
+}
+
+static void report(void)
+{
+  uint64_t span = now;
+  uint64_t awake = span > totals.sleep_cycles ? span - totals.sleep_cycles : 0;
+  char buf[48];
+
+  printf("\n%-28s %10s %10s %10s %10s %12s %7s\n", "span", "count", "avg us", "p99 us",
+         "max us", "total ms", "awake%");
+  for (int i = 0; i < stat_count; i++) {
+    const stat_t *s = &stats[i];
+    double total_ms = s->sum_ns / 1e6;
+
+    printf("%-28s %10llu %10.2f %10.2f %10.2f %12.3f", name_of(s->kind, s->arg, buf, sizeof(buf)),
+           (unsigned long long)s->count, s->count ? s->sum_ns / 1000.0 / s->count : 0.0,
+           percentile_ns(s, 0.99) / 1000.0, s->max_ns / 1000.0, total_ms);
+    if (s->kind != APP_TRACE_SLEEP && awake != 0) {
+      printf(" %6.2f%%", total_ms * 100.0 / to_ms(awake));
+    } else {
+      printf(" %7s", "");
+    }
+    printf("   worst at %.3f ms\n", s->max_at_ms);
+    if (opt.hist) {
+      print_hist(s);
+    }
+  }
+
+  printf("\n%llu records over %.3f s: awake %.3f ms (%.3f%%), %u sleeps",
+         (unsigned long long)totals.records, to_ms(span) / 1000.0, to_ms(awake),
+         span ? awake * 100.0 / span : 0.0, (unsigned)totals.sleeps);
+  if (totals.sleeps != 0) {
+    printf(" of %.3f ms on average", to_ms(totals.sleep_cycles) / totals.sleeps);
+  }
+  printf("\ncore clock %.0f Hz, sleeptimer %.0f Hz\n", cpu_hz, tick_hz);
+  if (totals.lost != 0) {
+    printf("%llu records lost on the device: ring full between flushes\n",
+           (unsigned long long)totals.lost);
+  }
+  if (totals.overflows != 0 || totals.misaligned != 0) {
+    printf("%llu ITM overflows, %llu words skipped: the SWO line is too slow for the trace\n",
+           (unsigned long long)totals.overflows, (unsigned long long)totals.misaligned);
+  }
+  if (totals.jumps != 0) {
+    printf("%llu records more than a second after the one before them, not counted as time\n",
+           (unsigned long long)totals.jumps);
+  }
+  if (totals.unmatched != 0 || totals.too_deep != 0) {
+    printf("%llu spans without a start or end, %llu nested too deep\n",
+           (unsigned long long)totals.unmatched, (unsigned long long)totals.too_deep);
+  }
+  if (totals.other_packets != 0) {
+    printf("%llu packets from other sources or ports ignored\n",
+           (unsigned long long)totals.other_packets);
+  }
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [--timeline] [--from MS] [--to MS] [--no-hist] [--hz N] "
+          "capture\n", prog);
+  exit(2);
+}
+
+int main(int argc, char **argv)
+{
+  static const struct option options[] = {
+    { "timeline", no_argument, NULL, 'l' },
+    { "from", required_argument, NULL, 'f' },
+    { "to", required_argument, NULL, 't' },
+    { "no-hist", no_argument, NULL, 'H' },
+    { "hz", required_argument, NULL, 'z' },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 },
+  };
+  FILE *f;
+  int c;
+
+  while ((c = getopt_long(argc, argv, "h", options, NULL)) != -1) {
+    switch (c) {
+      case 'l':
+        opt.timeline = true;
+        break;
+      case 'f':
+        opt.from_ms = strtod(optarg, NULL);
+        break;
+      case 't':
+        opt.to_ms = strtod(optarg, NULL);
+        break;
+      case 'H':
+        opt.hist = false;
+        break;
+      case 'z':
+        opt.hz = strtod(optarg, NULL);
+        break;
+      default:
+        usage(argv[0]);
+    }
+  }
+  if (optind != argc - 1) {
+    usage(argv[0]);
+  }
+  f = fopen(argv[optind], "rb");
+  if (f == NULL) {
+    perror(argv[optind]);
+    return 2;
+  }
+  cpu_hz = opt.hz;
+  parse(f);
+  fclose(f);
+  print_pending();
+  if (totals.records == 0) {
+    fprintf(stderr, "%s: no records on ITM port %d\n", argv[optind], APP_TRACE_ITM_PORT);
+    return 1;
+  }
+  report();
+  return 0;
+}
@@ -0,0 +1,93 @@
+/***************************************************************************//**
+ * @file
+ * @brief LED_IO characteristic: GATT writes driven straight to the pins.
+ *
+ * The timing covers the application side, from the moment the stack hands
+ * the event over to the GPIO write. Over the air a write lands in the next
+ * connection event, so end to end it is bounded by one connection interval
+ * plus this.
+ ******************************************************************************/
+#include "em_device.h"
+#include "em_gpio.h"
+#include "led_io.h"
+
+#define ATT_ERR_INVALID_OFFSET      0x07
+#define ATT_ERR_INVALID_VALUE_LEN   0x0d
+
+typedef struct {
+  GPIO_Port_TypeDef port;
+  uint8_t pin;
+} led_pin_t;
+
+// BRD4314a has a single user LED
+static const led_pin_t leds[] = {
+  { gpioPortA, 4 },
+};
+
+#define LED_COUNT (sizeof(leds) / sizeof(leds[0]))
+
+static led_io_stats_t stats;
+
+void led_io_init(void)
+{
+  for (size_t i = 0; i < LED_COUNT; i++) {
+    GPIO_PinModeSet(leds[i].port, leds[i].pin, gpioModePushPull, 1);
+  }
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+uint32_t led_io_timestamp(void)
+{
+  return DWT->CYCCNT;
+}
+
+uint8_t led_io_write(const uint8_t *value, size_t len, uint16_t offset,
+                     bool acked, uint32_t start)
+{
+  uint32_t cycles;
+
+  if (offset != 0) {
+    stats.rejected++;
+    return ATT_ERR_INVALID_OFFSET;
+  }
+  if (len == 0 || len > LED_IO_MAX_LEN) {
+    stats.rejected++;
+    return ATT_ERR_INVALID_VALUE_LEN;
+  }
+  for (size_t i = 0; i < len && i < LED_COUNT; i++) {
+    if (value[i] == 0) {
+      GPIO_PinOutClear(leds[i].port, leds[i].pin);
+    } else if (value[i] != LED_IO_KEEP) {
+      GPIO_PinOutSet(leds[i].port, leds[i].pin);
+    }
+  }
+
+  cycles = DWT->CYCCNT - start;
+  if (acked) {
+    stats.writes++;
+  } else {
+    stats.commands++;
+  }
+  stats.cycles_last = cycles;
+  stats.cycles_sum += cycles;
+  if (cycles > stats.cycles_max) {
+    stats.cycles_max = cycles;
+  }
+  return 0;
+}
+
+size_t led_io_read(uint8_t *value, size_t max)
+{
+  size_t n = LED_COUNT < max ? LED_COUNT : max;
+
+  for (size_t i = 0; i < n; i++) {
+    value[i] = (uint8_t)GPIO_PinOutGet(leds[i].port, leds[i].pin);
+  }
+  return n;
+}
+
+const led_io_stats_t *led_io_stats(void)
+{
+  return &stats;
+}
@@ -0,0 +1,51 @@
+/***************************************************************************//**
+ * @file
+ * @brief LED_IO characteristic: GATT writes driven straight to the pins.
+ *
+ * LED_IO is a user-type characteristic, so the stack keeps no copy of it:
+ * byte i of a write sets LED i (0 off, 0xff unchanged, anything else on)
+ * and a read returns the pin states. One byte writes keep working as before.
+ ******************************************************************************/
+
+#ifndef LED_IO_H
+#define LED_IO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Matches the characteristic length in gatt_configuration.btconf
+#define LED_IO_MAX_LEN      8
+
+#define LED_IO_KEEP         0xff
+
+typedef struct {
+  uint32_t writes;            ///< write requests (acknowledged)
+  uint32_t commands;          ///< write without response
+  uint32_t rejected;
+  uint32_t cycles_last;       ///< event dispatch to pin write, CPU cycles
+  uint32_t cycles_max;
+  uint64_t cycles_sum;
+} led_io_stats_t;
+
+/// Configures the LED pins and the cycle counter used for timing.
+void led_io_init(void);
+
+/// Cycle counter value to pass to led_io_write() as the event start.
+uint32_t led_io_timestamp(void);
+
+/**************************************************************************//**
+ * Applies a write to the pins. Returns an ATT error code, 0 on success.
+ *
+ * @param[in] acked true for a write request, false for a write command
+ * @param[in] start led_io_timestamp() taken when the event was dispatched
+ *****************************************************************************/
+uint8_t led_io_write(const uint8_t *value, size_t len, uint16_t offset,
+                     bool acked, uint32_t start);
+
+/// Current pin states, one byte per LED. Returns the length.
+size_t led_io_read(uint8_t *value, size_t max);
+
+const led_io_stats_t *led_io_stats(void);
+
+#endif // LED_IO_H
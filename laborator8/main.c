@@ -30,6 +30,7 @@
 #include "sl_component_catalog.h"
 #include "sl_system_init.h"
 #include "app.h"
+#include "app_trace.h"
 #if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
 #include "sl_power_manager.h"
 #endif // SL_CATALOG_POWER_MANAGER_PRESENT
@@ -57,10 +58,17 @@ int main(void)
   while (1) {
     // Do not remove this call: Silicon Labs components process action routine
     // must be called from the super loop.
+    app_trace(APP_TRACE_STEP, 0);
     sl_system_process_action();
+    app_trace(APP_TRACE_END(APP_TRACE_STEP), 0);
 
     // Application process.
+    app_trace(APP_TRACE_APP, 0);
     app_process_action();
+    app_trace(APP_TRACE_END(APP_TRACE_APP), 0);
+
+    // Trace records go out on the SWO here, outside every traced handler
+    app_trace_flush();
 
 #if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
     // Let the CPU go to sleep if the system allows it.
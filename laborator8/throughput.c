@@ -0,0 +1,217 @@
+/***************************************************************************//**
+ * @file
+ * @brief Throughput service: bulk notifications with a built-in test mode.
+ *
+ * Flow control comes from the stack: notifications are queued until
+ * sl_bt_gatt_server_send_notification() runs out of buffer memory, and the
+ * main loop tops the queue up again. The loop must keep running for that,
+ * so a test holds an EM1 requirement until it ends; outside a test the
+ * connection goes back to a relaxed interval.
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "sl_bt_api.h"
+#include "sl_power_manager.h"
+#include "sl_sleeptimer.h"
+#include "conn_table.h"
+#include "throughput.h"
+
+#define ATT_ERR_INVALID_VALUE_LEN   0x0d
+#define ATT_ERR_CCCD_NOT_CONFIGURED 0xfd
+#define ATT_ERR_IN_PROGRESS         0xfe
+
+// Per call of throughput_process(), so other events still get a turn
+#define SENDS_PER_PASS              16
+
+// 15 ms while streaming, 30-50 ms otherwise
+#define FAST_INTERVAL               12
+#define SLOW_INTERVAL_MIN           24
+#define SLOW_INTERVAL_MAX           40
+#define SUPERVISION_TIMEOUT         100   // 1 s
+
+static uint16_t data_char;
+static uint32_t duration_ms;
+static uint64_t start_tick;
+static uint8_t payload[THROUGHPUT_MAX_MTU - 3];
+static throughput_stats_t stats = { .connection = 0xff };
+
+static uint32_t elapsed_ms(void)
+{
+  uint64_t ms = 0;
+
+  sl_sleeptimer_tick64_to_ms(sl_sleeptimer_get_tick_count64() - start_tick, &ms);
+  return (uint32_t)ms;
+}
+
+// Copies what the link negotiated so far into the result.
+static void snapshot_link(void)
+{
+  const conn_table_entry_t *e = conn_table_find(stats.connection);
+
+  if (e != NULL) {
+    stats.phy = e->phy;
+    stats.mtu = e->mtu;
+    stats.tx_len = e->tx_len;
+    stats.interval = e->interval;
+  }
+}
+
+static void stop(void)
+{
+  uint32_t kbps;
+
+  if (!stats.running) {
+    return;
+  }
+  stats.running = false;
+  stats.elapsed_ms = elapsed_ms();
+  snapshot_link();
+  sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
+  sl_bt_connection_set_parameters(stats.connection, SLOW_INTERVAL_MIN,
+                                  SLOW_INTERVAL_MAX, 0, SUPERVISION_TIMEOUT,
+                                  0, 0xffff);
+
+  kbps = stats.elapsed_ms ? (uint32_t)((uint64_t)stats.bytes * 8 / stats.elapsed_ms) : 0;
+  printf("Throughput: %lu bytes in %lu ms = %lu kbps (phy %u, mtu %u, "
+         "tx %u, interval %u, %lu stalls)\n",
+         (unsigned long)stats.bytes, (unsigned long)stats.elapsed_ms,
+         (unsigned long)kbps, stats.phy, stats.mtu, stats.tx_len,
+         stats.interval, (unsigned long)stats.stalls);
+}
+
+static void start(uint8_t connection, uint32_t ms)
+{
+  memset(&stats, 0, sizeof(stats));
+  stats.connection = connection;
+  snapshot_link();
+  stats.running = true;
+  duration_ms = ms;
+  start_tick = sl_sleeptimer_get_tick_count64();
+
+  // Each of these may be refused by the central; the test runs anyway and
+  // the result shows what was actually negotiated.
+  sl_bt_connection_set_preferred_phy(connection, sl_bt_gap_phy_2m, sl_bt_gap_phy_any);
+  sl_bt_connection_set_data_length(connection, 251, 0xffff);
+  sl_bt_connection_set_parameters(connection, FAST_INTERVAL, FAST_INTERVAL,
+                                  0, SUPERVISION_TIMEOUT, 0, 0xffff);
+  sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
+}
+
+void throughput_init(uint16_t characteristic)
+{
+  uint16_t mtu;
+
+  data_char = characteristic;
+  for (uint16_t i = 0; i < sizeof(payload); i++) {
+    payload[i] = (uint8_t)i;
+  }
+  sl_bt_gatt_server_set_max_mtu(THROUGHPUT_MAX_MTU, &mtu);
+}
+
+void throughput_on_closed(uint8_t connection)
+{
+  if (connection == stats.connection) {
+    stop();
+  }
+}
+
+void throughput_on_status(uint8_t connection, uint8_t status_flags, uint16_t client_config)
+{
+  if (status_flags == sl_bt_gatt_server_client_config
+      && !(client_config & sl_bt_gatt_notification)
+      && connection == stats.connection) {
+    stop();
+  }
+}
+
+uint8_t throughput_control(uint8_t connection, const uint8_t *value, uint8_t len)
+{
+  uint32_t ms = THROUGHPUT_DEFAULT_MS;
+
+  if (len != 1 && len != 5) {
+    return ATT_ERR_INVALID_VALUE_LEN;
+  }
+  if (value[0] == 0) {
+    stop();
+    return 0;
+  }
+  if (!(conn_table_client_config(connection, data_char) & sl_bt_gatt_notification)) {
+    return ATT_ERR_CCCD_NOT_CONFIGURED;
+  }
+  if (stats.running) {
+    return ATT_ERR_IN_PROGRESS;
+  }
+  if (len == 5) {
+    memcpy(&ms, &value[1], sizeof(ms));
+  }
+  start(connection, ms);
+  return 0;
+}
+
+uint8_t throughput_read(uint16_t offset, uint8_t *value, uint8_t max)
+{
+  uint8_t r[THROUGHPUT_RESULT_LEN];
+  uint32_t elapsed = stats.running ? elapsed_ms() : stats.elapsed_ms;
+  uint32_t kbps = elapsed ? (uint32_t)((uint64_t)stats.bytes * 8 / elapsed) : 0;
+  uint8_t n;
+
+  if (stats.running) {
+    snapshot_link();
+  }
+  r[0] = stats.running;
+  r[1] = stats.phy;
+  memcpy(&r[2], &stats.mtu, 2);
+  memcpy(&r[4], &stats.tx_len, 2);
+  memcpy(&r[6], &stats.interval, 2);
+  memcpy(&r[8], &elapsed, 4);
+  memcpy(&r[12], &stats.bytes, 4);
+  memcpy(&r[16], &stats.notifications, 4);
+  memcpy(&r[20], &stats.stalls, 4);
+  memcpy(&r[24], &kbps, 4);
+
+  if (offset >= sizeof(r)) {
+    return 0;
+  }
+  n = (sizeof(r) - offset < max) ? sizeof(r) - offset : max;
+  memcpy(value, &r[offset], n);
+  return n;
+}
+
+void throughput_process(void)
+{
+  uint16_t len;
+  sl_status_t sc;
+
+  if (!stats.running) {
+    return;
+  }
+  if (duration_ms != 0 && elapsed_ms() >= duration_ms) {
+    stop();
+    return;
+  }
+  // The MTU exchange may finish after the test started
+  snapshot_link();
+  len = stats.mtu - 3;
+  if (len > sizeof(payload)) {
+    len = sizeof(payload);
+  }
+  for (uint8_t i = 0; i < SENDS_PER_PASS; i++) {
+    memcpy(payload, &stats.notifications, sizeof(stats.notifications));
+    sc = sl_bt_gatt_server_send_notification(stats.connection, data_char, len, payload);
+    if (sc == SL_STATUS_NO_MORE_RESOURCE) {
+      stats.stalls++;
+      return;
+    }
+    if (sc != SL_STATUS_OK) {
+      stop();
+      return;
+    }
+    stats.notifications++;
+    stats.bytes += len;
+  }
+}
+
+const throughput_stats_t *throughput_stats(void)
+{
+  return &stats;
+}
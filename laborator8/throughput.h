@@ -0,0 +1,58 @@
+/***************************************************************************//**
+ * @file
+ * @brief Throughput service: bulk notifications with a built-in test mode.
+ *
+ * Writing TP_CONTROL starts a test on that connection:
+ *   cmd:1 (1 start, 0 stop) | duration_ms:4 (optional, 0 until stopped)
+ * Link properties come from conn_table. One test runs at a time; the
+ * client must be subscribed to TP_DATA. A test asks for the 2M PHY,
+ * 251 byte link layer packets and a 15 ms interval, then streams MTU - 3
+ * byte notifications (u32 sequence number first) as fast as the stack
+ * takes them. Reading TP_CONTROL returns, little endian:
+ *   running:1 | phy:1 | mtu:2 | tx_len:2 | interval:2 | elapsed_ms:4 |
+ *   bytes:4 | notifications:4 | stalls:4 | kbps:4
+ ******************************************************************************/
+
+#ifndef THROUGHPUT_H
+#define THROUGHPUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define THROUGHPUT_MAX_MTU            247
+#define THROUGHPUT_DEFAULT_MS         10000
+#define THROUGHPUT_RESULT_LEN         28
+
+typedef struct {
+  bool running;
+  uint8_t connection;
+  uint8_t phy;                ///< sl_bt_gap_phy_*
+  uint16_t mtu;
+  uint16_t tx_len;            ///< link layer payload
+  uint16_t interval;          ///< 1.25 ms units
+  uint32_t elapsed_ms;
+  uint32_t bytes;
+  uint32_t notifications;
+  uint32_t stalls;            ///< sends refused for lack of buffers
+} throughput_stats_t;
+
+/// Sets the maximum ATT MTU. Call on boot.
+void throughput_init(uint16_t data_char);
+
+void throughput_on_closed(uint8_t connection);
+
+/// CCCD changes of TP_DATA.
+void throughput_on_status(uint8_t connection, uint8_t status_flags, uint16_t client_config);
+
+/// A write to TP_CONTROL. Returns an ATT error code, 0 on success.
+uint8_t throughput_control(uint8_t connection, const uint8_t *value, uint8_t len);
+
+/// Fills a read of TP_CONTROL at offset. Returns the length.
+uint8_t throughput_read(uint16_t offset, uint8_t *value, uint8_t max);
+
+/// Keeps the stack's buffers full while a test runs. Call from the main loop.
+void throughput_process(void);
+
+const throughput_stats_t *throughput_stats(void);
+
+#endif // THROUGHPUT_H